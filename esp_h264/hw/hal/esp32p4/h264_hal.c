@@ -166,7 +166,7 @@ void h264_hal_set_roi_mode(esp_h264_set_dev_t device, int8_t roi_mode, int8_t no
     }
     h264_ll_disable_roi(device);
     for (uint8_t i = 0; i < 8; i++) {
-        h264_ll_set_roi_reg(device, false, 0, 0, 0, 0, 0, 0);
+        h264_ll_set_roi_reg(device, false, 0, 0, 0, 0, 0, i);
     }
 }
 
@@ -187,7 +187,7 @@ void h264_hal_get_rc_bits_mad_qpsum(h264_hal_context_t *hal, uint32_t *enc_bits,
  *                     Otherwise it's result of 16 * 16 macro block MV data.
  * @param  mv_fmt   Motion vector(MV) format
  *                  0: Output all MV data expect zero
- *                  1: Output horizontal or vertical direction absolute of MV data gather than or equal 4
+ *                  1: Output horizontal or vertical direction absolute of MV data greater than or equal 4
  */
 void h264_hal_set_mv_mode(esp_h264_set_dev_t device, int8_t mv_mode, uint8_t mv_fmt);
 
@@ -204,7 +204,7 @@ void h264_hal_set_mv_mode(esp_h264_set_dev_t device, int8_t mv_mode, uint8_t mv_
  *                      Otherwise it's result of 16 * 16 macro block MV data.
  * @param  mv_fmt   Motion vector(MV) format
  *                  0: Output all MV data expect zero
- *                  1: Output horizontal or vertical direction absolute of MV data gather than or equal 4
+ *                  1: Output horizontal or vertical direction absolute of MV data greater than or equal 4
  */
 void h264_hal_get_mv_mode(esp_h264_set_dev_t device, int8_t *mv_mode, uint8_t *mv_fmt);
 
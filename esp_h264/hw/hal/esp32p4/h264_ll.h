@@ -633,7 +633,7 @@ static inline bool h264_ll_get_mvm_en1(h264_dev_t *h264)
  *                     Otherwise it's result of 16 * 16 macro block MV data.
  * @param  mv_fmt   Motion vector(MV) format
  *                  0: Output all MV data expect zero
- *                  1: Output horizontal or vertical direction absolute of MV data gather than or equal 4.
+ *                  1: Output horizontal or vertical direction absolute of MV data greater than or equal 4.
  */
 static inline void h264_ll_set_mvm(h264_dev_t *h264, uint8_t mv_mode, uint8_t mv_fmt)
 {
@@ -653,7 +653,7 @@ static inline void h264_ll_set_mvm(h264_dev_t *h264, uint8_t mv_mode, uint8_t mv
  *                     Otherwise it's result of 16 * 16 macro block MV data.
  * @param  mv_fmt   Motion vector(MV) format
  *                  0: Output all MV data expect zero
- *                  1: Output horizontal or vertical direction absolute of MV data gather than or equal 4
+ *                  1: Output horizontal or vertical direction absolute of MV data greater than or equal 4
  */
 static inline void h264_ll_get_mvm(h264_dev_t *h264, uint8_t *mv_mode, uint8_t *mv_fmt)
 {
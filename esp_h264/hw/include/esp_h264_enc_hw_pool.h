@@ -0,0 +1,78 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *esp_h264_enc_hw_pool_handle_t;  /*<! Working buffer pool handle of hardware encoder */
+
+/**
+ * @brief  Working buffer pool configuration
+ *         The pool holds the reference frame, de-blocking filter data and temporary buffers for the maximum resolution.
+ *         The encoders created by `esp_h264_enc_hw_new_with_pool` share them instead of allocating their own.
+ */
+typedef struct {
+    esp_h264_resolution_t res;  /*<! The maximum resolution of encoders sharing the pool */
+} esp_h264_enc_hw_pool_cfg_t;
+
+/**
+ * @brief  Working buffer pool memory information
+ */
+typedef struct {
+    uint32_t ref_size;     /*<! The size of reference frame buffer in internal memory */
+    uint32_t db_size;      /*<! The size of de-blocking filter data buffer. It is in internal memory first */
+    uint32_t db_tmp_size;  /*<! The size of de-blocking filter temporary buffer in internal memory */
+} esp_h264_enc_hw_pool_info_t;
+
+/**
+ * @brief  Create a working buffer pool for the time-multiplexed hardware encoders
+ *
+ * @note  Only the encoder configuration is saved and restored at every switch, not the reference frame.
+ *        So every switch between the encoders of the pool costs one IDR-frame of the opened encoder.
+ *        Switch at the GOP boundary of the stream to keep the bitrate, or use separate encoders when the IDR-frame isn't affordable.
+ *
+ * @param[in]   cfg       Working buffer pool configuration
+ * @param[out]  out_pool  Working buffer pool handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory, the `*out_pool` will be set NULL
+ */
+esp_h264_err_t esp_h264_enc_hw_pool_new(const esp_h264_enc_hw_pool_cfg_t *cfg, esp_h264_enc_hw_pool_handle_t *out_pool);
+
+/**
+ * @brief  Get the memory information of working buffer pool
+ *
+ * @param[in]   pool      Working buffer pool handle
+ * @param[out]  out_info  Memory information
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_pool_get_info(esp_h264_enc_hw_pool_handle_t pool, esp_h264_enc_hw_pool_info_t *out_info);
+
+/**
+ * @brief  Delete the working buffer pool
+ *
+ * @param[in]  pool  Working buffer pool handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_FAIL  Some encoders still use the pool. Delete them first
+ */
+esp_h264_err_t esp_h264_enc_hw_pool_del(esp_h264_enc_hw_pool_handle_t pool);
+
+#ifdef __cplusplus
+}
+#endif
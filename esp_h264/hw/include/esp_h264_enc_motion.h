@@ -0,0 +1,142 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_types.h"
+#include "esp_h264_enc_param_hw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_H264_MOTION_ZONE_NUM (8)  /*<! The maximum number of motion zones */
+#define ESP_H264_MOTION_BOX_NUM  (8)  /*<! The maximum number of motion bounding boxes */
+
+typedef void *esp_h264_motion_handle_t;  /*<! Motion detection handle */
+
+/**
+ * @brief  Motion detection configuration
+ *         Every macroblock has a heat. The heat of moving macroblock rises by `heat_rise`, otherwise it decays by `heat_decay`.
+ *         The macroblock is hot when its heat is no less than `heat_thres`. So the single frame noise is filtered.
+ *         The motion score is the permillage of hot macroblocks. The motion starts when the score is no less than `on_thres` in `on_frames`
+ *         continuous frames, and stops when the score is less than `off_thres` in `off_frames` continuous frames.
+ */
+typedef struct {
+    uint8_t  mb_width;    /*<! Width of picture in macroblock. It is `(width + 15) >> 4` */
+    uint8_t  mb_height;   /*<! Height of picture in macroblock. It is `(height + 15) >> 4` */
+    uint8_t  mv_thres;    /*<! The macroblock is moving when `|mv_x| + |mv_y|` is no less than `mv_thres` */
+    uint8_t  heat_rise;   /*<! The heat rising of moving macroblock */
+    uint8_t  heat_decay;  /*<! The heat decay of still macroblock */
+    uint8_t  heat_thres;  /*<! The heat threshold of hot macroblock. Range:[1, 255] */
+    uint16_t on_thres;    /*<! The score threshold to start motion in permillage. Range:[1, 1000] */
+    uint16_t off_thres;   /*<! The score threshold to stop motion in permillage. It is no more than `on_thres` */
+    uint8_t  on_frames;   /*<! The continuous frames to start motion. Range:[1, 255] */
+    uint8_t  off_frames;  /*<! The continuous frames to stop motion. Range:[1, 255] */
+    uint8_t  min_area;    /*<! The bounding box less than `min_area` macroblocks is dropped */
+} esp_h264_motion_cfg_t;
+
+/**
+ * @brief  Motion bounding box in macroblock
+ */
+typedef struct {
+    uint8_t x;      /*<! The start position of the box in horizontal direction */
+    uint8_t y;      /*<! The start position of the box in vertical direction */
+    uint8_t len_x;  /*<! The box width */
+    uint8_t len_y;  /*<! The box height */
+} esp_h264_motion_box_t;
+
+/**
+ * @brief  Motion detection result
+ */
+typedef struct {
+    bool                  motion;                                 /*<! Whether there is motion in any zone after hysteresis */
+    bool                  changed;                                /*<! Whether `motion` is changed by this frame */
+    uint16_t              score;                                  /*<! Motion score of the whole picture in permillage */
+    uint16_t              moving_mb;                              /*<! The number of moving macroblocks of this frame */
+    uint16_t              zone_score[ESP_H264_MOTION_ZONE_NUM];  /*<! Motion score of each zone in permillage */
+    uint8_t               zone_motion;                            /*<! Bit mask of the zones in motion after hysteresis */
+    uint8_t               box_num;                                /*<! The number of bounding boxes */
+    esp_h264_motion_box_t box[ESP_H264_MOTION_BOX_NUM];          /*<! Bounding boxes of the hot macroblocks */
+    const uint8_t        *heatmap;                                /*<! Heat of every macroblock in raster order. It is owned by the handle
+                                                                       and valid until next `esp_h264_motion_process` */
+} esp_h264_motion_result_t;
+
+/**
+ * @brief  Create a motion detection handle
+ *         Without zone mask, the whole picture is zone 0
+ *
+ * @param[in]   cfg         Motion detection configuration
+ * @param[out]  out_handle  Motion detection handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory, the `*out_handle` will be set NULL
+ */
+esp_h264_err_t esp_h264_motion_new(const esp_h264_motion_cfg_t *cfg, esp_h264_motion_handle_t *out_handle);
+
+/**
+ * @brief  Set the zone mask
+ *         Bit `n` of every byte is set when the macroblock is in zone `n`. One macroblock can be in several zones.
+ *         The zone without any macroblock is never in motion.
+ *
+ * @param[in]  handle     Motion detection handle
+ * @param[in]  zone_mask  Zone mask of every macroblock in raster order. NULL means the whole picture is zone 0
+ * @param[in]  len        The length of zone mask. It is `mb_width * mb_height`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_motion_set_zone(esp_h264_motion_handle_t handle, const uint8_t *zone_mask, uint32_t len);
+
+/**
+ * @brief  Analyze the motion vector(MV) data of one P-frame
+ *
+ * @note  The MV data is from the MV packet set by `esp_h264_enc_hw_set_mv_pkt`. Its cache must be invalidated before.
+ *        The I-frame has no MV data, so don't call it after I-frame.
+ *
+ * @param[in]   handle  Motion detection handle
+ * @param[in]   mv      MV data. It can be NULL when `mv_num` is 0
+ * @param[in]   mv_num  The number of MV data. It is from `esp_h264_enc_hw_get_mv_data_len`
+ * @param[out]  result  Motion detection result
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_motion_process(esp_h264_motion_handle_t handle, const esp_h264_enc_mv_data_t *mv, uint32_t mv_num, esp_h264_motion_result_t *result);
+
+/**
+ * @brief  Reset the heatmap and the hysteresis state
+ *         Call it after scene change or IDR-frame requested by application
+ *
+ * @param[in]  handle  Motion detection handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_motion_reset(esp_h264_motion_handle_t handle);
+
+/**
+ * @brief  Delete the motion detection handle
+ *
+ * @param[in]  handle  Motion detection handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_motion_del(esp_h264_motion_handle_t handle);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,16 +8,36 @@
 
 #include "esp_h264_enc_single.h"
 #include "esp_h264_enc_param_hw.h"
+#include "esp_h264_enc_hw_pool.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+#define ESP_H264_OUT_SEG_MAX (32)  /*<! The maximum number of output segments */
+
 /**
  * @brief Configuration type for hardware-based H.264 encoder
  */
 typedef esp_h264_enc_cfg_t esp_h264_enc_cfg_hw_t;
 
+/**
+ * @brief  Memory used by hardware encoder in byte
+ *         The DMA descriptors, reference frame buffer, de-blocking filter temporary buffer and NAL buffer are regions of one arena
+ *         in internal RAM. It is allocated once when the encoder is created.
+ *         The working buffers from pool are counted by pool, so they are 0 here.
+ */
+typedef struct {
+    uint32_t handle;  /*<! Encoder and parameter set handles */
+    uint32_t arena;   /*<! The arena in internal RAM */
+    uint32_t desc;    /*<! DMA descriptors. The output segment descriptors are outside of the arena */
+    uint32_t ref;     /*<! Reference frame buffer in the arena */
+    uint32_t db_tmp;  /*<! De-blocking filter temporary buffer in the arena */
+    uint32_t nal;     /*<! SPS and PPS buffer in the arena */
+    uint32_t db;      /*<! De-blocking filter data buffer. It is outside of the arena and in PSRAM if internal RAM isn't enough */
+    uint32_t total;   /*<! Total memory. It is the sum of handles, arena, de-blocking filter data and the output segment descriptors */
+} esp_h264_enc_hw_mem_info_t;
+
 /**
  * @brief  This function is used to create a new instance of the `esp_h264_enc_t` data structure,
  *         which represents a single-streams H.264 encoder in hardware
@@ -34,6 +54,29 @@ typedef esp_h264_enc_cfg_t esp_h264_enc_cfg_hw_t;
  */
 esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_handle_t *out_enc);
 
+/**
+ * @brief  Create a single-stream hardware encoder sharing the working buffers of `pool`
+ *         The encoders of one pool are time-multiplexed. Only one of them is open at a time.
+ *         Every `esp_h264_enc_open` programs the hardware and the working buffers for the encoder again,
+ *         and restores the QP, MV and ROI configuration saved by its last `esp_h264_enc_close`.
+ *
+ * @note  The reference frame in the working buffers is overwritten by other encoders and it isn't saved,
+ *        so the first frame after `esp_h264_enc_open` is always IDR-frame. Every switch of the pool costs one IDR-frame.
+ *        Configure the encoder when it is open, or before another encoder of the pool is created or opened.
+ *        Create the encoder when no encoder of the pool is open.
+ *
+ * @param[in]   cfg      The configuration of encoder. The resolution isn't greater than the pool resolution
+ * @param[in]   pool     Working buffer pool handle from `esp_h264_enc_hw_pool_new`
+ * @param[out]  out_enc  The created encoder instance
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory, the `*out_enc` will be set NULL
+ *       - ESP_H264_ERR_FAIL  An encoder of the pool is open
+ */
+esp_h264_err_t esp_h264_enc_hw_new_with_pool(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_hw_pool_handle_t pool, esp_h264_enc_handle_t *out_enc);
+
 /**
  * @brief  This function returns a pointer to the hardware-encoded parameter structure associated with the given `esp_h264_enc_t` encoder
  *
@@ -46,6 +89,172 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
  */
 esp_h264_err_t esp_h264_enc_hw_get_param_hd(esp_h264_enc_handle_t enc, esp_h264_enc_param_hw_handle_t *out_param);
 
+/**
+ * @brief  Get the memory used by the encoder
+ *
+ * @param[in]   enc       The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[out]  out_info  Memory used by every region
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_get_mem_info(esp_h264_enc_handle_t enc, esp_h264_enc_hw_mem_info_t *out_info);
+
+/**
+ * @brief  Reconfigure the resolution, QP range, bitrate, RC mode, FPS and GOP without deleting the encoder
+ *         The new configuration is applied from the next frame, which is IDR-frame with new SPS and PPS.
+ *         All buffers and the interrupt are reused, so the encoding doesn't stall for the re-creation.
+ *
+ * @note  The resolution can't be greater than the one at creation, as the buffers are sized by it.
+ *        The ROI regions and QP map are for the macroblocks of old resolution. Set them again after reconfiguration.
+ *
+ * @param[in]  enc  The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[in]  cfg  New configuration. `pic_type` must be the same as the one at creation
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_reconfigure(esp_h264_enc_handle_t enc, const esp_h264_enc_cfg_hw_t *cfg);
+
+/**
+ * @brief  Export the trace events of the encoder as Chrome trace JSON
+ *         The timestamps of process entry and exit, slice header, DMA configuration, hardware start, ISR branches,
+ *         frame done, cache invalidation and rate control end are recorded into a ring of the last 256 events.
+ *         Load the JSON in `chrome://tracing` or Perfetto on host.
+ *
+ * @note  The trace points are only compiled with `CONFIG_ESP_H264_TRACE`.
+ *        Export it when the encoder is idle, or the newest events may be partly written.
+ *
+ * @param[in]   enc      The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[out]  buf      JSON buffer. It is NULL terminated
+ * @param[in]   size     The size of `buf` in byte
+ * @param[out]  out_len  The JSON length. If `buf` is too small, it is the required length without NULL terminator
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          `buf` is too small
+ *       - ESP_H264_ERR_UNSUPPORTED  `CONFIG_ESP_H264_TRACE` is disabled
+ */
+esp_h264_err_t esp_h264_enc_hw_trace_export(esp_h264_enc_handle_t enc, char *buf, uint32_t size, uint32_t *out_len);
+
+/**
+ * @brief  Get the upper bound of output buffer size for the next frame
+ *         The bound is from resolution, the lowest QP of frame and ROI regions, and the frame type.
+ *         When rate control is enabled, it is tightened to twice the largest recent frame of the same type.
+ *         So the output buffer can be sized per frame instead of the worst case.
+ *
+ * @note  The bound from rate control history is an estimate. Set a spill buffer by `esp_h264_enc_hw_set_spill_buf`
+ *        to catch the rare frame beyond it.
+ *        The P-frame bound is kept with scene change detection. Only the frame promoted by the MAD jump of last frame takes the IDR-frame bound.
+ *        The frame promoted by luma histogram stays P-frame when the output buffer is less than the IDR-frame bound, and the next frame is promoted.
+ *
+ * @param[in]   enc       The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[out]  out_size  The output buffer size in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_get_out_buf_size(esp_h264_enc_handle_t enc, uint32_t *out_size);
+
+/**
+ * @brief  Set the output segments. The encoded data continues into them in order when the output buffer of `esp_h264_enc_process` is full.
+ *         So the encoded frame lands directly in the application buffers, such as the fixed-size transmit buffers, without copy.
+ *         `out_frame->length` is the total length. The length of encoded data in every segment is from `esp_h264_enc_hw_get_out_seg_len`,
+ *         and the rest is in the output buffer.
+ *
+ * @note  With the output segments, the used length of output buffer is aligned down to 8 bytes.
+ *        Every segment buffer and length must be aligned to the cache line, as the segments are invalidated by whole cache lines.
+ *        The cache line is the larger one of internal RAM and PSRAM from `esp_cache_get_alignment`.
+ *        The segments are kept by application until they are unset or the encoder is deleted.
+ *        The output buffer holds SPS, PPS and slice header. So 64 bytes at least is recommended.
+ *
+ * @param[in]  enc      The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[in]  seg      The output segments
+ * @param[in]  seg_num  The number of output segments. Range:[0, ESP_H264_OUT_SEG_MAX]. Zero unsets the output segments
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_enc_hw_set_out_seg(esp_h264_enc_handle_t enc, const esp_h264_pkt_t *seg, uint8_t seg_num);
+
+/**
+ * @brief  Get the length of encoded data in every output segment of last frame
+ *
+ * @param[in]   enc      The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[out]  out_len  The length array in byte. Zero means the segment isn't used
+ * @param[in]   len_num  The number of `out_len` array
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_get_out_seg_len(esp_h264_enc_handle_t enc, uint32_t *out_len, uint8_t len_num);
+
+/**
+ * @brief  Set the spill buffer. The encoded data continues into it when the output buffer of `esp_h264_enc_process` is full.
+ *         It is the same as `esp_h264_enc_hw_set_out_seg` with one segment.
+ *         `out_frame->length` is the total length. The first `out_frame->length - spill_len` bytes are in the output buffer
+ *         and the rest `spill_len` bytes are in the spill buffer. `spill_len` is from `esp_h264_enc_hw_get_spill_len`.
+ *
+ * @note  With the spill buffer, the used length of output buffer is aligned down to 8 bytes.
+ *        The spill buffer and its length must be aligned to the cache line as `esp_h264_enc_hw_set_out_seg`.
+ *        It is kept by application until it is unset or the encoder is deleted.
+ *
+ * @param[in]  enc    The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[in]  spill  The spill buffer and its length. NULL `buffer` unsets the spill buffer
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_enc_hw_set_spill_buf(esp_h264_enc_handle_t enc, esp_h264_pkt_t spill);
+
+/**
+ * @brief  Get the length of encoded data in the spill buffer of last frame. It is the total length in all output segments
+ *
+ * @param[in]   enc      The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[out]  out_len  The length in byte. Zero means all data is in the output buffer
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_get_spill_len(esp_h264_enc_handle_t enc, uint32_t *out_len);
+
+/**
+ * @brief  Buffer ownership flags of single hardware encoder
+ *         The cache of a buffer is synchronized only when CPU accesses it.
+ */
+typedef enum {
+    ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN = (1 << 0),  /*<! The input frame is written by device only, such as camera DMA. The cache write back of it is skipped */
+    ESP_H264_ENC_HW_BUF_OUT_DEV_READ   = (1 << 1),  /*<! The output frame and segments are read by device only, such as network DMA. The cache invalidation of encoded data is skipped */
+} esp_h264_enc_hw_buf_flag_t;
+
+/**
+ * @brief  Set the buffer ownership flags. It takes effect from the next frame.
+ *
+ * @note  The flags are kept by encoder, not carried by each frame. They stay until the next call.
+ *        So for frames of mixed ownership, call it before `esp_h264_enc_process` of the frame that changes the ownership.
+ *        By default, the whole input frame is written back from cache and the coded data of output buffer is invalidated.
+ *        With `ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN`, the CPU mustn't write the input frame, or the hardware may read stale data.
+ *        With `ESP_H264_ENC_HW_BUF_OUT_DEV_READ`, the CPU mustn't read the encoded data except the headers written by encoder.
+ *
+ * @param[in]  enc    The encoder instance that is from `esp_h264_enc_hw_new`
+ * @param[in]  flags  Bitwise OR of `esp_h264_enc_hw_buf_flag_t`. Zero is default
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_enc_hw_set_buf_flags(esp_h264_enc_handle_t enc, uint32_t flags);
+
 #ifdef __cplusplus
 }
 #endif
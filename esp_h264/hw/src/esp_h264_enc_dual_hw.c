@@ -23,8 +23,10 @@ typedef struct esp_h264_hw_handle {
     h264_dma_desc_t            *dsc_bs;
     uint8_t                     frame_num;
     uint8_t                     gop;
+    bool                        scene_change;
     esp_h264_mutex_t            frame_done;
     esp_h264_intr_hd_t          intr_hd;
+    esp_h264_arena_t            arena;
 } esp_h264_hw_handle_t;
 
 static void h264_frame_isr(void *arg)
@@ -102,6 +104,16 @@ static inline esp_h264_err_t h264_hw_enc_frame_mode_process(esp_h264_hw_handle_t
         /** Slice header will record the delta QP */
         qp_delta = qp - qp_init;
     }
+    int8_t frame_qp = -1;
+    esp_h264_enc_hw_get_frame_qp(param_hd, &frame_qp);
+    if (frame_qp >= 0) {
+        /** The frame QP of QP map overrides the RC QP. The RC still learns from the encoded frame. */
+        uint8_t qp_init = 0;
+        esp_h264_enc_hw_get_qp_init(param_hd, &qp_init);
+        qp = frame_qp;
+        esp_h264_enc_hw_set_qp(param_hd, qp);
+        qp_delta = qp - qp_init;
+    }
     uint32_t *slice_start_code = (uint32_t *)out_frame;
     uint32_t slice_nal_len = 0;
     if (!hw_hd->frame_num) {
@@ -117,10 +129,10 @@ static inline esp_h264_err_t h264_hw_enc_frame_mode_process(esp_h264_hw_handle_t
     int out_frame_len = (bs - out_frame);
     esp_h264_cache_check_and_writeback(out_frame, (slice_nal_len + 7) >> 3);
     /** Configure descriptor */
-    esp_h264_enc_hw_cfg_dma_yuv_bs(param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_yuv, in_frame, hw_hd->dsc_bs, bs, out_frame_size - out_frame_len);
+    esp_h264_enc_hw_cfg_dma_yuv_bs(param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_yuv, in_frame, hw_hd->dsc_bs, bs, out_frame_size - out_frame_len, NULL, NULL, 0);
     esp_h264_err_t ret = esp_h264_enc_hw_cfg_dma_mvm(param_hd, &hw_hd->dma2d_hal);
     if (ret != ESP_H264_ERR_OK) {
-        ESP_H264_LOGE(TAG, "Please configure MV packet.");
+        ESP_H264_LOGE(TAG, "Please configure MV packet, or release the MV packets of MV buffer ring.");
         return ESP_H264_ERR_FAIL;
     }
     esp_h264_enc_hw_cfg_dma_db_ref(param_hd, &hw_hd->dma2d_hal);
@@ -176,6 +188,25 @@ static esp_h264_err_t enc_process(esp_h264_enc_dual_handle_t enc, esp_h264_enc_i
     esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
     esp_h264_err_t ret = ESP_H264_ERR_OK;
     hw_hd->frame_num = hw_hd->frame_num % hw_hd->gop;
+    /** Scene change check. The scene change from MAD jump of the last frame or luma histogram of both streams. */
+    esp_h264_scene_hd_t scene_hd[H264_SUP_MAX_CHANNEL];
+    esp_h264_enc_hw_get_scene_hd(hw_hd->param_hd0, &scene_hd[0]);
+    esp_h264_enc_hw_get_scene_hd(hw_hd->param_hd1, &scene_hd[1]);
+    hw_hd->scene_change |= esp_h264_scene_check_pic(scene_hd[0], in_frame[0]->raw_data.buffer);
+    hw_hd->scene_change |= esp_h264_scene_check_pic(scene_hd[1], in_frame[1]->raw_data.buffer);
+    if (hw_hd->scene_change && hw_hd->frame_num) {
+        esp_h264_rc_hd_t rc_hd = NULL;
+        esp_h264_enc_hw_get_rc_hd(hw_hd->param_hd0, &rc_hd);
+        if (rc_hd) {
+            esp_h264_enc_hw_rc_reset(rc_hd);
+        }
+        esp_h264_enc_hw_get_rc_hd(hw_hd->param_hd1, &rc_hd);
+        if (rc_hd) {
+            esp_h264_enc_hw_rc_reset(rc_hd);
+        }
+        hw_hd->frame_num = 0;
+    }
+    hw_hd->scene_change = false;
     out_frame[0]->dts = in_frame[0]->pts;
     out_frame[0]->pts = in_frame[0]->pts;
     out_frame[0]->frame_type = ESP_H264_FRAME_TYPE_P;
@@ -204,13 +235,30 @@ static esp_h264_err_t enc_process(esp_h264_enc_dual_handle_t enc, esp_h264_enc_i
      *  `mutex` is for thread safety.
     */
     esp_h264_mutex_t mutex;
+    uint32_t enc_bits = 0, mad = 0, qp_sum = 0;
     esp_h264_enc_hw_get_mutex(hw_hd->param_hd0, &mutex);
     esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
     ret |= h264_hw_enc_frame_mode_process(hw_hd, hw_hd->param_hd0, in_frame[0]->raw_data.buffer, out_frame[0]->raw_data.buffer, out_frame[0]->raw_data.len, &out_frame[0]->length);
+    if (ret == ESP_H264_ERR_OK) {
+        esp_h264_enc_hw_mv_done(hw_hd->param_hd0, !hw_hd->frame_num);
+    }
+    if (hw_hd->frame_num) {
+        h264_hal_get_rc_bits_mad_qpsum(&hw_hd->h264_hal, &enc_bits, &mad, &qp_sum);
+        hw_hd->scene_change |= esp_h264_scene_check_mad(scene_hd[0], mad);
+        esp_h264_enc_hw_update_auto_roi(hw_hd->param_hd0);
+    }
     esp_h264_mutex_unlock(mutex);
     esp_h264_enc_hw_get_mutex(hw_hd->param_hd1, &mutex);
     esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
     ret |= h264_hw_enc_frame_mode_process(hw_hd, hw_hd->param_hd1, in_frame[1]->raw_data.buffer, out_frame[1]->raw_data.buffer, out_frame[1]->raw_data.len, &out_frame[1]->length);
+    if (ret == ESP_H264_ERR_OK) {
+        esp_h264_enc_hw_mv_done(hw_hd->param_hd1, !hw_hd->frame_num);
+    }
+    if (hw_hd->frame_num) {
+        h264_hal_get_rc_bits_mad_qpsum(&hw_hd->h264_hal, &enc_bits, &mad, &qp_sum);
+        hw_hd->scene_change |= esp_h264_scene_check_mad(scene_hd[1], mad);
+        esp_h264_enc_hw_update_auto_roi(hw_hd->param_hd1);
+    }
     esp_h264_mutex_unlock(mutex);
     hw_hd->frame_num++;
     return ret;
@@ -255,9 +303,6 @@ static esp_h264_err_t enc_del(esp_h264_enc_dual_handle_t enc)
 {
     if (enc) {
         esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
-        if (hw_hd->db_tmp) {
-            esp_h264_free(hw_hd->db_tmp);
-        }
 
         /** Close the encoder */
         enc_close(enc);
@@ -266,18 +311,8 @@ static esp_h264_err_t enc_del(esp_h264_enc_dual_handle_t enc)
         esp_h264_enc_hw_del_param(hw_hd->param_hd0);
         esp_h264_enc_hw_del_param(hw_hd->param_hd1);
 
-        if (hw_hd->dsc_yuv) {
-            esp_h264_free(hw_hd->dsc_yuv);
-        }
-        if (hw_hd->dsc_dbtmp[0]) {
-            esp_h264_free(hw_hd->dsc_dbtmp[0]);
-        }
-        if (hw_hd->dsc_dbtmp[1]) {
-            esp_h264_free(hw_hd->dsc_dbtmp[1]);
-        }
-        if (hw_hd->dsc_bs) {
-            esp_h264_free(hw_hd->dsc_bs);
-        }
+        /** The descriptors, db_tmp and the regions of parameter handles are in the arena */
+        esp_h264_arena_del(&hw_hd->arena);
         /** Free the encoder */
         esp_h264_free(hw_hd);
     }
@@ -292,6 +327,7 @@ esp_h264_err_t esp_h264_enc_dual_hw_new(const esp_h264_enc_cfg_dual_hw_t *cfg, e
     for (uint8_t i = 0; i < H264_SUP_MAX_CHANNEL; i++) {
         ESP_H264_RET_ON_FALSE((enc_cfg[i].pic_type == ESP_H264_RAW_FMT_O_UYY_E_VYY), ESP_H264_ERR_ARG, TAG, "Un-supported h264 picture type parameter");
         ESP_H264_RET_ON_FALSE((enc_cfg[i].rc.qp_max >= enc_cfg[i].rc.qp_min) && (enc_cfg[i].rc.qp_max <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, TAG, "Invalid h264 QP parameter");
+        ESP_H264_RET_ON_FALSE(enc_cfg[i].rc.mode < ESP_H264_RC_MODE_MAX, ESP_H264_ERR_ARG, TAG, "Invalid h264 RC mode parameter");
         ESP_H264_RET_ON_FALSE((esp_h264_enc_hw_res_check(enc_cfg[i].res.width, enc_cfg[i].res.height) == ESP_H264_ERR_OK), ESP_H264_ERR_ARG, TAG, "Invalid h264 resolution parameter");
         ESP_H264_RET_ON_FALSE((enc_cfg[i].fps > 0) && (enc_cfg[i].gop > 0), ESP_H264_ERR_ARG, TAG, "Invalid h264 FPS and GOP parameter");
     }
@@ -315,6 +351,7 @@ esp_h264_err_t esp_h264_enc_dual_hw_new(const esp_h264_enc_cfg_dual_hw_t *cfg, e
         param_cfg[i].qp_min = enc_cfg[i].rc.qp_min;
         param_cfg[i].qp_max = enc_cfg[i].rc.qp_max;
         param_cfg[i].bitrate = enc_cfg[i].rc.bitrate;
+        param_cfg[i].rc_mode = enc_cfg[i].rc.mode;
         param_cfg[i].fps = enc_cfg[i].fps;
     }
     h264_hal_dma_context_cfg_t cfg_h264_dma_hal = { 0 };
@@ -342,6 +379,20 @@ esp_h264_err_t esp_h264_enc_dual_hw_new(const esp_h264_enc_cfg_dual_hw_t *cfg, e
     /** H.264 DMA HAL initalization*/
     h264_dma_hal_init(&hw_hd->dma2d_hal, &cfg_h264_dma_hal);
 
+    /** One arena in internal RAM holds all the descriptors and working buffers except de-blocking filter data */
+    uint16_t db_tmp_size = esp_h264_enc_hw_max_db_tmp_buffer_size(width);
+    esp_h264_arena_reserve(&hw_hd->arena, db_tmp_size);
+    /** YUV, BS and two db_tmp descriptors */
+    for (size_t i = 0; i < 4; i++) {
+        esp_h264_arena_reserve(&hw_hd->arena, sizeof(h264_dma_desc_t));
+    }
+    for (uint8_t i = 0; i < H264_SUP_MAX_CHANNEL; i++) {
+        esp_h264_enc_hw_reserve_param(&param_cfg[i], &hw_hd->arena);
+        param_cfg[i].arena = &hw_hd->arena;
+    }
+    ret = esp_h264_arena_create(&hw_hd->arena);
+    ESP_H264_GOTO_ON_FALSE(ret == ESP_H264_ERR_OK, ret, __exit__, TAG, "No memory for arena");
+
     /** Get device */
     param_cfg[0].device = h264_hal_get_param_dev0(&hw_hd->h264_hal);
     param_cfg[1].device = h264_hal_get_param_dev1(&hw_hd->h264_hal);
@@ -355,16 +406,16 @@ esp_h264_err_t esp_h264_enc_dual_hw_new(const esp_h264_enc_cfg_dual_hw_t *cfg, e
         esp_h264_enc_set_gop(&param_hd[i]->base, enc_cfg[i].gop);
     }
     /** Allocated de-blocking filter temporary parameter memory*/
-    hw_hd->db_tmp = (uint8_t *)esp_h264_aligned_calloc(16, 1, esp_h264_enc_hw_max_db_tmp_buffer_size(width), &actual_size, ESP_H264_MEM_INTERNAL);
+    hw_hd->db_tmp = (uint8_t *)esp_h264_arena_alloc(&hw_hd->arena, db_tmp_size);
     ESP_H264_GOTO_ON_FALSE(hw_hd->db_tmp != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for db_tmp");
     /** Allocated descriptor memory*/
     for (size_t i = 0; i < 2; i++) {
-        hw_hd->dsc_dbtmp[i] = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+        hw_hd->dsc_dbtmp[i] = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
         ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_dbtmp[i] != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for DB descriptor");
     }
-    hw_hd->dsc_yuv = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    hw_hd->dsc_yuv = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_yuv != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for YUV descriptor");
-    hw_hd->dsc_bs = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    hw_hd->dsc_bs = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_bs != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for BS descriptor");
 
     /** Encoder handle configure */
@@ -14,6 +14,29 @@ static const char *TAG = "H264_ENC.HW.SET";
 #define ESP_H264_ROI_SUP_NUM    (8)
 #define ESP_H264_REDUNDANT_BYTE (8 + 64)
 #define SPS_PPS_BUF_SIZE        (100)
+/* The macroblock layer is no more than `128 + RawMbBits * 189 / 100` bits (A.3.1 of H.264 spec) */
+#define H264_MB_BYTES_MAX       ((128 + 384 * 8 * 189 / 100 + 7) >> 3)
+#define H264_MB_BYTES_MIN       (2)
+/* The macroblock bits nearly halve every 6 QP */
+#define H264_MB_QP_HALF         (6)
+/* The frame is rarely more than twice the largest recent frame of the same type */
+#define H264_RC_SIZE_MARGIN     (2)
+/* Start code + NAL header + slice header + 8 bytes alignment of bitstream */
+#define H264_SLICE_HEADER_SIZE  (32)
+
+#define H264_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define H264_MAX(a, b) ((a) > (b) ? (a) : (b))
+
+/* Hardware registers of one encoder. They are restored when the encoder gets the hardware back from the working buffer pool. */
+typedef struct {
+    uint8_t                qp;
+    int8_t                 mv_mode;
+    uint8_t                mv_fmt;
+    bool                   roi_en;
+    uint8_t                roi_mode;
+    int8_t                 none_roi_delta_qp;
+    esp_h264_enc_roi_reg_t roi_reg[ESP_H264_ROI_SUP_NUM];
+} esp_h264_param_regs_t;
 
 typedef struct esp_h264_param {
     esp_h264_enc_param_hw_t    hw_base;
@@ -21,12 +44,23 @@ typedef struct esp_h264_param {
     uint8_t                    fps;
     uint8_t                    gop;
     esp_h264_rc_hd_t           rc_hd;
+    bool                       rc_en;
+    esp_h264_scene_hd_t        scene_hd;
     uint8_t                    qp_init;
+    uint8_t                    qp_min;
+    int8_t                     frame_qp;
+    uint8_t                   *qp_map_mask;
+    esp_h264_mv_roi_hd_t       mv_roi_hd;
+    uint8_t                   *mv_roi_buf;
+    esp_h264_mv_ring_hd_t      mv_ring_hd;
     uint32_t                   bitrate;
     uint16_t                   width;
     uint16_t                   height;
     uint8_t                    mb_width;
     uint8_t                    mb_height;
+    uint8_t                    mb_width_max;
+    uint8_t                    mb_height_max;
+    uint16_t                   mb_cnt_max;
     uint8_t                   *nal_buf;
     uint8_t                    nal_buf_len;
     uint16_t                   nal_bit_len;
@@ -34,6 +68,9 @@ typedef struct esp_h264_param {
     uint32_t                   mvm_buf_len;
     uint8_t                   *db;
     uint8_t                   *ref;
+    bool                       work_buf_ext;
+    esp_h264_arena_t           arena;
+    esp_h264_param_regs_t      regs;
     h264_dma_desc_t           *dsc_ref;
     h264_dma_desc_t           *dsc_db[4];
     h264_dma_desc_t           *dsc_mvm;
@@ -136,8 +173,8 @@ static esp_h264_err_t set_roi_reg(esp_h264_enc_param_hw_handle_t handle, esp_h26
     ESP_H264_RET_ON_FALSE(roi_reg.reg_idx < ESP_H264_ROI_SUP_NUM, ESP_H264_ERR_ARG, TAG, "Invalid `reg_idx` parameter");
     int16_t x_size = roi_reg.len_x + roi_reg.x;
     int16_t y_size = roi_reg.len_y + roi_reg.y;
-    ESP_H264_RET_ON_FALSE(x_size <= param->mb_width, ESP_H264_ERR_ARG, TAG, "The sum of `len_x` and `x` is gather than `mb_width` ");
-    ESP_H264_RET_ON_FALSE(y_size <= param->mb_height, ESP_H264_ERR_ARG, TAG, "The sum of `len_y` and `y` is gather than `mb_height` ");
+    ESP_H264_RET_ON_FALSE(x_size <= param->mb_width, ESP_H264_ERR_ARG, TAG, "The sum of `len_x` and `x` is greater than `mb_width` ");
+    ESP_H264_RET_ON_FALSE(y_size <= param->mb_height, ESP_H264_ERR_ARG, TAG, "The sum of `len_y` and `y` is greater than `mb_height` ");
     uint8_t roi_mode = 0;
     int8_t none_roi_delta_qp = 0;
     /* Check ROI function enable*/
@@ -220,6 +257,245 @@ static esp_h264_err_t get_mv_data_len(esp_h264_enc_param_hw_handle_t handle, uin
     return ESP_H264_ERR_OK;
 }
 
+static esp_h264_err_t cfg_mv_ring(esp_h264_enc_param_hw_handle_t handle, uint8_t depth)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    if (param->mv_ring_hd) {
+        ESP_H264_GOTO_ON_FALSE(!esp_h264_mv_ring_is_held(param->mv_ring_hd), ESP_H264_ERR_FAIL, __exit__, TAG, "Please release all MV packets first");
+        esp_h264_enc_hw_mv_ring_del(param->mv_ring_hd);
+        param->mv_ring_hd = NULL;
+    }
+    if (depth) {
+        param->mv_ring_hd = esp_h264_enc_hw_mv_ring_new(depth, param->mb_cnt_max * sizeof(esp_h264_enc_mv_data_t));
+        ESP_H264_GOTO_ON_FALSE(param->mv_ring_hd, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for MV buffer ring");
+    }
+__exit__:
+    esp_h264_mutex_unlock(param->mutex);
+    return ret;
+}
+
+static esp_h264_err_t acquire_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t *mv_pkt)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    /** The ring has its own lock. So it doesn't wait for the encoding in progress. */
+    if (param->mv_ring_hd == NULL) {
+        return ESP_H264_ERR_FAIL;
+    }
+    return esp_h264_mv_ring_acquire(param->mv_ring_hd, mv_pkt);
+}
+
+static esp_h264_err_t release_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t mv_pkt)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    if (param->mv_ring_hd == NULL) {
+        return ESP_H264_ERR_ARG;
+    }
+    return esp_h264_mv_ring_release(param->mv_ring_hd, &mv_pkt);
+}
+
+static esp_h264_err_t cfg_scene(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    esp_h264_enc_hw_scene_cfg(param->scene_hd, &cfg);
+    esp_h264_mutex_unlock(param->mutex);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t get_scene_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t *cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_enc_hw_scene_get_cfg(param->scene_hd, cfg);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t cfg_skip(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    esp_h264_err_t ret = esp_h264_enc_hw_scene_skip_cfg(param->scene_hd, &cfg);
+    esp_h264_mutex_unlock(param->mutex);
+    ESP_H264_RET_ON_FALSE(ret == ESP_H264_ERR_OK, ret, TAG, "No memory for frame skipping");
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t get_skip_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t *cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_enc_hw_scene_get_skip_cfg(param->scene_hd, cfg);
+    return ESP_H264_ERR_OK;
+}
+
+typedef struct {
+    uint8_t  x;
+    uint8_t  y;
+    uint8_t  len_x;
+    uint8_t  len_y;
+    int8_t   qp;
+    uint32_t weight;
+} qp_map_rect_t;
+
+static void qp_map_rect_insert(qp_map_rect_t *rect, uint8_t *rect_num, const qp_map_rect_t *new_rect)
+{
+    /** `rect` is sorted by weight in descending order. The lightest one is dropped when it is full. */
+    uint8_t i = *rect_num;
+    if (i == ESP_H264_ROI_SUP_NUM) {
+        if (rect[i - 1].weight >= new_rect->weight) {
+            return;
+        }
+        i--;
+    } else {
+        (*rect_num)++;
+    }
+    while ((i > 0) && (rect[i - 1].weight < new_rect->weight)) {
+        rect[i] = rect[i - 1];
+        i--;
+    }
+    rect[i] = *new_rect;
+}
+
+static esp_h264_err_t set_qp_map(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_qp_map_t qp_map)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    const int8_t *map = qp_map.delta_qp_map;
+    uint16_t hist[(ESP_H264_QP_MAX << 1) + 1] = { 0 };
+    /** The resolution is changed by reconfiguration. So the mutex is held from the length check to the end of mask build. */
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    uint32_t mb_cnt = param->mb_width * param->mb_height;
+    ESP_H264_GOTO_ON_FALSE(!map || (qp_map.map_len == mb_cnt), ESP_H264_ERR_ARG, __exit__, TAG, "The length of delta QP map isn't `mb_width * mb_height`");
+    if (map == NULL) {
+        h264_hal_set_roi_mode(param->device, (int8_t)ESP_H264_ROI_MODE_DISABLE, 0);
+        param->frame_qp = qp_map.frame_qp;
+        h264_hal_set_qp(param->device, qp_map.frame_qp >= 0 ? qp_map.frame_qp : param->qp_init);
+        goto __exit__;
+    }
+    /** The most frequent delta QP is the none ROI region delta QP */
+    for (uint32_t i = 0; i < mb_cnt; i++) {
+        ESP_H264_GOTO_ON_FALSE((map[i] >= -ESP_H264_QP_MAX) && (map[i] <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, __exit__, TAG, "The delta QP of map is out of [-51, 51]");
+        hist[map[i] + ESP_H264_QP_MAX]++;
+    }
+    int8_t bg_qp = 0;
+    for (int16_t i = 0; i < sizeof(hist) / sizeof(hist[0]); i++) {
+        if (hist[i] > hist[bg_qp + ESP_H264_QP_MAX]) {
+            bg_qp = i - ESP_H264_QP_MAX;
+        }
+    }
+    if (param->qp_map_mask == NULL) {
+        uint32_t actual_size;
+        /** It is sized for the resolution at creation. So it is kept after reconfiguration. */
+        param->qp_map_mask = esp_h264_calloc_prefer(1, param->mb_cnt_max, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+        ESP_H264_GOTO_ON_FALSE(param->qp_map_mask, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for QP map");
+    }
+    /** Split the map into uniform rectangles in raster order. Each one grows right first, and then down.
+     *  The heaviest rectangles, area multiplied by QP difference with none ROI region, are kept in ROI registers.
+     *  The others fall back to the none ROI region delta QP. */
+    uint8_t *mask = param->qp_map_mask;
+    memset(mask, 0, mb_cnt);
+    qp_map_rect_t rect[ESP_H264_ROI_SUP_NUM];
+    uint8_t rect_num = 0;
+    for (uint8_t y = 0; y < param->mb_height; y++) {
+        for (uint8_t x = 0; x < param->mb_width; x++) {
+            uint32_t idx = y * param->mb_width + x;
+            if (mask[idx] || (map[idx] == bg_qp)) {
+                continue;
+            }
+            int8_t qp = map[idx];
+            uint8_t len_x = 1;
+            while ((x + len_x < param->mb_width) && !mask[idx + len_x] && (map[idx + len_x] == qp)) {
+                len_x++;
+            }
+            uint8_t len_y = 1;
+            while (y + len_y < param->mb_height) {
+                uint32_t line = idx + len_y * param->mb_width;
+                uint8_t i = 0;
+                while ((i < len_x) && !mask[line + i] && (map[line + i] == qp)) {
+                    i++;
+                }
+                if (i < len_x) {
+                    break;
+                }
+                len_y++;
+            }
+            for (uint8_t j = 0; j < len_y; j++) {
+                memset(&mask[idx + j * param->mb_width], 1, len_x);
+            }
+            qp_map_rect_t new_rect = {
+                .x = x,
+                .y = y,
+                .len_x = len_x,
+                .len_y = len_y,
+                .qp = qp,
+                .weight = (uint32_t)len_x * len_y * (qp > bg_qp ? qp - bg_qp : bg_qp - qp),
+            };
+            qp_map_rect_insert(rect, &rect_num, &new_rect);
+        }
+    }
+    h264_hal_set_roi_mode(param->device, (int8_t)ESP_H264_ROI_MODE_DELTA_QP, bg_qp);
+    for (uint8_t i = 0; i < ESP_H264_ROI_SUP_NUM; i++) {
+        if (i < rect_num) {
+            h264_hal_set_roi_reg(param->device, true, rect[i].x, rect[i].y, rect[i].len_x, rect[i].len_y, rect[i].qp, i);
+        } else {
+            h264_hal_set_roi_reg(param->device, false, 0, 0, 0, 0, 0, i);
+        }
+    }
+    param->frame_qp = qp_map.frame_qp;
+    h264_hal_set_qp(param->device, qp_map.frame_qp >= 0 ? qp_map.frame_qp : param->qp_init);
+__exit__:
+    esp_h264_mutex_unlock(param->mutex);
+    return ret;
+}
+
+static esp_h264_err_t cfg_auto_roi(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    uint32_t mv_buf_len = param->mb_cnt_max * sizeof(esp_h264_enc_mv_data_t);
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    ret = esp_h264_enc_hw_mv_roi_cfg(param->mv_roi_hd, &cfg);
+    ESP_H264_GOTO_ON_FALSE(ret == ESP_H264_ERR_OK, ret, __exit__, TAG, "No memory for MV driven ROI");
+    if (cfg.enable) {
+        if (param->mvm_buf == NULL) {
+            /** No MV packet from application. The MV buffer is owned by encoder. */
+            uint32_t actual_size;
+            param->mv_roi_buf = esp_h264_aligned_calloc(16, 1, mv_buf_len, &actual_size, ESP_H264_MEM_INTERNAL);
+            ESP_H264_GOTO_ON_FALSE(param->mv_roi_buf, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for MV buffer");
+            param->mvm_buf = param->mv_roi_buf;
+            param->mvm_buf_len = mv_buf_len;
+        }
+        int8_t mv_mode = 0;
+        uint8_t mv_fmt = 0;
+        h264_hal_get_mv_mode(param->device, &mv_mode, &mv_fmt);
+        if (mv_mode == ESP_H264_MVM_MODE_DISABLE) {
+            h264_hal_set_mv_mode(param->device, (int8_t)ESP_H264_MVM_MODE_P16X16, (uint8_t)ESP_H264_MVM_FMT_ALL);
+        }
+        h264_hal_set_roi_mode(param->device, (int8_t)ESP_H264_ROI_MODE_DELTA_QP, cfg.none_roi_delta_qp);
+    } else {
+        if (param->mv_roi_buf && (param->mvm_buf == param->mv_roi_buf)) {
+            h264_hal_set_mv_mode(param->device, (int8_t)ESP_H264_MVM_MODE_DISABLE, 0);
+            param->mvm_buf = NULL;
+            param->mvm_buf_len = 0;
+        }
+        h264_hal_set_roi_mode(param->device, (int8_t)ESP_H264_ROI_MODE_DISABLE, 0);
+    }
+    if (param->mv_roi_buf && (param->mvm_buf != param->mv_roi_buf)) {
+        esp_h264_free(param->mv_roi_buf);
+        param->mv_roi_buf = NULL;
+    }
+__exit__:
+    esp_h264_mutex_unlock(param->mutex);
+    return ret;
+}
+
+static esp_h264_err_t get_auto_roi_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t *cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_enc_hw_mv_roi_get_cfg(param->mv_roi_hd, cfg);
+    return ESP_H264_ERR_OK;
+}
+
 static int max_refame_buffer_size(int16_t mb_width)
 {
     /** H264_DMA_MACRO_SIZE + H264_DMA_HALF_MACRO_SIZE : Y(16) + U(4) + V(4) */
@@ -253,35 +529,90 @@ esp_h264_err_t esp_h264_enc_hw_del_param(esp_h264_enc_param_hw_handle_t handle)
 {
     if (handle) {
         esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
-        if (param->nal_buf) {
-            esp_h264_free(param->nal_buf);
-        }
-        if (param->ref) {
-            esp_h264_free(param->ref);
-        }
-        if (param->db) {
+        /** The working buffers from pool are freed by pool */
+        if (param->db && !param->work_buf_ext) {
             esp_h264_free(param->db);
         }
-        if (param->dsc_ref) {
-            esp_h264_free(param->dsc_ref);
-        }
-        for (size_t i = 0; i < 4; i++) {
-            if (param->dsc_db[i]) {
-                esp_h264_free(param->dsc_db[i]);
-            }
+        esp_h264_enc_hw_rc_del(param->rc_hd);
+        esp_h264_enc_hw_scene_del(param->scene_hd);
+        if (param->qp_map_mask) {
+            esp_h264_free(param->qp_map_mask);
         }
-        if (param->dsc_mvm) {
-            esp_h264_free(param->dsc_mvm);
+        esp_h264_enc_hw_mv_roi_del(param->mv_roi_hd);
+        esp_h264_enc_hw_mv_ring_del(param->mv_ring_hd);
+        if (param->mv_roi_buf) {
+            esp_h264_free(param->mv_roi_buf);
         }
-        esp_h264_enc_hw_rc_del(param->rc_hd);
         if (param->mutex) {
             esp_h264_mutex_delete(param->mutex);
         }
+        /** The NAL buffer, reference frame buffer and descriptors are in the arena */
+        esp_h264_arena_del(&param->arena);
         esp_h264_free(param);
     }
     return ESP_H264_ERR_OK;
 }
 
+esp_h264_err_t esp_h264_enc_hw_reconfig_param(esp_h264_enc_param_hw_handle_t handle, const esp_h264_enc_hw_param_cfg_t *cfg)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    uint8_t mb_width = (cfg->width + 15) >> 4;
+    uint8_t mb_height = (cfg->height + 15) >> 4;
+    ESP_H264_RET_ON_FALSE((mb_width <= param->mb_width_max) && (mb_height <= param->mb_height_max), ESP_H264_ERR_ARG, TAG, "The resolution is greater than the allocated one");
+    param->width = cfg->width;
+    param->height = cfg->height;
+    param->mb_width = mb_width;
+    param->mb_height = mb_height;
+    param->qp_init = (cfg->qp_min + cfg->qp_max) >> 1;
+    param->qp_min = cfg->qp_min;
+    param->fps = cfg->fps;
+    param->bitrate = cfg->bitrate;
+    /** The handles and buffers are reused. Only their state is reset for the new resolution. */
+    esp_h264_enc_hw_rc_reinit(param->rc_hd, cfg->qp_max, cfg->qp_min, param->bitrate, param->fps, mb_width, mb_height, cfg->rc_mode);
+    param->rc_en = cfg->qp_min < cfg->qp_max;
+    h264_hal_set_rc_qp(param->device, false, cfg->qp_min, cfg->qp_max);
+    esp_h264_enc_hw_scene_set_res(param->scene_hd, param->width, param->height, mb_width * mb_height);
+    esp_h264_enc_hw_mv_roi_set_res(param->mv_roi_hd, mb_width, mb_height);
+    /** SPS + PPS */
+    param->nal_bit_len = esp_h264_enc_set_sps(param->nal_buf, param->nal_buf_len, param->height, param->width, param->fps);
+    param->nal_bit_len += esp_h264_enc_set_pps(param->nal_buf + (param->nal_bit_len >> 3), param->nal_buf_len - (param->nal_bit_len >> 3), param->qp_init, true);
+    return ESP_H264_ERR_OK;
+}
+
+void esp_h264_enc_hw_program_reconfig(esp_h264_enc_param_hw_handle_t handle)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    h264_hal_set_mbres(param->device, param->mb_width, param->mb_height);
+    h264_hal_set_qp(param->device, param->frame_qp >= 0 ? param->frame_qp : param->qp_init);
+}
+
+void esp_h264_enc_hw_reserve_param(const esp_h264_enc_hw_param_cfg_t *cfg, esp_h264_arena_t *arena)
+{
+    esp_h264_arena_reserve(arena, SPS_PPS_BUF_SIZE);
+    if (!(cfg->ref && cfg->db)) {
+        esp_h264_arena_reserve(arena, max_refame_buffer_size((cfg->width + 15) >> 4));
+    }
+    /** Reference, DB and MVM descriptors */
+    for (size_t i = 0; i < 6; i++) {
+        esp_h264_arena_reserve(arena, sizeof(h264_dma_desc_t));
+    }
+}
+
+void esp_h264_enc_hw_add_param_mem_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_hw_mem_info_t *info)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    info->handle += sizeof(esp_h264_param_t);
+    info->desc += 6 * esp_h264_arena_region_size(sizeof(h264_dma_desc_t));
+    info->nal += esp_h264_arena_region_size(param->nal_buf_len);
+    if (!param->work_buf_ext) {
+        info->ref += esp_h264_arena_region_size(max_refame_buffer_size(param->mb_width_max));
+        info->db += max_db_buffer_size(param->mb_width_max, param->mb_height_max);
+        info->total += max_db_buffer_size(param->mb_width_max, param->mb_height_max);
+    }
+    info->arena += param->arena.size;
+    info->total += sizeof(esp_h264_param_t) + param->arena.size;
+}
+
 esp_h264_err_t esp_h264_enc_hw_new_param(esp_h264_enc_hw_param_cfg_t *cfg, esp_h264_enc_param_hw_handle_t *out_handle)
 {
     /* Parameter check */
@@ -299,40 +630,67 @@ esp_h264_err_t esp_h264_enc_hw_new_param(esp_h264_enc_hw_param_cfg_t *cfg, esp_h
     param->width = cfg->width;
     param->height = cfg->height;
     param->qp_init = (cfg->qp_min + cfg->qp_max) >> 1;
+    param->qp_min = cfg->qp_min;
+    param->frame_qp = -1;
     param->fps = cfg->fps;
     param->bitrate = cfg->bitrate;
     h264_hal_set_qp(param->device, param->qp_init);
     h264_hal_get_mbres(param->device, &param->mb_width, &param->mb_height);
+    param->mb_width_max = param->mb_width;
+    param->mb_height_max = param->mb_height;
+    param->mb_cnt_max = param->mb_width * param->mb_height;
 
-    /** Create RC handle */
-    if (cfg->qp_min < cfg->qp_max) {
-        param->rc_hd = esp_h264_enc_hw_rc_new(cfg->qp_max, cfg->qp_min, param->bitrate, param->fps, param->mb_width, param->mb_height);
-        ESP_H264_GOTO_ON_FALSE(param->rc_hd, ret, __exit__, TAG, "No memory for RC");
+    /** All the regions below are taken from one arena. It is created here if caller doesn't provide it. */
+    esp_h264_arena_t *arena = cfg->arena;
+    if (arena == NULL) {
+        arena = &param->arena;
+        esp_h264_enc_hw_reserve_param(cfg, arena);
+        ret = esp_h264_arena_create(arena);
+        ESP_H264_GOTO_ON_FALSE(ret == ESP_H264_ERR_OK, ret, __exit__, TAG, "No memory for arena");
     }
+
+    /** Create RC handle. It is kept with fixed QP too, so RC can be enabled by reconfiguration. */
+    param->rc_hd = esp_h264_enc_hw_rc_new(cfg->qp_max, cfg->qp_min, param->bitrate, param->fps, param->mb_width, param->mb_height, cfg->rc_mode);
+    ESP_H264_GOTO_ON_FALSE(param->rc_hd, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for RC");
+    param->rc_en = cfg->qp_min < cfg->qp_max;
+    /** The MB level RC of hardware is off. The frame QP is from software RC, so capped quality mode keeps it for every MB. */
+    h264_hal_set_rc_qp(param->device, false, cfg->qp_min, cfg->qp_max);
+    /** Create scene change detection handle. It is disabled by default. */
+    param->scene_hd = esp_h264_enc_hw_scene_new(param->width, param->height, param->mb_width * param->mb_height);
+    ESP_H264_GOTO_ON_FALSE(param->scene_hd, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for scene change detection");
+    /** Create MV driven ROI handle. It is disabled by default. */
+    param->mv_roi_hd = esp_h264_enc_hw_mv_roi_new(param->mb_width, param->mb_height);
+    ESP_H264_GOTO_ON_FALSE(param->mv_roi_hd, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for MV driven ROI");
     /** Disable MV */
     h264_hal_set_mv_mode(param->device, (int8_t)ESP_H264_MVM_MODE_DISABLE, 0);
 
     /** SPS + PPS */
     param->nal_buf_len = SPS_PPS_BUF_SIZE;
-    param->nal_buf = (uint8_t *)esp_h264_calloc_prefer(1, param->nal_buf_len, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    param->nal_buf = (uint8_t *)esp_h264_arena_alloc(arena, param->nal_buf_len);
     ESP_H264_GOTO_ON_FALSE(param->nal_buf, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for NAL");
     param->nal_bit_len = esp_h264_enc_set_sps(param->nal_buf, param->nal_buf_len, param->height, param->width, param->fps);
     param->nal_bit_len += esp_h264_enc_set_pps(param->nal_buf + (param->nal_bit_len >> 3), param->nal_buf_len - (param->nal_bit_len >> 3), param->qp_init, true);
 
     /** Allocated reference frame and DB memory */
-    param->ref = (uint8_t *)esp_h264_aligned_calloc(16, 1, max_refame_buffer_size(param->mb_width), &actual_size, ESP_H264_MEM_INTERNAL);
-    ESP_H264_GOTO_ON_FALSE(param->ref, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for reference frame");
-    param->db = (uint8_t *)esp_h264_calloc_prefer(1, max_db_buffer_size(param->mb_width, param->mb_height), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
-    ESP_H264_GOTO_ON_FALSE(param->db, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for data");
+    if (cfg->ref && cfg->db) {
+        param->ref = cfg->ref;
+        param->db = cfg->db;
+        param->work_buf_ext = true;
+    } else {
+        param->ref = (uint8_t *)esp_h264_arena_alloc(arena, max_refame_buffer_size(param->mb_width));
+        ESP_H264_GOTO_ON_FALSE(param->ref, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for reference frame");
+        param->db = (uint8_t *)esp_h264_calloc_prefer(1, max_db_buffer_size(param->mb_width, param->mb_height), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+        ESP_H264_GOTO_ON_FALSE(param->db, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for data");
+    }
 
     /** Allocated descriptor memory*/
-    param->dsc_ref = (h264_dma_desc_t *)esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    param->dsc_ref = (h264_dma_desc_t *)esp_h264_arena_alloc(arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(param->dsc_ref, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for reference descriptor");
     for (size_t i = 0; i < 4; i++) {
-        param->dsc_db[i] = (h264_dma_desc_t *)esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+        param->dsc_db[i] = (h264_dma_desc_t *)esp_h264_arena_alloc(arena, sizeof(h264_dma_desc_t));
         ESP_H264_GOTO_ON_FALSE(param->dsc_db[i], ESP_H264_ERR_MEM, __exit__, TAG, "No memory for DB descriptor");
     }
-    param->dsc_mvm = (h264_dma_desc_t *)esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    param->dsc_mvm = (h264_dma_desc_t *)esp_h264_arena_alloc(arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(param->dsc_mvm, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for MVM descriptor");
 
     /** Create MUTEX */
@@ -355,6 +713,16 @@ esp_h264_err_t esp_h264_enc_hw_new_param(esp_h264_enc_hw_param_cfg_t *cfg, esp_h
     param->hw_base.get_roi_cfg_info = get_roi_cfg_info;
     param->hw_base.set_roi_reg = set_roi_reg;
     param->hw_base.get_roi_reg = get_roi_reg;
+    param->hw_base.cfg_scene = cfg_scene;
+    param->hw_base.get_scene_cfg_info = get_scene_cfg_info;
+    param->hw_base.cfg_skip = cfg_skip;
+    param->hw_base.set_qp_map = set_qp_map;
+    param->hw_base.cfg_auto_roi = cfg_auto_roi;
+    param->hw_base.get_auto_roi_cfg_info = get_auto_roi_cfg_info;
+    param->hw_base.get_skip_cfg_info = get_skip_cfg_info;
+    param->hw_base.cfg_mv_ring = cfg_mv_ring;
+    param->hw_base.acquire_mv_pkt = acquire_mv_pkt;
+    param->hw_base.release_mv_pkt = release_mv_pkt;
     *out_handle = &param->hw_base;
     return ret;
 __exit__:
@@ -409,14 +777,24 @@ esp_h264_err_t esp_h264_enc_hw_cfg_dma_db_ref(esp_h264_enc_param_hw_handle_t han
     return ESP_H264_ERR_OK;
 }
 
-esp_h264_err_t esp_h264_enc_hw_cfg_dma_yuv_bs(esp_h264_enc_param_hw_handle_t handle, h264_dma_hal_context_t *dma2d_hal, h264_dma_desc_t *dsc_yuv, uint8_t *buf_yuv, h264_dma_desc_t *dsc_bs, uint8_t *buf_bs, uint32_t buf_bs_len)
+esp_h264_err_t esp_h264_enc_hw_cfg_dma_yuv_bs(esp_h264_enc_param_hw_handle_t handle, h264_dma_hal_context_t *dma2d_hal, h264_dma_desc_t *dsc_yuv, uint8_t *buf_yuv, h264_dma_desc_t *dsc_bs, uint8_t *buf_bs, uint32_t buf_bs_len,
+                                         h264_dma_desc_t *dsc_seg, const esp_h264_pkt_t *seg, uint8_t seg_num)
 {
     esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
     cfg_dsc(dsc_yuv, H264_DMA_2D_ENABLE, H264_DMA_MODE1, H264_DMA_MACRO_SIZE, H264_DMA_MACRO_SIZE * H264_DMA_4_LINES, H264_DMA_EOF_CONTINUE, H264_DMA_OWNER_H264,
             param->height, param->width, buf_yuv, NULL);
     h264_dma_hal_cfg_yuv_dsc(dma2d_hal, (uint32_t)dsc_yuv);
-    cfg_dsc(dsc_bs, H264_DMA_2D_DISABLE, H264_DMA_MODE0, buf_bs_len & H264_DMA_MAX_SIZE, 0, H264_DMA_EOF_END, H264_DMA_OWNER_H264, (buf_bs_len >> H264_DMA_SIZE_BIT),
-            0, buf_bs, NULL);
+    /** The bitstream continues in the next segment when the current one is full. The descriptors are linked from the last one. */
+    h264_dma_desc_t *next_dsc = NULL;
+    uint8_t eof = H264_DMA_EOF_END;
+    for (int i = seg_num - 1; i >= 0; i--) {
+        cfg_dsc(&dsc_seg[i], H264_DMA_2D_DISABLE, H264_DMA_MODE0, seg[i].len & H264_DMA_MAX_SIZE, 0, eof, H264_DMA_OWNER_H264, (seg[i].len >> H264_DMA_SIZE_BIT),
+                0, seg[i].buffer, next_dsc);
+        next_dsc = &dsc_seg[i];
+        eof = H264_DMA_EOF_CONTINUE;
+    }
+    cfg_dsc(dsc_bs, H264_DMA_2D_DISABLE, H264_DMA_MODE0, buf_bs_len & H264_DMA_MAX_SIZE, 0, eof, H264_DMA_OWNER_H264, (buf_bs_len >> H264_DMA_SIZE_BIT),
+            0, buf_bs, next_dsc);
     h264_dma_hal_cfg_bs_dsc(dma2d_hal, (uint32_t)dsc_bs);
     return ESP_H264_ERR_OK;
 }
@@ -442,11 +820,16 @@ esp_h264_err_t esp_h264_enc_hw_cfg_dma_mvm(esp_h264_enc_param_hw_handle_t handle
     if (mv_mode == ESP_H264_MVM_MODE_DISABLE) {
         return ESP_H264_ERR_OK;
     }
-    if (param->mvm_buf == NULL) {
+    uint8_t *mvm_buf = param->mvm_buf;
+    uint32_t mvm_buf_len = param->mvm_buf_len;
+    if (param->mv_ring_hd) {
+        mvm_buf = esp_h264_mv_ring_hw_get(param->mv_ring_hd, &mvm_buf_len);
+    }
+    if (mvm_buf == NULL) {
         return ESP_H264_ERR_FAIL;
     }
-    cfg_dsc(param->dsc_mvm, H264_DMA_2D_DISABLE, H264_DMA_MODE0, param->mvm_buf_len & H264_DMA_MAX_SIZE, 0, H264_DMA_EOF_END, H264_DMA_OWNER_H264,
-            (param->mvm_buf_len >> H264_DMA_SIZE_BIT), 0, param->mvm_buf, NULL);
+    cfg_dsc(param->dsc_mvm, H264_DMA_2D_DISABLE, H264_DMA_MODE0, mvm_buf_len & H264_DMA_MAX_SIZE, 0, H264_DMA_EOF_END, H264_DMA_OWNER_H264,
+            (mvm_buf_len >> H264_DMA_SIZE_BIT), 0, mvm_buf, NULL);
     h264_dma_hal_cfg_mvm_dsc(dma2d_hal, (uint32_t)param->dsc_mvm);
     return ESP_H264_ERR_OK;
 }
@@ -458,10 +841,122 @@ esp_h264_err_t esp_h264_enc_hw_set_qp(esp_h264_enc_param_hw_handle_t handle, uin
     return ESP_H264_ERR_OK;
 }
 
+esp_h264_err_t esp_h264_enc_hw_get_frame_qp(esp_h264_enc_param_hw_handle_t handle, int8_t *out_frame_qp)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    *out_frame_qp = param->frame_qp;
+    return ESP_H264_ERR_OK;
+}
+
+/* The lowest QP of the next frame, including ROI regions */
+static int8_t frame_qp_floor(esp_h264_param_t *param)
+{
+    int8_t qp = param->frame_qp >= 0 ? param->frame_qp : param->qp_min;
+    int8_t qp_low = qp;
+    uint8_t roi_mode = 0;
+    int8_t none_roi_delta_qp = 0;
+    if (h264_hal_get_roi_mode(param->device, &roi_mode, &none_roi_delta_qp)) {
+        qp_low = H264_MIN(qp_low, qp + none_roi_delta_qp);
+        for (uint8_t i = 0; i < ESP_H264_ROI_SUP_NUM; i++) {
+            esp_h264_enc_roi_reg_t roi_reg = { .reg_idx = i };
+            h264_hal_get_roi_reg(param->device, &roi_reg.x, &roi_reg.y, &roi_reg.len_x, &roi_reg.len_y, &roi_reg.qp, i);
+            if (roi_reg.len_x && roi_reg.len_y) {
+                qp_low = H264_MIN(qp_low, (roi_mode == ESP_H264_ROI_MODE_FIX_QP) ? roi_reg.qp : qp + roi_reg.qp);
+            }
+        }
+    }
+    return qp_low < 0 ? 0 : qp_low;
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_frame_size_max(esp_h264_enc_param_hw_handle_t handle, bool is_iframe, uint32_t *out_size)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    uint32_t mb_bytes = H264_MB_BYTES_MAX >> (frame_qp_floor(param) / H264_MB_QP_HALF);
+    uint32_t size = param->mb_width * param->mb_height * H264_MAX(mb_bytes, H264_MB_BYTES_MIN);
+    if (param->rc_en && (param->frame_qp < 0)) {
+        /** The recent frames of the same type are much tighter than the QP bound */
+        uint32_t rc_size = (esp_h264_rc_get_frame_bits_max(param->rc_hd, is_iframe) >> 3) * H264_RC_SIZE_MARGIN;
+        if (rc_size) {
+            size = H264_MIN(size, rc_size);
+        }
+    }
+    size += H264_SLICE_HEADER_SIZE;
+    if (is_iframe) {
+        size += param->nal_bit_len >> 3;
+    }
+    esp_h264_mutex_unlock(param->mutex);
+    *out_size = size;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_mv_done(esp_h264_enc_param_hw_handle_t handle, bool is_iframe)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    int8_t mv_mode = 0;
+    uint8_t mv_fmt = 0;
+    h264_hal_get_mv_mode(param->device, &mv_mode, &mv_fmt);
+    if ((param->mv_ring_hd == NULL) || (mv_mode == ESP_H264_MVM_MODE_DISABLE)) {
+        return ESP_H264_ERR_OK;
+    }
+    if (is_iframe) {
+        /** The hardware hasn't written the buffer. The length register still has the last P-frame. */
+        esp_h264_mv_ring_hw_cancel(param->mv_ring_hd);
+        return ESP_H264_ERR_OK;
+    }
+    esp_h264_mv_ring_hw_done(param->mv_ring_hd, h264_hal_get_mvm_data_len(param->device));
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_update_auto_roi(esp_h264_enc_param_hw_handle_t handle)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_enc_auto_roi_cfg_t cfg;
+    esp_h264_enc_hw_mv_roi_get_cfg(param->mv_roi_hd, &cfg);
+    if (!cfg.enable) {
+        return ESP_H264_ERR_OK;
+    }
+    const esp_h264_enc_mv_data_t *mv = NULL;
+    uint32_t mv_num = 0;
+    if (param->mv_ring_hd) {
+        /** The MV buffer of ring is invalidated when it is done */
+        mv = esp_h264_mv_ring_last(param->mv_ring_hd, &mv_num);
+    } else if (param->mvm_buf) {
+        mv = (const esp_h264_enc_mv_data_t *)param->mvm_buf;
+        mv_num = h264_hal_get_mvm_data_len(param->device);
+        if (mv_num * sizeof(esp_h264_enc_mv_data_t) > param->mvm_buf_len) {
+            mv_num = param->mvm_buf_len / sizeof(esp_h264_enc_mv_data_t);
+        }
+        esp_h264_cache_check_and_invalidate(param->mvm_buf, param->mvm_buf_len);
+    }
+    if (mv == NULL) {
+        return ESP_H264_ERR_OK;
+    }
+    esp_h264_enc_roi_reg_t roi_reg[ESP_H264_MV_ROI_MAX_NUM];
+    uint8_t roi_num = esp_h264_mv_roi_cluster(param->mv_roi_hd, mv, mv_num, roi_reg);
+    /** The ROI mode may be changed by application */
+    h264_hal_set_roi_mode(param->device, (int8_t)ESP_H264_ROI_MODE_DELTA_QP, cfg.none_roi_delta_qp);
+    for (uint8_t i = 0; i < ESP_H264_ROI_SUP_NUM; i++) {
+        if (i < roi_num) {
+            h264_hal_set_roi_reg(param->device, true, roi_reg[i].x, roi_reg[i].y, roi_reg[i].len_x, roi_reg[i].len_y, roi_reg[i].qp, i);
+        } else {
+            h264_hal_set_roi_reg(param->device, false, 0, 0, 0, 0, 0, i);
+        }
+    }
+    return ESP_H264_ERR_OK;
+}
+
 esp_h264_err_t esp_h264_enc_hw_get_rc_hd(esp_h264_enc_param_hw_handle_t handle, esp_h264_rc_hd_t *out_rc_hd)
 {
     esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
-    *out_rc_hd = param->rc_hd;
+    *out_rc_hd = param->rc_en ? param->rc_hd : NULL;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_scene_hd(esp_h264_enc_param_hw_handle_t handle, esp_h264_scene_hd_t *out_scene_hd)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    *out_scene_hd = param->scene_hd;
     return ESP_H264_ERR_OK;
 }
 
@@ -490,6 +985,49 @@ esp_h264_err_t esp_h264_enc_hw_res_check(uint16_t width, uint16_t height)
     return ESP_H264_ERR_FAIL;
 }
 
+uint32_t esp_h264_enc_hw_max_ref_buffer_size(uint16_t width)
+{
+    return max_refame_buffer_size((width + 15) >> 4);
+}
+
+uint32_t esp_h264_enc_hw_max_db_buffer_size(uint16_t width, uint16_t height)
+{
+    return max_db_buffer_size((width + 15) >> 4, (height + 15) >> 4);
+}
+
+esp_h264_err_t esp_h264_enc_hw_save_regs(esp_h264_enc_param_hw_handle_t handle)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_param_regs_t *regs = &param->regs;
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    h264_hal_get_qp(param->device, &regs->qp);
+    h264_hal_get_mv_mode(param->device, &regs->mv_mode, &regs->mv_fmt);
+    regs->roi_en = h264_hal_get_roi_mode(param->device, &regs->roi_mode, &regs->none_roi_delta_qp);
+    for (uint8_t i = 0; i < ESP_H264_ROI_SUP_NUM; i++) {
+        esp_h264_enc_roi_reg_t *reg = &regs->roi_reg[i];
+        h264_hal_get_roi_reg(param->device, &reg->x, &reg->y, &reg->len_x, &reg->len_y, &reg->qp, i);
+    }
+    esp_h264_mutex_unlock(param->mutex);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_restore_regs(esp_h264_enc_param_hw_handle_t handle)
+{
+    esp_h264_param_t *param = __containerof(handle, esp_h264_param_t, hw_base);
+    esp_h264_param_regs_t *regs = &param->regs;
+    esp_h264_mutex_lock(param->mutex, ESP_H264_MAX_DELAY);
+    h264_hal_set_mbres(param->device, param->mb_width, param->mb_height);
+    h264_hal_set_qp(param->device, regs->qp);
+    h264_hal_set_mv_mode(param->device, regs->mv_mode, regs->mv_fmt);
+    h264_hal_set_roi_mode(param->device, regs->roi_en ? (int8_t)regs->roi_mode : (int8_t)ESP_H264_ROI_MODE_DISABLE, regs->none_roi_delta_qp);
+    for (uint8_t i = 0; regs->roi_en && (i < ESP_H264_ROI_SUP_NUM); i++) {
+        esp_h264_enc_roi_reg_t *reg = &regs->roi_reg[i];
+        h264_hal_set_roi_reg(param->device, reg->len_x && reg->len_y, reg->x, reg->y, reg->len_x, reg->len_y, reg->qp, i);
+    }
+    esp_h264_mutex_unlock(param->mutex);
+    return ESP_H264_ERR_OK;
+}
+
 /*  Dual stream mode, DB tmp  buffer can be resused. */
 uint16_t esp_h264_enc_hw_max_db_tmp_buffer_size(uint16_t width)
 {
@@ -7,10 +7,15 @@
 #pragma once
 
 #include "esp_h264_enc_param_hw.h"
+#include "esp_h264_enc_single_hw.h"
 #include "h264_hal.h"
 #include "h264_dma_hal.h"
 #include "h264_nal.h"
 #include "h264_rc.h"
+#include "h264_scene.h"
+#include "h264_mv_roi.h"
+#include "h264_mv_ring.h"
+#include "h264_arena.h"
 #include "esp_h264_mutex.h"
 #include "esp_h264_cache.h"
 #include "esp_h264_check.h"
@@ -37,8 +42,22 @@ typedef struct esp_h264_set_cfg {
     uint8_t            qp_max;   /*<! The maximum quantization parameter(QP) */
     uint8_t            fps;      /*<! Frames per second */
     uint32_t           bitrate;  /*<! Bit per second */
+    esp_h264_rc_mode_t rc_mode;  /*<! Rate control(RC) mode */
+    uint8_t           *ref;      /*<! Reference frame buffer from working buffer pool. NULL means the handle allocates it */
+    uint8_t           *db;       /*<! De-blocking filter data buffer from working buffer pool. NULL means the handle allocates it */
+    esp_h264_arena_t  *arena;    /*<! Arena reserved by `esp_h264_enc_hw_reserve_param` and created by caller.
+                                      NULL means the handle creates its own arena */
 } esp_h264_enc_hw_param_cfg_t;
 
+/**
+ * @brief  Reserve the regions of parameter set handle in the arena
+ *         They are DMA descriptors, NAL buffer and reference frame buffer if it isn't from working buffer pool
+ *
+ * @param[in]  cfg    Configuration of the parameter set handle
+ * @param[in]  arena  Arena which isn't created yet
+ */
+void esp_h264_enc_hw_reserve_param(const esp_h264_enc_hw_param_cfg_t *cfg, esp_h264_arena_t *arena);
+
 /**
  * @brief  Create a new parameter set handle
  *
@@ -64,6 +83,40 @@ esp_h264_err_t esp_h264_enc_hw_new_param(esp_h264_enc_hw_param_cfg_t *cfg, esp_h
  */
 esp_h264_err_t esp_h264_enc_hw_del_param(esp_h264_enc_param_hw_handle_t handle);
 
+/**
+ * @brief  Apply new resolution, QP range, bitrate, FPS and RC mode to the parameter set handle
+ *         The handles and buffers are reused. The RC history and scene change detection history are dropped, and SPS and PPS are updated.
+ *         The hardware registers aren't changed here, as the hardware may be used by another encoder of working buffer pool.
+ *
+ * @note  The caller holds the mutex of parameter set handle. The next frame must be IDR-frame,
+ *        and `esp_h264_enc_hw_program_reconfig` is called before it.
+ *        The ROI regions and delta QP map are in macroblock of the old resolution. They are kept as they are.
+ *
+ * @param[in]  handle  Hardware H.264 encoder parameter set handle
+ * @param[in]  cfg     New configuration. `device`, `ref`, `db` and `arena` are ignored
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  The number of macroblocks is greater than the one at creation
+ */
+esp_h264_err_t esp_h264_enc_hw_reconfig_param(esp_h264_enc_param_hw_handle_t handle, const esp_h264_enc_hw_param_cfg_t *cfg);
+
+/**
+ * @brief  Program the resolution and QP from `esp_h264_enc_hw_reconfig_param` into hardware
+ *
+ * @param[in]  handle  Hardware H.264 encoder parameter set handle
+ */
+void esp_h264_enc_hw_program_reconfig(esp_h264_enc_param_hw_handle_t handle);
+
+/**
+ * @brief  Add the memory of parameter set handle to the report
+ *         The `arena` and `total` fields only count the arena owned by the handle
+ *
+ * @param[in]   handle  Hardware H.264 encoder parameter set handle
+ * @param[out]  info    Memory report. The sizes are added to it
+ */
+void esp_h264_enc_hw_add_param_mem_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_hw_mem_info_t *info);
+
 /**
  * @brief  Get mutual exclusion (MUTEX) parameter
  *
@@ -118,12 +171,16 @@ esp_h264_err_t esp_h264_enc_hw_cfg_dma_db_ref(esp_h264_enc_param_hw_handle_t han
  * @param[in]  buf_yuv     The buffer is to save un-encoder data
  * @param[in]  dsc_bs      Encoder data DMA descriptor
  * @param[in]  buf_bs      The buffer is to save encoder data
- * @param[in]  buf_bs_len  The length of `buf_bs`
+ * @param[in]  buf_bs_len  The length of `buf_bs`. It must be 8 bytes aligned when `seg_num` isn't zero
+ * @param[in]  dsc_seg     Output segment DMA descriptors. They are chained after `dsc_bs` in order
+ * @param[in]  seg         Output segments. The encoder data continues into the next segment when the current one is full
+ * @param[in]  seg_num     The number of output segments. Zero means the encoder data is only in `buf_bs`
  *
  * @return
  *       - ESP_H264_ERR_OK  Succeeded
  */
-esp_h264_err_t esp_h264_enc_hw_cfg_dma_yuv_bs(esp_h264_enc_param_hw_handle_t handle, h264_dma_hal_context_t *dma2d_hal, h264_dma_desc_t *dsc_yuv, uint8_t *buf_yuv, h264_dma_desc_t *dsc_bs, uint8_t *buf_bs, uint32_t buf_bs_len);
+esp_h264_err_t esp_h264_enc_hw_cfg_dma_yuv_bs(esp_h264_enc_param_hw_handle_t handle, h264_dma_hal_context_t *dma2d_hal, h264_dma_desc_t *dsc_yuv, uint8_t *buf_yuv, h264_dma_desc_t *dsc_bs, uint8_t *buf_bs, uint32_t buf_bs_len,
+                                         h264_dma_desc_t *dsc_seg, const esp_h264_pkt_t *seg, uint8_t seg_num);
 
 /**
  * @brief  Configure de-blocking filter temporary parameter DMA descriptor
@@ -145,7 +202,8 @@ esp_h264_err_t esp_h264_enc_hw_cfg_dma_dbtmp(esp_h264_enc_param_hw_handle_t hand
  * @param[in]  dma2d_hal  The 2DDMA handle
  *
  * @return
- *       - ESP_H264_ERR_OK  Succeeded
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_FAIL  No MV buffer. MV packet isn't set, or all buffers of MV buffer ring are held by application
  */
 esp_h264_err_t esp_h264_enc_hw_cfg_dma_mvm(esp_h264_enc_param_hw_handle_t handle, h264_dma_hal_context_t *dma2d_hal);
 
@@ -171,6 +229,65 @@ esp_h264_err_t esp_h264_enc_hw_set_qp(esp_h264_enc_param_hw_handle_t handle, uin
  */
 esp_h264_err_t esp_h264_enc_hw_get_rc_hd(esp_h264_enc_param_hw_handle_t handle, esp_h264_rc_hd_t *out_rc_hd);
 
+/**
+ * @brief  Get frame quantization parameter(QP) of QP map
+ *
+ * @param[in]   handle        Hardware H.264 encoder parameter set handle
+ * @param[out]  out_frame_qp  Frame QP. Negative value means the frame QP is from RC or initial QP
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_get_frame_qp(esp_h264_enc_param_hw_handle_t handle, int8_t *out_frame_qp);
+
+/**
+ * @brief  Get the upper bound of encoded data size for the next frame
+ *         The bound is from resolution and the lowest QP including ROI regions.
+ *         When RC is enabled, it is tightened by the largest recent frame of the same type.
+ *
+ * @param[in]   handle     Hardware H.264 encoder parameter set handle
+ * @param[in]   is_iframe  Whether the next frame is I-frame
+ * @param[out]  out_size   The upper bound in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_get_frame_size_max(esp_h264_enc_param_hw_handle_t handle, bool is_iframe, uint32_t *out_size);
+
+/**
+ * @brief  Complete the motion vector(MV) buffer of the MV buffer ring after hardware encoding
+ *         It does nothing when the MV buffer ring isn't configured or MV output is disabled
+ *
+ * @param[in]  handle     Hardware H.264 encoder parameter set handle
+ * @param[in]  is_iframe  The frame is I-frame. The MVM DMA isn't started for it, so the MV buffer is returned to the ring
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_mv_done(esp_h264_enc_param_hw_handle_t handle, bool is_iframe);
+
+/**
+ * @brief  Update the ROI regions from the motion vector(MV) output of the last P-frame
+ *         It does nothing when MV driven ROI is disabled
+ *
+ * @param[in]  handle  Hardware H.264 encoder parameter set handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_update_auto_roi(esp_h264_enc_param_hw_handle_t handle);
+
+/**
+ * @brief  Get scene change detection handle
+ *
+ * @param[in]   handle        Hardware H.264 encoder parameter set handle
+ * @param[out]  out_scene_hd  Scene change detection handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_get_scene_hd(esp_h264_enc_param_hw_handle_t handle, esp_h264_scene_hd_t *out_scene_hd);
+
 /**
  * @brief  Set rate control parameter
  *
@@ -217,6 +334,48 @@ esp_h264_err_t esp_h264_enc_hw_res_check(uint16_t width, uint16_t height);
  */
 uint16_t esp_h264_enc_hw_max_db_tmp_buffer_size(uint16_t width);
 
+/**
+ * @brief  Get reference frame buffer size
+ *
+ * @param[in]  width  Width of picture
+ *
+ * @return
+ *       - The size of reference frame buffer
+ */
+uint32_t esp_h264_enc_hw_max_ref_buffer_size(uint16_t width);
+
+/**
+ * @brief  Get de-blocking filter data buffer size
+ *
+ * @param[in]  width   Width of picture
+ * @param[in]  height  Height of picture
+ *
+ * @return
+ *       - The size of de-blocking filter data buffer
+ */
+uint32_t esp_h264_enc_hw_max_db_buffer_size(uint16_t width, uint16_t height);
+
+/**
+ * @brief  Save the hardware registers of parameter set, such as QP, MV and ROI configuration
+ *         It is called before the hardware is used by another encoder
+ *
+ * @param[in]  handle  Hardware H.264 encoder parameter set handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_save_regs(esp_h264_enc_param_hw_handle_t handle);
+
+/**
+ * @brief  Restore the hardware registers from `esp_h264_enc_hw_save_regs` and the resolution
+ *
+ * @param[in]  handle  Hardware H.264 encoder parameter set handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK  Succeeded
+ */
+esp_h264_err_t esp_h264_enc_hw_restore_regs(esp_h264_enc_param_hw_handle_t handle);
+
 /**
  * @brief  Make bit stream buffer aligned to 8 byte
  *
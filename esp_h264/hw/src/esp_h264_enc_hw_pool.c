@@ -0,0 +1,150 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_h264_alloc.h"
+#include "esp_h264_check.h"
+#include "esp_h264_mutex.h"
+#include "esp_h264_enc_hw_param.h"
+#include "h264_pool.h"
+
+static const char *TAG = "H264_ENC.HW.POOL";
+
+typedef struct esp_h264_pool {
+    uint16_t                    width;
+    uint16_t                    height;
+    esp_h264_pool_buf_t         buf;
+    esp_h264_enc_hw_pool_info_t info;
+    uint8_t                     user_num;
+    void                       *owner;
+    void                       *hw_user;
+    esp_h264_mutex_t            mutex;
+} esp_h264_pool_t;
+
+esp_h264_err_t esp_h264_enc_hw_pool_new(const esp_h264_enc_hw_pool_cfg_t *cfg, esp_h264_enc_hw_pool_handle_t *out_pool)
+{
+    ESP_H264_RET_ON_FALSE(cfg && out_pool, ESP_H264_ERR_ARG, TAG, "Invalid pool configure and handle parameter");
+    *out_pool = NULL;
+    ESP_H264_RET_ON_FALSE(esp_h264_enc_hw_res_check(cfg->res.width, cfg->res.height) == ESP_H264_ERR_OK, ESP_H264_ERR_ARG, TAG, "Invalid pool resolution parameter");
+    uint32_t actual_size;
+    esp_h264_pool_t *pool = esp_h264_calloc_prefer(1, sizeof(esp_h264_pool_t), &actual_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    ESP_H264_RET_ON_FALSE(pool, ESP_H264_ERR_MEM, TAG, "No memory for pool handle");
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    pool->width = cfg->res.width;
+    pool->height = cfg->res.height;
+    /** The same memory as one encoder of the maximum resolution */
+    pool->info.ref_size = esp_h264_enc_hw_max_ref_buffer_size(pool->width);
+    pool->info.db_size = esp_h264_enc_hw_max_db_buffer_size(pool->width, pool->height);
+    pool->info.db_tmp_size = esp_h264_enc_hw_max_db_tmp_buffer_size(pool->width);
+    pool->buf.ref = esp_h264_aligned_calloc(16, 1, pool->info.ref_size, &actual_size, ESP_H264_MEM_INTERNAL);
+    ESP_H264_GOTO_ON_FALSE(pool->buf.ref, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for reference frame");
+    pool->buf.db = esp_h264_calloc_prefer(1, pool->info.db_size, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    ESP_H264_GOTO_ON_FALSE(pool->buf.db, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for data");
+    pool->buf.db_tmp = esp_h264_aligned_calloc(16, 1, pool->info.db_tmp_size, &actual_size, ESP_H264_MEM_INTERNAL);
+    ESP_H264_GOTO_ON_FALSE(pool->buf.db_tmp, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for db_tmp");
+    pool->mutex = xSemaphoreCreateMutex();
+    ESP_H264_GOTO_ON_FALSE(pool->mutex, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for mutex semaphore");
+    *out_pool = pool;
+    return ESP_H264_ERR_OK;
+__exit__:
+    esp_h264_enc_hw_pool_del(pool);
+    return ret;
+}
+
+esp_h264_err_t esp_h264_enc_hw_pool_get_info(esp_h264_enc_hw_pool_handle_t pool, esp_h264_enc_hw_pool_info_t *out_info)
+{
+    ESP_H264_RET_ON_FALSE(pool && out_info, ESP_H264_ERR_ARG, TAG, "Invalid pool handle and information parameter");
+    *out_info = ((esp_h264_pool_t *)pool)->info;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_pool_del(esp_h264_enc_hw_pool_handle_t pool)
+{
+    ESP_H264_RET_ON_FALSE(pool, ESP_H264_ERR_ARG, TAG, "Invalid pool handle");
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    ESP_H264_RET_ON_FALSE(hd->user_num == 0, ESP_H264_ERR_FAIL, TAG, "The pool is used by %d encoders", hd->user_num);
+    if (hd->buf.ref) {
+        esp_h264_free(hd->buf.ref);
+    }
+    if (hd->buf.db) {
+        esp_h264_free(hd->buf.db);
+    }
+    if (hd->buf.db_tmp) {
+        esp_h264_free(hd->buf.db_tmp);
+    }
+    if (hd->mutex) {
+        esp_h264_mutex_delete(hd->mutex);
+    }
+    esp_h264_free(hd);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_pool_attach(esp_h264_enc_hw_pool_handle_t pool, uint16_t width, uint16_t height, esp_h264_pool_buf_t *out_buf, void **out_hw_user)
+{
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    /** The working buffer sizes rise with the resolution */
+    ESP_H264_RET_ON_FALSE((width <= hd->width) && (height <= hd->height), ESP_H264_ERR_ARG, TAG, "The resolution is greater than the pool resolution");
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_mutex_lock(hd->mutex, ESP_H264_MAX_DELAY);
+    if (hd->owner) {
+        /** The new encoder programs the hardware which is encoding */
+        ESP_H264_LOGE(TAG, "Please close the encoder of the pool before creating another one");
+        ret = ESP_H264_ERR_FAIL;
+    } else {
+        hd->user_num++;
+        *out_buf = hd->buf;
+        *out_hw_user = hd->hw_user;
+    }
+    esp_h264_mutex_unlock(hd->mutex);
+    return ret;
+}
+
+void esp_h264_pool_detach(esp_h264_enc_hw_pool_handle_t pool, void *user)
+{
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    esp_h264_mutex_lock(hd->mutex, ESP_H264_MAX_DELAY);
+    if (hd->owner == user) {
+        hd->owner = NULL;
+    }
+    if (hd->hw_user == user) {
+        hd->hw_user = NULL;
+    }
+    hd->user_num--;
+    esp_h264_mutex_unlock(hd->mutex);
+}
+
+esp_h264_err_t esp_h264_pool_acquire(esp_h264_enc_hw_pool_handle_t pool, void *user, bool *out_rebind)
+{
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_mutex_lock(hd->mutex, ESP_H264_MAX_DELAY);
+    if (hd->owner && (hd->owner != user)) {
+        ret = ESP_H264_ERR_FAIL;
+    } else {
+        hd->owner = user;
+        *out_rebind = (hd->hw_user != user);
+        hd->hw_user = user;
+    }
+    esp_h264_mutex_unlock(hd->mutex);
+    return ret;
+}
+
+void esp_h264_pool_release(esp_h264_enc_hw_pool_handle_t pool, void *user)
+{
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    esp_h264_mutex_lock(hd->mutex, ESP_H264_MAX_DELAY);
+    if (hd->owner == user) {
+        hd->owner = NULL;
+    }
+    esp_h264_mutex_unlock(hd->mutex);
+}
+
+void esp_h264_pool_set_hw_user(esp_h264_enc_hw_pool_handle_t pool, void *user)
+{
+    esp_h264_pool_t *hd = (esp_h264_pool_t *)pool;
+    esp_h264_mutex_lock(hd->mutex, ESP_H264_MAX_DELAY);
+    hd->hw_user = user;
+    esp_h264_mutex_unlock(hd->mutex);
+}
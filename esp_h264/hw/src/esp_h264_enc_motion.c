@@ -0,0 +1,173 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_alloc.h"
+#include "esp_h264_check.h"
+#include "esp_h264_enc_motion.h"
+#include "h264_mv_roi.h"
+
+static const char *TAG = "H264_ENC.MOTION";
+
+#define MOTION_ABS(a)    ((a) < 0 ? -(a) : (a))
+#define MOTION_PERMILLE  (1000)
+
+typedef struct esp_h264_motion {
+    esp_h264_motion_cfg_t cfg;
+    uint16_t              mb_cnt;
+    uint8_t              *heat;
+    uint8_t              *hot;
+    uint8_t              *moving;
+    uint8_t              *zone;
+    uint16_t              zone_cnt[ESP_H264_MOTION_ZONE_NUM];
+    uint8_t               zone_motion;
+    uint8_t               on_cnt[ESP_H264_MOTION_ZONE_NUM];
+    uint8_t               off_cnt[ESP_H264_MOTION_ZONE_NUM];
+} esp_h264_motion_t;
+
+esp_h264_err_t esp_h264_motion_new(const esp_h264_motion_cfg_t *cfg, esp_h264_motion_handle_t *out_handle)
+{
+    ESP_H264_RET_ON_FALSE(cfg && out_handle, ESP_H264_ERR_ARG, TAG, "Invalid motion configure and handle parameter");
+    *out_handle = NULL;
+    ESP_H264_RET_ON_FALSE(cfg->mb_width && cfg->mb_height, ESP_H264_ERR_ARG, TAG, "Invalid motion resolution parameter");
+    ESP_H264_RET_ON_FALSE(cfg->heat_thres && cfg->on_frames && cfg->off_frames, ESP_H264_ERR_ARG, TAG, "Invalid motion heat and frames parameter");
+    ESP_H264_RET_ON_FALSE(cfg->on_thres && (cfg->on_thres <= MOTION_PERMILLE) && (cfg->off_thres <= cfg->on_thres),
+                          ESP_H264_ERR_ARG, TAG, "Invalid motion score threshold parameter");
+    uint32_t actual_size;
+    esp_h264_motion_t *motion = esp_h264_calloc_prefer(1, sizeof(esp_h264_motion_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    ESP_H264_RET_ON_FALSE(motion, ESP_H264_ERR_MEM, TAG, "No memory for motion handle");
+    motion->cfg = *cfg;
+    motion->mb_cnt = cfg->mb_width * cfg->mb_height;
+    /** heat, hot and moving mask are in one buffer */
+    motion->heat = esp_h264_calloc_prefer(3, motion->mb_cnt, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (motion->heat == NULL) {
+        esp_h264_free(motion);
+        ESP_H264_LOGE(TAG, "No memory for motion heatmap");
+        return ESP_H264_ERR_MEM;
+    }
+    motion->hot = motion->heat + motion->mb_cnt;
+    motion->moving = motion->hot + motion->mb_cnt;
+    motion->zone_cnt[0] = motion->mb_cnt;
+    *out_handle = motion;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_motion_set_zone(esp_h264_motion_handle_t handle, const uint8_t *zone_mask, uint32_t len)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid motion handle");
+    esp_h264_motion_t *motion = (esp_h264_motion_t *)handle;
+    ESP_H264_RET_ON_FALSE(!zone_mask || (len == motion->mb_cnt), ESP_H264_ERR_ARG, TAG, "Invalid zone mask length");
+    if (zone_mask && !motion->zone) {
+        uint32_t actual_size;
+        motion->zone = esp_h264_calloc_prefer(1, motion->mb_cnt, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+        ESP_H264_RET_ON_FALSE(motion->zone, ESP_H264_ERR_MEM, TAG, "No memory for zone mask");
+    }
+    memset(motion->zone_cnt, 0, sizeof(motion->zone_cnt));
+    memset(motion->on_cnt, 0, sizeof(motion->on_cnt));
+    memset(motion->off_cnt, 0, sizeof(motion->off_cnt));
+    motion->zone_motion = 0;
+    if (zone_mask == NULL) {
+        esp_h264_free(motion->zone);
+        motion->zone = NULL;
+        motion->zone_cnt[0] = motion->mb_cnt;
+        return ESP_H264_ERR_OK;
+    }
+    memcpy(motion->zone, zone_mask, motion->mb_cnt);
+    for (uint16_t i = 0; i < motion->mb_cnt; i++) {
+        for (uint8_t z = 0; z < ESP_H264_MOTION_ZONE_NUM; z++) {
+            motion->zone_cnt[z] += (zone_mask[i] >> z) & 1;
+        }
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_motion_process(esp_h264_motion_handle_t handle, const esp_h264_enc_mv_data_t *mv, uint32_t mv_num, esp_h264_motion_result_t *result)
+{
+    ESP_H264_RET_ON_FALSE(handle && result && (mv || !mv_num), ESP_H264_ERR_ARG, TAG, "Invalid motion handle, MV and result parameter");
+    esp_h264_motion_t *motion = (esp_h264_motion_t *)handle;
+    esp_h264_motion_cfg_t *cfg = &motion->cfg;
+    memset(result, 0, sizeof(esp_h264_motion_result_t));
+    /** Only the macroblocks with non-zero MV are in MV data */
+    memset(motion->moving, 0, motion->mb_cnt);
+    for (uint32_t i = 0; i < mv_num; i++) {
+        if ((mv[i].mb_x < cfg->mb_width) && (mv[i].mb_y < cfg->mb_height)
+                && (MOTION_ABS(mv[i].mv_x) + MOTION_ABS(mv[i].mv_y) >= cfg->mv_thres)) {
+            motion->moving[mv[i].mb_y * cfg->mb_width + mv[i].mb_x] = 1;
+            result->moving_mb++;
+        }
+    }
+    uint16_t hot_cnt = 0;
+    uint16_t zone_hot[ESP_H264_MOTION_ZONE_NUM] = { 0 };
+    for (uint16_t i = 0; i < motion->mb_cnt; i++) {
+        uint8_t heat = motion->heat[i];
+        if (motion->moving[i]) {
+            heat = (heat > UINT8_MAX - cfg->heat_rise) ? UINT8_MAX : heat + cfg->heat_rise;
+        } else {
+            heat = (heat < cfg->heat_decay) ? 0 : heat - cfg->heat_decay;
+        }
+        motion->heat[i] = heat;
+        motion->hot[i] = heat >= cfg->heat_thres;
+        if (!motion->hot[i]) {
+            continue;
+        }
+        hot_cnt++;
+        uint8_t zone = motion->zone ? motion->zone[i] : 1;
+        for (uint8_t z = 0; zone; z++, zone >>= 1) {
+            zone_hot[z] += zone & 1;
+        }
+    }
+    result->score = hot_cnt * MOTION_PERMILLE / motion->mb_cnt;
+    /** Hysteresis of every zone */
+    bool last_motion = motion->zone_motion != 0;
+    for (uint8_t z = 0; z < ESP_H264_MOTION_ZONE_NUM; z++) {
+        if (motion->zone_cnt[z] == 0) {
+            continue;
+        }
+        uint16_t score = zone_hot[z] * MOTION_PERMILLE / motion->zone_cnt[z];
+        uint8_t bit = 1 << z;
+        result->zone_score[z] = score;
+        if (!(motion->zone_motion & bit)) {
+            motion->on_cnt[z] = (score >= cfg->on_thres) ? motion->on_cnt[z] + 1 : 0;
+            if (motion->on_cnt[z] >= cfg->on_frames) {
+                motion->zone_motion |= bit;
+                motion->on_cnt[z] = 0;
+            }
+        } else {
+            motion->off_cnt[z] = (score < cfg->off_thres) ? motion->off_cnt[z] + 1 : 0;
+            if (motion->off_cnt[z] >= cfg->off_frames) {
+                motion->zone_motion &= ~bit;
+                motion->off_cnt[z] = 0;
+            }
+        }
+    }
+    result->zone_motion = motion->zone_motion;
+    result->motion = motion->zone_motion != 0;
+    result->changed = result->motion != last_motion;
+    result->box_num = esp_h264_mv_box_cluster(motion->hot, cfg->mb_width, cfg->mb_height, cfg->min_area, result->box, ESP_H264_MOTION_BOX_NUM);
+    result->heatmap = motion->heat;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_motion_reset(esp_h264_motion_handle_t handle)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid motion handle");
+    esp_h264_motion_t *motion = (esp_h264_motion_t *)handle;
+    memset(motion->heat, 0, motion->mb_cnt);
+    memset(motion->on_cnt, 0, sizeof(motion->on_cnt));
+    memset(motion->off_cnt, 0, sizeof(motion->off_cnt));
+    motion->zone_motion = 0;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_motion_del(esp_h264_motion_handle_t handle)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid motion handle");
+    esp_h264_motion_t *motion = (esp_h264_motion_t *)handle;
+    esp_h264_free(motion->zone);
+    esp_h264_free(motion->heat);
+    esp_h264_free(motion);
+    return ESP_H264_ERR_OK;
+}
@@ -4,28 +4,69 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <string.h>
 #include "esp_h264_alloc.h"
 #include "esp_h264_enc_single_hw.h"
 #include "esp_h264_enc_hw_param.h"
 #include "esp_h264_intr_alloc.h"
+#include "esp_private/esp_cache_private.h"
+#include "h264_pool.h"
+#include "h264_arena.h"
+#include "esp_h264_stats_acc.h"
+#include "h264_trace.h"
 
 static const char *TAG = "H264_ENC.HW";
 
+/* Start code + NAL header + P-slice header + `mb_skip_run` are less than it */
+#define H264_SKIP_SLICE_MAX_SIZE (32)
+
 typedef struct esp_h264_hw_handle {
-    esp_h264_enc_t              base;
-    esp_h264_enc_param_hw_t    *param_hd;
-    uint8_t                    *db_tmp;
-    h264_hal_context_t          h264_hal;
-    h264_dma_hal_context_t      dma2d_hal;
-    h264_dma_desc_t            *dsc_yuv;
-    h264_dma_desc_t            *dsc_dbtmp[2];
-    h264_dma_desc_t            *dsc_bs;
-    uint8_t                     frame_num;
-    uint8_t                     gop;
-    esp_h264_mutex_t            frame_done;
-    esp_h264_intr_hd_t          intr_hd;
+    esp_h264_enc_t                base;
+    esp_h264_enc_param_hw_t      *param_hd;
+    uint8_t                      *db_tmp;
+    uint32_t                      db_tmp_size;
+    h264_hal_context_t            h264_hal;
+    h264_dma_hal_context_t        dma2d_hal;
+    h264_dma_desc_t              *dsc_yuv;
+    h264_dma_desc_t              *dsc_dbtmp[2];
+    h264_dma_desc_t              *dsc_bs;
+    h264_dma_desc_t              *dsc_seg;
+    esp_h264_pkt_t                seg[ESP_H264_OUT_SEG_MAX];
+    uint32_t                      seg_len[ESP_H264_OUT_SEG_MAX];
+    uint8_t                       seg_num;
+    uint8_t                       frame_num;
+    uint8_t                       skip_num;
+    uint8_t                       gop;
+    uint8_t                       qp_last;
+    esp_h264_mutex_t              frame_done;
+    esp_h264_intr_hd_t            intr_hd;
+    esp_h264_enc_hw_pool_handle_t pool;
+    bool                          pool_acquired;
+    esp_h264_arena_t              arena;
+    esp_h264_resolution_t         res_max;
+    bool                          reconfig_pending;
+    bool                          scene_change;
+    esp_h264_stats_acc_t          stats;
+    uint32_t                      buf_flags;
+    uint32_t                      cache_align;
+#if CONFIG_ESP_H264_TRACE
+    h264_trace_t                  trace;
+#endif
+    h264_hal_context_cfg_t        hal_cfg;
+    h264_hal_dma_context_cfg_t    dma_cfg;
 } esp_h264_hw_handle_t;
 
+/* The cache line size of output buffer. It may be in internal RAM or PSRAM. */
+static uint32_t h264_hw_cache_align(void)
+{
+    size_t align_int = 0;
+    size_t align_ext = 0;
+    esp_cache_get_alignment(ESP_H264_MEM_INTERNAL, &align_int);
+    esp_cache_get_alignment(ESP_H264_MEM_SPIRAM, &align_ext);
+    size_t align = align_int > align_ext ? align_int : align_ext;
+    return align ? (uint32_t)align : 1;
+}
+
 static void h264_gop_isr(void *arg)
 {
     esp_h264_hw_handle_t *hw_hd = (esp_h264_hw_handle_t *)arg;
@@ -36,19 +77,25 @@ static void h264_gop_isr(void *arg)
         if (!status) {
             break;
         } else if (status & H264_INTR_DB_TMP_READY) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_DB_TMP, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_DB_TMP_READY);
         } else if (status & H264_INTR_REC_READY && (!hw_hd->frame_num)) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_REC, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_REC_READY);
             h264_dma_hal_start_tx_db12_4_dma(&hw_hd->dma2d_hal);
             h264_hal_dma_move_start(&hw_hd->h264_hal);
         } else if (status & H264_INTR_REC_READY) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_REC, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_REC_READY);
         } else if (status & H264_INTR_2MB_LINE_DONE && (!hw_hd->frame_num)) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_2MB_LINE, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_2MB_LINE_DONE);
             h264_dma_hal_start_ref_dma(&hw_hd->dma2d_hal);
         } else if (status & H264_INTR_2MB_LINE_DONE) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_2MB_LINE, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_2MB_LINE_DONE);
         } else if (status & H264_INTR_FRAME_DONE) {
+            H264_TRACE(&hw_hd->trace, H264_TRACE_ISR_FRAME_DONE, hw_hd->frame_num);
             h264_hal_clear_intr_status(&hw_hd->h264_hal, H264_INTR_FRAME_DONE);
             esp_h264_mutex_unlock_from_isr(hw_hd->frame_done, &xHigherPriorityTaskWoken);
         }
@@ -105,6 +152,21 @@ static esp_h264_err_t h264_hw_enc_gop_mode_process(esp_h264_hw_handle_t *hw_hd,
         /** Slice header will record the delta QP */
         qp_delta = qp - qp_init;
     }
+    int8_t frame_qp = -1;
+    esp_h264_enc_hw_get_frame_qp(param_hd, &frame_qp);
+    if (frame_qp >= 0) {
+        /** The frame QP of QP map overrides the RC QP. The RC still learns from the encoded frame. */
+        uint8_t qp_init = 0;
+        esp_h264_enc_hw_get_qp_init(param_hd, &qp_init);
+        qp = frame_qp;
+        esp_h264_enc_hw_set_qp(param_hd, qp);
+        qp_delta = qp - qp_init;
+    }
+    if (!rc_hd && (frame_qp < 0)) {
+        /** Fixed QP */
+        esp_h264_enc_hw_get_qp_init(param_hd, &qp);
+    }
+    hw_hd->qp_last = qp;
     uint32_t *slice_start_code = (uint32_t *)out_frame;
     uint32_t slice_nal_len = 0;
     if (hw_hd->frame_num == 0) {
@@ -115,20 +177,31 @@ static esp_h264_err_t h264_hw_enc_gop_mode_process(esp_h264_hw_handle_t *hw_hd,
         slice_nal_len += nal_bit_len;
     }
     /** Configure slice header */
-    slice_nal_len += esp_h264_enc_hw_set_slice((uint8_t *)slice_start_code, out_frame_size - (slice_nal_len >> 3), !hw_hd->frame_num, hw_hd->frame_num, qp_delta, true);
+    /** The skipped frames are reference frames too. So `frame_num` of slice header counts them. */
+    slice_nal_len += esp_h264_enc_hw_set_slice((uint8_t *)slice_start_code, out_frame_size - (slice_nal_len >> 3), !hw_hd->frame_num, hw_hd->frame_num + hw_hd->skip_num, qp_delta, true);
     /** The descriptor's buffer must aligned 8 byte. */
     uint8_t *bs = esp_h264_enc_hw_slice_header_align8(out_frame, slice_nal_len, &hw_hd->h264_hal);
     int out_frame_len = (bs - out_frame);
     // Although slice head will be overwrote, always write back to avoid cache missing
     esp_h264_cache_check_and_writeback(out_frame, (slice_nal_len + 7) >> 3);
+    H264_TRACE(&hw_hd->trace, H264_TRACE_SLICE_HEADER, hw_hd->frame_num);
+    uint32_t bs_len = out_frame_size - out_frame_len;
+    memset(hw_hd->seg_len, 0, sizeof(hw_hd->seg_len));
+    if (hw_hd->seg_num) {
+        /** The DMA continues into the output segments at the end of first buffer. So the first buffer length is 8 bytes aligned. */
+        bs_len &= ~HW_DMA_BUF_ALIGN_SIZE;
+    }
     /** Configure descriptor to prevent the input frame buffer and output frame buffer, MVM buffer changing */
-    esp_h264_enc_hw_cfg_dma_yuv_bs(param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_yuv, in_frame, hw_hd->dsc_bs, bs, out_frame_size - out_frame_len);
+    esp_h264_enc_hw_cfg_dma_yuv_bs(param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_yuv, in_frame, hw_hd->dsc_bs, bs, bs_len,
+                                   hw_hd->dsc_seg, hw_hd->seg, hw_hd->seg_num);
     esp_h264_err_t ret = esp_h264_enc_hw_cfg_dma_mvm(param_hd, &hw_hd->dma2d_hal);
     if (ret != ESP_H264_ERR_OK) {
-        ESP_H264_LOGE(TAG, "Please configure MV packet.");
+        ESP_H264_LOGE(TAG, "Please configure MV packet, or release the MV packets of MV buffer ring.");
         return ESP_H264_ERR_FAIL;
     }
+    H264_TRACE(&hw_hd->trace, H264_TRACE_DMA_CFG, hw_hd->frame_num);
     /** Start HW encoding */
+    H264_TRACE(&hw_hd->trace, H264_TRACE_HW_START, hw_hd->frame_num);
     h264_start_gop_mode_enc(!hw_hd->frame_num, &hw_hd->h264_hal, &hw_hd->dma2d_hal);
     if (esp_h264_mutex_lock(hw_hd->frame_done, (TickType_t)H264_TIME_OUT) != pdTRUE) {
         *out_len = 0;
@@ -144,8 +217,28 @@ static esp_h264_err_t h264_hw_enc_gop_mode_process(esp_h264_hw_handle_t *hw_hd,
         ESP_H264_LOGE(TAG, "Timeout");
         return ESP_H264_ERR_TIMEOUT;
     }
+    H264_TRACE(&hw_hd->trace, H264_TRACE_FRAME_DONE, hw_hd->frame_num);
     *out_len = h264_hal_get_coded_len(&hw_hd->h264_hal);
-    esp_h264_cache_check_and_invalidate(out_frame, out_frame_size);
+    bool cpu_read = !(hw_hd->buf_flags & ESP_H264_ENC_HW_BUF_OUT_DEV_READ);
+    /** Only the cache lines of coded data are invalidated. The rest of output buffer isn't written by hardware.
+     *  The headers are always invalidated, as the start code is re-written by CPU below. */
+    uint32_t coded_len = out_frame_len;
+    if (cpu_read) {
+        coded_len += (*out_len < bs_len) ? *out_len : bs_len;
+    }
+    coded_len = ALIGN_UP(coded_len, hw_hd->cache_align);
+    esp_h264_cache_check_and_invalidate(out_frame, coded_len < out_frame_size ? coded_len : out_frame_size);
+    /** The rest of encoder data fills the output segments in order */
+    uint32_t seg_rest = (*out_len > bs_len) ? *out_len - bs_len : 0;
+    for (uint8_t i = 0; (i < hw_hd->seg_num) && seg_rest; i++) {
+        hw_hd->seg_len[i] = seg_rest < hw_hd->seg[i].len ? seg_rest : hw_hd->seg[i].len;
+        seg_rest -= hw_hd->seg_len[i];
+        if (cpu_read) {
+            uint32_t inv_len = ALIGN_UP(hw_hd->seg_len[i], hw_hd->cache_align);
+            esp_h264_cache_check_and_invalidate(hw_hd->seg[i].buffer, inv_len < hw_hd->seg[i].len ? inv_len : hw_hd->seg[i].len);
+        }
+    }
+    H264_TRACE(&hw_hd->trace, H264_TRACE_CACHE_INVALIDATE, hw_hd->frame_num);
     /** CAVLA mustn't be continue zeros.
      *  And HW encoding will check output buffer.
      *  Maybe start code will be wrote error data after HW encoding.
@@ -165,6 +258,7 @@ static esp_h264_err_t h264_hw_enc_gop_mode_process(esp_h264_hw_handle_t *hw_hd,
         }
         /** Software calculation the RC parameter.*/
         esp_h264_rc_end(rc_hd, enc_bits, qp_sum, mad);
+        H264_TRACE(&hw_hd->trace, H264_TRACE_RC_END, hw_hd->frame_num);
     }
     *out_len += out_frame_len;
     if (h264_hal_get_bs_bit_overflow(&hw_hd->h264_hal)) {
@@ -173,35 +267,161 @@ static esp_h264_err_t h264_hw_enc_gop_mode_process(esp_h264_hw_handle_t *hw_hd,
     return ESP_H264_ERR_OK;
 }
 
-static esp_h264_err_t enc_process(esp_h264_enc_handle_t enc, esp_h264_enc_in_frame_t *in_frame, esp_h264_enc_out_frame_t *out_frame)
+static esp_h264_err_t h264_hw_enc_skip_process(esp_h264_hw_handle_t *hw_hd, esp_h264_enc_out_frame_t *out_frame)
+{
+    /** The hardware isn't started. Its reference picture and GOP counter keep unchanged. */
+    uint8_t mb_width = 0;
+    uint8_t mb_height = 0;
+    esp_h264_enc_hw_get_mbres(hw_hd->param_hd, &mb_width, &mb_height);
+    uint16_t bit_len = esp_h264_enc_hw_set_skip_slice(out_frame->raw_data.buffer, out_frame->raw_data.len, hw_hd->frame_num + hw_hd->skip_num, mb_width * mb_height, true);
+    out_frame->length = bit_len >> 3;
+    esp_h264_cache_check_and_writeback(out_frame->raw_data.buffer, out_frame->length);
+    hw_hd->skip_num++;
+    return ESP_H264_ERR_OK;
+}
+
+static void h264_hw_enc_idr_start(esp_h264_hw_handle_t *hw_hd, esp_h264_enc_out_frame_t *out_frame)
+{
+    /** Currently, the I-frame is instantaneous decoding refresh frame(IDR-frame).
+     * In IDR-frame, the GOP can be updating.*/
+    out_frame->frame_type = ESP_H264_FRAME_TYPE_IDR;
+    hw_hd->skip_num = 0;
+    esp_h264_enc_get_gop(&hw_hd->param_hd->base, &hw_hd->gop);
+    h264_hal_set_gop(&hw_hd->h264_hal, hw_hd->gop, true);
+}
+
+static void h264_hw_enc_scene_change(esp_h264_hw_handle_t *hw_hd)
+{
+    /** The scene change frame is promoted to IDR-frame. And the RC history of last scene is dropped. */
+    esp_h264_rc_hd_t rc_hd = NULL;
+    esp_h264_enc_hw_get_rc_hd(hw_hd->param_hd, &rc_hd);
+    if (rc_hd) {
+        esp_h264_enc_hw_rc_reset(rc_hd);
+    }
+    hw_hd->frame_num = 0;
+}
+
+static void h264_hw_enc_reconfig(esp_h264_hw_handle_t *hw_hd)
+{
+    /** The new configuration starts from IDR-frame. The buffers and the interrupt are reused. */
+    esp_h264_enc_hw_program_reconfig(hw_hd->param_hd);
+    esp_h264_enc_hw_cfg_dma_dbtmp(hw_hd->param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_dbtmp, (uint8_t *)(ALIGN_UP((uint32_t)hw_hd->db_tmp, 8)));
+    esp_h264_enc_hw_cfg_dma_db_ref(hw_hd->param_hd, &hw_hd->dma2d_hal);
+    hw_hd->frame_num = 0;
+    hw_hd->reconfig_pending = false;
+}
+
+static esp_h264_err_t h264_hw_enc_frame(esp_h264_hw_handle_t *hw_hd, esp_h264_enc_in_frame_t *in_frame, esp_h264_enc_out_frame_t *out_frame, esp_h264_frame_stats_t *rec)
 {
-    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
     esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_scene_hd_t scene_hd = NULL;
+    esp_h264_enc_scene_cfg_t scene_cfg = { 0 };
+    uint32_t idr_size = 0;
+    esp_h264_enc_hw_get_scene_hd(hw_hd->param_hd, &scene_hd);
+    esp_h264_enc_hw_scene_get_cfg(scene_hd, &scene_cfg);
+    if (scene_cfg.enable && scene_cfg.hist_thres) {
+        /** It takes the parameter mutex, so it is before the lock below */
+        esp_h264_enc_hw_get_frame_size_max(hw_hd->param_hd, true, &idr_size);
+    }
+    memset(hw_hd->seg_len, 0, sizeof(hw_hd->seg_len));
     hw_hd->frame_num = hw_hd->frame_num % hw_hd->gop;
+    /** The skipped frames are counted into GOP. So the IDR-frame interval keeps the same with skipping. */
+    if (hw_hd->frame_num + hw_hd->skip_num >= hw_hd->gop) {
+        hw_hd->frame_num = 0;
+    }
     out_frame->dts = in_frame->pts;
     out_frame->pts = in_frame->pts;
     out_frame->frame_type = ESP_H264_FRAME_TYPE_P;
-    /** Intra (I-frame) check */
-    if (!hw_hd->frame_num) {
-        /** Currently, the I-frame is instantaneous decoding refresh frame(IDR-frame).
-         * In IDR-frame, the GOP can be updating.*/
-        out_frame->frame_type = ESP_H264_FRAME_TYPE_IDR;
-        esp_h264_enc_get_gop(&hw_hd->param_hd->base, &hw_hd->gop);
-        h264_hal_set_gop(&hw_hd->h264_hal, hw_hd->gop, true);
-    }
-    esp_h264_cache_check_and_writeback(in_frame->raw_data.buffer, in_frame->raw_data.len);
     /** In multi-thread, the parameter cann't be set in encoding.
      *  `mutex` is for thread safety.
     */
     esp_h264_mutex_t mutex;
     esp_h264_enc_hw_get_mutex(hw_hd->param_hd, &mutex);
     esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
+    if (hw_hd->reconfig_pending) {
+        h264_hw_enc_reconfig(hw_hd);
+    }
+    /** Scene change check. The scene change from MAD jump of the last frame or luma histogram before encoding.
+     *  The histogram promotes this frame only when the output buffer holds an IDR-frame, otherwise the next frame. */
+    bool hist_change = esp_h264_scene_check_pic(scene_hd, in_frame->raw_data.buffer);
+    bool defer = hist_change && (out_frame->raw_data.len < idr_size);
+    if ((hw_hd->scene_change || (hist_change && !defer)) && hw_hd->frame_num) {
+        h264_hw_enc_scene_change(hw_hd);
+    }
+    hw_hd->scene_change = defer && hw_hd->frame_num;
+    /** Intra (I-frame) check */
+    if (!hw_hd->frame_num) {
+        h264_hw_enc_idr_start(hw_hd, out_frame);
+    }
+    /** Static scene check. The IDR-frame is always encoded by hardware. */
+    if (esp_h264_scene_check_static(scene_hd, in_frame->raw_data.buffer) && hw_hd->frame_num
+            && (out_frame->raw_data.len >= H264_SKIP_SLICE_MAX_SIZE)) {
+        ret = h264_hw_enc_skip_process(hw_hd, out_frame);
+        esp_h264_mutex_unlock(mutex);
+        return ret;
+    }
+    if (!(hw_hd->buf_flags & ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN)) {
+        esp_h264_cache_check_and_writeback(in_frame->raw_data.buffer, in_frame->raw_data.len);
+    }
     ret |= h264_hw_enc_gop_mode_process(hw_hd, in_frame->raw_data.buffer, out_frame->raw_data.buffer, out_frame->raw_data.len, &out_frame->length);
+    uint32_t enc_bits = 0, mad = 0, qp_sum = 0;
+    if (ret == ESP_H264_ERR_OK) {
+        rec->qp = hw_hd->qp_last;
+        if (hw_hd->frame_num) {
+            /** The average QP with ROI and MAD of P-frame are from HW */
+            uint8_t mb_width = 0;
+            uint8_t mb_height = 0;
+            esp_h264_enc_hw_get_mbres(hw_hd->param_hd, &mb_width, &mb_height);
+            h264_hal_get_rc_bits_mad_qpsum(&hw_hd->h264_hal, &enc_bits, &mad, &qp_sum);
+            rec->mad = mad / (mb_width * mb_height);
+            if (qp_sum) {
+                rec->qp = qp_sum / (mb_width * mb_height);
+            }
+            /** Scene change check with the MAD jump after encoding. The next frame is promoted to IDR-frame, same as dual stream encoder */
+            hw_hd->scene_change |= esp_h264_scene_check_mad(scene_hd, mad);
+        }
+        esp_h264_enc_hw_mv_done(hw_hd->param_hd, !hw_hd->frame_num);
+        esp_h264_scene_update_ref(scene_hd, !hw_hd->frame_num, mad);
+        if (hw_hd->frame_num) {
+            /** MV driven ROI for the next frame. I-frame has no MV, so the last ROI regions keep. */
+            esp_h264_enc_hw_update_auto_roi(hw_hd->param_hd);
+        }
+    }
     esp_h264_mutex_unlock(mutex);
     hw_hd->frame_num++;
     return ret;
 }
 
+static esp_h264_err_t enc_process(esp_h264_enc_handle_t enc, esp_h264_enc_in_frame_t *in_frame, esp_h264_enc_out_frame_t *out_frame)
+{
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    H264_TRACE(&hw_hd->trace, H264_TRACE_PROCESS_BEGIN, hw_hd->frame_num);
+    int64_t start_us = esp_h264_stats_acc_start();
+    esp_h264_frame_stats_t rec = { 0 };
+    esp_h264_err_t ret = h264_hw_enc_frame(hw_hd, in_frame, out_frame, &rec);
+    rec.frame_type = out_frame->frame_type;
+    rec.len = out_frame->length;
+    esp_h264_stats_acc_add(&hw_hd->stats, start_us, &rec, ret);
+    H264_TRACE(&hw_hd->trace, H264_TRACE_PROCESS_END, (uint16_t)ret);
+    return ret;
+}
+
+static esp_h264_err_t enc_get_stats(esp_h264_enc_handle_t enc, esp_h264_stats_t *stats)
+{
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    uint8_t fps = 0;
+    esp_h264_enc_get_fps(&hw_hd->param_hd->base, &fps);
+    esp_h264_stats_acc_get(&hw_hd->stats, fps, stats);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t enc_reset_stats(esp_h264_enc_handle_t enc)
+{
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    esp_h264_stats_acc_reset(&hw_hd->stats);
+    return ESP_H264_ERR_OK;
+}
+
 static esp_h264_err_t enc_close(esp_h264_enc_handle_t enc)
 {
     esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
@@ -214,12 +434,46 @@ static esp_h264_err_t enc_close(esp_h264_enc_handle_t enc)
             hw_hd->frame_done = NULL;
         }
     }
+    if (hw_hd->pool) {
+        if (!hw_hd->pool_acquired) {
+            /** The hardware may be used by another encoder of the pool */
+            return ESP_H264_ERR_OK;
+        }
+        /** Keep the configuration for the next open. Another encoder of the pool may re-program the hardware. */
+        esp_h264_enc_hw_save_regs(hw_hd->param_hd);
+    }
     /** Clear all interrupts */
     h264_hal_ena_intr(&hw_hd->h264_hal, 0);
     /** Reset H.264 */
     h264_hal_reset(&hw_hd->h264_hal);
     /** Close DMA */
     h264_dma_hal_deinit(&hw_hd->dma2d_hal);
+    if (hw_hd->pool) {
+        esp_h264_pool_release(hw_hd->pool, hw_hd);
+        hw_hd->pool_acquired = false;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t h264_hw_enc_pool_bind(esp_h264_hw_handle_t *hw_hd)
+{
+    bool rebind = false;
+    if (esp_h264_pool_acquire(hw_hd->pool, hw_hd, &rebind) != ESP_H264_ERR_OK) {
+        ESP_H264_LOGE(TAG, "Another encoder of the pool is open");
+        return ESP_H264_ERR_FAIL;
+    }
+    hw_hd->pool_acquired = true;
+    if (!rebind) {
+        /** The hardware still has the configuration of this encoder */
+        esp_h264_enc_hw_save_regs(hw_hd->param_hd);
+    }
+    /** The working buffers and the hardware are shared. So program them for this encoder. */
+    hw_hd->hal_cfg.gop = hw_hd->gop;
+    h264_hal_init(&hw_hd->h264_hal, &hw_hd->hal_cfg);
+    h264_dma_hal_init(&hw_hd->dma2d_hal, &hw_hd->dma_cfg);
+    esp_h264_enc_hw_restore_regs(hw_hd->param_hd);
+    esp_h264_enc_hw_cfg_dma_dbtmp(hw_hd->param_hd, &hw_hd->dma2d_hal, hw_hd->dsc_dbtmp, (uint8_t *)(ALIGN_UP((uint32_t)hw_hd->db_tmp, 8)));
+    esp_h264_enc_hw_cfg_dma_db_ref(hw_hd->param_hd, &hw_hd->dma2d_hal);
     return ESP_H264_ERR_OK;
 }
 
@@ -227,6 +481,10 @@ static esp_h264_err_t enc_open(esp_h264_enc_handle_t enc)
 {
     esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
     hw_hd->frame_num = 0;
+    hw_hd->scene_change = false;
+    if (hw_hd->pool && (h264_hw_enc_pool_bind(hw_hd) != ESP_H264_ERR_OK)) {
+        return ESP_H264_ERR_FAIL;
+    }
     /** Enable H.264 interrupt */
     if (esp_h264_intr_alloc(0, h264_gop_isr, (void *)hw_hd, &hw_hd->intr_hd) == ESP_OK) {
         hw_hd->frame_done = esp_h264_mutex_create();
@@ -242,27 +500,20 @@ static esp_h264_err_t enc_del(esp_h264_enc_handle_t enc)
 {
     if (enc) {
         esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
-        if (hw_hd->db_tmp) {
-            esp_h264_free(hw_hd->db_tmp);
-        }
 
         /** Close the encoder */
         enc_close(enc);
 
         /** Delete the parameter handle */
         esp_h264_enc_hw_del_param(hw_hd->param_hd);
-        if (hw_hd->dsc_yuv) {
-            esp_h264_free(hw_hd->dsc_yuv);
-        }
 
-        if (hw_hd->dsc_dbtmp[0]) {
-            esp_h264_free(hw_hd->dsc_dbtmp[0]);
-        }
-        if (hw_hd->dsc_dbtmp[1]) {
-            esp_h264_free(hw_hd->dsc_dbtmp[1]);
+        /** The descriptors, db_tmp and the regions of parameter handle are in the arena */
+        esp_h264_arena_del(&hw_hd->arena);
+        if (hw_hd->dsc_seg) {
+            esp_h264_free(hw_hd->dsc_seg);
         }
-        if (hw_hd->dsc_bs) {
-            esp_h264_free(hw_hd->dsc_bs);
+        if (hw_hd->pool) {
+            esp_h264_pool_detach(hw_hd->pool, hw_hd);
         }
         /** Free the encoder */
         esp_h264_free(hw_hd);
@@ -270,18 +521,28 @@ static esp_h264_err_t enc_del(esp_h264_enc_handle_t enc)
     return ESP_H264_ERR_OK;
 }
 
-esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_handle_t *out_enc)
+static esp_h264_err_t enc_hw_cfg_check(const esp_h264_enc_cfg_hw_t *cfg)
 {
-    /* Parameter check */
-    ESP_H264_RET_ON_FALSE(cfg && out_enc, ESP_H264_ERR_ARG, TAG, "Invalid h264 configure and handle parameter");
     ESP_H264_RET_ON_FALSE(cfg->pic_type == ESP_H264_RAW_FMT_O_UYY_E_VYY, ESP_H264_ERR_ARG, TAG, "Un-supported h264 picture type parameter");
     ESP_H264_RET_ON_FALSE((cfg->rc.qp_max >= cfg->rc.qp_min) && (cfg->rc.qp_max <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, TAG, "Invalid h264 QP parameter");
+    ESP_H264_RET_ON_FALSE(cfg->rc.mode < ESP_H264_RC_MODE_MAX, ESP_H264_ERR_ARG, TAG, "Invalid h264 RC mode parameter");
     ESP_H264_RET_ON_FALSE((esp_h264_enc_hw_res_check(cfg->res.width, cfg->res.height) == ESP_H264_ERR_OK), ESP_H264_ERR_ARG, TAG, "Invalid h264 resolution parameter");
     ESP_H264_RET_ON_FALSE((cfg->fps > 0) && (cfg->gop > 0), ESP_H264_ERR_ARG, TAG, "Invalid h264 FPS and GOP parameter");
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_hw_pool_handle_t pool, esp_h264_enc_handle_t *out_enc)
+{
+    /* Parameter check */
+    ESP_H264_RET_ON_FALSE(cfg && out_enc, ESP_H264_ERR_ARG, TAG, "Invalid h264 configure and handle parameter");
+    esp_h264_err_t ret = enc_hw_cfg_check(cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        return ret;
+    }
 
     /* Parameter initalization */
     *out_enc = NULL;
-    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_pool_buf_t pool_buf = { 0 };
     h264_hal_context_cfg_t cfg_h264_hal = { 0 };
     cfg_h264_hal.dual_stream_en = false;
     cfg_h264_hal.gop = cfg->gop;
@@ -306,6 +567,7 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
         .qp_min = cfg->rc.qp_min,
         .qp_max = cfg->rc.qp_max,
         .bitrate = cfg->rc.bitrate,
+        .rc_mode = cfg->rc.mode,
         .fps = cfg->fps,
     };
 
@@ -313,6 +575,23 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
     uint32_t actual_size;
     esp_h264_hw_handle_t *hw_hd = (esp_h264_hw_handle_t *)esp_h264_calloc_prefer(1, sizeof(esp_h264_hw_handle_t), &actual_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
     ESP_H264_RET_ON_FALSE(hw_hd != NULL, ESP_H264_ERR_MEM, TAG, "No memory for handle");
+    hw_hd->hal_cfg = cfg_h264_hal;
+    hw_hd->dma_cfg = cfg_h264_dma_hal;
+    hw_hd->res_max = cfg->res;
+    hw_hd->cache_align = h264_hw_cache_align();
+    if (pool) {
+        /** The working buffers are from pool */
+        void *hw_user = NULL;
+        ret = esp_h264_pool_attach(pool, cfg->res.width, cfg->res.height, &pool_buf, &hw_user);
+        ESP_H264_GOTO_ON_FALSE(ret == ESP_H264_ERR_OK, ret, __exit__, TAG, "The pool can't be used");
+        hw_hd->pool = pool;
+        if (hw_user) {
+            /** The configuration of last encoder is kept before the hardware initialization */
+            esp_h264_enc_hw_save_regs(((esp_h264_hw_handle_t *)hw_user)->param_hd);
+        }
+        param_cfg.ref = pool_buf.ref;
+        param_cfg.db = pool_buf.db;
+    }
 
     /** H.264 HAL initalization*/
     h264_hal_init(&hw_hd->h264_hal, &cfg_h264_hal);
@@ -320,6 +599,21 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
     /** H.264 DMA HAL initalization*/
     h264_dma_hal_init(&hw_hd->dma2d_hal, &cfg_h264_dma_hal);
 
+    /** One arena in internal RAM holds all the descriptors and working buffers except de-blocking filter data */
+    uint16_t db_tmp_size = esp_h264_enc_hw_max_db_tmp_buffer_size(cfg->res.width);
+    if (!pool) {
+        esp_h264_arena_reserve(&hw_hd->arena, db_tmp_size);
+        hw_hd->db_tmp_size = esp_h264_arena_region_size(db_tmp_size);
+    }
+    /** YUV, BS and two db_tmp descriptors */
+    for (size_t i = 0; i < 4; i++) {
+        esp_h264_arena_reserve(&hw_hd->arena, sizeof(h264_dma_desc_t));
+    }
+    esp_h264_enc_hw_reserve_param(&param_cfg, &hw_hd->arena);
+    ret = esp_h264_arena_create(&hw_hd->arena);
+    ESP_H264_GOTO_ON_FALSE(ret == ESP_H264_ERR_OK, ret, __exit__, TAG, "No memory for arena");
+    param_cfg.arena = &hw_hd->arena;
+
     /** Create a new parameter handle */
     param_cfg.device = h264_hal_get_param_dev0(&hw_hd->h264_hal);
     h264_hal_set_mbres(param_cfg.device, mb_width, mb_height);
@@ -330,17 +624,21 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
     esp_h264_enc_set_gop(&hw_hd->param_hd->base, cfg->gop);
 
     /** Allocated de-blocking filter temporary parameter memory*/
-    hw_hd->db_tmp = (uint8_t *)esp_h264_aligned_calloc(16, 1, esp_h264_enc_hw_max_db_tmp_buffer_size(cfg->res.width), &actual_size, ESP_H264_MEM_INTERNAL);
+    if (pool) {
+        hw_hd->db_tmp = pool_buf.db_tmp;
+    } else {
+        hw_hd->db_tmp = (uint8_t *)esp_h264_arena_alloc(&hw_hd->arena, db_tmp_size);
+    }
     ESP_H264_GOTO_ON_FALSE(hw_hd->db_tmp != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for db_tmp");
 
     /** Allocated descriptor memory*/
     for (size_t i = 0; i < 2; i++) {
-        hw_hd->dsc_dbtmp[i] = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+        hw_hd->dsc_dbtmp[i] = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
         ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_dbtmp[i] != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for DB descriptor");
     }
-    hw_hd->dsc_yuv = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    hw_hd->dsc_yuv = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_yuv != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for YUV descriptor");
-    hw_hd->dsc_bs = esp_h264_aligned_calloc(16, 1, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+    hw_hd->dsc_bs = esp_h264_arena_alloc(&hw_hd->arena, sizeof(h264_dma_desc_t));
     ESP_H264_GOTO_ON_FALSE(hw_hd->dsc_bs != NULL, ESP_H264_ERR_MEM, __exit__, TAG, "No memory for BS descriptor");
 
     /** Configure de-blocking filter temporary parameter and de-blocking data, reference picture DMA*/
@@ -353,6 +651,12 @@ esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_en
     hw_hd->base.process = enc_process;
     hw_hd->base.close = enc_close;
     hw_hd->base.del = enc_del;
+    hw_hd->base.get_stats = enc_get_stats;
+    hw_hd->base.reset_stats = enc_reset_stats;
+    if (pool) {
+        /** The hardware is programmed by this encoder now */
+        esp_h264_pool_set_hw_user(pool, hw_hd);
+    }
     *out_enc = &hw_hd->base;
     return ret;
 __exit__:
@@ -361,6 +665,63 @@ __exit__:
     return ret;
 }
 
+esp_h264_err_t esp_h264_enc_hw_new(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_handle_t *out_enc)
+{
+    return enc_hw_new(cfg, NULL, out_enc);
+}
+
+esp_h264_err_t esp_h264_enc_hw_new_with_pool(const esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_hw_pool_handle_t pool, esp_h264_enc_handle_t *out_enc)
+{
+    ESP_H264_RET_ON_FALSE(pool, ESP_H264_ERR_ARG, TAG, "Invalid pool handle");
+    return enc_hw_new(cfg, pool, out_enc);
+}
+
+esp_h264_err_t esp_h264_enc_hw_reconfigure(esp_h264_enc_handle_t enc, const esp_h264_enc_cfg_hw_t *cfg)
+{
+    ESP_H264_RET_ON_FALSE(enc && cfg, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and configure parameter");
+    esp_h264_err_t ret = enc_hw_cfg_check(cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        return ret;
+    }
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    ESP_H264_RET_ON_FALSE((cfg->res.width <= hw_hd->res_max.width) && (cfg->res.height <= hw_hd->res_max.height), ESP_H264_ERR_ARG, TAG,
+                          "The resolution is greater than the one at creation");
+    esp_h264_enc_hw_param_cfg_t param_cfg = {
+        .width = cfg->res.width,
+        .height = cfg->res.height,
+        .qp_min = cfg->rc.qp_min,
+        .qp_max = cfg->rc.qp_max,
+        .bitrate = cfg->rc.bitrate,
+        .rc_mode = cfg->rc.mode,
+        .fps = cfg->fps,
+    };
+    esp_h264_mutex_t mutex;
+    esp_h264_enc_hw_get_mutex(hw_hd->param_hd, &mutex);
+    esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
+    /** The software state is updated now, so the resolution and output buffer size of next frame are right.
+     *  The hardware is programmed before next frame, which is IDR-frame. */
+    ret = esp_h264_enc_hw_reconfig_param(hw_hd->param_hd, &param_cfg);
+    if (ret == ESP_H264_ERR_OK) {
+        esp_h264_enc_set_gop(&hw_hd->param_hd->base, cfg->gop);
+        hw_hd->reconfig_pending = true;
+    }
+    esp_h264_mutex_unlock(mutex);
+    return ret;
+}
+
+esp_h264_err_t esp_h264_enc_hw_trace_export(esp_h264_enc_handle_t enc, char *buf, uint32_t size, uint32_t *out_len)
+{
+    ESP_H264_RET_ON_FALSE(enc && buf && out_len, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle, buffer or length parameter");
+#if CONFIG_ESP_H264_TRACE
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    return h264_trace_export(&hw_hd->trace, (uint32_t)hw_hd, buf, size, out_len);
+#else
+    *out_len = 0;
+    ESP_H264_LOGE(TAG, "Please enable CONFIG_ESP_H264_TRACE");
+    return ESP_H264_ERR_UNSUPPORTED;
+#endif
+}
+
 esp_h264_err_t esp_h264_enc_hw_get_param_hd(esp_h264_enc_handle_t enc, esp_h264_enc_param_hw_handle_t *out_param)
 {
     if (enc && out_param) {
@@ -370,3 +731,100 @@ esp_h264_err_t esp_h264_enc_hw_get_param_hd(esp_h264_enc_handle_t enc, esp_h264_
     }
     return ESP_H264_ERR_ARG;
 }
+
+esp_h264_err_t esp_h264_enc_hw_get_mem_info(esp_h264_enc_handle_t enc, esp_h264_enc_hw_mem_info_t *out_info)
+{
+    ESP_H264_RET_ON_FALSE(enc && out_info, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and memory information parameter");
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    memset(out_info, 0, sizeof(esp_h264_enc_hw_mem_info_t));
+    esp_h264_enc_hw_add_param_mem_info(hw_hd->param_hd, out_info);
+    out_info->handle += sizeof(esp_h264_hw_handle_t);
+    out_info->desc += 4 * esp_h264_arena_region_size(sizeof(h264_dma_desc_t));
+    out_info->db_tmp += hw_hd->db_tmp_size;
+    out_info->arena += hw_hd->arena.size;
+    out_info->total += sizeof(esp_h264_hw_handle_t) + hw_hd->arena.size;
+    if (hw_hd->dsc_seg) {
+        /** The output segment descriptors are allocated on demand, so they are outside of the arena */
+        uint32_t seg_size = esp_h264_arena_region_size(ESP_H264_OUT_SEG_MAX * sizeof(h264_dma_desc_t));
+        out_info->desc += seg_size;
+        out_info->total += seg_size;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_out_buf_size(esp_h264_enc_handle_t enc, uint32_t *out_size)
+{
+    ESP_H264_RET_ON_FALSE(enc && out_size, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and size parameter");
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    /** Predict the frame type same as `enc_process` */
+    uint8_t frame_num = hw_hd->frame_num % hw_hd->gop;
+    bool is_iframe = (frame_num == 0) || (frame_num + hw_hd->skip_num >= hw_hd->gop) || hw_hd->reconfig_pending || hw_hd->scene_change;
+    return esp_h264_enc_hw_get_frame_size_max(hw_hd->param_hd, is_iframe, out_size);
+}
+
+esp_h264_err_t esp_h264_enc_hw_set_out_seg(esp_h264_enc_handle_t enc, const esp_h264_pkt_t *seg, uint8_t seg_num)
+{
+    ESP_H264_RET_ON_FALSE(enc && (seg || !seg_num), ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and segment parameter");
+    ESP_H264_RET_ON_FALSE(seg_num <= ESP_H264_OUT_SEG_MAX, ESP_H264_ERR_ARG, TAG, "The number of segments is greater than %d", ESP_H264_OUT_SEG_MAX);
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    /** The segments are invalidated by whole cache lines after encoding. So the segment mustn't share a cache line with other data.
+     *  The cache line is a multiple of 8 bytes, which the DMA descriptor needs. */
+    uint32_t align = hw_hd->cache_align > (HW_DMA_BUF_ALIGN_SIZE + 1) ? hw_hd->cache_align : (HW_DMA_BUF_ALIGN_SIZE + 1);
+    for (uint8_t i = 0; i < seg_num; i++) {
+        ESP_H264_RET_ON_FALSE(seg[i].buffer && seg[i].len && !((uint32_t)seg[i].buffer & (align - 1)) && !(seg[i].len & (align - 1)),
+                              ESP_H264_ERR_ARG, TAG, "The segment %d must be %d bytes aligned", i, (int)align);
+    }
+    if (seg_num && !hw_hd->dsc_seg) {
+        uint32_t actual_size;
+        hw_hd->dsc_seg = esp_h264_aligned_calloc(16, ESP_H264_OUT_SEG_MAX, sizeof(h264_dma_desc_t), &actual_size, ESP_H264_MEM_INTERNAL);
+        ESP_H264_RET_ON_FALSE(hw_hd->dsc_seg, ESP_H264_ERR_MEM, TAG, "No memory for segment descriptors");
+    }
+    esp_h264_mutex_t mutex;
+    esp_h264_enc_hw_get_mutex(hw_hd->param_hd, &mutex);
+    esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
+    memcpy(hw_hd->seg, seg, seg_num * sizeof(esp_h264_pkt_t));
+    memset(hw_hd->seg_len, 0, sizeof(hw_hd->seg_len));
+    hw_hd->seg_num = seg_num;
+    esp_h264_mutex_unlock(mutex);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_out_seg_len(esp_h264_enc_handle_t enc, uint32_t *out_len, uint8_t len_num)
+{
+    ESP_H264_RET_ON_FALSE(enc && out_len && len_num, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and length parameter");
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    for (uint8_t i = 0; i < len_num; i++) {
+        out_len[i] = (i < ESP_H264_OUT_SEG_MAX) ? hw_hd->seg_len[i] : 0;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_set_spill_buf(esp_h264_enc_handle_t enc, esp_h264_pkt_t spill)
+{
+    /** The spill buffer is one output segment */
+    return esp_h264_enc_hw_set_out_seg(enc, &spill, spill.buffer ? 1 : 0);
+}
+
+esp_h264_err_t esp_h264_enc_hw_set_buf_flags(esp_h264_enc_handle_t enc, uint32_t flags)
+{
+    ESP_H264_RET_ON_FALSE(enc, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle");
+    ESP_H264_RET_ON_FALSE(!(flags & ~(ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN | ESP_H264_ENC_HW_BUF_OUT_DEV_READ)), ESP_H264_ERR_ARG, TAG, "Invalid buffer flags");
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    esp_h264_mutex_t mutex;
+    esp_h264_enc_hw_get_mutex(hw_hd->param_hd, &mutex);
+    esp_h264_mutex_lock(mutex, ESP_H264_MAX_DELAY);
+    hw_hd->buf_flags = flags;
+    esp_h264_mutex_unlock(mutex);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_spill_len(esp_h264_enc_handle_t enc, uint32_t *out_len)
+{
+    ESP_H264_RET_ON_FALSE(enc && out_len, ESP_H264_ERR_ARG, TAG, "Invalid encoder handle and length parameter");
+    esp_h264_hw_handle_t *hw_hd = __containerof(enc, esp_h264_hw_handle_t, base);
+    *out_len = 0;
+    for (uint8_t i = 0; i < ESP_H264_OUT_SEG_MAX; i++) {
+        *out_len += hw_hd->seg_len[i];
+    }
+    return ESP_H264_ERR_OK;
+}
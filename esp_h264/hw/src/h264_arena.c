@@ -0,0 +1,61 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_alloc.h"
+#include "esp_private/esp_cache_private.h"
+#include "h264_arena.h"
+
+/* The DMA descriptor needs 16 bytes alignment at least */
+#define H264_ARENA_ALIGN_MIN (16)
+
+static uint32_t arena_align(void)
+{
+    size_t align = 0;
+    esp_cache_get_alignment(ESP_H264_MEM_INTERNAL, &align);
+    return align > H264_ARENA_ALIGN_MIN ? (uint32_t)align : H264_ARENA_ALIGN_MIN;
+}
+
+uint32_t esp_h264_arena_region_size(uint32_t size)
+{
+    return ALIGN_UP(size, arena_align());
+}
+
+void esp_h264_arena_reserve(esp_h264_arena_t *arena, uint32_t size)
+{
+    arena->size += esp_h264_arena_region_size(size);
+}
+
+esp_h264_err_t esp_h264_arena_create(esp_h264_arena_t *arena)
+{
+    uint32_t actual_size;
+    arena->buf = esp_h264_aligned_calloc(arena_align(), 1, arena->size, &actual_size, ESP_H264_MEM_INTERNAL);
+    if (arena->buf == NULL) {
+        return ESP_H264_ERR_MEM;
+    }
+    arena->size = actual_size;
+    arena->used = 0;
+    return ESP_H264_ERR_OK;
+}
+
+void *esp_h264_arena_alloc(esp_h264_arena_t *arena, uint32_t size)
+{
+    uint32_t region_size = esp_h264_arena_region_size(size);
+    if ((arena->buf == NULL) || (arena->used + region_size > arena->size)) {
+        return NULL;
+    }
+    void *region = arena->buf + arena->used;
+    arena->used += region_size;
+    return region;
+}
+
+void esp_h264_arena_del(esp_h264_arena_t *arena)
+{
+    if (arena->buf) {
+        esp_h264_free(arena->buf);
+    }
+    memset(arena, 0, sizeof(esp_h264_arena_t));
+}
@@ -0,0 +1,79 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Memory arena in internal RAM
+ *         The regions are reserved first by `esp_h264_arena_reserve`. Then the arena is allocated once by `esp_h264_arena_create`
+ *         and the regions are taken by `esp_h264_arena_alloc` in the same order. Every region is cache line aligned, so the cache
+ *         synchronization of one region never touches its neighbours.
+ *         The zero initialized structure is an empty arena.
+ */
+typedef struct {
+    uint8_t *buf;   /*<! Arena memory. NULL until `esp_h264_arena_create` */
+    uint32_t size;  /*<! Total size in byte */
+    uint32_t used;  /*<! Size taken by `esp_h264_arena_alloc` in byte */
+} esp_h264_arena_t;
+
+/**
+ * @brief  Get the size of one region in arena
+ *
+ * @param  size  The requested size in byte
+ *
+ * @return
+ *       - The size aligned to cache line
+ */
+uint32_t esp_h264_arena_region_size(uint32_t size);
+
+/**
+ * @brief  Reserve one region before the arena is created
+ *
+ * @param  arena  Arena
+ * @param  size   The region size in byte
+ */
+void esp_h264_arena_reserve(esp_h264_arena_t *arena, uint32_t size);
+
+/**
+ * @brief  Allocate the arena for all reserved regions. The memory is zero initialized.
+ *
+ * @param  arena  Arena
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_arena_create(esp_h264_arena_t *arena);
+
+/**
+ * @brief  Take one region from the arena
+ *
+ * @param  arena  Arena
+ * @param  size   The region size in byte
+ *
+ * @return
+ *       - >0    Cache line aligned region
+ *       - NULL  The arena isn't created or the region isn't reserved
+ */
+void *esp_h264_arena_alloc(esp_h264_arena_t *arena, uint32_t size);
+
+/**
+ * @brief  Free the arena. All regions are invalid then.
+ *
+ * @param  arena  Arena
+ */
+void esp_h264_arena_del(esp_h264_arena_t *arena);
+
+#ifdef __cplusplus
+}
+#endif
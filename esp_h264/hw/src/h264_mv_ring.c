@@ -0,0 +1,206 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_h264_alloc.h"
+#include "esp_h264_cache.h"
+#include "esp_h264_mutex.h"
+#include "h264_mv_ring.h"
+
+typedef enum {
+    MV_RING_FREE,   /*<! It can be used by hardware */
+    MV_RING_HW,     /*<! It is written by hardware */
+    MV_RING_READY,  /*<! It is completed and waits for application */
+    MV_RING_APP,    /*<! It is held by application */
+} mv_ring_state_t;
+
+typedef struct {
+    uint8_t        *buf;
+    uint32_t        mv_num;
+    uint32_t        seq;
+    mv_ring_state_t state;
+} mv_ring_slot_t;
+
+typedef struct esp_h264_mv_ring {
+    uint8_t           depth;
+    uint32_t          buf_len;
+    uint32_t          seq;
+    int8_t            hw_idx;
+    int8_t            last_idx;
+    esp_h264_mutex_t  mutex;
+    mv_ring_slot_t    slot[ESP_H264_MV_RING_DEPTH_MAX];
+} esp_h264_mv_ring_t;
+
+/* The oldest slot in `state`, or -1 */
+static int8_t mv_ring_oldest(esp_h264_mv_ring_t *ring, mv_ring_state_t state)
+{
+    int8_t idx = -1;
+    for (uint8_t i = 0; i < ring->depth; i++) {
+        if ((ring->slot[i].state == state) && ((idx < 0) || ((int32_t)(ring->slot[i].seq - ring->slot[idx].seq) < 0))) {
+            idx = i;
+        }
+    }
+    return idx;
+}
+
+esp_h264_mv_ring_hd_t esp_h264_enc_hw_mv_ring_new(uint8_t depth, uint32_t buf_len)
+{
+    uint32_t actual_size;
+    esp_h264_mv_ring_t *ring = esp_h264_calloc_prefer(1, sizeof(esp_h264_mv_ring_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (ring == NULL) {
+        return NULL;
+    }
+    ring->depth = depth;
+    ring->hw_idx = -1;
+    ring->last_idx = -1;
+    ring->mutex = xSemaphoreCreateMutex();
+    if (ring->mutex == NULL) {
+        goto __exit__;
+    }
+    for (uint8_t i = 0; i < depth; i++) {
+        /** The MV buffers are in PSRAM first, as they are too large for several pictures */
+        ring->slot[i].buf = esp_h264_aligned_calloc(16, 1, buf_len, &actual_size, ESP_H264_MEM_SPIRAM);
+        if (ring->slot[i].buf == NULL) {
+            ring->slot[i].buf = esp_h264_aligned_calloc(16, 1, buf_len, &actual_size, ESP_H264_MEM_INTERNAL);
+        }
+        if (ring->slot[i].buf == NULL) {
+            goto __exit__;
+        }
+        /** The buffer length is cache line aligned by allocation, so the cache is synchronized without unaligned lines */
+        ring->buf_len = actual_size;
+    }
+    return ring;
+__exit__:
+    esp_h264_enc_hw_mv_ring_del(ring);
+    return NULL;
+}
+
+uint8_t *esp_h264_mv_ring_hw_get(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t *out_len)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    if (ring->hw_idx < 0) {
+        ring->hw_idx = mv_ring_oldest(ring, MV_RING_FREE);
+    }
+    if (ring->hw_idx < 0) {
+        /** Application falls behind. The oldest MV data is dropped. */
+        ring->hw_idx = mv_ring_oldest(ring, MV_RING_READY);
+        if (ring->hw_idx == ring->last_idx) {
+            ring->last_idx = -1;
+        }
+    }
+    uint8_t *buf = NULL;
+    if (ring->hw_idx >= 0) {
+        ring->slot[ring->hw_idx].state = MV_RING_HW;
+        buf = ring->slot[ring->hw_idx].buf;
+        *out_len = ring->buf_len;
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+    return buf;
+}
+
+void esp_h264_mv_ring_hw_done(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t mv_num)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    if (ring->hw_idx >= 0) {
+        mv_ring_slot_t *slot = &ring->slot[ring->hw_idx];
+        if (mv_num * sizeof(esp_h264_enc_mv_data_t) > ring->buf_len) {
+            mv_num = ring->buf_len / sizeof(esp_h264_enc_mv_data_t);
+        }
+        esp_h264_cache_check_and_invalidate(slot->buf, ring->buf_len);
+        slot->mv_num = mv_num;
+        slot->seq = ring->seq++;
+        slot->state = MV_RING_READY;
+        ring->last_idx = ring->hw_idx;
+        ring->hw_idx = -1;
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+}
+
+void esp_h264_mv_ring_hw_cancel(esp_h264_mv_ring_hd_t mv_ring_hd)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    if (ring->hw_idx >= 0) {
+        ring->slot[ring->hw_idx].state = MV_RING_FREE;
+        ring->hw_idx = -1;
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+}
+
+const esp_h264_enc_mv_data_t *esp_h264_mv_ring_last(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t *out_mv_num)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    const esp_h264_enc_mv_data_t *mv = NULL;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    if (ring->last_idx >= 0) {
+        *out_mv_num = ring->slot[ring->last_idx].mv_num;
+        mv = (const esp_h264_enc_mv_data_t *)ring->slot[ring->last_idx].buf;
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+    return mv;
+}
+
+esp_h264_err_t esp_h264_mv_ring_acquire(esp_h264_mv_ring_hd_t mv_ring_hd, esp_h264_enc_mvm_pkt_t *out_pkt)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    int8_t idx = mv_ring_oldest(ring, MV_RING_READY);
+    if (idx >= 0) {
+        ring->slot[idx].state = MV_RING_APP;
+        out_pkt->data = (esp_h264_enc_mv_data_t *)ring->slot[idx].buf;
+        out_pkt->len = ring->slot[idx].mv_num * sizeof(esp_h264_enc_mv_data_t);
+        ret = ESP_H264_ERR_OK;
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+    return ret;
+}
+
+esp_h264_err_t esp_h264_mv_ring_release(esp_h264_mv_ring_hd_t mv_ring_hd, const esp_h264_enc_mvm_pkt_t *pkt)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    esp_h264_err_t ret = ESP_H264_ERR_ARG;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    for (uint8_t i = 0; i < ring->depth; i++) {
+        if ((ring->slot[i].buf == (uint8_t *)pkt->data) && (ring->slot[i].state == MV_RING_APP)) {
+            ring->slot[i].state = MV_RING_FREE;
+            ret = ESP_H264_ERR_OK;
+            break;
+        }
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+    return ret;
+}
+
+bool esp_h264_mv_ring_is_held(esp_h264_mv_ring_hd_t mv_ring_hd)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    bool held = false;
+    esp_h264_mutex_lock(ring->mutex, ESP_H264_MAX_DELAY);
+    for (uint8_t i = 0; i < ring->depth; i++) {
+        held |= (ring->slot[i].state == MV_RING_APP);
+    }
+    esp_h264_mutex_unlock(ring->mutex);
+    return held;
+}
+
+void esp_h264_enc_hw_mv_ring_del(esp_h264_mv_ring_hd_t mv_ring_hd)
+{
+    esp_h264_mv_ring_t *ring = (esp_h264_mv_ring_t *)mv_ring_hd;
+    if (ring == NULL) {
+        return;
+    }
+    for (uint8_t i = 0; i < ring->depth; i++) {
+        if (ring->slot[i].buf) {
+            esp_h264_free(ring->slot[i].buf);
+        }
+    }
+    if (ring->mutex) {
+        esp_h264_mutex_delete(ring->mutex);
+    }
+    esp_h264_free(ring);
+}
@@ -0,0 +1,119 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_enc_param_hw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *esp_h264_mv_ring_hd_t;  /*<! Motion vector(MV) buffer ring handle */
+
+/**
+ * @brief  Create a motion vector(MV) buffer ring
+ *         Every buffer is cache line aligned and holds the MV data of one whole picture
+ *
+ * @param  depth    The number of MV buffers
+ * @param  buf_len  The length of one MV buffer in byte
+ *
+ * @return
+ *       - >0    MV buffer ring handle
+ *       - NULL  Allcated memory failed.
+ */
+esp_h264_mv_ring_hd_t esp_h264_enc_hw_mv_ring_new(uint8_t depth, uint32_t buf_len);
+
+/**
+ * @brief  Get the MV buffer for hardware encoding
+ *         The free buffer is used first. If there isn't any free buffer, the oldest completed buffer is dropped and reused.
+ *         The buffer got but not done yet is reused by the next call.
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ * @param  out_len     The length of MV buffer in byte
+ *
+ * @return
+ *       - >0    MV buffer
+ *       - NULL  All buffers are held by application
+ */
+uint8_t *esp_h264_mv_ring_hw_get(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t *out_len);
+
+/**
+ * @brief  Complete the MV buffer from `esp_h264_mv_ring_hw_get` after hardware encoding
+ *         The cache of the buffer is invalidated here, so application can read it directly
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ * @param  mv_num      The number of MV data in the buffer
+ */
+void esp_h264_mv_ring_hw_done(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t mv_num);
+
+/**
+ * @brief  Return the MV buffer from `esp_h264_mv_ring_hw_get` without MV data, such as for I-frame
+ *         The MVM DMA isn't started, so the buffer is free again and nothing is passed to application.
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ */
+void esp_h264_mv_ring_hw_cancel(esp_h264_mv_ring_hd_t mv_ring_hd);
+
+/**
+ * @brief  Get the MV data of last completed buffer
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ * @param  out_mv_num  The number of MV data
+ *
+ * @return
+ *       - >0    MV data
+ *       - NULL  No buffer is completed
+ */
+const esp_h264_enc_mv_data_t *esp_h264_mv_ring_last(esp_h264_mv_ring_hd_t mv_ring_hd, uint32_t *out_mv_num);
+
+/**
+ * @brief  Acquire the oldest completed MV buffer. It isn't reused until it is released.
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ * @param  out_pkt     MV packet. `len` is the length of MV data in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_FAIL  No completed MV buffer
+ */
+esp_h264_err_t esp_h264_mv_ring_acquire(esp_h264_mv_ring_hd_t mv_ring_hd, esp_h264_enc_mvm_pkt_t *out_pkt);
+
+/**
+ * @brief  Release the MV buffer from `esp_h264_mv_ring_acquire`
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ * @param  pkt         MV packet
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  The packet isn't acquired from this ring
+ */
+esp_h264_err_t esp_h264_mv_ring_release(esp_h264_mv_ring_hd_t mv_ring_hd, const esp_h264_enc_mvm_pkt_t *pkt);
+
+/**
+ * @brief  Check whether any MV buffer is held by application
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ *
+ * @return
+ *       - true   Some MV buffers are held by application
+ *       - false  No MV buffer is held by application
+ */
+bool esp_h264_mv_ring_is_held(esp_h264_mv_ring_hd_t mv_ring_hd);
+
+/**
+ * @brief  Delete the MV buffer ring
+ *
+ * @param  mv_ring_hd  MV buffer ring handle
+ */
+void esp_h264_enc_hw_mv_ring_del(esp_h264_mv_ring_hd_t mv_ring_hd);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,226 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_alloc.h"
+#include "h264_mv_roi.h"
+
+/* The working boxes in clustering. When it is full, the two closest boxes are merged */
+#define MV_ROI_BOX_NUM (32)
+
+typedef struct {
+    uint8_t x0;
+    uint8_t y0;
+    uint8_t x1;
+    uint8_t y1;
+} mv_roi_box_t;
+
+typedef struct esp_h264_mv_roi {
+    esp_h264_enc_auto_roi_cfg_t cfg;
+    uint8_t                     mb_width;
+    uint8_t                     mb_height;
+    uint16_t                    mb_cnt_max;
+    uint8_t                    *mask;
+} esp_h264_mv_roi_t;
+
+#define MV_ROI_MIN(a, b) ((a) < (b) ? (a) : (b))
+#define MV_ROI_MAX(a, b) ((a) > (b) ? (a) : (b))
+#define MV_ROI_ABS(a)    ((a) < 0 ? -(a) : (a))
+
+static inline uint32_t box_area(const mv_roi_box_t *b)
+{
+    return (b->x1 - b->x0 + 1) * (b->y1 - b->y0 + 1);
+}
+
+static inline void box_union(mv_roi_box_t *dst, const mv_roi_box_t *a, const mv_roi_box_t *b)
+{
+    dst->x0 = MV_ROI_MIN(a->x0, b->x0);
+    dst->y0 = MV_ROI_MIN(a->y0, b->y0);
+    dst->x1 = MV_ROI_MAX(a->x1, b->x1);
+    dst->y1 = MV_ROI_MAX(a->y1, b->y1);
+}
+
+static inline bool box_touch(const mv_roi_box_t *a, const mv_roi_box_t *b)
+{
+    return (a->x0 <= b->x1 + 1) && (b->x0 <= a->x1 + 1) && (a->y0 <= b->y1 + 1) && (b->y0 <= a->y1 + 1);
+}
+
+static void box_remove(mv_roi_box_t *box, uint8_t *box_num, uint8_t idx)
+{
+    (*box_num)--;
+    box[idx] = box[*box_num];
+}
+
+static void box_merge_closest(mv_roi_box_t *box, uint8_t *box_num)
+{
+    /** The cost is the area added by union. So the far boxes aren't merged into a huge region. */
+    uint32_t min_cost = UINT32_MAX;
+    uint8_t min_i = 0;
+    uint8_t min_j = 1;
+    mv_roi_box_t u;
+    for (uint8_t i = 0; i < *box_num; i++) {
+        for (uint8_t j = i + 1; j < *box_num; j++) {
+            box_union(&u, &box[i], &box[j]);
+            uint32_t cost = box_area(&u) - box_area(&box[i]) - box_area(&box[j]);
+            if ((int32_t)cost < 0) {
+                cost = 0;
+            }
+            if (cost < min_cost) {
+                min_cost = cost;
+                min_i = i;
+                min_j = j;
+            }
+        }
+    }
+    box_union(&box[min_i], &box[min_i], &box[min_j]);
+    box_remove(box, box_num, min_j);
+}
+
+esp_h264_mv_roi_hd_t esp_h264_enc_hw_mv_roi_new(uint8_t mb_width, uint8_t mb_height)
+{
+    uint32_t actual_size;
+    esp_h264_mv_roi_t *mv_roi = esp_h264_calloc_prefer(1, sizeof(esp_h264_mv_roi_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (mv_roi == NULL) {
+        return NULL;
+    }
+    mv_roi->mb_width = mb_width;
+    mv_roi->mb_height = mb_height;
+    mv_roi->mb_cnt_max = mb_width * mb_height;
+    return mv_roi;
+}
+
+esp_h264_err_t esp_h264_enc_hw_mv_roi_cfg(esp_h264_mv_roi_hd_t mv_roi_hd, const esp_h264_enc_auto_roi_cfg_t *cfg)
+{
+    esp_h264_mv_roi_t *mv_roi = (esp_h264_mv_roi_t *)mv_roi_hd;
+    if (cfg->enable && (mv_roi->mask == NULL)) {
+        uint32_t actual_size;
+        mv_roi->mask = esp_h264_calloc_prefer(1, mv_roi->mb_cnt_max, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+        if (mv_roi->mask == NULL) {
+            return ESP_H264_ERR_MEM;
+        }
+    }
+    mv_roi->cfg = *cfg;
+    return ESP_H264_ERR_OK;
+}
+
+void esp_h264_enc_hw_mv_roi_set_res(esp_h264_mv_roi_hd_t mv_roi_hd, uint8_t mb_width, uint8_t mb_height)
+{
+    esp_h264_mv_roi_t *mv_roi = (esp_h264_mv_roi_t *)mv_roi_hd;
+    mv_roi->mb_width = mb_width;
+    mv_roi->mb_height = mb_height;
+}
+
+void esp_h264_enc_hw_mv_roi_get_cfg(esp_h264_mv_roi_hd_t mv_roi_hd, esp_h264_enc_auto_roi_cfg_t *cfg)
+{
+    esp_h264_mv_roi_t *mv_roi = (esp_h264_mv_roi_t *)mv_roi_hd;
+    *cfg = mv_roi->cfg;
+}
+
+uint8_t esp_h264_mv_box_cluster(const uint8_t *mask, uint8_t mb_width, uint8_t mb_height, uint8_t min_area, esp_h264_motion_box_t *out_box, uint8_t max_num)
+{
+    /** Every horizontal run of marked macroblocks joins the box above it, or starts a new box */
+    mv_roi_box_t box[MV_ROI_BOX_NUM];
+    uint8_t box_num = 0;
+    for (uint8_t y = 0; y < mb_height; y++) {
+        const uint8_t *line = mask + y * mb_width;
+        for (uint8_t x = 0; x < mb_width; x++) {
+            if (!line[x]) {
+                continue;
+            }
+            mv_roi_box_t run = { .x0 = x, .y0 = y, .y1 = y };
+            while ((x + 1 < mb_width) && line[x + 1]) {
+                x++;
+            }
+            run.x1 = x;
+            uint8_t i = 0;
+            for (; i < box_num; i++) {
+                if (box_touch(&box[i], &run)) {
+                    box_union(&box[i], &box[i], &run);
+                    break;
+                }
+            }
+            if (i < box_num) {
+                continue;
+            }
+            if (box_num == MV_ROI_BOX_NUM) {
+                box_merge_closest(box, &box_num);
+            }
+            box[box_num++] = run;
+        }
+    }
+    /** The grown boxes may touch each other now, like the two arms of `U` */
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (uint8_t i = 0; i < box_num && !merged; i++) {
+            for (uint8_t j = i + 1; j < box_num; j++) {
+                if (box_touch(&box[i], &box[j])) {
+                    box_union(&box[i], &box[i], &box[j]);
+                    box_remove(box, &box_num, j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+    /** Drop the noise */
+    for (uint8_t i = 0; i < box_num;) {
+        if (box_area(&box[i]) < min_area) {
+            box_remove(box, &box_num, i);
+        } else {
+            i++;
+        }
+    }
+    while (box_num > max_num) {
+        box_merge_closest(box, &box_num);
+    }
+    for (uint8_t i = 0; i < box_num; i++) {
+        out_box[i].x = box[i].x0;
+        out_box[i].y = box[i].y0;
+        out_box[i].len_x = box[i].x1 - box[i].x0 + 1;
+        out_box[i].len_y = box[i].y1 - box[i].y0 + 1;
+    }
+    return box_num;
+}
+
+uint8_t esp_h264_mv_roi_cluster(esp_h264_mv_roi_hd_t mv_roi_hd, const esp_h264_enc_mv_data_t *mv, uint32_t mv_num, esp_h264_enc_roi_reg_t roi_reg[ESP_H264_MV_ROI_MAX_NUM])
+{
+    esp_h264_mv_roi_t *mv_roi = (esp_h264_mv_roi_t *)mv_roi_hd;
+    if (!mv_roi->cfg.enable) {
+        return 0;
+    }
+    /** Mark the moving macroblocks. Only the macroblocks with non-zero MV are in MV data. */
+    uint8_t *mask = mv_roi->mask;
+    memset(mask, 0, mv_roi->mb_width * mv_roi->mb_height);
+    for (uint32_t i = 0; i < mv_num; i++) {
+        if ((mv[i].mb_x < mv_roi->mb_width) && (mv[i].mb_y < mv_roi->mb_height)
+                && (MV_ROI_ABS(mv[i].mv_x) + MV_ROI_ABS(mv[i].mv_y) >= mv_roi->cfg.mv_thres)) {
+            mask[mv[i].mb_y * mv_roi->mb_width + mv[i].mb_x] = 1;
+        }
+    }
+    esp_h264_motion_box_t box[ESP_H264_MV_ROI_MAX_NUM];
+    uint8_t box_num = esp_h264_mv_box_cluster(mask, mv_roi->mb_width, mv_roi->mb_height, mv_roi->cfg.min_area, box, ESP_H264_MV_ROI_MAX_NUM);
+    for (uint8_t i = 0; i < box_num; i++) {
+        roi_reg[i].x = box[i].x;
+        roi_reg[i].y = box[i].y;
+        roi_reg[i].len_x = box[i].len_x;
+        roi_reg[i].len_y = box[i].len_y;
+        roi_reg[i].qp = mv_roi->cfg.roi_delta_qp;
+        roi_reg[i].reg_idx = i;
+    }
+    return box_num;
+}
+
+void esp_h264_enc_hw_mv_roi_del(esp_h264_mv_roi_hd_t mv_roi_hd)
+{
+    if (mv_roi_hd) {
+        esp_h264_mv_roi_t *mv_roi = (esp_h264_mv_roi_t *)mv_roi_hd;
+        if (mv_roi->mask) {
+            esp_h264_free(mv_roi->mask);
+        }
+        esp_h264_free(mv_roi_hd);
+    }
+}
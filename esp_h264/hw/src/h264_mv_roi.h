@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_enc_param_hw.h"
+#include "esp_h264_enc_motion.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_H264_MV_ROI_MAX_NUM (8)  /*<! The maximum number of ROI regions from motion vector(MV) clustering */
+
+typedef void *esp_h264_mv_roi_hd_t;  /*<! Motion vector(MV) driven ROI handle */
+
+/**
+ * @brief  Create a new motion vector(MV) driven ROI handle
+ *         It is disabled until `esp_h264_enc_hw_mv_roi_cfg` enables it
+ *
+ * @param  mb_width   Width of picture in macroblock
+ * @param  mb_height  Height of picture in macroblock
+ *
+ * @return
+ *       - >0    MV driven ROI handle
+ *       - NULL  Allcated memory failed.
+ */
+esp_h264_mv_roi_hd_t esp_h264_enc_hw_mv_roi_new(uint8_t mb_width, uint8_t mb_height);
+
+/**
+ * @brief  Configure motion vector(MV) driven ROI
+ *         The moving macroblock mask is allocated when it is enabled first time
+ *
+ * @param  mv_roi_hd  MV driven ROI handle
+ * @param  cfg        MV driven ROI configuration
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_enc_hw_mv_roi_cfg(esp_h264_mv_roi_hd_t mv_roi_hd, const esp_h264_enc_auto_roi_cfg_t *cfg);
+
+/**
+ * @brief  Set the resolution of picture
+ *
+ * @param  mv_roi_hd  MV driven ROI handle
+ * @param  mb_width   Width of picture in macroblock
+ * @param  mb_height  Height of picture in macroblock. `mb_width * mb_height` isn't greater than the one at creation
+ */
+void esp_h264_enc_hw_mv_roi_set_res(esp_h264_mv_roi_hd_t mv_roi_hd, uint8_t mb_width, uint8_t mb_height);
+
+/**
+ * @brief  Get motion vector(MV) driven ROI configuration
+ *
+ * @param  mv_roi_hd  MV driven ROI handle
+ * @param  cfg        MV driven ROI configuration
+ */
+void esp_h264_enc_hw_mv_roi_get_cfg(esp_h264_mv_roi_hd_t mv_roi_hd, esp_h264_enc_auto_roi_cfg_t *cfg);
+
+/**
+ * @brief  Cluster the marked macroblocks into bounding boxes
+ *         The touching macroblocks are in the same box. When there are more than `max_num` boxes,
+ *         the two boxes whose union adds the least area are merged.
+ *
+ * @param  mask       Macroblock mask in raster order. Non-zero means marked
+ * @param  mb_width   Width of picture in macroblock
+ * @param  mb_height  Height of picture in macroblock
+ * @param  min_area   The box less than `min_area` macroblocks is dropped
+ * @param  out_box    Bounding boxes. Its length is no less than `max_num`
+ * @param  max_num    The maximum number of boxes
+ *
+ * @return
+ *       - The number of boxes
+ */
+uint8_t esp_h264_mv_box_cluster(const uint8_t *mask, uint8_t mb_width, uint8_t mb_height, uint8_t min_area, esp_h264_motion_box_t *out_box, uint8_t max_num);
+
+/**
+ * @brief  Cluster the moving macroblocks of MV data into ROI regions
+ *
+ * @param  mv_roi_hd  MV driven ROI handle
+ * @param  mv         MV data of the last encoded frame
+ * @param  mv_num     The number of MV data
+ * @param  roi_reg    ROI regions. `qp` is `roi_delta_qp` and `reg_idx` is the index in array
+ *
+ * @return
+ *       - The number of ROI regions. Zero means no motion or it is disabled
+ */
+uint8_t esp_h264_mv_roi_cluster(esp_h264_mv_roi_hd_t mv_roi_hd, const esp_h264_enc_mv_data_t *mv, uint32_t mv_num, esp_h264_enc_roi_reg_t roi_reg[ESP_H264_MV_ROI_MAX_NUM]);
+
+/**
+ * @brief  Delete motion vector(MV) driven ROI handle
+ *
+ * @param  mv_roi_hd  MV driven ROI handle
+ */
+void esp_h264_enc_hw_mv_roi_del(esp_h264_mv_roi_hd_t mv_roi_hd);
+
+#ifdef __cplusplus
+}
+#endif
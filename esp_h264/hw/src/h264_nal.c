@@ -321,3 +321,55 @@ uint16_t esp_h264_enc_hw_set_slice(uint8_t *buffer, uint32_t len, bool is_iframe
     uint16_t nal_size = nal_bs_size(&bs) + 32;
     return nal_size;
 }
+
+uint16_t esp_h264_enc_hw_set_skip_slice(uint8_t *buffer, uint32_t len, uint32_t frame_num, uint16_t mb_cnt, bool db_ena)
+{
+    uint32_t *start_code = (uint32_t *)buffer;
+    start_code[0] = 0x01000000;
+    bs_t bs = {
+        .bits_left = 8,
+        .end = buffer + len - 4,
+        .p = buffer + 4,
+        .start = buffer + 4,
+    };
+    bs.p[0] = 0;
+    uint8_t forbidden_zero_bit = 0;
+    uint8_t nal_ref_idc = 2; // The skipped frame is the reference of next P-frame. Its reconstructed picture equals to the last one.
+    uint8_t nal_unit_type = 1;
+    uint8_t first_mb_in_slice = 0;
+    uint8_t slice_type = SLICE_P5;
+    uint8_t pic_parameter_set_id = 0;
+    uint8_t num_ref_idx_active_override_flag = 0;
+    uint8_t ref_pic_list_modification_flag_l0 = 0;
+    uint8_t adaptive_ref_pic_marking_mode_flag = 0;
+    int8_t qp_delta = 0;
+    uint8_t deblocking_filter_control_present_flag = db_ena;
+
+    bs_write_u(&bs, forbidden_zero_bit, 1);
+    bs_write_u(&bs, nal_ref_idc, 2);
+    bs_write_u(&bs, nal_unit_type, 5);
+    bs_write_ue(&bs, first_mb_in_slice);
+    bs_write_ue(&bs, slice_type);
+    bs_write_ue(&bs, pic_parameter_set_id);
+    bs_write_u(&bs, frame_num, LOG_MAX_FRAME_NUM);
+    bs_write_u(&bs, num_ref_idx_active_override_flag, 1);
+    bs_write_u(&bs, ref_pic_list_modification_flag_l0, 1);
+    bs_write_u(&bs, adaptive_ref_pic_marking_mode_flag, 1);
+    bs_write_se(&bs, qp_delta);
+    if (deblocking_filter_control_present_flag) {
+        uint8_t disable_deblocking_filter_idc = !db_ena;
+        bs_write_se(&bs, disable_deblocking_filter_idc);
+        if (disable_deblocking_filter_idc != 1) {
+            uint8_t slice_alpha_c0_offset_div2 = 0;
+            uint8_t slice_beta_offset_div2 = 0;
+            bs_write_se(&bs, slice_alpha_c0_offset_div2);
+            bs_write_se(&bs, slice_beta_offset_div2);
+        }
+    }
+    /** Slice data: one skip run covers all macroblocks. P_Skip has no residual, so the de-blocking filter does nothing.
+     *  The longest zero run of `mb_skip_run` is less than 16 bits, so no emulation prevention byte is needed. */
+    bs_write_ue(&bs, mb_cnt);
+    bs_rbsp_trailing(&bs);
+    uint16_t nal_size = nal_bs_size(&bs) + 32;
+    return nal_size;
+}
@@ -55,6 +55,21 @@ uint16_t esp_h264_enc_set_pps(uint8_t *buffer, uint16_t len, uint8_t qp, bool db
  */
 uint16_t esp_h264_enc_hw_set_slice(uint8_t *buffer, uint32_t len, bool is_iframe, uint32_t frame_num, int8_t qp_delta, bool db_ena);
 
+/**
+ * @brief  Set a whole P-slice whose macroblocks are all P_Skip
+ *         The slice is generated by software without hardware encoding. The decoded picture equals to the reference picture.
+ *
+ * @param  buffer     The address is to save start code + network abstract layer(NAL) header + slice header + slice data
+ * @param  len        The length of `buffer`
+ * @param  frame_num  The number of frame
+ * @param  mb_cnt     The number of macroblocks in one picture
+ * @param  db_ena     The de-blocking filter is enable or not, true: enable, false: disable
+ *
+ * @return
+ *       - The bit length of slice. It is byte aligned.
+ */
+uint16_t esp_h264_enc_hw_set_skip_slice(uint8_t *buffer, uint32_t len, uint32_t frame_num, uint16_t mb_cnt, bool db_ena);
+
 #ifdef __cplusplus
 }
 #endif
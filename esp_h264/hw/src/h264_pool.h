@@ -0,0 +1,81 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_enc_hw_pool.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Working buffers of one encoder
+ */
+typedef struct {
+    uint8_t *ref;     /*<! Reference frame buffer */
+    uint8_t *db;      /*<! De-blocking filter data buffer */
+    uint8_t *db_tmp;  /*<! De-blocking filter temporary buffer */
+} esp_h264_pool_buf_t;
+
+/**
+ * @brief  Attach an encoder to the pool and get the working buffers
+ *
+ * @param  pool         Working buffer pool handle
+ * @param  width        Width of picture
+ * @param  height       Height of picture
+ * @param  out_buf      Working buffers
+ * @param  out_hw_user  The encoder programming the hardware last, or NULL. Save its configuration before the hardware is programmed again
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   The resolution is greater than the pool resolution
+ *       - ESP_H264_ERR_FAIL  An encoder of the pool is open
+ */
+esp_h264_err_t esp_h264_pool_attach(esp_h264_enc_hw_pool_handle_t pool, uint16_t width, uint16_t height, esp_h264_pool_buf_t *out_buf, void **out_hw_user);
+
+/**
+ * @brief  Detach an encoder from the pool
+ *
+ * @param  pool  Working buffer pool handle
+ * @param  user  The encoder
+ */
+void esp_h264_pool_detach(esp_h264_enc_hw_pool_handle_t pool, void *user);
+
+/**
+ * @brief  Acquire the hardware and the working buffers of pool for one encoder until `esp_h264_pool_release`
+ *
+ * @param  pool        Working buffer pool handle
+ * @param  user        The encoder
+ * @param  out_rebind  Whether the hardware is programmed by another encoder after `user` last released it
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_FAIL  Another encoder of the pool is open
+ */
+esp_h264_err_t esp_h264_pool_acquire(esp_h264_enc_hw_pool_handle_t pool, void *user, bool *out_rebind);
+
+/**
+ * @brief  Release the pool acquired by `esp_h264_pool_acquire`
+ *
+ * @param  pool  Working buffer pool handle
+ * @param  user  The encoder
+ */
+void esp_h264_pool_release(esp_h264_enc_hw_pool_handle_t pool, void *user);
+
+/**
+ * @brief  Mark the encoder as the last one programming the hardware
+ *
+ * @param  pool  Working buffer pool handle
+ * @param  user  The encoder
+ */
+void esp_h264_pool_set_hw_user(esp_h264_enc_hw_pool_handle_t pool, void *user);
+
+#ifdef __cplusplus
+}
+#endif
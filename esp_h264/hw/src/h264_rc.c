@@ -4,6 +4,8 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 
+#include <math.h>
+#include <string.h>
 #include "esp_h264_alloc.h"
 #include "h264_rc.h"
 
@@ -24,12 +26,22 @@ typedef struct esp_h264_rc {
     int32_t  ebits;
     int32_t  err_sum;
     uint8_t  frame_num;
+    uint8_t  mode;
+    int8_t   cap_qp;
+    int32_t  cap_bits;
+    float    mad_long;
+    bool     is_iframe;
+    uint32_t iframe_bits;
 } esp_h264_rc_t;
 
 static const int init_mad[] = { 1, 3, 4, 5, 6, 7, 8, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9, 9 };
 
 #define CLIP3(min, max, v) ((v) > (max) ? (max) : ((v) < (min) ? (min) : (v)))
 
+/* The QP raised by complexity in capped quality mode. 2.4 * log2 approximates `qcomp` 0.6 of CRF */
+#define CAPPED_CPLX_QP_MAX (3)
+#define CAPPED_CPLX_QP_K   (2.4f)
+
 void esp_h264_enc_hw_rc_del(esp_h264_rc_hd_t rc_hd)
 {
     if (rc_hd) {
@@ -37,19 +49,17 @@ void esp_h264_enc_hw_rc_del(esp_h264_rc_hd_t rc_hd)
     }
 }
 
-esp_h264_rc_hd_t esp_h264_enc_hw_rc_new(uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height)
+static void rc_init(esp_h264_rc_t *prc, uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height, esp_h264_rc_mode_t mode)
 {
-    uint32_t actual_size;
-    esp_h264_rc_t *prc = esp_h264_calloc_prefer(1, sizeof(esp_h264_rc_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
-    if (prc == NULL) {
-        return NULL;
-    }
+    memset(prc, 0, sizeof(esp_h264_rc_t));
     prc->frame_num = 0;
     prc->qp_max = qp_max;
     prc->qp_min = qp_min;
     prc->qpm = (qp_max + qp_min) >> 1;
     prc->bits_per_frame = bitrate / fps;
     prc->mb_cnt = mb_width * mb_height;
+    prc->mode = mode;
+    prc->cap_bits = bitrate;
     float mad = 8.0 / (init_mad[(53 / (prc->qpm + 1))]);
     for (uint8_t i = 0; i < 4; i++) {
         prc->frame_bits_last[i] = prc->bits_per_frame;
@@ -57,9 +67,44 @@ esp_h264_rc_hd_t esp_h264_enc_hw_rc_new(uint8_t qp_max, uint8_t qp_min, uint32_t
     }
     prc->frame_bits_last4_average = prc->bits_per_frame;
     prc->mad_last4_average = mad;
+    prc->mad_long = mad;
+}
+
+esp_h264_rc_hd_t esp_h264_enc_hw_rc_new(uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height, esp_h264_rc_mode_t mode)
+{
+    uint32_t actual_size;
+    esp_h264_rc_t *prc = esp_h264_calloc_prefer(1, sizeof(esp_h264_rc_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (prc == NULL) {
+        return NULL;
+    }
+    rc_init(prc, qp_max, qp_min, bitrate, fps, mb_width, mb_height, mode);
     return prc;
 }
 
+void esp_h264_enc_hw_rc_reinit(esp_h264_rc_hd_t rc_hd, uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height, esp_h264_rc_mode_t mode)
+{
+    rc_init((esp_h264_rc_t *)rc_hd, qp_max, qp_min, bitrate, fps, mb_width, mb_height, mode);
+}
+
+void esp_h264_enc_hw_rc_reset(esp_h264_rc_hd_t rc_hd)
+{
+    esp_h264_rc_t *prc = (esp_h264_rc_t *)rc_hd;
+    int idx = 53 / (prc->qp_average_frame + 1);
+    float mad = 8.0 / init_mad[CLIP3(0, (int)(sizeof(init_mad) / sizeof(init_mad[0])) - 1, idx)];
+    for (uint8_t i = 0; i < 4; i++) {
+        prc->frame_bits_last[i] = prc->bits_per_frame;
+        prc->mad[i] = mad;
+    }
+    prc->frame_bits_last4_average = prc->bits_per_frame;
+    prc->mad_last4_average = mad;
+    prc->mad_long = mad;
+    prc->ebits = 0;
+    prc->err_sum = 0;
+    prc->eqp = 0;
+    prc->frame_num = 0;
+    prc->iframe_bits = 0;
+}
+
 void esp_h264_enc_hw_rc_set_qp(esp_h264_rc_hd_t rc_hd, uint8_t qp_max, uint8_t qp_min)
 {
     esp_h264_rc_t *prc = (esp_h264_rc_t *)rc_hd;
@@ -71,12 +116,14 @@ void esp_h264_enc_hw_rc_set_bt_fps(esp_h264_rc_hd_t rc_hd, uint32_t bitrate, uin
 {
     esp_h264_rc_t *prc = (esp_h264_rc_t *)rc_hd;
     prc->bits_per_frame = bitrate / fps;
+    prc->cap_bits = bitrate;
 }
 
 void esp_h264_rc_start(esp_h264_rc_hd_t rc_hd, bool is_iframe, uint32_t *rate, uint32_t *pred_mad, uint8_t *qp)
 {
     esp_h264_rc_t *prc = (esp_h264_rc_t *)rc_hd;
     float mad_pred = prc->mad_last4_average;
+    prc->is_iframe = is_iframe;
     int target_frame_bits = (prc->bits_per_frame * 10 - 4 * prc->frame_bits_last4_average) / 6;
     int target_mb_bits = 0;
     prc->target_frame_bits = target_frame_bits;
@@ -84,6 +131,21 @@ void esp_h264_rc_start(esp_h264_rc_hd_t rc_hd, bool is_iframe, uint32_t *rate, u
     if (prc->mad_frame_pred < 1) {
         prc->mad_frame_pred = 1;
     }
+    if (prc->mode == ESP_H264_RC_MODE_CAPPED_QUALITY) {
+        /** Complex picture masks the quantization noise, so QP only rises with MAD above the long term average.
+         *  `cap_qp` is the extra QP when the bitrate ceiling is hit. */
+        if (mad_pred < 1) {
+            mad_pred = 1;
+        }
+        int cplx_qp = (int)(CAPPED_CPLX_QP_K * log2f(mad_pred / prc->mad_long) + 0.5f);
+        cplx_qp = CLIP3(0, CAPPED_CPLX_QP_MAX, cplx_qp);
+        prc->qpm = prc->qp_min + cplx_qp + prc->cap_qp;
+        /** No MB level RC. The rate and predicted MAD toward the bitrate would pull the QP of static MBs down. */
+        *qp = CLIP3(prc->qp_min, prc->qp_max, prc->qpm);
+        *rate = 0;
+        *pred_mad = 0;
+        return;
+    }
     prc->qpm = (uint32_t)(prc->qp_average_frame) + (int)prc->eqp;
     *qp = CLIP3(prc->qp_min, prc->qp_max, prc->qpm);
     if (!is_iframe) {
@@ -103,6 +165,9 @@ void esp_h264_rc_end(esp_h264_rc_hd_t rc_hd, uint32_t total_enc_bits, uint32_t f
     float mad_cur = 1.0 * frame_mad_sum / prc->mb_cnt;
     prc->qp_average_frame = frame_qp_sum / prc->mb_cnt;
     prc->ebits += total_enc_bits - prc->bits_per_frame;
+    if (prc->is_iframe) {
+        prc->iframe_bits = total_enc_bits;
+    }
 
     prc->mad[(prc->frame_num & 0x3)] = mad_cur;
     prc->frame_bits_last[(prc->frame_num & 0x3)] = total_enc_bits;
@@ -115,6 +180,24 @@ void esp_h264_rc_end(esp_h264_rc_hd_t rc_hd, uint32_t total_enc_bits, uint32_t f
     prc->frame_bits_last4_average >>= 2;
     prc->mad_last4_average /= 4;
 
+    if (prc->mode == ESP_H264_RC_MODE_CAPPED_QUALITY) {
+        prc->mad_long = prc->mad_long * 0.95f + mad_cur * 0.05f;
+        if (prc->mad_long < 1) {
+            prc->mad_long = 1;
+        }
+        /** The saved bits of static scene aren't banked. So the ceiling holds over one second window. */
+        if (prc->ebits < 0) {
+            prc->ebits = 0;
+        }
+        if (prc->ebits > (prc->cap_bits >> 1)) {
+            prc->cap_qp = CLIP3(0, prc->qp_max - prc->qp_min, prc->cap_qp + 1);
+        } else if ((prc->ebits < (prc->cap_bits >> 3)) && (prc->cap_qp > 0)) {
+            prc->cap_qp--;
+        }
+        prc->frame_num++;
+        return;
+    }
+
     bits_err = 1.0 * prc->frame_bits_last4_average / prc->bits_per_frame - 1.0;
     if (prc->err_sum > 10.0) {
         prc->err_sum = prc->err_sum * 0.85 + bits_err;
@@ -130,3 +213,18 @@ void esp_h264_rc_end(esp_h264_rc_hd_t rc_hd, uint32_t total_enc_bits, uint32_t f
     }
     prc->frame_num++;
 }
+
+uint32_t esp_h264_rc_get_frame_bits_max(esp_h264_rc_hd_t rc_hd, bool is_iframe)
+{
+    esp_h264_rc_t *prc = (esp_h264_rc_t *)rc_hd;
+    if (is_iframe) {
+        return prc->iframe_bits;
+    }
+    uint32_t bits = 0;
+    for (uint8_t i = 0; i < 4; i++) {
+        if (prc->frame_bits_last[i] > bits) {
+            bits = prc->frame_bits_last[i];
+        }
+    }
+    return bits;
+}
@@ -9,6 +9,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include "esp_h264_types.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -25,12 +26,27 @@ typedef void *esp_h264_rc_hd_t;  /*<! Rate control(RC) handle */
  * @param  fps        Frame per second
  * @param  mb_width   The width of picture in macroblocks
  * @param  mb_height  The height of picture in macroblock
+ * @param  mode       RC mode. In capped quality mode, `bitrate` is the ceiling instead of the target
  *
  * @return
  *       - >0    Rate control handle
  *       - NULL  Allcated memory failed.
  */
-esp_h264_rc_hd_t esp_h264_enc_hw_rc_new(uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height);
+esp_h264_rc_hd_t esp_h264_enc_hw_rc_new(uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height, esp_h264_rc_mode_t mode);
+
+/**
+ * @brief  Re-initialize the rate control handle with new configuration. All the history is dropped.
+ *
+ * @param  rc_hd      Rate control handle
+ * @param  qp_max     Maxinum of quantization parameter(QP)
+ * @param  qp_min     Mininum of quantization parameter(QP)
+ * @param  bitrate    Target bitrate desired
+ * @param  fps        Frame per second
+ * @param  mb_width   Width of picture in macroblock
+ * @param  mb_height  Height of picture in macroblock
+ * @param  mode       Rate control mode
+ */
+void esp_h264_enc_hw_rc_reinit(esp_h264_rc_hd_t rc_hd, uint8_t qp_max, uint8_t qp_min, uint32_t bitrate, uint8_t fps, uint8_t mb_width, uint8_t mb_height, esp_h264_rc_mode_t mode);
 
 /**
  * @brief  Set quantization parameter(QP)
@@ -55,8 +71,8 @@ void esp_h264_enc_hw_rc_set_bt_fps(esp_h264_rc_hd_t rc_hd, uint32_t bitrate, uin
  *
  * @param  rc_hd      Rate control handle
  * @param  is_iframe  Intra frame or not, true: it is intra frame, false: it isn't intra frame
- * @param  rate       rate = target bit / predicted bit
- * @param  pred_mad   Predicted mean absolute difference (MAD)
+ * @param  rate       rate = target bit / predicted bit. It is 0 in capped quality mode
+ * @param  pred_mad   Predicted mean absolute difference (MAD). It is 0 in capped quality mode
  * @param  qp         Quantization parameter(QP)
  */
 void esp_h264_rc_start(esp_h264_rc_hd_t rc_hd, bool is_iframe, uint32_t *rate, uint32_t *pred_mad, uint8_t *qp);
@@ -71,6 +87,25 @@ void esp_h264_rc_start(esp_h264_rc_hd_t rc_hd, bool is_iframe, uint32_t *rate, u
  */
 void esp_h264_rc_end(esp_h264_rc_hd_t rc_hd, uint32_t total_enc_bits, uint32_t frame_qp_sum, uint32_t frame_mad_sum);
 
+/**
+ * @brief  Get the largest bits of recent frames
+ *
+ * @param  rc_hd      Rate control handle
+ * @param  is_iframe  true: The bits of last I-frame. false: The largest bits of last 4 frames
+ *
+ * @return
+ *       - The bits. 0 means no I-frame is encoded after creating or resetting
+ */
+uint32_t esp_h264_rc_get_frame_bits_max(esp_h264_rc_hd_t rc_hd, bool is_iframe);
+
+/**
+ * @brief  Reset RC history
+ *         It is called on scene change. So the bits and MAD of the last scene don't disturb the new scene.
+ *
+ * @param  rc_hd  Rate control handle
+ */
+void esp_h264_enc_hw_rc_reset(esp_h264_rc_hd_t rc_hd);
+
 /**
  * @brief  Delete RC handle
  *
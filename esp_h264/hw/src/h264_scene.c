@@ -0,0 +1,242 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_alloc.h"
+#include "h264_scene.h"
+
+/* 32 bins of luma. Every 4th line and every 4th luma pair are sampled */
+#define SCENE_HIST_BIN_SHIFT (3)
+#define SCENE_HIST_BIN_NUM   (256 >> SCENE_HIST_BIN_SHIFT)
+#define SCENE_SAMPLE_LINE    (4)
+#define SCENE_SAMPLE_PAIR    (4)
+/* The P-frames of new scene are needed before MAD check */
+#define SCENE_MAD_WARM_UP    (2)
+/* The static check samples 4 x 4 luma of every macroblock, in the middle of every 4 x 4 block */
+#define SCENE_SIG_STEP       (4)
+#define SCENE_SIG_OFFSET     (2)
+
+typedef struct esp_h264_scene {
+    esp_h264_enc_scene_cfg_t cfg;
+    uint16_t                 width;
+    uint16_t                 height;
+    uint16_t                 mb_cnt;
+    uint16_t                 mb_cnt_max;
+    uint32_t                 mad_avg;
+    uint8_t                  mad_cnt;
+    bool                     hist_valid;
+    uint32_t                 hist[SCENE_HIST_BIN_NUM];
+    esp_h264_enc_skip_cfg_t  skip_cfg;
+    uint8_t                 *sig_buf;
+    uint8_t                 *ref_sig;
+    uint8_t                 *cur_sig;
+    bool                     ref_valid;
+    uint32_t                 ref_mad;
+    uint8_t                  skip_cnt;
+} esp_h264_scene_t;
+
+esp_h264_scene_hd_t esp_h264_enc_hw_scene_new(uint16_t width, uint16_t height, uint16_t mb_cnt)
+{
+    uint32_t actual_size;
+    esp_h264_scene_t *scene = esp_h264_calloc_prefer(1, sizeof(esp_h264_scene_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (scene == NULL) {
+        return NULL;
+    }
+    scene->width = width;
+    scene->height = height;
+    scene->mb_cnt = mb_cnt;
+    scene->mb_cnt_max = mb_cnt;
+    return scene;
+}
+
+void esp_h264_enc_hw_scene_set_res(esp_h264_scene_hd_t scene_hd, uint16_t width, uint16_t height, uint16_t mb_cnt)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    scene->width = width;
+    scene->height = height;
+    scene->mb_cnt = mb_cnt;
+    /** The history of last resolution can't be compared */
+    scene->mad_cnt = 0;
+    scene->hist_valid = false;
+    scene->ref_valid = false;
+    scene->skip_cnt = 0;
+}
+
+void esp_h264_enc_hw_scene_cfg(esp_h264_scene_hd_t scene_hd, const esp_h264_enc_scene_cfg_t *cfg)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    scene->cfg = *cfg;
+    scene->mad_cnt = 0;
+    scene->hist_valid = false;
+}
+
+void esp_h264_enc_hw_scene_get_cfg(esp_h264_scene_hd_t scene_hd, esp_h264_enc_scene_cfg_t *cfg)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    *cfg = scene->cfg;
+}
+
+bool esp_h264_scene_check_pic(esp_h264_scene_hd_t scene_hd, const uint8_t *pic)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    if (!scene->cfg.enable || !scene->cfg.hist_thres) {
+        return false;
+    }
+    uint32_t hist[SCENE_HIST_BIN_NUM] = { 0 };
+    uint32_t cnt = 0;
+    uint32_t stride = (scene->width * 3) >> 1;
+    /** Each line is `u y y u y y ...` or `v y y v y y ...` */
+    for (uint16_t j = 0; j < scene->height; j += SCENE_SAMPLE_LINE) {
+        const uint8_t *line = pic + j * stride;
+        for (uint32_t i = 0; i + 2 < stride; i += 3 * SCENE_SAMPLE_PAIR) {
+            hist[line[i + 1] >> SCENE_HIST_BIN_SHIFT]++;
+            hist[line[i + 2] >> SCENE_HIST_BIN_SHIFT]++;
+            cnt += 2;
+        }
+    }
+    bool is_cut = false;
+    if (scene->hist_valid) {
+        uint32_t diff = 0;
+        for (uint8_t i = 0; i < SCENE_HIST_BIN_NUM; i++) {
+            diff += hist[i] > scene->hist[i] ? hist[i] - scene->hist[i] : scene->hist[i] - hist[i];
+        }
+        /** The difference of two histogram is in [0, 2 * cnt] */
+        is_cut = (diff * 50) > (scene->cfg.hist_thres * cnt);
+    }
+    memcpy(scene->hist, hist, sizeof(hist));
+    scene->hist_valid = true;
+    if (is_cut) {
+        scene->mad_cnt = 0;
+    }
+    return is_cut;
+}
+
+bool esp_h264_scene_check_mad(esp_h264_scene_hd_t scene_hd, uint32_t mad_sum)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    if (!scene->cfg.enable || !scene->cfg.mad_thres) {
+        return false;
+    }
+    bool is_cut = false;
+    if (scene->mad_cnt >= SCENE_MAD_WARM_UP) {
+        /** The average is at least one per macroblock, so the noise of static scene isn't a scene change */
+        uint32_t mad_avg = scene->mad_avg > scene->mb_cnt ? scene->mad_avg : scene->mb_cnt;
+        is_cut = ((uint64_t)mad_sum * 100) > ((uint64_t)mad_avg * scene->cfg.mad_thres);
+    }
+    if (is_cut || (scene->mad_cnt == 0)) {
+        scene->mad_avg = mad_sum;
+        scene->mad_cnt = is_cut ? 0 : 1;
+        return is_cut;
+    }
+    scene->mad_avg = (scene->mad_avg * 3 + mad_sum) >> 2;
+    if (scene->mad_cnt < SCENE_MAD_WARM_UP) {
+        scene->mad_cnt++;
+    }
+    return false;
+}
+
+esp_h264_err_t esp_h264_enc_hw_scene_skip_cfg(esp_h264_scene_hd_t scene_hd, const esp_h264_enc_skip_cfg_t *cfg)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    if (cfg->enable && (scene->sig_buf == NULL)) {
+        /** The signature is the mean of sampled luma per macroblock. Two pictures are kept: reference and current. */
+        uint32_t actual_size;
+        scene->sig_buf = esp_h264_calloc_prefer(2, scene->mb_cnt_max, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+        if (scene->sig_buf == NULL) {
+            return ESP_H264_ERR_MEM;
+        }
+        scene->ref_sig = scene->sig_buf;
+        scene->cur_sig = scene->sig_buf + scene->mb_cnt_max;
+    }
+    scene->skip_cfg = *cfg;
+    scene->ref_valid = false;
+    scene->skip_cnt = 0;
+    return ESP_H264_ERR_OK;
+}
+
+void esp_h264_enc_hw_scene_get_skip_cfg(esp_h264_scene_hd_t scene_hd, esp_h264_enc_skip_cfg_t *cfg)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    *cfg = scene->skip_cfg;
+}
+
+static void scene_calc_sig(esp_h264_scene_t *scene, const uint8_t *pic, uint8_t *sig)
+{
+    uint16_t mb_width = (scene->width + 15) >> 4;
+    uint16_t mb_height = (scene->height + 15) >> 4;
+    uint32_t stride = (scene->width * 3) >> 1;
+    for (uint16_t mb_y = 0; mb_y < mb_height; mb_y++) {
+        for (uint16_t mb_x = 0; mb_x < mb_width; mb_x++) {
+            uint16_t sum = 0;
+            for (uint8_t j = SCENE_SIG_OFFSET; j < 16; j += SCENE_SIG_STEP) {
+                uint16_t y = (mb_y << 4) + j;
+                y = y < scene->height ? y : scene->height - 1;
+                const uint8_t *line = pic + y * stride;
+                for (uint8_t i = SCENE_SIG_OFFSET; i < 16; i += SCENE_SIG_STEP) {
+                    uint16_t x = (mb_x << 4) + i;
+                    x = x < scene->width ? x : scene->width - 1;
+                    /** Luma pair `x >> 1` is at 3 * (x >> 1) + 1 and 3 * (x >> 1) + 2 of `u y y` or `v y y` line */
+                    sum += line[3 * (x >> 1) + 1 + (x & 1)];
+                }
+            }
+            *sig++ = sum >> 4;
+        }
+    }
+}
+
+bool esp_h264_scene_check_static(esp_h264_scene_hd_t scene_hd, const uint8_t *pic)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    if (!scene->skip_cfg.enable) {
+        return false;
+    }
+    scene_calc_sig(scene, pic, scene->cur_sig);
+    if (!scene->ref_valid) {
+        return false;
+    }
+    if (scene->skip_cfg.mad_thres && (scene->ref_mad > (uint32_t)scene->skip_cfg.mad_thres * scene->mb_cnt)) {
+        return false;
+    }
+    if (scene->skip_cfg.max_skip && (scene->skip_cnt >= scene->skip_cfg.max_skip)) {
+        return false;
+    }
+    /** Compare with the last encoded picture rather than the last input. So the slow change can't be skipped for ever. */
+    for (uint16_t i = 0; i < scene->mb_cnt; i++) {
+        int diff = scene->cur_sig[i] - scene->ref_sig[i];
+        if ((diff > scene->skip_cfg.diff_thres) || (-diff > scene->skip_cfg.diff_thres)) {
+            return false;
+        }
+    }
+    scene->skip_cnt++;
+    return true;
+}
+
+void esp_h264_scene_update_ref(esp_h264_scene_hd_t scene_hd, bool is_iframe, uint32_t mad_sum)
+{
+    esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+    if (!scene->skip_cfg.enable) {
+        return;
+    }
+    /** The signature of current picture has been calculated in `esp_h264_scene_check_static` */
+    uint8_t *sig = scene->ref_sig;
+    scene->ref_sig = scene->cur_sig;
+    scene->cur_sig = sig;
+    scene->ref_valid = true;
+    /** The MAD of I-frame isn't the difference with reference. So the MAD check always encodes the frame after I-frame. */
+    scene->ref_mad = is_iframe ? UINT32_MAX : mad_sum;
+    scene->skip_cnt = 0;
+}
+
+void esp_h264_enc_hw_scene_del(esp_h264_scene_hd_t scene_hd)
+{
+    if (scene_hd) {
+        esp_h264_scene_t *scene = (esp_h264_scene_t *)scene_hd;
+        if (scene->sig_buf) {
+            esp_h264_free(scene->sig_buf);
+        }
+        esp_h264_free(scene_hd);
+    }
+}
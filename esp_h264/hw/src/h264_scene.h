@@ -0,0 +1,136 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_enc_param_hw.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *esp_h264_scene_hd_t;  /*<! Scene change detection handle */
+
+/**
+ * @brief  Create a new scene change detection handle
+ *         The detection is disabled until `esp_h264_enc_hw_scene_cfg` enables it
+ *
+ * @param  width   Width of picture
+ * @param  height  Height of picture
+ * @param  mb_cnt  The number of macroblocks in one picture
+ *
+ * @return
+ *       - >0    Scene change detection handle
+ *       - NULL  Allcated memory failed.
+ */
+esp_h264_scene_hd_t esp_h264_enc_hw_scene_new(uint16_t width, uint16_t height, uint16_t mb_cnt);
+
+/**
+ * @brief  Set the resolution of picture. The history of last resolution is dropped.
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  width     Width of picture
+ * @param  height    Height of picture
+ * @param  mb_cnt    The number of macroblocks in one picture. It isn't greater than the one at creation
+ */
+void esp_h264_enc_hw_scene_set_res(esp_h264_scene_hd_t scene_hd, uint16_t width, uint16_t height, uint16_t mb_cnt);
+
+/**
+ * @brief  Configure scene change detection
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  cfg       Scene change detection configuration
+ */
+void esp_h264_enc_hw_scene_cfg(esp_h264_scene_hd_t scene_hd, const esp_h264_enc_scene_cfg_t *cfg);
+
+/**
+ * @brief  Get scene change detection configuration
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  cfg       Scene change detection configuration
+ */
+void esp_h264_enc_hw_scene_get_cfg(esp_h264_scene_hd_t scene_hd, esp_h264_enc_scene_cfg_t *cfg);
+
+/**
+ * @brief  Check the un-encoded picture with luma histogram before encoding
+ *         The histogram of every picture is recorded to compare with the next one
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  pic       The un-encoded picture. The format is `ESP_H264_RAW_FMT_O_UYY_E_VYY`
+ *
+ * @return
+ *       - true   The picture is a scene change
+ *       - false  The picture isn't a scene change or the histogram check is disabled
+ */
+bool esp_h264_scene_check_pic(esp_h264_scene_hd_t scene_hd, const uint8_t *pic);
+
+/**
+ * @brief  Check the mean absolute difference (MAD) of P-frame after encoding
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  mad_sum   The mean absolute difference (MAD) sum of frame
+ *
+ * @return
+ *       - true   The P-frame is a scene change
+ *       - false  The P-frame isn't a scene change or the MAD check is disabled
+ */
+bool esp_h264_scene_check_mad(esp_h264_scene_hd_t scene_hd, uint32_t mad_sum);
+
+/**
+ * @brief  Configure static scene frame skipping
+ *         The luma signature buffers are allocated when it is enabled first time
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  cfg       Static scene frame skipping configuration
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_enc_hw_scene_skip_cfg(esp_h264_scene_hd_t scene_hd, const esp_h264_enc_skip_cfg_t *cfg);
+
+/**
+ * @brief  Get static scene frame skipping configuration
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  cfg       Static scene frame skipping configuration
+ */
+void esp_h264_enc_hw_scene_get_skip_cfg(esp_h264_scene_hd_t scene_hd, esp_h264_enc_skip_cfg_t *cfg);
+
+/**
+ * @brief  Check whether the un-encoded picture is static compared with the last encoded picture
+ *         The luma signature of the picture is always calculated when skipping is enabled
+ *
+ * @param  scene_hd  Scene change detection handle
+ * @param  pic       The un-encoded picture. The format is `ESP_H264_RAW_FMT_O_UYY_E_VYY`
+ *
+ * @return
+ *       - true   The picture can be skipped
+ *       - false  The picture must be encoded or skipping is disabled
+ */
+bool esp_h264_scene_check_static(esp_h264_scene_hd_t scene_hd, const uint8_t *pic);
+
+/**
+ * @brief  Record the hardware encoded picture as the reference of static check
+ *
+ * @param  scene_hd   Scene change detection handle
+ * @param  is_iframe  Intra frame or not
+ * @param  mad_sum    The mean absolute difference (MAD) sum of frame
+ */
+void esp_h264_scene_update_ref(esp_h264_scene_hd_t scene_hd, bool is_iframe, uint32_t mad_sum);
+
+/**
+ * @brief  Delete scene change detection handle
+ *
+ * @param  scene_hd  Scene change detection handle
+ */
+void esp_h264_enc_hw_scene_del(esp_h264_scene_hd_t scene_hd);
+
+#ifdef __cplusplus
+}
+#endif
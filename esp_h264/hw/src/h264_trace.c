@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include "h264_trace.h"
+
+typedef struct {
+    const char *name;
+    char        ph;   /*<! Phase of Chrome trace. 'B' begin, 'E' end, 'i' instant */
+    uint8_t     tid;
+} h264_trace_point_t;
+
+static const h264_trace_point_t trace_point[H264_TRACE_MAX] = {
+    [H264_TRACE_PROCESS_BEGIN]    = { "process",          'B', 0 },
+    [H264_TRACE_PROCESS_END]      = { "process",          'E', 0 },
+    [H264_TRACE_SLICE_HEADER]     = { "slice_header",     'i', 0 },
+    [H264_TRACE_DMA_CFG]          = { "dma_cfg",          'i', 0 },
+    [H264_TRACE_HW_START]         = { "hw_start",         'i', 0 },
+    [H264_TRACE_ISR_DB_TMP]       = { "isr_db_tmp_ready", 'i', 1 },
+    [H264_TRACE_ISR_REC]          = { "isr_rec_ready",    'i', 1 },
+    [H264_TRACE_ISR_2MB_LINE]     = { "isr_2mb_line",     'i', 1 },
+    [H264_TRACE_ISR_FRAME_DONE]   = { "isr_frame_done",   'i', 1 },
+    [H264_TRACE_FRAME_DONE]       = { "frame_done",       'i', 0 },
+    [H264_TRACE_CACHE_INVALIDATE] = { "cache_invalidate", 'i', 0 },
+    [H264_TRACE_RC_END]           = { "rc_end",           'i', 0 },
+};
+
+typedef struct {
+    char    *buf;
+    uint32_t size;
+    uint32_t len;
+} trace_writer_t;
+
+static void trace_write(trace_writer_t *w, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    /** Keep counting the length when the buffer is full. So the required size is reported. */
+    int n = vsnprintf(w->len < w->size ? w->buf + w->len : NULL, w->len < w->size ? w->size - w->len : 0, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        w->len += n;
+    }
+}
+
+esp_h264_err_t h264_trace_export(const h264_trace_t *trace, uint32_t pid, char *buf, uint32_t size, uint32_t *out_len)
+{
+    trace_writer_t w = {
+        .buf = buf,
+        .size = size,
+    };
+    uint32_t head = __atomic_load_n(&trace->head, __ATOMIC_RELAXED);
+    uint32_t num = head < H264_TRACE_DEPTH ? head : H264_TRACE_DEPTH;
+    trace_write(&w, "{\"traceEvents\":[\n");
+    trace_write(&w, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,\"args\":{\"name\":\"encoder\"}},\n", (unsigned)pid);
+    trace_write(&w, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":1,\"args\":{\"name\":\"isr\"}}", (unsigned)pid);
+    for (uint32_t i = head - num; i != head; i++) {
+        const h264_trace_evt_t *evt = &trace->evt[i & (H264_TRACE_DEPTH - 1)];
+        if (evt->id >= H264_TRACE_MAX) {
+            continue;
+        }
+        const h264_trace_point_t *point = &trace_point[evt->id];
+        trace_write(&w, ",\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%u,\"tid\":%u,%s\"args\":{\"arg\":%u}}",
+                    point->name, point->ph, (long long)evt->ts_us, (unsigned)pid, point->tid, point->ph == 'i' ? "\"s\":\"t\"," : "", evt->arg);
+    }
+    trace_write(&w, "\n]}\n");
+    *out_len = w.len;
+    return w.len < size ? ESP_H264_ERR_OK : ESP_H264_ERR_MEM;
+}
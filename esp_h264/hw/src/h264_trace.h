@@ -0,0 +1,92 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "esp_h264_types.h"
+#if CONFIG_ESP_H264_TRACE
+#include "esp_timer.h"
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* The number of events in one trace ring. It is power of 2, so the write index wraps without a lock */
+#define H264_TRACE_DEPTH (256)
+
+/**
+ * @brief  Trace point
+ */
+typedef enum {
+    H264_TRACE_PROCESS_BEGIN,     /*<! `enc_process` entry */
+    H264_TRACE_PROCESS_END,       /*<! `enc_process` exit */
+    H264_TRACE_SLICE_HEADER,      /*<! Slice header written */
+    H264_TRACE_DMA_CFG,           /*<! DMA descriptors configured */
+    H264_TRACE_HW_START,          /*<! `h264_hal_set_start` */
+    H264_TRACE_ISR_DB_TMP,        /*<! ISR branch of `H264_INTR_DB_TMP_READY` */
+    H264_TRACE_ISR_REC,           /*<! ISR branch of `H264_INTR_REC_READY` */
+    H264_TRACE_ISR_2MB_LINE,      /*<! ISR branch of `H264_INTR_2MB_LINE_DONE` */
+    H264_TRACE_ISR_FRAME_DONE,    /*<! ISR branch of `H264_INTR_FRAME_DONE` */
+    H264_TRACE_FRAME_DONE,        /*<! The encoding task wakes up by `FRAME_DONE` */
+    H264_TRACE_CACHE_INVALIDATE,  /*<! Cache of output data invalidated */
+    H264_TRACE_RC_END,            /*<! Rate control end */
+    H264_TRACE_MAX,
+} h264_trace_id_t;
+
+/**
+ * @brief  Trace event
+ */
+typedef struct {
+    int64_t  ts_us;  /*<! Timestamp in microsecond */
+    uint16_t id;     /*<! Trace point. The type is `h264_trace_id_t` */
+    uint16_t arg;    /*<! Argument of trace point */
+} h264_trace_evt_t;
+
+/**
+ * @brief  Trace ring of one encoder
+ *         The encoding task and ISR reserve the slot by an atomic increase of `head`. So no lock is taken in the hot path.
+ *         The oldest events are overwritten when the ring is full.
+ */
+typedef struct {
+    uint32_t         head;                    /*<! The number of events written */
+    h264_trace_evt_t evt[H264_TRACE_DEPTH];   /*<! Event ring */
+} h264_trace_t;
+
+#if CONFIG_ESP_H264_TRACE
+static inline void h264_trace_rec(h264_trace_t *trace, h264_trace_id_t id, uint16_t arg)
+{
+    uint32_t idx = __atomic_fetch_add(&trace->head, 1, __ATOMIC_RELAXED) & (H264_TRACE_DEPTH - 1);
+    trace->evt[idx].ts_us = esp_timer_get_time();
+    trace->evt[idx].id = id;
+    trace->evt[idx].arg = arg;
+}
+#define H264_TRACE(trace, id, arg) h264_trace_rec((trace), (id), (arg))
+#else
+#define H264_TRACE(trace, id, arg)
+#endif
+
+/**
+ * @brief  Export the trace ring as Chrome trace JSON
+ *         The events of encoding task are in thread 0, and the ones of ISR are in thread 1.
+ *
+ * @param  trace    Trace ring
+ * @param  pid      Process ID in JSON. It tells the encoders apart
+ * @param  buf      JSON buffer. It is NULL terminated
+ * @param  size     The size of `buf` in byte
+ * @param  out_len  The JSON length without NULL terminator. If `buf` is too small, it is the required length
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_MEM  `buf` is too small
+ */
+esp_h264_err_t h264_trace_export(const h264_trace_t *trace, uint32_t pid, char *buf, uint32_t size, uint32_t *out_len);
+
+#ifdef __cplusplus
+}
+#endif
@@ -33,6 +33,8 @@ typedef struct esp_h264_dec_if {
                               esp_h264_dec_out_frame_t *out_frame);                          /*<! The process function */
     esp_h264_err_t (*close)(esp_h264_dec_handle_t dec);                                      /*<! The close function */
     esp_h264_err_t (*del)(esp_h264_dec_handle_t dec);                                        /*<! The delete function */
+    esp_h264_err_t (*get_stats)(esp_h264_dec_handle_t dec, esp_h264_stats_t *stats);         /*<! The get statistics function */
+    esp_h264_err_t (*reset_stats)(esp_h264_dec_handle_t dec);                                /*<! The reset statistics function */
 } esp_h264_dec_t;
 
 /**
@@ -64,6 +66,7 @@ esp_h264_err_t esp_h264_dec_open(esp_h264_dec_handle_t dec);
  *       - ESP_H264_ERR_ARG          Invalid arguments passed
  *       - ESP_H264_ERR_MEM          Insufficient memory
  *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_BUSY         Nothing is consumed because the output frame is held. Call it again later
  *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the decoder
  */
 esp_h264_err_t esp_h264_dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_frame_t *in_frame, esp_h264_dec_out_frame_t *out_frame);
@@ -92,6 +95,35 @@ esp_h264_err_t esp_h264_dec_close(esp_h264_dec_handle_t dec);
  */
 esp_h264_err_t esp_h264_dec_del(esp_h264_dec_handle_t dec);
 
+/**
+ * @brief  This function gets the runtime statistics of the H.264 decoder
+ *         It has per-frame records of recent frames and the aggregates like latency, bitrate, QP histogram and IDR-frame size.
+ *
+ * @note  The statistics are updated at the end of `esp_h264_dec_process`.
+ *        Call it in the same task as `esp_h264_dec_process`, or the newest frame may be partly updated.
+ *
+ * @param[in]   dec        A pointer to the H.264 decoder instance
+ * @param[out]  out_stats  Statistics
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Statistics feature is not supported by the decoder
+ */
+esp_h264_err_t esp_h264_dec_get_stats(esp_h264_dec_handle_t dec, esp_h264_stats_t *out_stats);
+
+/**
+ * @brief  This function clears the runtime statistics of the H.264 decoder
+ *
+ * @param[in]  dec  A pointer to the H.264 decoder instance
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Statistics feature is not supported by the decoder
+ */
+esp_h264_err_t esp_h264_dec_reset_stats(esp_h264_dec_handle_t dec);
+
 #ifdef __cplusplus
 }
 #endif
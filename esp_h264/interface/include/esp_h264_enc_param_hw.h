@@ -12,6 +12,8 @@
 extern "C" {
 #endif
 
+#define ESP_H264_MV_RING_DEPTH_MAX (8)  /*<! The maximum number of MV buffers in the MV buffer ring */
+
 /**
  * @brief  H.264 range of interesting (ROI) mode
  */
@@ -58,9 +60,9 @@ typedef struct {
     uint8_t x;        /*<! Start position in horizontal direction. units macroblock size. Maxnium value is `mb_width`.*/
     uint8_t y;        /*<! Start position in vertical direction. units macroblock size. Maxnium value is `mb_height`.*/
     uint8_t len_x;    /*<! ROI length in horizontal direction. units macroblock size. Maxnium value is `mb_width`.
-                           And the sum `x` and `len_x` cann't gather than `mb_width`.*/
+                           And the sum `x` and `len_x` cann't be greater than `mb_width`.*/
     uint8_t len_y;    /*<! ROI length in vertical direction. units macroblock size. Maxnium value is `mb_height`.
-                           And the sum `y` and `len_y` cann't gather than `mb_height`.*/
+                           And the sum `y` and `len_y` cann't be greater than `mb_height`.*/
     int8_t  qp;       /*<! Fixed quantization parameter(QP) or delta QP
                            |-----------------------------|-------------------|----------------------------------|------------|
                            |  roi_mode                   |  ROI QP           |  NONE_ROI_QP                     |  `qp` range
@@ -93,7 +95,7 @@ typedef enum {
  */
 typedef enum {
     ESP_H264_MVM_FMT_ALL = 0,  /*<! Output all MV data except zero */
-    ESP_H264_MVM_FMT_PART,     /*<! Output horizontal or vertical direction MV data that is gather than or equal 4 */
+    ESP_H264_MVM_FMT_PART,     /*<! Output horizontal or vertical direction MV data that is greater than or equal 4 */
     ESP_H264_MVM_FMT_INVALID,  /*<! Invalid value */
 } esp_h264_enc_mvm_fmt_t;
 
@@ -129,6 +131,74 @@ typedef struct {
                                         The maximum is `mb_width * mb_height * sizeof(esp_h264_enc_mv_data_t)`*/
 } esp_h264_enc_mvm_pkt_t;
 
+/**
+ * @brief  Scene change detection configuration
+ *         The scene change frame is promoted to IDR-frame and the rate control(RC) history is reset.
+ *         So the RC won't oscillate after a cut because of huge P-frames.
+ */
+typedef struct {
+    bool     enable;      /*<! Enable scene change detection */
+    uint16_t mad_thres;   /*<! The P-frame is a scene change when its mean absolute difference (MAD) is greater than
+                               `mad_thres` percent of the average MAD of last P-frames. Zero disables the MAD check.
+                               The next frame is promoted to IDR-frame, so the frame isn't encoded twice.
+                               The recommended value is 300 */
+    uint8_t  hist_thres;  /*<! The frame is a scene change before encoding when the difference between its luma histogram
+                               and the last frame luma histogram is greater than `hist_thres` percent. The range is [0, 100].
+                               Zero disables the histogram check. It costs CPU to read the sampled luma of input frame.
+                               The recommended value is 50 */
+} esp_h264_enc_scene_cfg_t;
+
+/**
+ * @brief  Static scene frame skipping configuration
+ *         When the input frame is nearly identical to the last encoded frame, the encoder doesn't start hardware.
+ *         It outputs a P-frame whose macroblocks are all P_Skip. The frame is only a few bytes
+ *         and the decoded picture repeats the last one. The skipped frames are counted into GOP.
+ *         Only the single stream encoder skips frames.
+ */
+typedef struct {
+    bool     enable;      /*<! Enable static scene frame skipping */
+    uint8_t  diff_thres;  /*<! The frame is static when the sampled luma mean of every macroblock differs from
+                               the last encoded frame by no more than `diff_thres`. The recommended value is 2 */
+    uint8_t  mad_thres;   /*<! The frame is skipped only when the average mean absolute difference (MAD) per macroblock
+                               of the last encoded P-frame is no more than `mad_thres`. Zero disables the MAD check.
+                               The recommended value is 2 */
+    uint8_t  max_skip;    /*<! The maximum number of consecutive skipped frames. Zero means no limit */
+} esp_h264_enc_skip_cfg_t;
+
+/**
+ * @brief  Quantization parameter(QP) map
+ *         The delta QP map is compressed into the 8 ROI regions in `ESP_H264_ROI_MODE_DELTA_QP` mode.
+ *         The most frequent delta QP becomes `none_roi_delta_qp`. The map is split into uniform rectangles,
+ *         and the 8 rectangles with the largest area multiplied by delta QP difference are kept.
+ *         The other macroblocks fall back to `none_roi_delta_qp`.
+ *         The map overwrites the ROI configuration and ROI regions
+ */
+typedef struct {
+    int8_t        frame_qp;      /*<! The frame QP, the range is [0, 51]. It overrides the QP of rate control(RC).
+                                      The RC still learns from the encoded frames. Negative value means the RC decides */
+    const int8_t *delta_qp_map;  /*<! Delta QP of every macroblock in raster order, the range is [-51, 51].
+                                      The macroblock QP is the sum of delta QP and frame QP. NULL disables ROI */
+    uint32_t      map_len;       /*<! The length of `delta_qp_map`. It must be `mb_width * mb_height` */
+} esp_h264_enc_qp_map_t;
+
+/**
+ * @brief  Motion vector(MV) driven ROI configuration
+ *         After every P-frame, the moving macroblocks of MV output are clustered into up to 8 rectangles.
+ *         They are set as ROI regions in `ESP_H264_ROI_MODE_DELTA_QP` mode for the next frame.
+ *         So the moving objects get lower QP and the static background gets higher QP at the same bitrate.
+ *         If no MV packet is set by `esp_h264_enc_hw_set_mv_pkt`, the encoder allocates the MV buffer itself
+ *         and enables `ESP_H264_MVM_MODE_P16X16` when MV is disabled.
+ *         It overwrites the ROI configuration and ROI regions, so don't use it with `esp_h264_enc_hw_set_qp_map`
+ */
+typedef struct {
+    bool    enable;             /*<! Enable MV driven ROI */
+    uint8_t mv_thres;           /*<! The macroblock is moving when the sum of absolute MV in horizontal and vertical direction
+                                     is no less than `mv_thres`. The recommended value is 2 */
+    uint8_t min_area;           /*<! The moving region less than `min_area` macroblocks is noise. The recommended value is 2 */
+    int8_t  roi_delta_qp;       /*<! Delta QP of moving regions, the range is [-51, 51]. The recommended value is -4 */
+    int8_t  none_roi_delta_qp;  /*<! Delta QP of static background, the range is [-51, 51]. The recommended value is 2 */
+} esp_h264_enc_auto_roi_cfg_t;
+
 /**
  * @brief Handle for accessing hardware-specific H.264 encoder parameters
  */
@@ -147,6 +217,16 @@ typedef struct esp_h264_enc_hw_param_if {
     esp_h264_err_t (*get_mv_cfg_info)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mv_cfg_t *cfg);    /*<! Get the MV configuration parameter */
     esp_h264_err_t (*set_mv_pkt)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t mv_pkt);      /*<! Set motion vector(MV) packet */
     esp_h264_err_t (*get_mv_data_len)(esp_h264_enc_param_hw_handle_t handle, uint32_t *length);              /*<! Get motion vector(MV) buffer actual length */
+    esp_h264_err_t (*cfg_scene)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t cfg);        /*<! Configure scene change detection */
+    esp_h264_err_t (*get_scene_cfg_info)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t *cfg); /*<! Get the scene change detection configuration parameter */
+    esp_h264_err_t (*cfg_skip)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t cfg);          /*<! Configure static scene frame skipping */
+    esp_h264_err_t (*get_skip_cfg_info)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t *cfg); /*<! Get the static scene frame skipping configuration parameter */
+    esp_h264_err_t (*set_qp_map)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_qp_map_t qp_map);       /*<! Set frame QP and macroblock delta QP map */
+    esp_h264_err_t (*cfg_auto_roi)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t cfg);  /*<! Configure MV driven ROI */
+    esp_h264_err_t (*get_auto_roi_cfg_info)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t *cfg); /*<! Get the MV driven ROI configuration parameter */
+    esp_h264_err_t (*cfg_mv_ring)(esp_h264_enc_param_hw_handle_t handle, uint8_t depth);                     /*<! Configure the MV buffer ring owned by encoder */
+    esp_h264_err_t (*acquire_mv_pkt)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t *mv_pkt); /*<! Acquire the oldest completed MV packet from the MV buffer ring */
+    esp_h264_err_t (*release_mv_pkt)(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t mv_pkt);  /*<! Release the MV packet to the MV buffer ring */
 } esp_h264_enc_param_hw_t;
 
 /**
@@ -262,6 +342,154 @@ esp_h264_err_t esp_h264_enc_hw_set_mv_pkt(esp_h264_enc_param_hw_handle_t handle,
  */
 esp_h264_err_t esp_h264_enc_hw_get_mv_data_len(esp_h264_enc_param_hw_handle_t handle, uint32_t *out_length);
 
+/**
+ * @brief  Configure the motion vector (MV) buffer ring owned by encoder
+ *         Each encoded frame takes one free buffer of the ring, so the MV packet needn't be set before each process.
+ *         The completed buffers are queued in encoding order and got by `esp_h264_enc_hw_acquire_mv_pkt`.
+ *         If all buffers are completed but not acquired, the oldest one is dropped. The ring takes precedence over `esp_h264_enc_hw_set_mv_pkt`.
+ *
+ * @note  The MV output is still configured by `esp_h264_enc_hw_cfg_mv`. The I-frame and the skipped static frame have no MV packet.
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  depth   The number of MV buffers. 0 means deleting the ring, otherwise the range is [2, ESP_H264_MV_RING_DEPTH_MAX]
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Some MV packets are still held by application
+ *       - ESP_H264_ERR_UNSUPPORTED  MV buffer ring is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_cfg_mv_ring(esp_h264_enc_param_hw_handle_t handle, uint8_t depth);
+
+/**
+ * @brief  Acquire the oldest completed motion vector (MV) packet from the MV buffer ring
+ *         The cache of MV data has been invalidated, so it can be read directly.
+ *         The buffer isn't reused by encoder until `esp_h264_enc_hw_release_mv_pkt`. It can be called in other task.
+ *
+ * @param[in]   handle      It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[out]  out_mv_pkt  The MV packet. Its `len` is the length of MV data in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_FAIL         No completed MV packet or the MV buffer ring isn't configured
+ *       - ESP_H264_ERR_UNSUPPORTED  MV buffer ring is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_acquire_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t *out_mv_pkt);
+
+/**
+ * @brief  Release the motion vector (MV) packet from `esp_h264_enc_hw_acquire_mv_pkt` to the MV buffer ring
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  mv_pkt  The MV packet
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed or the MV packet isn't acquired from the ring
+ *       - ESP_H264_ERR_UNSUPPORTED  MV buffer ring is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_release_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t mv_pkt);
+
+/**
+ * @brief  Configure scene change detection
+ *         The detection is based on mean absolute difference (MAD) jump of P-frame and optional luma histogram of input frame
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  cfg     An `esp_h264_enc_scene_cfg_t` structure that specifies the scene change detection configuration
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Scene change detection is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_cfg_scene_change(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t cfg);
+
+/**
+ * @brief  Get scene change detection configuration
+ *
+ * @param[in]   handle   It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[out]  out_cfg  A pointer to an `esp_h264_enc_scene_cfg_t` structure where the configuration will be stored
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Scene change detection is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_get_scene_change_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t *out_cfg);
+
+/**
+ * @brief  Configure static scene frame skipping
+ *         It is suitable for surveillance cameras. The skipped frame saves hardware encoding power, DMA bandwidth and bitrate.
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  cfg     An `esp_h264_enc_skip_cfg_t` structure that specifies the frame skipping configuration
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_UNSUPPORTED  Frame skipping is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_cfg_static_skip(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t cfg);
+
+/**
+ * @brief  Get static scene frame skipping configuration
+ *
+ * @param[in]   handle   It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[out]  out_cfg  A pointer to an `esp_h264_enc_skip_cfg_t` structure where the configuration will be stored
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Frame skipping is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_get_static_skip_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t *out_cfg);
+
+/**
+ * @brief  Set frame quantization parameter(QP) and macroblock delta QP map
+ *         It takes effect from the next encoded frame and keeps until the next call.
+ *         So the analytics can drive the quality of every frame by calling it before each `esp_h264_enc_process`
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  qp_map  An `esp_h264_enc_qp_map_t` structure that specifies the frame QP and delta QP map
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_UNSUPPORTED  QP map is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_set_qp_map(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_qp_map_t qp_map);
+
+/**
+ * @brief  Configure motion vector(MV) driven ROI
+ *         The ROI regions are programmed by the encoder after every P-frame, no analytics is needed in application
+ *
+ * @param[in]  handle  It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[in]  cfg     An `esp_h264_enc_auto_roi_cfg_t` structure that specifies the MV driven ROI configuration
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_UNSUPPORTED  MV driven ROI is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_cfg_auto_roi(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t cfg);
+
+/**
+ * @brief  Get motion vector(MV) driven ROI configuration
+ *
+ * @param[in]   handle   It is a pointer to the hardware H.264 encoding parameters structure
+ * @param[out]  out_cfg  A pointer to an `esp_h264_enc_auto_roi_cfg_t` structure where the configuration will be stored
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  MV driven ROI is not supported by the hardware encoder
+ */
+esp_h264_err_t esp_h264_enc_hw_get_auto_roi_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t *out_cfg);
+
 #ifdef __cplusplus
 }
 #endif
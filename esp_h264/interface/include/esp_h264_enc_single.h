@@ -27,6 +27,8 @@ typedef struct esp_h264_enc_if {
                               esp_h264_enc_out_frame_t *out_frame);                          /*<! The process function */
     esp_h264_err_t (*close)(esp_h264_enc_handle_t enc);                                      /*<! The close function */
     esp_h264_err_t (*del)(esp_h264_enc_handle_t enc);                                        /*<! The delete function */
+    esp_h264_err_t (*get_stats)(esp_h264_enc_handle_t enc, esp_h264_stats_t *stats);         /*<! The get statistics function */
+    esp_h264_err_t (*reset_stats)(esp_h264_enc_handle_t enc);                                /*<! The reset statistics function */
 } esp_h264_enc_t;
 
 /**
@@ -95,6 +97,35 @@ esp_h264_err_t esp_h264_enc_close(esp_h264_enc_handle_t enc);
  */
 esp_h264_err_t esp_h264_enc_del(esp_h264_enc_handle_t enc);
 
+/**
+ * @brief  This function gets the runtime statistics of the H.264 encoder
+ *         It has per-frame records of recent frames and the aggregates like latency, bitrate, QP histogram and IDR-frame size.
+ *
+ * @note  The statistics are updated at the end of `esp_h264_enc_process`.
+ *        Call it in the same task as `esp_h264_enc_process`, or the newest frame may be partly updated.
+ *
+ * @param[in]   enc        A pointer to the H.264 encoder instance
+ * @param[out]  out_stats  Statistics
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Statistics feature is not supported by the encoder
+ */
+esp_h264_err_t esp_h264_enc_get_stats(esp_h264_enc_handle_t enc, esp_h264_stats_t *out_stats);
+
+/**
+ * @brief  This function clears the runtime statistics of the H.264 encoder
+ *
+ * @param[in]  enc  A pointer to the H.264 encoder instance
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_UNSUPPORTED  Statistics feature is not supported by the encoder
+ */
+esp_h264_err_t esp_h264_enc_reset_stats(esp_h264_enc_handle_t enc);
+
 #ifdef __cplusplus
 }
 #endif
@@ -27,6 +27,7 @@ typedef enum {
     ESP_H264_ERR_UNSUPPORTED    = -5,  /*<! Un-supported */
     ESP_H264_ERR_TIMEOUT        = -6,  /*<! Timeout */
     ESP_H264_ERR_OVERFLOW       = -7,  /*<! Buffer overflow */
+    ESP_H264_ERR_BUSY           = -8,  /*<! Resource is busy. Try again after it is released */
 } esp_h264_err_t;
 
 /**
@@ -36,11 +37,19 @@ typedef enum {
  *        |-------------------------------|--------------|--------------|--------------|
  *        | enum                          |  SW encoedr  |  HW encoder  | SW decoder   |
  *        |-------------------------------|--------------|--------------|--------------|
- *        | ESP_H264_RAW_FMT_YUYV         |  supported   | un-supported | un-supported |
+ *        | ESP_H264_RAW_FMT_YUYV         |  supported   | un-supported |  supported   |
  *        |-------------------------------|--------------|--------------|--------------|
  *        | ESP_H264_RAW_FMT_I420         |  supported   | un-supported |  supported   |
  *        |-------------------------------|--------------|--------------|--------------|
- *        | ESP_H264_RAW_FMT_O_UYY_E_VYY  | un-supported |  supported   | un-supported |
+ *        | ESP_H264_RAW_FMT_O_UYY_E_VYY  | un-supported |  supported   |  supported   |
+ *        |-------------------------------|--------------|--------------|--------------|
+ *        | ESP_H264_RAW_FMT_NV12         | un-supported | un-supported |  supported   |
+ *        |-------------------------------|--------------|--------------|--------------|
+ *        | ESP_H264_RAW_FMT_RGB565_LE    | un-supported | un-supported |  supported   |
+ *        |-------------------------------|--------------|--------------|--------------|
+ *        | ESP_H264_RAW_FMT_RGB565_BE    | un-supported | un-supported |  supported   |
+ *        |-------------------------------|--------------|--------------|--------------|
+ *        | ESP_H264_RAW_FMT_RGB888       | un-supported | un-supported |  supported   |
  *        |-------------------------------|--------------|--------------|--------------|
  */
 typedef enum {
@@ -61,6 +70,10 @@ typedef enum {
                                         |   ...       |         ...                   |
                                         |-------------|-------------------------------|
  */
+    ESP_H264_RAW_FMT_NV12,         /*<! The storage format is YUV420 semi-planer. The data order is to store all Y first then U V interleaved */
+    ESP_H264_RAW_FMT_RGB565_LE,    /*<! The storage format is RGB565 in little endian. R is in the high 5 bits of the 16 bits pixel */
+    ESP_H264_RAW_FMT_RGB565_BE,    /*<! The storage format is RGB565 in big endian, such as for SPI LCD */
+    ESP_H264_RAW_FMT_RGB888,       /*<! The storage format is RGB888 packet. The data order is R G B... for per pixel */
 } esp_h264_raw_format_t;
 
 /**
@@ -114,6 +127,29 @@ typedef struct {
                      */
 } esp_h264_resolution_t;
 
+/**
+ * @brief  Rate control(RC) mode
+ *
+ * @note
+ *        |-----------------------------------|--------------------|--------------------|
+ *        | enum                              |  SW encoder        |  HW encoder        |
+ *        |-----------------------------------|--------------------|--------------------|
+ *        | ESP_H264_RC_MODE_BITRATE          |  RC_QUALITY_MODE   |  bitrate target    |
+ *        |-----------------------------------|--------------------|--------------------|
+ *        | ESP_H264_RC_MODE_CAPPED_QUALITY   |  RC_QUALITY_MODE   |  capped quality    |
+ *        |-----------------------------------|--------------------|--------------------|
+ */
+typedef enum {
+    ESP_H264_RC_MODE_BITRATE        = 0,  /*<! The output stream is controlled to approach `bitrate`. It is the default mode */
+    ESP_H264_RC_MODE_CAPPED_QUALITY = 1,  /*<! Constant quality with a bitrate ceiling (CRF/VBR like)
+                                               QP starts from `qp_min` and follows the picture complexity (MAD).
+                                               Bits are only reduced when the output exceeds `bitrate`,
+                                               so static scenes cost much less than `bitrate`. It suits local storage recording.
+                                               The software encoder has no such RC. It controls the output to `bitrate`
+                                               with the same QP range, so `bitrate` is still the ceiling */
+    ESP_H264_RC_MODE_MAX,                 /*<! Invalid RC mode */
+} esp_h264_rc_mode_t;
+
 /**
  * @brief  Rate control(RC) parameter
  *         The size of the output stream approaching the target stream is controlled
@@ -128,7 +164,8 @@ typedef struct {
                             The smaller QP, the better video quality and the lower compression rate.*/
     uint8_t  qp_max;   /*<! Maxinum of quantization parameter(QP). The range is [0, 51].
                             The smaller QP, the better video quality and the lower compression rate.
-                            It must gather than or equal `qp_min`.*/
+                            It must be greater than or equal `qp_min`.*/
+    esp_h264_rc_mode_t mode;  /*<! RC mode. In `ESP_H264_RC_MODE_CAPPED_QUALITY` mode, `bitrate` is the ceiling instead of the target */
 } esp_h264_enc_rc_t;
 
 /**
@@ -141,9 +178,9 @@ typedef struct {
                                           that is, the FPS, which is generally 25 or 30, but other values can also be set. */
     uint8_t               fps;       /*<! Maxinum input frames per second
                                           The higher FPS, the more coherent and realistic the video.
-                                          When FPS is gather than 24, the general video seems coherent.
-                                          When FPS is gather than 30, the game video seems coherent.
-                                          When FPS is gather than 75, increase FPS, the video fluency isn't obvious.*/
+                                          When FPS is greater than 24, the general video seems coherent.
+                                          When FPS is greater than 30, the game video seems coherent.
+                                          When FPS is greater than 75, increase FPS, the video fluency isn't obvious.*/
     esp_h264_resolution_t res;       /*<! Picture resolution */
     esp_h264_enc_rc_t     rc;        /*<! RC parameter */
 } esp_h264_enc_cfg_t;
@@ -191,6 +228,9 @@ typedef struct {
                                             Commonly time base in TS stream is {1, 90000}.  So PTS uint is 1/90000 second.
                                             If time base is milliseconed, PTS uint is 1 / 1000 second .
                                             If H.264 encode data have only I-frame and P-frame, the DTS is equal to PTS. */
+    uint32_t              damaged_mb;  /*<! The number of concealed macroblocks in the picture. It is estimated from the slices
+                                            with error and the lost slices or pictures the decoder can detect. Zero doesn't
+                                            mean no loss. It is valid if the decoder supports error concealment */
 } esp_h264_dec_out_frame_t;
 
 /**
@@ -226,6 +266,42 @@ typedef struct {
  */
 } esp_h264_dec_in_frame_t;
 
+#define ESP_H264_STATS_FRAME_NUM  (16)  /*<! The number of recent frame records in statistics */
+#define ESP_H264_STATS_QP_BIN_NUM (13)  /*<! The number of bins in QP histogram. Every bin has 4 QPs */
+
+/**
+ * @brief  Statistics of one frame
+ */
+typedef struct {
+    esp_h264_frame_type_t frame_type;  /*<! Frame type. It is `ESP_H264_FRAME_TYPE_INVALID` if the codec doesn't report it */
+    uint8_t               qp;          /*<! Average QP of frame. It is 0 if the codec doesn't report it, or the static frame is skipped */
+    uint16_t              mad;         /*<! Average mean absolute difference(MAD) of macroblock. It is 0 for I-frame or if the codec doesn't report it */
+    uint32_t              len;         /*<! Encoded data length in byte. For decoder, it is the consumed length */
+    uint32_t              latency_us;  /*<! Process time in microsecond */
+} esp_h264_frame_stats_t;
+
+/**
+ * @brief  Runtime statistics of encoder or decoder
+ *         The counters and the QP histogram are accumulated since creation or last reset.
+ *         The latency and bitrate are from the recent frames in `frame_stats`.
+ */
+typedef struct {
+    uint32_t               frame_num;                             /*<! The number of processed frames */
+    uint32_t               idr_num;                               /*<! The number of IDR-frames */
+    uint32_t               err_num;                               /*<! The number of failed process except timeout and overflow */
+    uint32_t               timeout_num;                           /*<! The number of timeout */
+    uint32_t               overflow_num;                          /*<! The number of output buffer overflow */
+    uint32_t               latency_avg_us;                        /*<! Average process time of recent frames in microsecond */
+    uint32_t               latency_max_us;                        /*<! Maximum process time of recent frames in microsecond */
+    uint32_t               bitrate;                               /*<! Bitrate of recent frames in bit per second.
+                                                                       Encoder counts it by FPS, decoder counts it by wall time */
+    uint32_t               idr_len_last;                          /*<! Length of last IDR-frame in byte */
+    uint32_t               idr_len_max;                           /*<! Maximum length of IDR-frame in byte */
+    uint32_t               qp_hist[ESP_H264_STATS_QP_BIN_NUM];    /*<! QP histogram. Bin `i` is the number of frames with QP in [4 * i, 4 * i + 3] */
+    uint8_t                frame_stats_num;                       /*<! The number of valid records in `frame_stats` */
+    esp_h264_frame_stats_t frame_stats[ESP_H264_STATS_FRAME_NUM]; /*<! Recent frame records. The oldest one is the first */
+} esp_h264_stats_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -37,3 +37,17 @@ esp_h264_err_t esp_h264_dec_del(esp_h264_dec_handle_t dec)
     ESP_H264_RET_ON_FALSE(dec->del, ESP_H264_ERR_UNSUPPORTED, TAG, "Delete function is not supported yet");
     return dec->del(dec);
 }
+
+esp_h264_err_t esp_h264_dec_get_stats(esp_h264_dec_handle_t dec, esp_h264_stats_t *out_stats)
+{
+    ESP_H264_RET_ON_FALSE(dec && out_stats, ESP_H264_ERR_ARG, TAG, "Invalid h264 handle or statistics pointer");
+    ESP_H264_RET_ON_FALSE(dec->get_stats, ESP_H264_ERR_UNSUPPORTED, TAG, "Get statistics function is not supported yet");
+    return dec->get_stats(dec, out_stats);
+}
+
+esp_h264_err_t esp_h264_dec_reset_stats(esp_h264_dec_handle_t dec)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid h264 handle");
+    ESP_H264_RET_ON_FALSE(dec->reset_stats, ESP_H264_ERR_UNSUPPORTED, TAG, "Reset statistics function is not supported yet");
+    return dec->reset_stats(dec);
+}
@@ -29,7 +29,7 @@ esp_h264_err_t esp_h264_enc_hw_get_roi_cfg_info(esp_h264_enc_param_hw_handle_t h
 esp_h264_err_t esp_h264_enc_hw_set_roi_region(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_roi_reg_t roi_reg)
 {
     ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
-    ESP_H264_RET_ON_FALSE(roi_reg.qp <= ESP_H264_QP_MAX, ESP_H264_ERR_ARG, TAG, "ROI region QP is gather than 51");
+    ESP_H264_RET_ON_FALSE(roi_reg.qp <= ESP_H264_QP_MAX, ESP_H264_ERR_ARG, TAG, "ROI region QP is greater than 51");
     ESP_H264_RET_ON_FALSE(handle->set_roi_reg, ESP_H264_ERR_UNSUPPORTED, TAG, "`set_roi_reg` is not supported yet");
     return handle->set_roi_reg(handle, roi_reg);
 }
@@ -45,8 +45,8 @@ esp_h264_err_t esp_h264_enc_hw_get_roi_region(esp_h264_enc_param_hw_handle_t han
 esp_h264_err_t esp_h264_enc_hw_cfg_mv(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mv_cfg_t cfg)
 {
     ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
-    ESP_H264_RET_ON_FALSE(cfg.mv_mode < ESP_H264_MVM_MODE_INVALID, ESP_H264_ERR_ARG, TAG, "The MV mode is gather than or equal ESP_H264_MVM_MODE_INVALID");
-    ESP_H264_RET_ON_FALSE(cfg.mv_fmt < ESP_H264_MVM_FMT_INVALID, ESP_H264_ERR_ARG, TAG, "The MV format is gather than or equal ESP_H264_MVM_FMT_INVALID");
+    ESP_H264_RET_ON_FALSE(cfg.mv_mode < ESP_H264_MVM_MODE_INVALID, ESP_H264_ERR_ARG, TAG, "The MV mode is greater than or equal ESP_H264_MVM_MODE_INVALID");
+    ESP_H264_RET_ON_FALSE(cfg.mv_fmt < ESP_H264_MVM_FMT_INVALID, ESP_H264_ERR_ARG, TAG, "The MV format is greater than or equal ESP_H264_MVM_FMT_INVALID");
     ESP_H264_RET_ON_FALSE(handle->cfg_mv, ESP_H264_ERR_UNSUPPORTED, TAG, "`cfg_mv` is not supported yet");
     return handle->cfg_mv(handle, cfg);
 }
@@ -75,3 +75,83 @@ esp_h264_err_t esp_h264_enc_hw_get_mv_data_len(esp_h264_enc_param_hw_handle_t ha
     ESP_H264_RET_ON_FALSE(handle->get_mv_data_len, ESP_H264_ERR_UNSUPPORTED, TAG, "`get_mv_data_len` is not supported yet");
     return handle->get_mv_data_len(handle, out_length);
 }
+
+esp_h264_err_t esp_h264_enc_hw_cfg_mv_ring(esp_h264_enc_param_hw_handle_t handle, uint8_t depth)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE((depth == 0) || ((depth >= 2) && (depth <= ESP_H264_MV_RING_DEPTH_MAX)), ESP_H264_ERR_ARG, TAG, "Invalid MV buffer ring depth");
+    ESP_H264_RET_ON_FALSE(handle->cfg_mv_ring, ESP_H264_ERR_UNSUPPORTED, TAG, "`cfg_mv_ring` is not supported yet");
+    return handle->cfg_mv_ring(handle, depth);
+}
+
+esp_h264_err_t esp_h264_enc_hw_acquire_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t *out_mv_pkt)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(out_mv_pkt, ESP_H264_ERR_ARG, TAG, "The out MV packet pointer is NULL");
+    ESP_H264_RET_ON_FALSE(handle->acquire_mv_pkt, ESP_H264_ERR_UNSUPPORTED, TAG, "`acquire_mv_pkt` is not supported yet");
+    return handle->acquire_mv_pkt(handle, out_mv_pkt);
+}
+
+esp_h264_err_t esp_h264_enc_hw_release_mv_pkt(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_mvm_pkt_t mv_pkt)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(mv_pkt.data, ESP_H264_ERR_ARG, TAG, "The MV packet data is NULL.");
+    ESP_H264_RET_ON_FALSE(handle->release_mv_pkt, ESP_H264_ERR_UNSUPPORTED, TAG, "`release_mv_pkt` is not supported yet");
+    return handle->release_mv_pkt(handle, mv_pkt);
+}
+
+esp_h264_err_t esp_h264_enc_hw_cfg_scene_change(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(cfg.hist_thres <= 100, ESP_H264_ERR_ARG, TAG, "The histogram threshold is greater than 100");
+    ESP_H264_RET_ON_FALSE(handle->cfg_scene, ESP_H264_ERR_UNSUPPORTED, TAG, "`cfg_scene` is not supported yet");
+    return handle->cfg_scene(handle, cfg);
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_scene_change_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_scene_cfg_t *out_cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(out_cfg, ESP_H264_ERR_ARG, TAG, "The out scene change configure pointer is NULL");
+    ESP_H264_RET_ON_FALSE(handle->get_scene_cfg_info, ESP_H264_ERR_UNSUPPORTED, TAG, "`get_scene_cfg_info` is not supported yet");
+    return handle->get_scene_cfg_info(handle, out_cfg);
+}
+
+esp_h264_err_t esp_h264_enc_hw_cfg_static_skip(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(handle->cfg_skip, ESP_H264_ERR_UNSUPPORTED, TAG, "`cfg_skip` is not supported yet");
+    return handle->cfg_skip(handle, cfg);
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_static_skip_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_skip_cfg_t *out_cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(out_cfg, ESP_H264_ERR_ARG, TAG, "The out frame skipping configure pointer is NULL");
+    ESP_H264_RET_ON_FALSE(handle->get_skip_cfg_info, ESP_H264_ERR_UNSUPPORTED, TAG, "`get_skip_cfg_info` is not supported yet");
+    return handle->get_skip_cfg_info(handle, out_cfg);
+}
+
+esp_h264_err_t esp_h264_enc_hw_set_qp_map(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_qp_map_t qp_map)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(qp_map.frame_qp <= ESP_H264_QP_MAX, ESP_H264_ERR_ARG, TAG, "The frame QP is greater than 51");
+    ESP_H264_RET_ON_FALSE(handle->set_qp_map, ESP_H264_ERR_UNSUPPORTED, TAG, "`set_qp_map` is not supported yet");
+    return handle->set_qp_map(handle, qp_map);
+}
+
+esp_h264_err_t esp_h264_enc_hw_cfg_auto_roi(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE((cfg.roi_delta_qp >= -ESP_H264_QP_MAX) && (cfg.roi_delta_qp <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, TAG, "The ROI delta QP is out of [-51, 51]");
+    ESP_H264_RET_ON_FALSE((cfg.none_roi_delta_qp >= -ESP_H264_QP_MAX) && (cfg.none_roi_delta_qp <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, TAG, "The none ROI delta QP is out of [-51, 51]");
+    ESP_H264_RET_ON_FALSE(handle->cfg_auto_roi, ESP_H264_ERR_UNSUPPORTED, TAG, "`cfg_auto_roi` is not supported yet");
+    return handle->cfg_auto_roi(handle, cfg);
+}
+
+esp_h264_err_t esp_h264_enc_hw_get_auto_roi_cfg_info(esp_h264_enc_param_hw_handle_t handle, esp_h264_enc_auto_roi_cfg_t *out_cfg)
+{
+    ESP_H264_RET_ON_FALSE(handle, ESP_H264_ERR_ARG, TAG, "Invalid h264 parameter");
+    ESP_H264_RET_ON_FALSE(out_cfg, ESP_H264_ERR_ARG, TAG, "The out MV driven ROI configure pointer is NULL");
+    ESP_H264_RET_ON_FALSE(handle->get_auto_roi_cfg_info, ESP_H264_ERR_UNSUPPORTED, TAG, "`get_auto_roi_cfg_info` is not supported yet");
+    return handle->get_auto_roi_cfg_info(handle, out_cfg);
+}
@@ -38,3 +38,17 @@ esp_h264_err_t esp_h264_enc_del(esp_h264_enc_handle_t enc)
     ESP_H264_RET_ON_FALSE(enc->del, ESP_H264_ERR_UNSUPPORTED, TAG, "Delete function is not supported yet");
     return enc->del(enc);
 }
+
+esp_h264_err_t esp_h264_enc_get_stats(esp_h264_enc_handle_t enc, esp_h264_stats_t *out_stats)
+{
+    ESP_H264_RET_ON_FALSE(enc && out_stats, ESP_H264_ERR_ARG, TAG, "Invalid h264 handle or statistics pointer");
+    ESP_H264_RET_ON_FALSE(enc->get_stats, ESP_H264_ERR_UNSUPPORTED, TAG, "Get statistics function is not supported yet");
+    return enc->get_stats(enc, out_stats);
+}
+
+esp_h264_err_t esp_h264_enc_reset_stats(esp_h264_enc_handle_t enc)
+{
+    ESP_H264_RET_ON_FALSE(enc, ESP_H264_ERR_ARG, TAG, "Invalid h264 handle");
+    ESP_H264_RET_ON_FALSE(enc->reset_stats, ESP_H264_ERR_UNSUPPORTED, TAG, "Reset statistics function is not supported yet");
+    return enc->reset_stats(enc);
+}
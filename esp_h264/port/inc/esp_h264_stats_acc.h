@@ -0,0 +1,73 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Statistics accumulator
+ *         One frame costs a few counters and one record write, so it is always enabled.
+ *         The zero initialized structure is an empty accumulator.
+ */
+typedef struct {
+    uint32_t               frame_num;
+    uint32_t               idr_num;
+    uint32_t               err_num;
+    uint32_t               timeout_num;
+    uint32_t               overflow_num;
+    uint32_t               idr_len_last;
+    uint32_t               idr_len_max;
+    uint32_t               qp_hist[ESP_H264_STATS_QP_BIN_NUM];
+    uint8_t                rec_idx;                              /*<! The next record to write */
+    uint8_t                rec_num;                              /*<! The number of valid records */
+    esp_h264_frame_stats_t rec[ESP_H264_STATS_FRAME_NUM];
+    int64_t                rec_end_us[ESP_H264_STATS_FRAME_NUM]; /*<! The end time of every record */
+} esp_h264_stats_acc_t;
+
+/**
+ * @brief  Get the start time of one process
+ *
+ * @return
+ *       - Time in microsecond
+ */
+int64_t esp_h264_stats_acc_start(void);
+
+/**
+ * @brief  Add one processed frame
+ *         The record is only added for the succeeded process. The failed one only counts the error.
+ *
+ * @param  acc       Statistics accumulator
+ * @param  start_us  The time from `esp_h264_stats_acc_start`
+ * @param  rec       Frame record. `latency_us` is filled here
+ * @param  ret       The result of process
+ */
+void esp_h264_stats_acc_add(esp_h264_stats_acc_t *acc, int64_t start_us, esp_h264_frame_stats_t *rec, esp_h264_err_t ret);
+
+/**
+ * @brief  Get the statistics
+ *
+ * @param  acc       Statistics accumulator
+ * @param  fps       Frames per second. If it is 0, the bitrate is counted by wall time
+ * @param  out_stats Statistics
+ */
+void esp_h264_stats_acc_get(const esp_h264_stats_acc_t *acc, uint8_t fps, esp_h264_stats_t *out_stats);
+
+/**
+ * @brief  Reset the statistics accumulator
+ *
+ * @param  acc  Statistics accumulator
+ */
+void esp_h264_stats_acc_reset(esp_h264_stats_acc_t *acc);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,98 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_timer.h"
+#include "esp_h264_stats_acc.h"
+
+int64_t esp_h264_stats_acc_start(void)
+{
+    return esp_timer_get_time();
+}
+
+void esp_h264_stats_acc_add(esp_h264_stats_acc_t *acc, int64_t start_us, esp_h264_frame_stats_t *rec, esp_h264_err_t ret)
+{
+    int64_t end_us = esp_timer_get_time();
+    switch (ret) {
+    case ESP_H264_ERR_OK:
+        break;
+    case ESP_H264_ERR_TIMEOUT:
+        acc->timeout_num++;
+        return;
+    case ESP_H264_ERR_OVERFLOW:
+        acc->overflow_num++;
+        return;
+    default:
+        acc->err_num++;
+        return;
+    }
+    rec->latency_us = (uint32_t)(end_us - start_us);
+    acc->frame_num++;
+    if (rec->frame_type == ESP_H264_FRAME_TYPE_IDR) {
+        acc->idr_num++;
+        acc->idr_len_last = rec->len;
+        if (rec->len > acc->idr_len_max) {
+            acc->idr_len_max = rec->len;
+        }
+    }
+    if (rec->qp) {
+        uint8_t bin = rec->qp >> 2;
+        acc->qp_hist[bin < ESP_H264_STATS_QP_BIN_NUM ? bin : ESP_H264_STATS_QP_BIN_NUM - 1]++;
+    }
+    acc->rec[acc->rec_idx] = *rec;
+    acc->rec_end_us[acc->rec_idx] = end_us;
+    acc->rec_idx = (acc->rec_idx + 1) % ESP_H264_STATS_FRAME_NUM;
+    if (acc->rec_num < ESP_H264_STATS_FRAME_NUM) {
+        acc->rec_num++;
+    }
+}
+
+void esp_h264_stats_acc_get(const esp_h264_stats_acc_t *acc, uint8_t fps, esp_h264_stats_t *out_stats)
+{
+    memset(out_stats, 0, sizeof(esp_h264_stats_t));
+    out_stats->frame_num = acc->frame_num;
+    out_stats->idr_num = acc->idr_num;
+    out_stats->err_num = acc->err_num;
+    out_stats->timeout_num = acc->timeout_num;
+    out_stats->overflow_num = acc->overflow_num;
+    out_stats->idr_len_last = acc->idr_len_last;
+    out_stats->idr_len_max = acc->idr_len_max;
+    memcpy(out_stats->qp_hist, acc->qp_hist, sizeof(acc->qp_hist));
+    out_stats->frame_stats_num = acc->rec_num;
+    if (acc->rec_num == 0) {
+        return;
+    }
+    /** The records are copied from the oldest one */
+    uint8_t first = (acc->rec_idx + ESP_H264_STATS_FRAME_NUM - acc->rec_num) % ESP_H264_STATS_FRAME_NUM;
+    uint64_t latency_sum = 0;
+    uint64_t bits = 0;
+    for (uint8_t i = 0; i < acc->rec_num; i++) {
+        const esp_h264_frame_stats_t *rec = &acc->rec[(first + i) % ESP_H264_STATS_FRAME_NUM];
+        out_stats->frame_stats[i] = *rec;
+        latency_sum += rec->latency_us;
+        bits += (uint64_t)rec->len << 3;
+        if (rec->latency_us > out_stats->latency_max_us) {
+            out_stats->latency_max_us = rec->latency_us;
+        }
+    }
+    out_stats->latency_avg_us = (uint32_t)(latency_sum / acc->rec_num);
+    if (fps) {
+        out_stats->bitrate = (uint32_t)(bits * fps / acc->rec_num);
+        return;
+    }
+    /** The span from the end of oldest frame to the end of newest frame covers `rec_num - 1` frames */
+    uint8_t last = (acc->rec_idx + ESP_H264_STATS_FRAME_NUM - 1) % ESP_H264_STATS_FRAME_NUM;
+    int64_t span_us = acc->rec_end_us[last] - acc->rec_end_us[first];
+    if ((acc->rec_num > 1) && (span_us > 0)) {
+        bits -= (uint64_t)acc->rec[first].len << 3;
+        out_stats->bitrate = (uint32_t)(bits * 1000000 / span_us);
+    }
+}
+
+void esp_h264_stats_acc_reset(esp_h264_stats_acc_t *acc)
+{
+    memset(acc, 0, sizeof(esp_h264_stats_acc_t));
+}
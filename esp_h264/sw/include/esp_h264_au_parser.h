@@ -0,0 +1,104 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ESP_H264_AU_NAL_MAX (16)  /*<! The maximum number of NAL units listed in one access unit */
+
+/**
+ * @brief  Access unit(AU) parser handle
+ */
+typedef struct esp_h264_au_parser *esp_h264_au_parser_handle_t;
+
+/**
+ * @brief  Access unit parser configure information
+ */
+typedef struct {
+    uint32_t buf_size;  /*<! The size of assembly buffer in byte. It must be larger than the largest access unit
+                             that crosses the boundary of input chunks */
+} esp_h264_au_parser_cfg_t;
+
+/**
+ * @brief  One access unit in Annex-B byte stream
+ *         It is one picture with its parameter sets and SEI. It can be passed to `esp_h264_dec_process` as it is.
+ */
+typedef struct {
+    uint8_t  *buffer;                           /*<! AU data with start codes. It points to the input chunk or the assembly buffer.
+                                                     It is valid until the next call of the parser */
+    uint32_t  len;                              /*<! AU length in byte. Zero means no complete access unit */
+    uint32_t  dts;                              /*<! DTS of input chunk that the access unit starts in */
+    uint32_t  pts;                              /*<! PTS of input chunk that the access unit starts in */
+    uint8_t   nal_num;                          /*<! The number of listed NAL units. The NAL units beyond `ESP_H264_AU_NAL_MAX` are in data but not listed */
+    uint8_t   nal_type[ESP_H264_AU_NAL_MAX];    /*<! The `nal_unit_type` of NAL units, such as 5 for IDR slice, 7 for SPS */
+    uint32_t  nal_offset[ESP_H264_AU_NAL_MAX];  /*<! The offset of start code of NAL units in `buffer` */
+} esp_h264_au_t;
+
+/**
+ * @brief  Create an access unit parser
+ *         It splits the Annex-B byte stream into NAL units and assembles them into access units across the input chunks.
+ *
+ * @param[in]   cfg         Configuration
+ * @param[out]  out_parser  Parser handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_au_parser_new(const esp_h264_au_parser_cfg_t *cfg, esp_h264_au_parser_handle_t *out_parser);
+
+/**
+ * @brief  Parse one input chunk. At most one access unit is output per call.
+ *
+ * @note  The `consume` is handled like `esp_h264_dec_process`. The rest of chunk is passed again until it is empty.
+ *        The access unit points to the input chunk without copy if it is complete in the chunk.
+ *        Otherwise, its data is assembled in the parser buffer.
+ *        The access unit ends at the next AUD, SPS, PPS, SEI, or the slice with `first_mb_in_slice` 0 after a slice.
+ *        So the last access unit is output by `esp_h264_au_parser_flush`.
+ *
+ * @param[in]      parser    Parser handle
+ * @param[in/out]  in_frame  Input chunk. The `consume` is set to the consumed length
+ * @param[out]     out_au    Access unit. Its `len` is zero if no access unit is complete
+ *
+ * @return
+ *       - ESP_H264_ERR_OK        Succeeded
+ *       - ESP_H264_ERR_ARG       Invalid arguments passed
+ *       - ESP_H264_ERR_OVERFLOW  The access unit is larger than the assembly buffer. It is dropped
+ */
+esp_h264_err_t esp_h264_au_parser_process(esp_h264_au_parser_handle_t parser, esp_h264_dec_in_frame_t *in_frame, esp_h264_au_t *out_au);
+
+/**
+ * @brief  Output the last access unit at the end of stream
+ *
+ * @param[in]   parser  Parser handle
+ * @param[out]  out_au  Access unit. Its `len` is zero if no data is left
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_au_parser_flush(esp_h264_au_parser_handle_t parser, esp_h264_au_t *out_au);
+
+/**
+ * @brief  Delete the access unit parser
+ *
+ * @param[in]  parser  Parser handle
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_au_parser_del(esp_h264_au_parser_handle_t parser);
+
+#ifdef __cplusplus
+}
+#endif
@@ -14,11 +14,61 @@
 extern "C" {
 #endif
 
+#define ESP_H264_DEC_FRAME_POOL_MAX (8)  /*<! The maximum number of frames in decoded frame pool */
+
+/**
+ * @brief  Color space of YUV to RGB conversion
+ */
+typedef enum {
+    ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED,  /*<! BT.601 matrix, Y in 16 ~ 235. It is the default */
+    ESP_H264_DEC_COLOR_SPACE_BT601_FULL,     /*<! BT.601 matrix, Y in 0 ~ 255 */
+    ESP_H264_DEC_COLOR_SPACE_BT709_LIMITED,  /*<! BT.709 matrix, Y in 16 ~ 235 */
+    ESP_H264_DEC_COLOR_SPACE_BT709_FULL,     /*<! BT.709 matrix, Y in 0 ~ 255 */
+} esp_h264_dec_color_space_t;
+
+/**
+ * @brief  Downscale of output picture
+ */
+typedef enum {
+    ESP_H264_DEC_SCALE_1_1,  /*<! Output in full resolution. It is the default */
+    ESP_H264_DEC_SCALE_1_2,  /*<! Output in 1/2 width and 1/2 height */
+    ESP_H264_DEC_SCALE_1_4,  /*<! Output in 1/4 width and 1/4 height */
+    ESP_H264_DEC_SCALE_1_8,  /*<! Output in 1/8 width and 1/8 height */
+} esp_h264_dec_scale_t;
+
+/**
+ * @brief  The slices skipped at NAL level without decoding, such as for fast-forward and timeline scrubbing
+ */
+typedef enum {
+    ESP_H264_DEC_SKIP_NONE,       /*<! Decode all slices. It is the default */
+    ESP_H264_DEC_SKIP_NON_REF,    /*<! Skip the slices with `nal_ref_idc` 0. No other picture refers to them */
+    ESP_H264_DEC_SKIP_NON_INTRA,  /*<! Decode IDR, I and SI slices only */
+} esp_h264_dec_skip_t;
+
 /**
  * @brief Handle type for software-based H.264 decoder parameters
  */
 typedef esp_h264_dec_param_handle_t esp_h264_dec_param_sw_handle_t;
 
+/**
+ * @brief  Task mode of software decoder
+ */
+typedef enum {
+    ESP_H264_DEC_TASK_DEFAULT,  /*<! Follow `CONFIG_ESP_H264_DUAL_TASK` and its core and priority. It is the default */
+    ESP_H264_DEC_TASK_SINGLE,   /*<! Decode in the caller task only, such as for the low resolution substreams */
+    ESP_H264_DEC_TASK_DUAL,     /*<! Create the second decoding task on `core`, such as for the high resolution main stream */
+} esp_h264_dec_task_mode_t;
+
+/**
+ * @brief  Task configuration of one software decoder. Zero of all fields keeps the Kconfig behavior.
+ */
+typedef struct {
+    esp_h264_dec_task_mode_t mode;      /*<! Single task or dual task decoding */
+    uint8_t                  core;      /*<! The core ID of the second task in 0 ~ 1. It is valid in `ESP_H264_DEC_TASK_DUAL` */
+    uint8_t                  priority;  /*<! The priority of the second task in 1 ~ `configMAX_PRIORITIES` - 1. It is valid in `ESP_H264_DEC_TASK_DUAL`.
+                                             Zero means `CONFIG_ESP_H264_DUAL_TASK_PRIORITY`, or 17 if dual task is disabled in Kconfig */
+} esp_h264_dec_task_cfg_t;
+
 /**
  * @brief Configuration type for software-based H.264 decoder
  */
@@ -29,6 +79,10 @@ typedef esp_h264_dec_cfg_t esp_h264_dec_cfg_sw_t;
  *         which represents a single-streams H.264 decoder in software. The decoder is from tinyh264
  *
  * @note  The group of picture(GOP) will be updated in intra frame
+ *        The picture is decoded in I420. For ESP_H264_RAW_FMT_NV12, ESP_H264_RAW_FMT_YUYV and ESP_H264_RAW_FMT_O_UYY_E_VYY,
+ *        it is converted in the same pass as the output, into the frame of pool or the output buffer of decoder.
+ *        So are ESP_H264_RAW_FMT_RGB565_LE, ESP_H264_RAW_FMT_RGB565_BE and ESP_H264_RAW_FMT_RGB888 for LCD preview.
+ *        The task mode follows `CONFIG_ESP_H264_DUAL_TASK`. Use `esp_h264_dec_sw_new_with_task` for the task mode of each decoder.
  *
  * @param[in]   cfg      It is a pointer to the `esp_h264_dec_cfg_sw_t` structure, which contains the configuration settings for the decoder
  * @param[out]  out_dec  It is a double pointer to the `esp_h264_dec_t` structure, which will store the created decoder instance
@@ -40,6 +94,23 @@ typedef esp_h264_dec_cfg_t esp_h264_dec_cfg_sw_t;
  */
 esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_dec_handle_t *out_dec);
 
+/**
+ * @brief  Create a software decoder with its own task mode, core and priority
+ *         So the high resolution main stream is decoded in dual task, while the low resolution substreams stay in single task.
+ *
+ * @note  The task mode is fixed at creation. The other behaviors are the same as `esp_h264_dec_sw_new`.
+ *
+ * @param[in]   cfg       The configuration of decoder
+ * @param[in]   task_cfg  The task configuration of this decoder. It overrides `CONFIG_ESP_H264_DUAL_TASK`
+ * @param[out]  out_dec   The created decoder instance
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ *       - ESP_H264_ERR_MEM  Insufficient memory
+ */
+esp_h264_err_t esp_h264_dec_sw_new_with_task(const esp_h264_dec_cfg_sw_t *cfg, const esp_h264_dec_task_cfg_t *task_cfg, esp_h264_dec_handle_t *out_dec);
+
 /**
  * @brief  This function returns a pointer to the software-decoded parameter structure associated with the given `esp_h264_dec_t` decoder
  *
@@ -52,6 +123,161 @@ esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_de
  */
 esp_h264_err_t esp_h264_dec_sw_get_param_hd(esp_h264_dec_handle_t dec, esp_h264_dec_param_sw_handle_t *out_param);
 
+/**
+ * @brief  Set the avcC extradata for AVCC input, such as from MP4 or RTMP
+ *         Then the input of `esp_h264_dec_process` is length prefixed NAL units instead of Annex-B stream.
+ *         The SPS and PPS in avcC are decoded at once.
+ *
+ * @note  Every NAL unit is decoded in place after its length prefix, so the input isn't rewritten.
+ *        The NAL unit with emulation prevention bytes `00 00 03` is copied without them inside decoder,
+ *        as there is no start code for decoder to find and remove them.
+ *        The `consume` covers the length prefix and the NAL unit, or it is zero.
+ *
+ * @param[in]  dec       The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  avcc      The AVCDecoderConfigurationRecord. NULL switches back to Annex-B input
+ * @param[in]  avcc_len  The length of `avcc` in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_FAIL  Failed to decode SPS or PPS
+ */
+esp_h264_err_t esp_h264_dec_sw_set_avcc(esp_h264_dec_handle_t dec, const uint8_t *avcc, uint32_t avcc_len);
+
+/**
+ * @brief  Set the decoded frame pool. The frame buffers are from application.
+ *         With the pool, every decoded picture is output in one free frame of pool, and `out_frame->outbuf` points to it.
+ *         The frame is held with reference count 1 after `esp_h264_dec_process`. It keeps valid until the count is back to 0,
+ *         so the display, encoder or analytics use the same picture without copy.
+ *
+ * @note  If no large enough frame is free, `esp_h264_dec_process` consumes nothing and returns `ESP_H264_ERR_BUSY`.
+ *        Call it again after one frame is released. The busy call isn't counted in the statistics.
+ *        The frame length must be large enough for one output picture, such as width * height * 3 / 2 for ESP_H264_RAW_FMT_I420.
+ *        The length is checked before decoding. If no frame is large enough, `esp_h264_dec_process` consumes nothing
+ *        and returns `ESP_H264_ERR_FAIL`.
+ *        The pool can't be changed while any frame is held.
+ *
+ * @param[in]  dec        The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  frames     Frame buffers and their lengths. NULL unsets the pool, then `outbuf` is in decoder again
+ * @param[in]  frame_num  The number of frames. It is at most `ESP_H264_DEC_FRAME_POOL_MAX`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Some frames of current pool are held
+ */
+esp_h264_err_t esp_h264_dec_sw_set_frame_pool(esp_h264_dec_handle_t dec, const esp_h264_pkt_t *frames, uint8_t frame_num);
+
+/**
+ * @brief  Add one reference to the decoded frame, such as for one more consumer
+ *
+ * @param[in]  dec     The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  outbuf  The `out_frame->outbuf` from `esp_h264_dec_process`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed or the frame isn't held
+ */
+esp_h264_err_t esp_h264_dec_sw_frame_ref(esp_h264_dec_handle_t dec, const uint8_t *outbuf);
+
+/**
+ * @brief  Remove one reference from the decoded frame. The frame is re-used by decoder after the last reference is removed.
+ *         It can be called in any task.
+ *
+ * @param[in]  dec     The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  outbuf  The `out_frame->outbuf` from `esp_h264_dec_process`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed or the frame isn't held
+ */
+esp_h264_err_t esp_h264_dec_sw_frame_release(esp_h264_dec_handle_t dec, const uint8_t *outbuf);
+
+/**
+ * @brief  Set the color space of YUV to RGB conversion. It is used by the RGB output formats.
+ *         The color space is decided by the source, such as BT.709 for HD camera. The default is BT.601 limited range.
+ *
+ * @param[in]  dec          The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  color_space  Color space
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_dec_sw_set_color_space(esp_h264_dec_handle_t dec, esp_h264_dec_color_space_t color_space);
+
+/**
+ * @brief  Set the downscale of output picture, such as for thumbnails and multi-view grids
+ *         The picture is box filtered after decoding, before the format conversion. So the output picture,
+ *         the frame of pool and the display path are smaller by the square of scale.
+ *
+ * @note  The resolution from `esp_h264_dec_get_resolution` is still the decoded one.
+ *        The output resolution is it shifted right by `scale`, such as 1920 >> 3 = 240 for ESP_H264_DEC_SCALE_1_8.
+ *        The reference frames are in full resolution, so it doesn't save the decoding time.
+ *
+ * @param[in]  dec    The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  scale  Downscale of output picture
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_dec_sw_set_scale(esp_h264_dec_handle_t dec, esp_h264_dec_scale_t scale);
+
+/**
+ * @brief  Set the skip mode. The skipped slice is consumed as a whole without parsing, so it costs nearly nothing.
+ *
+ * @note  With ESP_H264_DEC_SKIP_NON_INTRA, the skipped P pictures leave a gap of `frame_num` before the next non-IDR I picture.
+ *        It is handled like lost pictures. The streams with IDR pictures only in the intra period have no gap.
+ *        Switch back to ESP_H264_DEC_SKIP_NONE with `esp_h264_dec_sw_seek`, so the P pictures are decoded from the next IDR.
+ *
+ * @param[in]  dec   The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  skip  Skip mode
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_dec_sw_set_skip(esp_h264_dec_handle_t dec, esp_h264_dec_skip_t skip);
+
+/**
+ * @brief  Seek in the stream. All slices are skipped until the next IDR slice, then the decoding resumes from it.
+ *         Call it between two access units, and then pass the data from the new position.
+ *
+ * @note  IDR picture refreshes the reference pictures of decoder, so the pictures before the seek aren't used.
+ *
+ * @param[in]  dec  The decoder instance that is from `esp_h264_dec_sw_new`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_dec_sw_seek(esp_h264_dec_handle_t dec);
+
+/**
+ * @brief  Enable error concealment for lossy streams, such as over Wi-Fi
+ *         The slice with error is dropped and `esp_h264_dec_process` returns `ESP_H264_ERR_OK` for it.
+ *         The macroblocks not decoded are concealed by tinyh264 from the reference picture, when the picture is output.
+ *         So the following P pictures go on decoding instead of freezing until the next IDR picture.
+ *
+ * @note  The `damaged_mb` of output frame is estimated from the first macroblock and `frame_num` of slices. It counts
+ *          - the slice with error, up to the first macroblock of the next decoded slice or the end of picture
+ *          - the slices lost as a whole before the first decoded slice of picture
+ *          - the whole picture after a gap of `frame_num`, that is, after reference pictures lost as a whole
+ *        The slice lost as a whole after the first decoded slice of picture leaves no trace, so it isn't counted.
+ *        The pictures predicted from the damaged picture aren't counted either.
+ *        The error of parameter sets still fails.
+ *
+ * @param[in]  dec     The decoder instance that is from `esp_h264_dec_sw_new`
+ * @param[in]  enable  true to conceal the slice with error. It is disabled by default
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  Invalid arguments passed
+ */
+esp_h264_err_t esp_h264_dec_sw_set_conceal(esp_h264_dec_handle_t dec, bool enable);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,83 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief  Stream information from SPS and PPS
+ */
+typedef struct {
+    uint8_t               profile_idc;              /*<! Profile, such as 66 for baseline, 77 for main and 100 for high */
+    uint8_t               constraint_flags;         /*<! The byte of `constraint_set0_flag` to `constraint_set5_flag` */
+    uint8_t               level_idc;                /*<! Level multiplied by 10, such as 31 for level 3.1 */
+    uint8_t               sps_id;                   /*<! SPS ID */
+    uint8_t               chroma_format_idc;        /*<! 1 for YUV420 */
+    uint8_t               bit_depth;                /*<! Luma bit depth */
+    bool                  frame_mbs_only;           /*<! No interlaced field or MBAFF */
+    uint8_t               log2_max_frame_num;       /*<! The bits of `frame_num` in slice header */
+    uint8_t               max_num_ref_frames;       /*<! The maximum number of reference frames */
+    bool                  frame_num_gaps_allowed;   /*<! The `gaps_in_frame_num_value_allowed_flag`. The gaps in `frame_num` aren't loss */
+    esp_h264_resolution_t coded_res;                /*<! Coded resolution in pixels before cropping. It is multiple of 16 */
+    esp_h264_resolution_t res;                      /*<! Display resolution after cropping */
+    uint16_t              crop_left;                /*<! Cropped pixels on the left */
+    uint16_t              crop_right;               /*<! Cropped pixels on the right */
+    uint16_t              crop_top;                 /*<! Cropped pixels on the top */
+    uint16_t              crop_bottom;              /*<! Cropped pixels on the bottom */
+    bool                  timing_info_present;      /*<! VUI timing is present */
+    uint32_t              num_units_in_tick;        /*<! VUI timing. The frame rate is `time_scale / (2 * num_units_in_tick)` in general */
+    uint32_t              time_scale;               /*<! VUI timing. The clock in Hz */
+    bool                  fixed_frame_rate;         /*<! VUI timing. The frame rate is fixed */
+    bool                  full_range;               /*<! VUI video signal. Y is in 0 ~ 255 */
+    uint8_t               matrix_coefficients;      /*<! VUI video signal. 1 for BT.709, 5 or 6 for BT.601, 2 for unspecified */
+    uint8_t               max_dec_frame_buffering;  /*<! Decoded picture buffer size in frames. It is from VUI,
+                                                         or the maximum of level and resolution if VUI doesn't have it */
+    bool                  pps_present;              /*<! PPS is found. The fields below are valid only if it is true */
+    uint8_t               pps_id;                   /*<! PPS ID */
+    bool                  cabac;                    /*<! The `entropy_coding_mode_flag` of PPS. The software decoder supports CAVLC only */
+} esp_h264_stream_info_t;
+
+/**
+ * @brief  Parse one SPS NAL unit without decoder
+ *
+ * @param[in]   nal   SPS NAL unit without start code. The first byte is NAL header
+ * @param[in]   len   The length of `nal` in byte
+ * @param[out]  info  Stream information. The PPS fields are cleared
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_FAIL  It isn't SPS or the SPS is invalid
+ */
+esp_h264_err_t esp_h264_probe_sps(const uint8_t *nal, uint32_t len, esp_h264_stream_info_t *info);
+
+/**
+ * @brief  Find the first SPS and PPS in Annex-B byte stream and parse them without decoder
+ *         It is cheap enough for the stream router to inspect many streams before any decoder is created.
+ *
+ * @note  The data without start code is taken as one NAL unit.
+ *        It stops at the first slice after the SPS, so only the head of stream is needed.
+ *
+ * @param[in]   data  Annex-B byte stream
+ * @param[in]   len   The length of `data` in byte
+ * @param[out]  info  Stream information
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_FAIL  No SPS is found or the SPS is invalid
+ */
+esp_h264_err_t esp_h264_probe(const uint8_t *data, uint32_t len, esp_h264_stream_info_t *info);
+
+#ifdef __cplusplus
+}
+#endif
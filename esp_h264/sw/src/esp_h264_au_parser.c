@@ -0,0 +1,274 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_check.h"
+#include "esp_h264_alloc.h"
+#include "esp_h264_au_parser.h"
+
+static const char *TAG = "H264_AU_PARSER";
+
+/* Start code prefix, NAL header and the first byte of slice header */
+#define AU_NAL_PEEK_SIZE (5)
+/* The number of input chunks whose time stamps are kept in assembly buffer */
+#define AU_CHUNK_TS_MAX  (8)
+
+typedef struct {
+    uint32_t pos;  /*<! The offset of input chunk in assembly buffer */
+    uint32_t dts;  /*<! DTS of input chunk */
+    uint32_t pts;  /*<! PTS of input chunk */
+} au_chunk_ts_t;
+
+typedef struct esp_h264_au_parser {
+    uint8_t      *buf;                         /*<! Assembly buffer */
+    uint32_t      size;                        /*<! The size of assembly buffer in byte */
+    uint32_t      len;                         /*<! The data length in assembly buffer */
+    uint32_t      out_len;                     /*<! The access unit length output from assembly buffer. It is removed in the next call */
+    uint32_t      scan_pos;                    /*<! The scanned offset of current access unit */
+    bool          has_vcl;                     /*<! Current access unit has slice */
+    esp_h264_au_t au;                          /*<! The NAL units and time stamps of current access unit */
+    au_chunk_ts_t chunk_ts[AU_CHUNK_TS_MAX];   /*<! The time stamps of input chunks in assembly buffer, from the oldest one */
+    uint8_t       chunk_num;                   /*<! The number of `chunk_ts` */
+} esp_h264_au_parser_t;
+
+/* Find the start code `00 00 01` from `pos`. Return its offset, or `len` if it isn't found */
+static uint32_t au_find_start_code(const uint8_t *data, uint32_t pos, uint32_t len)
+{
+    while (pos + 3 <= len) {
+        if (pos + 4 <= len) {
+            /** Word at a time. No start code begins in the word without zero byte. */
+            uint32_t word;
+            memcpy(&word, data + pos, sizeof(word));
+            if (!((word - 0x01010101) & ~word & 0x80808080)) {
+                pos += 4;
+                continue;
+            }
+        }
+        if (data[pos + 2] > 1) {
+            pos += 3;
+        } else if (!data[pos] && !data[pos + 1] && (data[pos + 2] == 1)) {
+            return pos;
+        } else {
+            pos++;
+        }
+    }
+    return len;
+}
+
+/* Scan the NAL units of current access unit from `scan_pos`. Return the offset of the next access unit, or 0 if it isn't found */
+static uint32_t au_scan(esp_h264_au_parser_t *parser, const uint8_t *data, uint32_t len, bool eos)
+{
+    uint32_t peek = eos ? AU_NAL_PEEK_SIZE - 1 : AU_NAL_PEEK_SIZE;
+    uint32_t pos = parser->scan_pos;
+    while (1) {
+        uint32_t sc = au_find_start_code(data, pos, len);
+        if (sc + peek > len) {
+            /** Resume from the start code, or the last 2 bytes which may be a part of start code */
+            parser->scan_pos = (sc < len) ? sc : ((len > pos + 2) ? len - 2 : pos);
+            return 0;
+        }
+        uint8_t type = data[sc + 3] & 0x1F;
+        uint32_t start = ((sc > 0) && !data[sc - 1]) ? sc - 1 : sc;
+        bool vcl = (type == 1) || (type == 5);
+        if (parser->has_vcl && !eos) {
+            /** The `first_mb_in_slice` is 0 if the first bit of slice header is 1 */
+            bool first_slice = vcl && (data[sc + 4] & 0x80);
+            if (((type >= 6) && (type <= 9)) || ((type >= 14) && (type <= 18)) || first_slice) {
+                return start;
+            }
+        }
+        if (parser->au.nal_num < ESP_H264_AU_NAL_MAX) {
+            parser->au.nal_type[parser->au.nal_num] = type;
+            parser->au.nal_offset[parser->au.nal_num] = start;
+            parser->au.nal_num++;
+        }
+        parser->has_vcl |= vcl;
+        pos = sc + 3;
+    }
+}
+
+static void au_parser_reset(esp_h264_au_parser_t *parser, const esp_h264_dec_in_frame_t *in_frame)
+{
+    parser->scan_pos = 0;
+    parser->has_vcl = false;
+    memset(&parser->au, 0, sizeof(esp_h264_au_t));
+    if (in_frame) {
+        parser->au.dts = in_frame->dts;
+        parser->au.pts = in_frame->pts;
+    }
+}
+
+/* Keep the time stamps of input chunk copied to `pos` of assembly buffer */
+static void au_parser_add_chunk(esp_h264_au_parser_t *parser, uint32_t pos, const esp_h264_dec_in_frame_t *in_frame)
+{
+    if (parser->chunk_num == AU_CHUNK_TS_MAX) {
+        /** The next access unit is found within a few bytes after its start. So the oldest chunk is no longer needed. */
+        memmove(&parser->chunk_ts[0], &parser->chunk_ts[1], (AU_CHUNK_TS_MAX - 1) * sizeof(au_chunk_ts_t));
+        parser->chunk_num--;
+    }
+    au_chunk_ts_t *chunk = &parser->chunk_ts[parser->chunk_num++];
+    chunk->pos = pos;
+    chunk->dts = in_frame->dts;
+    chunk->pts = in_frame->pts;
+}
+
+/* The next access unit starts at `pos` of assembly buffer, and the data from `end` is passed again.
+ * Stamp it with the chunk that its first byte arrived in, and move the chunk offsets as the output access unit is removed. */
+static void au_parser_keep_chunks(esp_h264_au_parser_t *parser, uint32_t pos, uint32_t end)
+{
+    uint8_t first = 0;
+    uint8_t num = 0;
+    for (uint8_t i = 0; (i < parser->chunk_num) && (parser->chunk_ts[i].pos < end); i++) {
+        if (parser->chunk_ts[i].pos <= pos) {
+            first = i;
+        }
+        num = i + 1;
+    }
+    parser->chunk_num = 0;
+    for (uint8_t i = first; i < num; i++) {
+        parser->chunk_ts[parser->chunk_num] = parser->chunk_ts[i];
+        parser->chunk_ts[parser->chunk_num].pos = (parser->chunk_ts[i].pos > pos) ? parser->chunk_ts[i].pos - pos : 0;
+        parser->chunk_num++;
+    }
+    if (parser->chunk_num) {
+        parser->au.dts = parser->chunk_ts[0].dts;
+        parser->au.pts = parser->chunk_ts[0].pts;
+    }
+}
+
+static void au_parser_output(esp_h264_au_parser_t *parser, uint8_t *data, uint32_t len, esp_h264_au_t *out_au)
+{
+    *out_au = parser->au;
+    out_au->buffer = data;
+    out_au->len = len;
+}
+
+/* Remove the access unit output last time. The rest data in assembly buffer is the beginning of current access unit. */
+static void au_parser_remove_output(esp_h264_au_parser_t *parser)
+{
+    if (parser->out_len) {
+        parser->len -= parser->out_len;
+        memmove(parser->buf, parser->buf + parser->out_len, parser->len);
+        parser->out_len = 0;
+    }
+}
+
+esp_h264_err_t esp_h264_au_parser_new(const esp_h264_au_parser_cfg_t *cfg, esp_h264_au_parser_handle_t *out_parser)
+{
+    ESP_H264_RET_ON_FALSE(cfg && out_parser, ESP_H264_ERR_ARG, TAG, "Invalid configure and parser handle parameter");
+    ESP_H264_RET_ON_FALSE(cfg->buf_size > AU_NAL_PEEK_SIZE, ESP_H264_ERR_ARG, TAG, "Invalid buffer size parameter");
+    *out_parser = NULL;
+    uint32_t actual_size;
+    esp_h264_au_parser_t *parser = esp_h264_calloc_prefer(1, sizeof(esp_h264_au_parser_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    ESP_H264_RET_ON_FALSE(parser != NULL, ESP_H264_ERR_MEM, TAG, "No memory for parser handle");
+    parser->buf = esp_h264_calloc_prefer(1, cfg->buf_size, &actual_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (parser->buf == NULL) {
+        ESP_H264_LOGE(TAG, "No memory for assembly buffer");
+        esp_h264_free(parser);
+        return ESP_H264_ERR_MEM;
+    }
+    parser->size = actual_size;
+    *out_parser = parser;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_au_parser_process(esp_h264_au_parser_handle_t parser_hd, esp_h264_dec_in_frame_t *in_frame, esp_h264_au_t *out_au)
+{
+    ESP_H264_RET_ON_FALSE(parser_hd && in_frame && out_au, ESP_H264_ERR_ARG, TAG, "Invalid parser, input frame and access unit parameter");
+    ESP_H264_RET_ON_FALSE(in_frame->raw_data.buffer || !in_frame->raw_data.len, ESP_H264_ERR_ARG, TAG, "Invalid input buffer parameter");
+    esp_h264_au_parser_t *parser = parser_hd;
+    uint8_t *data = in_frame->raw_data.buffer;
+    uint32_t len = in_frame->raw_data.len;
+    out_au->buffer = NULL;
+    out_au->len = 0;
+    au_parser_remove_output(parser);
+    if (parser->len == 0) {
+        /** The access unit in the input chunk is output without copy */
+        au_parser_reset(parser, in_frame);
+        uint32_t next = au_scan(parser, data, len, false);
+        if (next) {
+            au_parser_output(parser, data, next, out_au);
+            in_frame->consume = next;
+            return ESP_H264_ERR_OK;
+        }
+        in_frame->consume = len;
+        if (len > parser->size) {
+            au_parser_reset(parser, NULL);
+            ESP_H264_LOGE(TAG, "The access unit is larger than %d bytes", (int)parser->size);
+            return ESP_H264_ERR_OVERFLOW;
+        }
+        /** The scanned offsets are kept, as the access unit starts at the beginning of assembly buffer too */
+        memcpy(parser->buf, data, len);
+        parser->len = len;
+        parser->chunk_num = 0;
+        au_parser_add_chunk(parser, 0, in_frame);
+        return ESP_H264_ERR_OK;
+    }
+    uint32_t old_len = parser->len;
+    uint32_t copy = parser->size - parser->len;
+    copy = (len < copy) ? len : copy;
+    memcpy(parser->buf + parser->len, data, copy);
+    parser->len += copy;
+    au_parser_add_chunk(parser, old_len, in_frame);
+    uint32_t next = au_scan(parser, parser->buf, parser->len, false);
+    if (next) {
+        au_parser_output(parser, parser->buf, next, out_au);
+        parser->out_len = next;
+        /** The data after the access unit is returned to input, except the part which was in assembly buffer before */
+        if (next > old_len) {
+            parser->len = next;
+            in_frame->consume = next - old_len;
+            parser->chunk_num = 0;
+            au_parser_reset(parser, in_frame);
+        } else {
+            /** The next access unit starts in an earlier chunk. Its time stamps are from that chunk instead of current one. */
+            parser->len = old_len;
+            in_frame->consume = 0;
+            au_parser_reset(parser, NULL);
+            au_parser_keep_chunks(parser, next, old_len);
+        }
+        return ESP_H264_ERR_OK;
+    }
+    in_frame->consume = copy;
+    if (parser->len >= parser->size) {
+        parser->len = 0;
+        parser->chunk_num = 0;
+        au_parser_reset(parser, NULL);
+        ESP_H264_LOGE(TAG, "The access unit is larger than %d bytes", (int)parser->size);
+        return ESP_H264_ERR_OVERFLOW;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_au_parser_flush(esp_h264_au_parser_handle_t parser_hd, esp_h264_au_t *out_au)
+{
+    ESP_H264_RET_ON_FALSE(parser_hd && out_au, ESP_H264_ERR_ARG, TAG, "Invalid parser and access unit parameter");
+    esp_h264_au_parser_t *parser = parser_hd;
+    out_au->buffer = NULL;
+    out_au->len = 0;
+    au_parser_remove_output(parser);
+    if (parser->len == 0) {
+        return ESP_H264_ERR_OK;
+    }
+    /** The NAL units at the end of stream have no next start code */
+    au_scan(parser, parser->buf, parser->len, true);
+    au_parser_output(parser, parser->buf, parser->len, out_au);
+    parser->out_len = parser->len;
+    parser->chunk_num = 0;
+    au_parser_reset(parser, NULL);
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_au_parser_del(esp_h264_au_parser_handle_t parser_hd)
+{
+    ESP_H264_RET_ON_FALSE(parser_hd, ESP_H264_ERR_ARG, TAG, "Invalid parser handle");
+    esp_h264_au_parser_t *parser = parser_hd;
+    if (parser->buf) {
+        esp_h264_free(parser->buf);
+    }
+    esp_h264_free(parser);
+    return ESP_H264_ERR_OK;
+}
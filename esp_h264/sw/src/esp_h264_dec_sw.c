@@ -6,14 +6,31 @@
 
 #include <stdio.h>
 #include <string.h>
+#include "freertos/FreeRTOS.h"
 #include "esp_h264_dec.h"
 #include "h264bsd_decoder.h"
 #include "esp_h264_check.h"
 #include "esp_h264_alloc.h"
 #include "esp_h264_dec_sw.h"
+#include "esp_h264_probe.h"
+#include "esp_h264_stats_acc.h"
+#include "h264_frame_pool.h"
+#include "h264_color_convert.h"
 
 static const char *TAG = "H264_DEC.SW";
 
+#define H264_NAL_SLICE     (1)
+#define H264_NAL_IDR_SLICE (5)
+#define H264_NAL_SPS       (7)
+
+/* Q16 matrices in the order of `esp_h264_dec_color_space_t` */
+static const h264_yuv2rgb_matrix_t yuv2rgb_matrix[] = {
+    { 16, 76309, 104597, -25675, -53279, 132201 },  /** BT.601 limited range */
+    { 0,  65536, 91881,  -22553, -46802, 116130 },  /** BT.601 full range */
+    { 16, 76309, 117489, -13975, -34925, 138438 },  /** BT.709 limited range */
+    { 0,  65536, 103206, -12276, -30679, 121609 },  /** BT.709 full range */
+};
+
 typedef struct esp_h264_dec_sw_handle {
     esp_h264_dec_t        base;
     esp_h264_dec_param_t  param_hd;
@@ -21,6 +38,32 @@ typedef struct esp_h264_dec_sw_handle {
     uint32_t              height;
     h264bsd_hd_t          dec_hd;
     uint32_t              out_len;
+    esp_h264_stats_acc_t  stats;
+    uint32_t              in_len;   /*<! The consumed length since last picture */
+    int64_t               busy_us;  /*<! The process time since last picture */
+    uint8_t               nal_len_size;  /*<! The size of NAL length prefix in AVCC input. Zero means Annex-B input */
+    uint8_t              *nal_buf;       /*<! AVCC NAL unit without emulation prevention bytes */
+    uint32_t              nal_buf_size;
+    esp_h264_frame_pool_hd_t frame_pool;  /*<! Decoded frame pool of application. NULL means the picture is output in decoder */
+    esp_h264_raw_format_t pic_type;  /*<! Output format */
+    convert_color         cc;        /*<! Converter from I420 of tinyh264 to output format. NULL for I420 */
+    convert_rgb           rgb_cc;    /*<! Converter from I420 of tinyh264 to RGB format */
+    const h264_yuv2rgb_matrix_t *matrix;  /*<! YUV to RGB matrix of color space */
+    uint8_t              *out_buf;   /*<! Output buffer of converter without frame pool */
+    uint32_t              out_buf_size;
+    uint8_t               scale_shift;     /*<! Output picture is downscaled by `1 << scale_shift` */
+    uint8_t              *scale_buf;       /*<! Downscaled I420 picture before format conversion */
+    uint32_t              scale_buf_size;
+    esp_h264_dec_skip_t   skip;            /*<! The slices skipped at NAL level */
+    bool                  seeking;         /*<! All slices are skipped until the next IDR slice */
+    bool                  conceal;         /*<! The slice with error is concealed instead of failed */
+    bool                  pic_started;     /*<! One slice of current picture is decoded */
+    int32_t               err_mb;          /*<! The first macroblock of the slice with error in current picture. -1 means none */
+    uint32_t              damaged_mb;      /*<! The damaged macroblocks of current picture */
+    uint32_t              pic_damaged_mb;  /*<! The damaged macroblocks of output picture */
+    uint8_t               log2_max_frame_num;  /*<! The bits of `frame_num` from SPS. 0 means no SPS is parsed */
+    bool                  frame_num_gaps;      /*<! The gaps in `frame_num` are allowed by SPS */
+    int32_t               ref_frame_num;       /*<! The `frame_num` of the last reference picture. -1 means none */
 } esp_h264_dec_sw_handle_t;
 
 static esp_h264_err_t get_res(esp_h264_dec_param_handle_t param_hd, esp_h264_resolution_t *res)
@@ -31,17 +74,344 @@ static esp_h264_err_t get_res(esp_h264_dec_param_handle_t param_hd, esp_h264_res
     return ESP_H264_ERR_OK;
 }
 
-static esp_h264_err_t dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_frame_t *in_frame, esp_h264_dec_out_frame_t *out_frame)
+/* Get the NAL unit after the length prefix of AVCC input. tinyh264 takes the data without start code as one NAL unit. */
+static esp_h264_err_t h264_sw_dec_avcc_nal(esp_h264_dec_sw_handle_t *sw_hd, uint8_t **data, uint32_t *len)
+{
+    uint32_t nal_len = 0;
+    if (*len < sw_hd->nal_len_size) {
+        return ESP_H264_ERR_FAIL;
+    }
+    for (uint8_t i = 0; i < sw_hd->nal_len_size; i++) {
+        nal_len = (nal_len << 8) | (*data)[i];
+    }
+    if (nal_len > *len - sw_hd->nal_len_size) {
+        return ESP_H264_ERR_FAIL;
+    }
+    *data += sw_hd->nal_len_size;
+    *len = nal_len;
+    return ESP_H264_ERR_OK;
+}
+
+/* Read one Exp-Golomb code of slice header. It is enough for the first fields, which have no emulation prevention byte. */
+static uint32_t h264_sw_dec_read_ue(const uint8_t *data, uint32_t len, uint32_t *bit)
+{
+    uint8_t zeros = 0;
+    while (((*bit >> 3) < len) && !((data[*bit >> 3] >> (7 - (*bit & 7))) & 0x01) && (zeros < 31)) {
+        zeros++;
+        (*bit)++;
+    }
+    (*bit)++;
+    uint32_t v = 0;
+    for (uint8_t i = 0; (i < zeros) && ((*bit >> 3) < len); i++, (*bit)++) {
+        v = (v << 1) | ((data[*bit >> 3] >> (7 - (*bit & 7))) & 0x01);
+    }
+    return (1u << zeros) - 1 + v;
+}
+
+/* Check whether the NAL unit is skipped without decoding. The parameter sets and SEI are always decoded. */
+static bool h264_sw_dec_skip_nal(esp_h264_dec_sw_handle_t *sw_hd, const uint8_t *nal, uint32_t len)
+{
+    uint8_t type = nal[0] & 0x1F;
+    if (type == H264_NAL_IDR_SLICE) {
+        sw_hd->seeking = false;
+        return false;
+    }
+    if (type != H264_NAL_SLICE) {
+        return false;
+    }
+    if (sw_hd->seeking) {
+        return true;
+    }
+    if (sw_hd->skip == ESP_H264_DEC_SKIP_NON_REF) {
+        /** `nal_ref_idc` 0 means no picture refers to it */
+        return !(nal[0] & 0x60);
+    }
+    if (sw_hd->skip == ESP_H264_DEC_SKIP_NON_INTRA) {
+        /** `first_mb_in_slice` and then `slice_type`. 2 and 7 are I slices, 4 and 9 are SI slices */
+        uint32_t bit = 8;
+        h264_sw_dec_read_ue(nal, len, &bit);
+        uint32_t slice_type = h264_sw_dec_read_ue(nal, len, &bit) % 5;
+        return (slice_type != 2) && (slice_type != 4);
+    }
+    return false;
+}
+
+static void h264_sw_dec_conceal_finish(esp_h264_dec_sw_handle_t *sw_hd)
+{
+    uint32_t mb_num = (sw_hd->width >> 4) * (sw_hd->height >> 4);
+    if (sw_hd->err_mb >= 0) {
+        sw_hd->damaged_mb += mb_num - sw_hd->err_mb;
+    }
+    sw_hd->pic_damaged_mb = sw_hd->damaged_mb > mb_num ? mb_num : sw_hd->damaged_mb;
+    sw_hd->damaged_mb = 0;
+    sw_hd->err_mb = -1;
+    sw_hd->pic_started = false;
+}
+
+/* Keep the `frame_num` information of SPS for the loss of whole pictures */
+static void h264_sw_dec_conceal_sps(esp_h264_dec_sw_handle_t *sw_hd, const uint8_t *nal, uint32_t len)
+{
+    esp_h264_stream_info_t info;
+    if (esp_h264_probe_sps(nal, len, &info) == ESP_H264_ERR_OK) {
+        sw_hd->log2_max_frame_num = info.log2_max_frame_num;
+        sw_hd->frame_num_gaps = info.frame_num_gaps_allowed;
+    }
+}
+
+/* Check the `frame_num` of the first slice in picture from `bit` after `first_mb_in_slice`.
+ * The gap to the last reference picture means the reference pictures between are lost as a whole. */
+static bool h264_sw_dec_frame_num_gap(esp_h264_dec_sw_handle_t *sw_hd, const uint8_t *nal, uint32_t len, uint32_t bit)
+{
+    if (sw_hd->log2_max_frame_num == 0) {
+        return false;
+    }
+    /** `slice_type` and `pic_parameter_set_id` */
+    h264_sw_dec_read_ue(nal, len, &bit);
+    h264_sw_dec_read_ue(nal, len, &bit);
+    uint32_t frame_num = 0;
+    for (uint8_t i = 0; (i < sw_hd->log2_max_frame_num) && ((bit >> 3) < len); i++, bit++) {
+        frame_num = (frame_num << 1) | ((nal[bit >> 3] >> (7 - (bit & 7))) & 0x01);
+    }
+    uint32_t prev = sw_hd->ref_frame_num;
+    uint32_t next = (prev + 1) & ((1u << sw_hd->log2_max_frame_num) - 1);
+    /** The pictures skipped on purpose aren't loss */
+    bool gap = (sw_hd->ref_frame_num >= 0) && ((nal[0] & 0x1F) != H264_NAL_IDR_SLICE) && !sw_hd->frame_num_gaps
+               && (sw_hd->skip == ESP_H264_DEC_SKIP_NONE) && (frame_num != prev) && (frame_num != next);
+    if (nal[0] & 0x60) {
+        sw_hd->ref_frame_num = frame_num;
+    }
+    return gap;
+}
+
+/* Track the damaged macroblocks by the slices. The slices are in raster order, so the slice with error is damaged
+ * until the next decoded slice. The macroblocks before the first slice are lost. tinyh264 conceals them at the end of picture.
+ * The picture after a `frame_num` gap is damaged as a whole, as its reference pictures are lost.
+ * The slice lost as a whole after the first decoded slice of picture leaves no trace, so it isn't counted.
+ * Return H264BSD_RDY instead of H264BSD_ERROR for the slice with error, so decoding goes on. */
+static uint32_t h264_sw_dec_conceal(esp_h264_dec_sw_handle_t *sw_hd, uint32_t ret_code, const uint8_t *nal, uint32_t nal_len, bool consumed)
+{
+    uint8_t type = nal_len ? (nal[0] & 0x1F) : 0;
+    if (type == H264_NAL_SPS) {
+        h264_sw_dec_conceal_sps(sw_hd, nal, nal_len);
+    }
+    if ((ret_code == H264BSD_PIC_RDY) && !consumed) {
+        /** The picture ends before this NAL unit, so the rest of picture is lost */
+        h264_sw_dec_conceal_finish(sw_hd);
+        return ret_code;
+    }
+    if ((type == H264_NAL_SLICE) || (type == H264_NAL_IDR_SLICE)) {
+        uint32_t bit = 8;
+        int32_t first_mb = h264_sw_dec_read_ue(nal, nal_len, &bit);
+        if (!sw_hd->pic_started) {
+            sw_hd->damaged_mb += first_mb;
+            sw_hd->pic_started = true;
+            if (h264_sw_dec_frame_num_gap(sw_hd, nal, nal_len, bit)) {
+                sw_hd->damaged_mb += (sw_hd->width >> 4) * (sw_hd->height >> 4);
+            }
+        }
+        if ((sw_hd->err_mb >= 0) && (first_mb > sw_hd->err_mb)) {
+            sw_hd->damaged_mb += first_mb - sw_hd->err_mb;
+            sw_hd->err_mb = -1;
+        }
+        if (ret_code == H264BSD_ERROR) {
+            if (sw_hd->err_mb < 0) {
+                sw_hd->err_mb = first_mb;
+            }
+            ret_code = H264BSD_RDY;
+        }
+    }
+    if (ret_code == H264BSD_PIC_RDY) {
+        h264_sw_dec_conceal_finish(sw_hd);
+    }
+    return ret_code;
+}
+
+/* Get the NAL unit of Annex-B input. Return the offset of the next start code, or `len` */
+static uint32_t h264_sw_dec_annexb_nal(const uint8_t *data, uint32_t len, uint32_t *nal_pos)
+{
+    uint32_t pos = 0;
+    while ((pos < len) && !data[pos]) {
+        pos++;
+    }
+    /** The data without start code is one NAL unit for tinyh264 */
+    *nal_pos = ((pos >= 2) && (pos < len) && (data[pos] == 1)) ? pos + 1 : 0;
+    for (pos = *nal_pos + 1; pos + 3 <= len; pos++) {
+        if (!data[pos] && !data[pos + 1] && (data[pos + 2] == 1)) {
+            return pos;
+        }
+    }
+    return len;
+}
+
+/* Make sure the buffer of decoder is at least `len` bytes */
+static uint8_t *h264_sw_dec_buf(uint8_t **buf, uint32_t *size, uint32_t len)
+{
+    if (*size < len) {
+        if (*buf) {
+            esp_h264_free(*buf);
+        }
+        *buf = esp_h264_calloc_prefer(1, len, size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+        if (*buf == NULL) {
+            *size = 0;
+        }
+    }
+    return *buf;
+}
+
+/* Remove the emulation prevention bytes of NAL unit without start code, as tinyh264 only removes them from Annex-B input.
+ * The NAL unit is copied into `nal_buf` only if it has `00 00 03`. The input data is kept, as it may be passed again. */
+static esp_h264_err_t h264_sw_dec_unescape(esp_h264_dec_sw_handle_t *sw_hd, uint8_t **data, uint32_t *len)
+{
+    const uint8_t *src = *data;
+    uint32_t pos = 2;
+    while ((pos < *len) && ((src[pos] != 0x03) || src[pos - 1] || src[pos - 2])) {
+        pos++;
+    }
+    if (pos >= *len) {
+        return ESP_H264_ERR_OK;
+    }
+    uint8_t *dst = h264_sw_dec_buf(&sw_hd->nal_buf, &sw_hd->nal_buf_size, *len);
+    if (dst == NULL) {
+        ESP_H264_LOGE(TAG, "No memory for NAL unit buffer");
+        return ESP_H264_ERR_MEM;
+    }
+    memcpy(dst, src, pos);
+    uint32_t out_len = pos;
+    uint8_t zeros = 0;
+    for (pos++; pos < *len; pos++) {
+        if ((zeros >= 2) && (src[pos] == 0x03)) {
+            zeros = 0;
+            continue;
+        }
+        zeros = src[pos] ? 0 : zeros + 1;
+        dst[out_len++] = src[pos];
+    }
+    *data = dst;
+    *len = out_len;
+    return ESP_H264_ERR_OK;
+}
+
+/* Output the I420 picture of tinyh264 in the frame of pool, downscaled and in the output format.
+ * Every step writes once into the next buffer. */
+static esp_h264_err_t h264_sw_dec_output(esp_h264_dec_sw_handle_t *sw_hd, uint8_t **pic)
+{
+    uint32_t width = sw_hd->width >> sw_hd->scale_shift;
+    uint32_t height = sw_hd->height >> sw_hd->scale_shift;
+    bool convert = sw_hd->cc || sw_hd->rgb_cc;
+    uint8_t *out = NULL;
+    uint8_t *scale = NULL;
+    if (sw_hd->scale_shift && convert) {
+        /** It is before the frame of pool is acquired, so the frame isn't leaked on failure */
+        scale = h264_sw_dec_buf(&sw_hd->scale_buf, &sw_hd->scale_buf_size, width * height + (width * height >> 1));
+        ESP_H264_RET_ON_FALSE(scale, ESP_H264_ERR_MEM, TAG, "No memory for downscaled picture");
+    }
+    if (sw_hd->frame_pool) {
+        /** The frame of application is kept by reference count */
+        out = esp_h264_frame_pool_acquire(sw_hd->frame_pool, sw_hd->out_len);
+        if (out == NULL) {
+            ESP_H264_LOGE(TAG, "The frame of pool is smaller than %d bytes", (int)sw_hd->out_len);
+            return ESP_H264_ERR_FAIL;
+        }
+    } else if (convert || sw_hd->scale_shift) {
+        out = h264_sw_dec_buf(&sw_hd->out_buf, &sw_hd->out_buf_size, sw_hd->out_len);
+        ESP_H264_RET_ON_FALSE(out, ESP_H264_ERR_MEM, TAG, "No memory for output picture");
+    } else {
+        /** I420 is output in decoder without copy */
+        return ESP_H264_ERR_OK;
+    }
+    uint8_t *src = *pic;
+    if (sw_hd->scale_shift) {
+        uint8_t *dst = convert ? scale : out;
+        iyuv_downscale(sw_hd->height, sw_hd->width, sw_hd->scale_shift, src, dst);
+        src = dst;
+    }
+    if (sw_hd->rgb_cc) {
+        sw_hd->rgb_cc(height, width, src, out, sw_hd->matrix);
+    } else if (sw_hd->cc) {
+        sw_hd->cc(height, width, src, out);
+    } else if (src != out) {
+        memcpy(out, src, sw_hd->out_len);
+    }
+    *pic = out;
+    return ESP_H264_ERR_OK;
+}
+
+/* The length of output picture with the current resolution */
+static uint32_t h264_sw_dec_out_len(esp_h264_dec_sw_handle_t *sw_hd)
+{
+    uint32_t out_pixels = (sw_hd->width >> sw_hd->scale_shift) * (sw_hd->height >> sw_hd->scale_shift);
+    if ((sw_hd->pic_type == ESP_H264_RAW_FMT_YUYV) || (sw_hd->pic_type == ESP_H264_RAW_FMT_RGB565_LE)
+            || (sw_hd->pic_type == ESP_H264_RAW_FMT_RGB565_BE)) {
+        return out_pixels * 2;
+    } else if (sw_hd->pic_type == ESP_H264_RAW_FMT_RGB888) {
+        return out_pixels * 3;
+    }
+    return out_pixels + (out_pixels >> 1);
+}
+
+static esp_h264_err_t h264_sw_dec_process(esp_h264_dec_sw_handle_t *sw_hd, esp_h264_dec_in_frame_t *in_frame, esp_h264_dec_out_frame_t *out_frame)
 {
-    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
     uint32_t retCode = 3;
     uint8_t *pic = NULL;
-    uint32_t length = in_frame->raw_data.len;
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    uint8_t *data = in_frame->raw_data.buffer;
+    uint32_t data_len = in_frame->raw_data.len;
 
-    retCode = h264bsdDecode(sw_hd->dec_hd, in_frame->raw_data.buffer, (u32 *)&length, &pic, (u32 *)&sw_hd->width, (u32 *)&sw_hd->height);
-    in_frame->consume = in_frame->raw_data.len - length;
     out_frame->out_size = 0;
-    sw_hd->out_len = sw_hd->width * sw_hd->height + (sw_hd->width * sw_hd->height >> 1);
+    if (sw_hd->frame_pool) {
+        /** Nothing is consumed before decoding, so the picture isn't lost. The resolution is known after SPS is activated. */
+        ret = esp_h264_frame_pool_check(sw_hd->frame_pool, h264_sw_dec_out_len(sw_hd));
+        if (ret != ESP_H264_ERR_OK) {
+            in_frame->consume = 0;
+            if (ret == ESP_H264_ERR_FAIL) {
+                ESP_H264_LOGE(TAG, "The frame of pool is smaller than %d bytes", (int)h264_sw_dec_out_len(sw_hd));
+            }
+            return ret;
+        }
+    }
+    /** The length of AVCC NAL unit with its prefix in input */
+    uint32_t avcc_len = 0;
+    if (sw_hd->nal_len_size) {
+        if (h264_sw_dec_avcc_nal(sw_hd, &data, &data_len) != ESP_H264_ERR_OK) {
+            in_frame->consume = in_frame->raw_data.len;
+            ESP_H264_LOGE(TAG, "Invalid NAL length prefix");
+            return ESP_H264_ERR_FAIL;
+        }
+        if (data_len == 0) {
+            in_frame->consume = sw_hd->nal_len_size;
+            return ESP_H264_ERR_OK;
+        }
+        avcc_len = sw_hd->nal_len_size + data_len;
+        ret = h264_sw_dec_unescape(sw_hd, &data, &data_len);
+        if (ret != ESP_H264_ERR_OK) {
+            in_frame->consume = 0;
+            return ret;
+        }
+    }
+    uint32_t nal_pos = 0;
+    uint32_t next = data_len;
+    if (sw_hd->skip || sw_hd->seeking || sw_hd->conceal) {
+        next = sw_hd->nal_len_size ? data_len : h264_sw_dec_annexb_nal(data, data_len, &nal_pos);
+        if ((sw_hd->skip || sw_hd->seeking) && (nal_pos < next) && h264_sw_dec_skip_nal(sw_hd, data + nal_pos, next - nal_pos)) {
+            in_frame->consume = sw_hd->nal_len_size ? avcc_len : next;
+            return ESP_H264_ERR_OK;
+        }
+    }
+    uint32_t length = data_len;
+    retCode = h264bsdDecode(sw_hd->dec_hd, data, (u32 *)&length, &pic, (u32 *)&sw_hd->width, (u32 *)&sw_hd->height);
+    in_frame->consume = data_len - length;
+    if (sw_hd->nal_len_size && in_frame->consume) {
+        /** The NAL unit is consumed as a whole. Zero means it is passed again after the picture output. */
+        in_frame->consume = avcc_len;
+    }
+    if (sw_hd->conceal) {
+        if ((retCode == H264BSD_ERROR) && (in_frame->consume < next)) {
+            /** The NAL unit with error is dropped as a whole */
+            in_frame->consume = sw_hd->nal_len_size ? avcc_len : next;
+        }
+        retCode = h264_sw_dec_conceal(sw_hd, retCode, data + nal_pos, (nal_pos < next) ? next - nal_pos : 0, in_frame->consume != 0);
+    }
+    sw_hd->out_len = h264_sw_dec_out_len(sw_hd);
     switch (retCode) {
     case H264BSD_ERROR:
         ESP_H264_LOGE(TAG, "Error in decoding");
@@ -54,8 +424,13 @@ static esp_h264_err_t dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_fra
         return ESP_H264_ERR_OK;
     /* The parsing of picture NALU is done for, like I-frame P-frame.*/
     case H264BSD_PIC_RDY:
+        ret = h264_sw_dec_output(sw_hd, &pic);
+        if (ret != ESP_H264_ERR_OK) {
+            return ret;
+        }
         out_frame->outbuf = pic;
         out_frame->out_size = sw_hd->out_len;
+        out_frame->damaged_mb = sw_hd->conceal ? sw_hd->pic_damaged_mb : 0;
         out_frame->pts = in_frame->pts;
         out_frame->dts = in_frame->dts;
         return ESP_H264_ERR_OK;
@@ -66,6 +441,45 @@ static esp_h264_err_t dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_fra
     return ESP_H264_ERR_OK;
 }
 
+static esp_h264_err_t dec_process(esp_h264_dec_handle_t dec, esp_h264_dec_in_frame_t *in_frame, esp_h264_dec_out_frame_t *out_frame)
+{
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    int64_t start_us = esp_h264_stats_acc_start();
+    esp_h264_err_t ret = h264_sw_dec_process(sw_hd, in_frame, out_frame);
+    if (ret == ESP_H264_ERR_BUSY) {
+        /** Nothing is decoded. It isn't one error and the time of waiting isn't counted. */
+        return ret;
+    }
+    /** Only the picture is counted as one frame. The parameter sets are counted into the next picture. */
+    sw_hd->in_len += in_frame->consume;
+    if ((ret != ESP_H264_ERR_OK) || out_frame->out_size) {
+        esp_h264_frame_stats_t rec = {
+            .frame_type = ESP_H264_FRAME_TYPE_INVALID,
+            .len = sw_hd->in_len,
+        };
+        esp_h264_stats_acc_add(&sw_hd->stats, start_us - sw_hd->busy_us, &rec, ret);
+        sw_hd->in_len = 0;
+        sw_hd->busy_us = 0;
+    } else {
+        sw_hd->busy_us += esp_h264_stats_acc_start() - start_us;
+    }
+    return ret;
+}
+
+static esp_h264_err_t dec_get_stats(esp_h264_dec_handle_t dec, esp_h264_stats_t *stats)
+{
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    esp_h264_stats_acc_get(&sw_hd->stats, 0, stats);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t dec_reset_stats(esp_h264_dec_handle_t dec)
+{
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    esp_h264_stats_acc_reset(&sw_hd->stats);
+    return ESP_H264_ERR_OK;
+}
+
 static esp_h264_err_t dec_close(esp_h264_dec_handle_t dec)
 {
     return ESP_H264_ERR_OK;
@@ -86,16 +500,33 @@ static esp_h264_err_t dec_del(esp_h264_dec_handle_t dec)
             sw_hd->dec_hd = NULL;
         }
         dec_close(dec);
+        esp_h264_frame_pool_del(sw_hd->frame_pool);
+        if (sw_hd->out_buf) {
+            esp_h264_free(sw_hd->out_buf);
+        }
+        if (sw_hd->scale_buf) {
+            esp_h264_free(sw_hd->scale_buf);
+        }
+        if (sw_hd->nal_buf) {
+            esp_h264_free(sw_hd->nal_buf);
+        }
         esp_h264_free(sw_hd);
     }
     return ESP_H264_ERR_OK;
 }
 
-esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_dec_handle_t *out_dec)
+static esp_h264_err_t dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, const esp_h264_dec_task_cfg_t *task_cfg, esp_h264_dec_handle_t *out_dec)
 {
     /* Parameter check */
     ESP_H264_RET_ON_FALSE(cfg && out_dec, ESP_H264_ERR_ARG, TAG, "Invalid h264 configure and handle parameter");
-    ESP_H264_RET_ON_FALSE(cfg->pic_type == ESP_H264_RAW_FMT_I420, ESP_H264_ERR_ARG, TAG, "Un-supported h264 picture type parameter");
+    ESP_H264_RET_ON_FALSE((cfg->pic_type == ESP_H264_RAW_FMT_I420) || (cfg->pic_type == ESP_H264_RAW_FMT_NV12)
+                          || (cfg->pic_type == ESP_H264_RAW_FMT_YUYV) || (cfg->pic_type == ESP_H264_RAW_FMT_O_UYY_E_VYY)
+                          || (cfg->pic_type == ESP_H264_RAW_FMT_RGB565_LE) || (cfg->pic_type == ESP_H264_RAW_FMT_RGB565_BE)
+                          || (cfg->pic_type == ESP_H264_RAW_FMT_RGB888),
+                          ESP_H264_ERR_ARG, TAG, "Un-supported h264 picture type parameter");
+    ESP_H264_RET_ON_FALSE(task_cfg->mode <= ESP_H264_DEC_TASK_DUAL, ESP_H264_ERR_ARG, TAG, "Invalid task mode parameter %d", task_cfg->mode);
+    ESP_H264_RET_ON_FALSE((task_cfg->mode != ESP_H264_DEC_TASK_DUAL) || ((task_cfg->core <= 1) && (task_cfg->priority < configMAX_PRIORITIES)),
+                          ESP_H264_ERR_ARG, TAG, "Invalid task core %d and priority %d parameter", task_cfg->core, task_cfg->priority);
 
     *out_dec = NULL;
     ESP_H264_LOGI(TAG, "tinyh264 version: %s ", esp_tinyh264_get_version());
@@ -112,14 +543,45 @@ esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_de
     tinyh264_cfg.dualTaskCore = CONFIG_ESP_H264_DUAL_TASK_CORE;
     tinyh264_cfg.dualTaskPriority = CONFIG_ESP_H264_DUAL_TASK_PRIORITY;
 #endif
+    /** The task mode of this decoder overrides Kconfig */
+    if (task_cfg->mode == ESP_H264_DEC_TASK_SINGLE) {
+        tinyh264_cfg.dualTaskEnable = 0;
+    } else if (task_cfg->mode == ESP_H264_DEC_TASK_DUAL) {
+        tinyh264_cfg.dualTaskEnable = 1;
+        tinyh264_cfg.dualTaskCore = task_cfg->core;
+        if (task_cfg->priority) {
+            tinyh264_cfg.dualTaskPriority = task_cfg->priority;
+        }
+    }
     sw_hd->dec_hd = h264bsdAlloc(&tinyh264_cfg);
     ESP_H264_GOTO_ON_FALSE(sw_hd->dec_hd != NULL, ret, __dec_exit__, TAG, "No memory for decoder handle");
 
+    /** The output format is converted from I420 */
+    sw_hd->pic_type = cfg->pic_type;
+    if (cfg->pic_type == ESP_H264_RAW_FMT_NV12) {
+        sw_hd->cc = iyuv2nv12;
+    } else if (cfg->pic_type == ESP_H264_RAW_FMT_YUYV) {
+        sw_hd->cc = iyuv2yuyv;
+    } else if (cfg->pic_type == ESP_H264_RAW_FMT_O_UYY_E_VYY) {
+        sw_hd->cc = iyuv2ouyy_evyy;
+    } else if (cfg->pic_type == ESP_H264_RAW_FMT_RGB565_LE) {
+        sw_hd->rgb_cc = iyuv2rgb565le;
+    } else if (cfg->pic_type == ESP_H264_RAW_FMT_RGB565_BE) {
+        sw_hd->rgb_cc = iyuv2rgb565be;
+    } else if (cfg->pic_type == ESP_H264_RAW_FMT_RGB888) {
+        sw_hd->rgb_cc = iyuv2rgb888;
+    }
+    sw_hd->matrix = &yuv2rgb_matrix[ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED];
+    sw_hd->err_mb = -1;
+    sw_hd->ref_frame_num = -1;
+
     /** Encoder handle configure */
     sw_hd->base.open = dec_open;
     sw_hd->base.process = dec_process;
     sw_hd->base.close = dec_close;
     sw_hd->base.del = dec_del;
+    sw_hd->base.get_stats = dec_get_stats;
+    sw_hd->base.reset_stats = dec_reset_stats;
     sw_hd->param_hd.get_res = get_res;
     *out_dec = &sw_hd->base;
     return ret;
@@ -129,6 +591,93 @@ __dec_exit__:
     return ret;
 }
 
+esp_h264_err_t esp_h264_dec_sw_new(const esp_h264_dec_cfg_sw_t *cfg, esp_h264_dec_handle_t *out_dec)
+{
+    esp_h264_dec_task_cfg_t task_cfg = {.mode = ESP_H264_DEC_TASK_DEFAULT};
+    return dec_sw_new(cfg, &task_cfg, out_dec);
+}
+
+esp_h264_err_t esp_h264_dec_sw_new_with_task(const esp_h264_dec_cfg_sw_t *cfg, const esp_h264_dec_task_cfg_t *task_cfg, esp_h264_dec_handle_t *out_dec)
+{
+    ESP_H264_RET_ON_FALSE(task_cfg, ESP_H264_ERR_ARG, TAG, "Invalid task configure parameter");
+    return dec_sw_new(cfg, task_cfg, out_dec);
+}
+
+esp_h264_err_t esp_h264_dec_sw_set_avcc(esp_h264_dec_handle_t dec, const uint8_t *avcc, uint32_t avcc_len)
+{
+    ESP_H264_RET_ON_FALSE(dec && (avcc || !avcc_len), ESP_H264_ERR_ARG, TAG, "Invalid decoder handle and avcC parameter");
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    if (avcc == NULL) {
+        sw_hd->nal_len_size = 0;
+        return ESP_H264_ERR_OK;
+    }
+    /** configurationVersion, profile, compatibility, level, lengthSizeMinusOne and numOfSequenceParameterSets */
+    ESP_H264_RET_ON_FALSE((avcc_len >= 7) && (avcc[0] == 1), ESP_H264_ERR_ARG, TAG, "Invalid avcC header");
+    uint8_t nal_len_size = (avcc[4] & 0x03) + 1;
+    ESP_H264_RET_ON_FALSE(nal_len_size != 3, ESP_H264_ERR_ARG, TAG, "Invalid NAL length size");
+    uint32_t pos = 5;
+    for (uint8_t set = 0; set < 2; set++) {
+        /** SPS number is 5 bits and PPS number is 8 bits */
+        ESP_H264_RET_ON_FALSE(pos < avcc_len, ESP_H264_ERR_ARG, TAG, "Invalid parameter set number");
+        uint8_t num = set ? avcc[pos] : (avcc[pos] & 0x1F);
+        pos++;
+        for (uint8_t i = 0; i < num; i++) {
+            ESP_H264_RET_ON_FALSE(pos + 2 <= avcc_len, ESP_H264_ERR_ARG, TAG, "Invalid parameter set length");
+            uint32_t ps_len = (avcc[pos] << 8) | avcc[pos + 1];
+            pos += 2;
+            ESP_H264_RET_ON_FALSE(ps_len && (pos + ps_len <= avcc_len), ESP_H264_ERR_ARG, TAG, "Invalid parameter set length");
+            /** The parameter set is decoded in place, unless it has emulation prevention bytes */
+            uint8_t *pic = NULL;
+            uint8_t *ps = (uint8_t *)avcc + pos;
+            uint32_t length = ps_len;
+            ESP_H264_RET_ON_FALSE(h264_sw_dec_unescape(sw_hd, &ps, &length) == ESP_H264_ERR_OK, ESP_H264_ERR_MEM, TAG, "No memory for parameter set");
+            if ((ps[0] & 0x1F) == H264_NAL_SPS) {
+                h264_sw_dec_conceal_sps(sw_hd, ps, length);
+            }
+            uint32_t retCode = h264bsdDecode(sw_hd->dec_hd, ps, (u32 *)&length, &pic, (u32 *)&sw_hd->width, (u32 *)&sw_hd->height);
+            ESP_H264_RET_ON_FALSE((retCode == H264BSD_RDY) || (retCode == H264BSD_HDRS_RDY), ESP_H264_ERR_FAIL, TAG, "Failed to decode parameter set");
+            pos += ps_len;
+        }
+    }
+    sw_hd->nal_len_size = nal_len_size;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_set_frame_pool(esp_h264_dec_handle_t dec, const esp_h264_pkt_t *frames, uint8_t frame_num)
+{
+    ESP_H264_RET_ON_FALSE(dec && (frames || !frame_num), ESP_H264_ERR_ARG, TAG, "Invalid decoder handle and frames parameter");
+    ESP_H264_RET_ON_FALSE(frame_num <= ESP_H264_DEC_FRAME_POOL_MAX, ESP_H264_ERR_ARG, TAG, "The number of frames is more than %d", ESP_H264_DEC_FRAME_POOL_MAX);
+    for (uint8_t i = 0; i < frame_num; i++) {
+        ESP_H264_RET_ON_FALSE(frames[i].buffer && frames[i].len, ESP_H264_ERR_ARG, TAG, "Invalid frame buffer parameter");
+    }
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    ESP_H264_RET_ON_FALSE(!sw_hd->frame_pool || !esp_h264_frame_pool_is_held(sw_hd->frame_pool), ESP_H264_ERR_FAIL, TAG, "The frames of pool are held");
+    esp_h264_frame_pool_hd_t frame_pool = NULL;
+    if (frames && frame_num) {
+        frame_pool = esp_h264_frame_pool_new(frames, frame_num);
+        ESP_H264_RET_ON_FALSE(frame_pool != NULL, ESP_H264_ERR_MEM, TAG, "No memory for frame pool");
+    }
+    esp_h264_frame_pool_del(sw_hd->frame_pool);
+    sw_hd->frame_pool = frame_pool;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_frame_ref(esp_h264_dec_handle_t dec, const uint8_t *outbuf)
+{
+    ESP_H264_RET_ON_FALSE(dec && outbuf, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle and frame parameter");
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    ESP_H264_RET_ON_FALSE(sw_hd->frame_pool, ESP_H264_ERR_ARG, TAG, "The frame pool isn't set");
+    return esp_h264_frame_pool_ref(sw_hd->frame_pool, outbuf);
+}
+
+esp_h264_err_t esp_h264_dec_sw_frame_release(esp_h264_dec_handle_t dec, const uint8_t *outbuf)
+{
+    ESP_H264_RET_ON_FALSE(dec && outbuf, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle and frame parameter");
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    ESP_H264_RET_ON_FALSE(sw_hd->frame_pool, ESP_H264_ERR_ARG, TAG, "The frame pool isn't set");
+    return esp_h264_frame_pool_release(sw_hd->frame_pool, outbuf);
+}
+
 esp_h264_err_t esp_h264_dec_sw_get_param_hd(esp_h264_dec_handle_t dec, esp_h264_dec_param_sw_handle_t *out_param)
 {
     if (dec && out_param) {
@@ -138,3 +687,52 @@ esp_h264_err_t esp_h264_dec_sw_get_param_hd(esp_h264_dec_handle_t dec, esp_h264_
     }
     return ESP_H264_ERR_ARG;
 }
+
+esp_h264_err_t esp_h264_dec_sw_set_color_space(esp_h264_dec_handle_t dec, esp_h264_dec_color_space_t color_space)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle");
+    ESP_H264_RET_ON_FALSE((uint32_t)color_space < sizeof(yuv2rgb_matrix) / sizeof(yuv2rgb_matrix[0]), ESP_H264_ERR_ARG, TAG, "Invalid color space %d", color_space);
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    sw_hd->matrix = &yuv2rgb_matrix[color_space];
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_set_scale(esp_h264_dec_handle_t dec, esp_h264_dec_scale_t scale)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle");
+    ESP_H264_RET_ON_FALSE(scale <= ESP_H264_DEC_SCALE_1_8, ESP_H264_ERR_ARG, TAG, "Invalid scale %d", scale);
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    sw_hd->scale_shift = scale;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_set_skip(esp_h264_dec_handle_t dec, esp_h264_dec_skip_t skip)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle");
+    ESP_H264_RET_ON_FALSE(skip <= ESP_H264_DEC_SKIP_NON_INTRA, ESP_H264_ERR_ARG, TAG, "Invalid skip mode %d", skip);
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    sw_hd->skip = skip;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_seek(esp_h264_dec_handle_t dec)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle");
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    sw_hd->seeking = true;
+    sw_hd->in_len = 0;
+    sw_hd->busy_us = 0;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t esp_h264_dec_sw_set_conceal(esp_h264_dec_handle_t dec, bool enable)
+{
+    ESP_H264_RET_ON_FALSE(dec, ESP_H264_ERR_ARG, TAG, "Invalid decoder handle");
+    esp_h264_dec_sw_handle_t *sw_hd = __containerof(dec, esp_h264_dec_sw_handle_t, base);
+    sw_hd->conceal = enable;
+    sw_hd->pic_started = false;
+    sw_hd->err_mb = -1;
+    sw_hd->damaged_mb = 0;
+    sw_hd->ref_frame_num = -1;
+    return ESP_H264_ERR_OK;
+}
@@ -8,6 +8,7 @@
 #include "h264_color_convert.h"
 #include "esp_h264_enc_sw_param.h"
 #include "esp_h264_enc_single_sw.h"
+#include "esp_h264_stats_acc.h"
 
 static const char *TAG = "H264_ENC.SW";
 
@@ -22,6 +23,7 @@ typedef struct esp_h264_enc_sw_handle {
     convert_color         cc;
     int                   wxh;
     int                   wxh_q;
+    esp_h264_stats_acc_t  stats;
 } esp_h264_enc_sw_handle_t;
 
 static void fill_enc_param(SEncParamExt *sParam, const esp_h264_enc_cfg_sw_t *cfg)
@@ -47,6 +49,8 @@ static void fill_enc_param(SEncParamExt *sParam, const esp_h264_enc_cfg_sw_t *cf
 
     /*RC */
     sParam->bEnableFrameSkip = false;
+    /* openh264 has no capped quality mode. In both modes the target and maximum bitrate are `bitrate`,
+     * so the capped quality mode keeps the ceiling and the QP range [`qp_min`, `qp_max`] */
     sParam->iRCMode = RC_QUALITY_MODE; //  rc mode control
     sParam->iMaxBitrate = cfg->rc.bitrate;
     sParam->iMaxQp = cfg->rc.qp_max;
@@ -116,6 +120,20 @@ static esp_h264_err_t h264_sw_enc_process(esp_h264_enc_sw_handle_t *sw_hd, esp_h
     out_frame->length = (uint32_t)sFbi.iFrameSizeInBytes;
     out_frame->pts = (uint32_t)sFbi.uiTimeStamp;
     out_frame->dts = in_frame->pts;
+    switch (sFbi.eFrameType) {
+    case videoFrameTypeIDR:
+        out_frame->frame_type = ESP_H264_FRAME_TYPE_IDR;
+        break;
+    case videoFrameTypeI:
+        out_frame->frame_type = ESP_H264_FRAME_TYPE_I;
+        break;
+    case videoFrameTypeP:
+        out_frame->frame_type = ESP_H264_FRAME_TYPE_P;
+        break;
+    default:
+        out_frame->frame_type = ESP_H264_FRAME_TYPE_INVALID;
+        break;
+    }
     return ESP_H264_ERR_OK;
 }
 
@@ -123,10 +141,39 @@ static esp_h264_err_t enc_process(esp_h264_enc_handle_t enc, esp_h264_enc_in_fra
 {
     esp_h264_enc_sw_handle_t *sw_hd = __containerof(enc, esp_h264_enc_sw_handle_t, base);
     esp_h264_err_t ret = ESP_H264_ERR_OK;
+    int64_t start_us = esp_h264_stats_acc_start();
     ret = h264_sw_enc_process(sw_hd, in_frame, out_frame);
+    esp_h264_frame_stats_t rec = {
+        .frame_type = out_frame->frame_type,
+        .len = out_frame->length,
+    };
+    if (ret == ESP_H264_ERR_OK) {
+        /** The average QP of last frame is from openh264 statistics */
+        SEncoderStatistics enc_stats = { 0 };
+        if ((*(sw_hd->pPtrEnc))->GetOption(sw_hd->pPtrEnc, ENCODER_OPTION_GET_STATISTICS, &enc_stats) == cmResultSuccess) {
+            rec.qp = (uint8_t)enc_stats.uiAverageFrameQP;
+        }
+    }
+    esp_h264_stats_acc_add(&sw_hd->stats, start_us, &rec, ret);
     return ret;
 }
 
+static esp_h264_err_t enc_get_stats(esp_h264_enc_handle_t enc, esp_h264_stats_t *stats)
+{
+    esp_h264_enc_sw_handle_t *sw_hd = __containerof(enc, esp_h264_enc_sw_handle_t, base);
+    uint8_t fps = 0;
+    esp_h264_enc_get_fps(sw_hd->param_hd, &fps);
+    esp_h264_stats_acc_get(&sw_hd->stats, fps, stats);
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t enc_reset_stats(esp_h264_enc_handle_t enc)
+{
+    esp_h264_enc_sw_handle_t *sw_hd = __containerof(enc, esp_h264_enc_sw_handle_t, base);
+    esp_h264_stats_acc_reset(&sw_hd->stats);
+    return ESP_H264_ERR_OK;
+}
+
 static esp_h264_err_t enc_close(esp_h264_enc_handle_t enc)
 {
     return ESP_H264_ERR_OK;
@@ -166,6 +213,7 @@ esp_h264_err_t esp_h264_enc_sw_new(const esp_h264_enc_cfg_sw_t *cfg, esp_h264_en
     ESP_H264_RET_ON_FALSE(cfg && out_enc, ESP_H264_ERR_ARG, TAG, "Invalid h264 configure and handle parameter");
     ESP_H264_RET_ON_FALSE((cfg->pic_type == ESP_H264_RAW_FMT_YUYV) || (cfg->pic_type == ESP_H264_RAW_FMT_I420), ESP_H264_ERR_ARG, TAG, "Un-supported h264 picture type parameter");
     ESP_H264_RET_ON_FALSE((cfg->rc.qp_max >= cfg->rc.qp_min) && (cfg->rc.qp_max <= ESP_H264_QP_MAX), ESP_H264_ERR_ARG, TAG, "Invalid h264 QP parameter");
+    ESP_H264_RET_ON_FALSE(cfg->rc.mode < ESP_H264_RC_MODE_MAX, ESP_H264_ERR_ARG, TAG, "Invalid h264 RC mode parameter");
     ESP_H264_RET_ON_FALSE((esp_h264_enc_hw_res_check(cfg->res.width, cfg->res.height) == ESP_H264_ERR_OK), ESP_H264_ERR_ARG, TAG, "Invalid h264 resolution parameter");
     ESP_H264_RET_ON_FALSE((cfg->fps > 0) && (cfg->gop > 0), ESP_H264_ERR_ARG, TAG, "Invalid h264 FPS and GOP parameter");
 
@@ -228,6 +276,8 @@ esp_h264_err_t esp_h264_enc_sw_new(const esp_h264_enc_cfg_sw_t *cfg, esp_h264_en
     sw_hd->base.process = enc_process;
     sw_hd->base.close = enc_close;
     sw_hd->base.del = enc_del;
+    sw_hd->base.get_stats = enc_get_stats;
+    sw_hd->base.reset_stats = enc_reset_stats;
     *out_enc = &sw_hd->base;
     return ret;
 __exit__:
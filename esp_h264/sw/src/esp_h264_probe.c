@@ -0,0 +1,324 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include <string.h>
+#include "esp_h264_check.h"
+#include "esp_h264_probe.h"
+
+static const char *TAG = "H264_PROBE";
+
+#define NAL_SLICE       (1)
+#define NAL_IDR_SLICE   (5)
+#define NAL_SPS         (7)
+#define NAL_PPS         (8)
+#define PROBE_DPB_MAX   (16)
+
+/* Bit reader of RBSP. The emulation prevention byte `03` after `00 00` is removed on the fly. */
+typedef struct {
+    const uint8_t *p;
+    const uint8_t *end;
+    uint8_t        byte;
+    uint8_t        bits_left;
+    uint8_t        zeros;      /*<! The number of successive zero bytes before `p` */
+    bool           overrun;    /*<! Read over the end of NAL unit */
+} probe_bs_t;
+
+/** Level and its maximum decoded picture buffer size in macroblocks */
+static const uint32_t level_dpb_mbs[][2] = {
+    { 9, 396 }, { 10, 396 }, { 11, 900 }, { 12, 2376 }, { 13, 2376 }, { 20, 2376 }, { 21, 4752 },
+    { 22, 8100 }, { 30, 8100 }, { 31, 18000 }, { 32, 20480 }, { 40, 32768 }, { 41, 32768 },
+    { 42, 34816 }, { 50, 110400 }, { 51, 184320 }, { 52, 184320 },
+};
+
+static void bs_init(probe_bs_t *bs, const uint8_t *data, uint32_t len)
+{
+    memset(bs, 0, sizeof(probe_bs_t));
+    bs->p = data;
+    bs->end = data + len;
+}
+
+static uint32_t bs_read_u1(probe_bs_t *bs)
+{
+    if (bs->bits_left == 0) {
+        if ((bs->p < bs->end) && (bs->zeros >= 2) && (*bs->p == 0x03)) {
+            bs->p++;
+            bs->zeros = 0;
+        }
+        if (bs->p >= bs->end) {
+            bs->overrun = true;
+            return 0;
+        }
+        bs->byte = *(bs->p++);
+        bs->zeros = bs->byte ? 0 : bs->zeros + 1;
+        bs->bits_left = 8;
+    }
+    bs->bits_left--;
+    return (bs->byte >> bs->bits_left) & 0x01;
+}
+
+static uint32_t bs_read_u(probe_bs_t *bs, uint8_t n)
+{
+    uint32_t v = 0;
+    while (n--) {
+        v = (v << 1) | bs_read_u1(bs);
+    }
+    return v;
+}
+
+static uint32_t bs_read_ue(probe_bs_t *bs)
+{
+    uint8_t zeros = 0;
+    while (!bs_read_u1(bs)) {
+        if (bs->overrun || (++zeros > 31)) {
+            bs->overrun = true;
+            return 0;
+        }
+    }
+    return ((1u << zeros) - 1) + bs_read_u(bs, zeros);
+}
+
+static int32_t bs_read_se(probe_bs_t *bs)
+{
+    uint32_t v = bs_read_ue(bs);
+    return (v & 0x01) ? (int32_t)((v + 1) >> 1) : -(int32_t)(v >> 1);
+}
+
+static void probe_skip_scaling_list(probe_bs_t *bs, uint8_t size)
+{
+    int32_t last_scale = 8;
+    int32_t next_scale = 8;
+    for (uint8_t i = 0; (i < size) && !bs->overrun; i++) {
+        if (next_scale) {
+            next_scale = (last_scale + bs_read_se(bs) + 256) % 256;
+        }
+        last_scale = next_scale ? next_scale : last_scale;
+    }
+}
+
+static void probe_skip_hrd(probe_bs_t *bs)
+{
+    uint32_t cpb_cnt = bs_read_ue(bs) + 1;
+    bs_read_u(bs, 8);
+    for (uint32_t i = 0; (i < cpb_cnt) && !bs->overrun; i++) {
+        bs_read_ue(bs);
+        bs_read_ue(bs);
+        bs_read_u1(bs);
+    }
+    bs_read_u(bs, 20);
+}
+
+static void probe_vui(probe_bs_t *bs, esp_h264_stream_info_t *info)
+{
+    if (bs_read_u1(bs)) {
+        /** Aspect ratio. 255 is extended SAR */
+        if (bs_read_u(bs, 8) == 255) {
+            bs_read_u(bs, 32);
+        }
+    }
+    if (bs_read_u1(bs)) {
+        bs_read_u1(bs);
+    }
+    if (bs_read_u1(bs)) {
+        bs_read_u(bs, 3);
+        info->full_range = bs_read_u1(bs);
+        if (bs_read_u1(bs)) {
+            bs_read_u(bs, 16);
+            info->matrix_coefficients = bs_read_u(bs, 8);
+        }
+    }
+    if (bs_read_u1(bs)) {
+        bs_read_ue(bs);
+        bs_read_ue(bs);
+    }
+    info->timing_info_present = bs_read_u1(bs);
+    if (info->timing_info_present) {
+        info->num_units_in_tick = bs_read_u(bs, 32);
+        info->time_scale = bs_read_u(bs, 32);
+        info->fixed_frame_rate = bs_read_u1(bs);
+    }
+    bool nal_hrd = bs_read_u1(bs);
+    if (nal_hrd) {
+        probe_skip_hrd(bs);
+    }
+    bool vcl_hrd = bs_read_u1(bs);
+    if (vcl_hrd) {
+        probe_skip_hrd(bs);
+    }
+    if (nal_hrd || vcl_hrd) {
+        bs_read_u1(bs);
+    }
+    bs_read_u1(bs);
+    if (bs_read_u1(bs)) {
+        /** Bitstream restriction */
+        bs_read_u1(bs);
+        for (uint8_t i = 0; i < 5; i++) {
+            bs_read_ue(bs);
+        }
+        info->max_dec_frame_buffering = bs_read_ue(bs);
+    }
+}
+
+/* The decoded picture buffer size of level, if VUI doesn't have it */
+static uint8_t probe_level_dpb(const esp_h264_stream_info_t *info)
+{
+    uint8_t level = info->level_idc;
+    if ((level == 11) && (info->constraint_flags & 0x10) && (info->profile_idc == 66 || info->profile_idc == 77 || info->profile_idc == 88)) {
+        /** Level 1b */
+        level = 9;
+    }
+    uint32_t mbs = (info->coded_res.width >> 4) * (info->coded_res.height >> 4);
+    uint32_t dpb_mbs = 696320;
+    for (uint8_t i = 0; i < sizeof(level_dpb_mbs) / sizeof(level_dpb_mbs[0]); i++) {
+        if (level_dpb_mbs[i][0] == level) {
+            dpb_mbs = level_dpb_mbs[i][1];
+            break;
+        }
+    }
+    uint32_t frames = mbs ? dpb_mbs / mbs : 0;
+    return frames > PROBE_DPB_MAX ? PROBE_DPB_MAX : frames;
+}
+
+esp_h264_err_t esp_h264_probe_sps(const uint8_t *nal, uint32_t len, esp_h264_stream_info_t *info)
+{
+    ESP_H264_RET_ON_FALSE(nal && len && info, ESP_H264_ERR_ARG, TAG, "Invalid NAL unit and information parameter");
+    ESP_H264_RET_ON_FALSE((nal[0] & 0x1F) == NAL_SPS, ESP_H264_ERR_FAIL, TAG, "NAL unit type %d isn't SPS", nal[0] & 0x1F);
+    probe_bs_t bs;
+    memset(info, 0, sizeof(esp_h264_stream_info_t));
+    info->chroma_format_idc = 1;
+    info->bit_depth = 8;
+    info->matrix_coefficients = 2;
+    info->max_dec_frame_buffering = 0xFF;
+    bs_init(&bs, nal + 1, len - 1);
+    info->profile_idc = bs_read_u(&bs, 8);
+    info->constraint_flags = bs_read_u(&bs, 8);
+    info->level_idc = bs_read_u(&bs, 8);
+    info->sps_id = bs_read_ue(&bs);
+    bool separate_colour_plane = false;
+    switch (info->profile_idc) {
+    case 100: case 110: case 122: case 244: case 44: case 83: case 86: case 118: case 128: case 138: case 139: case 134: case 135:
+        info->chroma_format_idc = bs_read_ue(&bs);
+        if (info->chroma_format_idc == 3) {
+            separate_colour_plane = bs_read_u1(&bs);
+        }
+        info->bit_depth = bs_read_ue(&bs) + 8;
+        bs_read_ue(&bs);
+        bs_read_u1(&bs);
+        if (bs_read_u1(&bs)) {
+            for (uint8_t i = 0; i < ((info->chroma_format_idc != 3) ? 8 : 12); i++) {
+                if (bs_read_u1(&bs)) {
+                    probe_skip_scaling_list(&bs, (i < 6) ? 16 : 64);
+                }
+            }
+        }
+        break;
+    default:
+        break;
+    }
+    info->log2_max_frame_num = bs_read_ue(&bs) + 4;
+    uint32_t poc_type = bs_read_ue(&bs);
+    if (poc_type == 0) {
+        bs_read_ue(&bs);
+    } else if (poc_type == 1) {
+        bs_read_u1(&bs);
+        bs_read_se(&bs);
+        bs_read_se(&bs);
+        uint32_t cycle = bs_read_ue(&bs);
+        ESP_H264_RET_ON_FALSE(cycle < 256, ESP_H264_ERR_FAIL, TAG, "Invalid POC cycle %d", (int)cycle);
+        for (uint32_t i = 0; i < cycle; i++) {
+            bs_read_se(&bs);
+        }
+    }
+    info->max_num_ref_frames = bs_read_ue(&bs);
+    info->frame_num_gaps_allowed = bs_read_u1(&bs);
+    uint32_t mb_width = bs_read_ue(&bs) + 1;
+    uint32_t map_height = bs_read_ue(&bs) + 1;
+    info->frame_mbs_only = bs_read_u1(&bs);
+    if (!info->frame_mbs_only) {
+        bs_read_u1(&bs);
+    }
+    bs_read_u1(&bs);
+    ESP_H264_RET_ON_FALSE(!bs.overrun && (mb_width <= 4096) && (map_height <= 4096) && (info->chroma_format_idc <= 3)
+                          && (info->log2_max_frame_num <= 16), ESP_H264_ERR_FAIL, TAG, "Invalid SPS");
+    info->coded_res.width = mb_width << 4;
+    info->coded_res.height = (2 - info->frame_mbs_only) * map_height << 4;
+    if (bs_read_u1(&bs)) {
+        /** Crop in chroma sample unit */
+        uint8_t chroma_type = separate_colour_plane ? 0 : info->chroma_format_idc;
+        uint8_t unit_x = (chroma_type == 1 || chroma_type == 2) ? 2 : 1;
+        uint8_t unit_y = ((chroma_type == 1) ? 2 : 1) * (2 - info->frame_mbs_only);
+        info->crop_left = bs_read_ue(&bs) * unit_x;
+        info->crop_right = bs_read_ue(&bs) * unit_x;
+        info->crop_top = bs_read_ue(&bs) * unit_y;
+        info->crop_bottom = bs_read_ue(&bs) * unit_y;
+    }
+    if (bs_read_u1(&bs)) {
+        probe_vui(&bs, info);
+    }
+    ESP_H264_RET_ON_FALSE(!bs.overrun && (info->crop_left + info->crop_right < info->coded_res.width)
+                          && (info->crop_top + info->crop_bottom < info->coded_res.height), ESP_H264_ERR_FAIL, TAG, "Invalid SPS");
+    info->res.width = info->coded_res.width - info->crop_left - info->crop_right;
+    info->res.height = info->coded_res.height - info->crop_top - info->crop_bottom;
+    if (info->max_dec_frame_buffering == 0xFF) {
+        info->max_dec_frame_buffering = probe_level_dpb(info);
+    }
+    return ESP_H264_ERR_OK;
+}
+
+/* Find the start code `00 00 01` from `pos`. Return its offset, or `len` if it isn't found */
+static uint32_t probe_find_start_code(const uint8_t *data, uint32_t pos, uint32_t len)
+{
+    while (pos + 3 <= len) {
+        if (data[pos + 2] > 1) {
+            pos += 3;
+        } else if (!data[pos] && !data[pos + 1] && (data[pos + 2] == 1)) {
+            return pos;
+        } else {
+            pos++;
+        }
+    }
+    return len;
+}
+
+esp_h264_err_t esp_h264_probe(const uint8_t *data, uint32_t len, esp_h264_stream_info_t *info)
+{
+    ESP_H264_RET_ON_FALSE(data && len && info, ESP_H264_ERR_ARG, TAG, "Invalid data and information parameter");
+    bool sps_found = false;
+    uint32_t pos = probe_find_start_code(data, 0, len);
+    if (pos == len) {
+        /** One NAL unit without start code */
+        return esp_h264_probe_sps(data, len, info);
+    }
+    while (pos < len) {
+        uint32_t nal = pos + 3;
+        uint32_t next = probe_find_start_code(data, nal, len);
+        uint32_t nal_len = next - nal;
+        if (nal_len == 0) {
+            break;
+        }
+        uint8_t type = data[nal] & 0x1F;
+        if ((type == NAL_SPS) && !sps_found) {
+            ESP_H264_RET_ON_FALSE(esp_h264_probe_sps(data + nal, nal_len, info) == ESP_H264_ERR_OK, ESP_H264_ERR_FAIL, TAG, "Invalid SPS");
+            sps_found = true;
+        } else if ((type == NAL_PPS) && sps_found) {
+            probe_bs_t bs;
+            bs_init(&bs, data + nal + 1, nal_len - 1);
+            uint8_t pps_id = bs_read_ue(&bs);
+            uint8_t sps_id = bs_read_ue(&bs);
+            bool cabac = bs_read_u1(&bs);
+            if (!bs.overrun && (sps_id == info->sps_id)) {
+                info->pps_present = true;
+                info->pps_id = pps_id;
+                info->cabac = cabac;
+                break;
+            }
+        } else if (((type == NAL_SLICE) || (type == NAL_IDR_SLICE)) && sps_found) {
+            break;
+        }
+        pos = next;
+    }
+    ESP_H264_RET_ON_FALSE(sps_found, ESP_H264_ERR_FAIL, TAG, "No SPS is found");
+    return ESP_H264_ERR_OK;
+}
@@ -5,6 +5,9 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "h264_color_convert.h"
 
 void yuyv2iyuv(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out)
 {
@@ -26,3 +29,156 @@ void yuyv2iyuv(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out)
         }
     }
 }
+
+void iyuv2nv12(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out)
+{
+    uint8_t *u = in + (width * height);
+    uint8_t *v = u + (width * height >> 2);
+    uint8_t *uv = out + (width * height);
+    memcpy(out, in, width * height);
+    for (uint32_t i = 0; i < (width * height >> 2); i++) {
+        *(uv++) = *(u++);
+        *(uv++) = *(v++);
+    }
+}
+
+void iyuv2yuyv(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out)
+{
+    uint8_t *y = in;
+    uint8_t *u = y + (width * height);
+    uint8_t *v = u + (width * height >> 2);
+    for (uint32_t i = 0; i < height; i++) {
+        /** The odd line uses the chroma of the even line above */
+        uint8_t *u_line = u + (i >> 1) * (width >> 1);
+        uint8_t *v_line = v + (i >> 1) * (width >> 1);
+        for (uint32_t j = 0; j < width; j += 2) {
+            *(out++) = *(y++);
+            *(out++) = *(u_line++);
+            *(out++) = *(y++);
+            *(out++) = *(v_line++);
+        }
+    }
+}
+
+void iyuv2ouyy_evyy(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out)
+{
+    uint8_t *y = in;
+    uint8_t *u = y + (width * height);
+    uint8_t *v = u + (width * height >> 2);
+    for (uint32_t i = 0; i < height; i += 2) {
+        for (uint32_t j = 0; j < width; j += 2) {
+            *(out++) = *(u++);
+            *(out++) = *(y++);
+            *(out++) = *(y++);
+        }
+        for (uint32_t j = 0; j < width; j += 2) {
+            *(out++) = *(v++);
+            *(out++) = *(y++);
+            *(out++) = *(y++);
+        }
+    }
+}
+
+#define RGB_CLIP(v) ((v) < 0 ? 0 : ((v) > 255 ? 255 : (v)))
+
+/* Convert two lines which share one chroma line. `bpp` is constant in caller, so the branches are removed in inline. */
+static inline __attribute__((always_inline)) void iyuv2rgb_line_pair(uint32_t width, uint8_t *y0, uint8_t *u, uint8_t *v,
+                                                                     uint8_t *out0, const h264_yuv2rgb_matrix_t *m, uint8_t bpp, bool be)
+{
+    uint8_t *y1 = y0 + width;
+    uint8_t *out1 = out0 + width * bpp;
+    for (uint32_t j = 0; j < width; j += 2) {
+        int32_t cu = *(u++) - 128;
+        int32_t cv = *(v++) - 128;
+        int32_t r = m->v_r * cv + (1 << 15);
+        int32_t g = m->u_g * cu + m->v_g * cv + (1 << 15);
+        int32_t b = m->u_b * cu + (1 << 15);
+        uint8_t *luma[4] = { y0 + j, y0 + j + 1, y1 + j, y1 + j + 1 };
+        uint8_t *dst[4] = { out0 + j * bpp, out0 + (j + 1) * bpp, out1 + j * bpp, out1 + (j + 1) * bpp };
+        for (uint8_t k = 0; k < 4; k++) {
+            int32_t l = m->y_k * (*luma[k] - m->y_off);
+            int32_t cr = (l + r) >> 16;
+            int32_t cg = (l + g) >> 16;
+            int32_t cb = (l + b) >> 16;
+            cr = RGB_CLIP(cr);
+            cg = RGB_CLIP(cg);
+            cb = RGB_CLIP(cb);
+            if (bpp == 3) {
+                dst[k][0] = cr;
+                dst[k][1] = cg;
+                dst[k][2] = cb;
+            } else {
+                uint16_t pixel = ((cr & 0xF8) << 8) | ((cg & 0xFC) << 3) | (cb >> 3);
+                dst[k][be ? 1 : 0] = pixel & 0xFF;
+                dst[k][be ? 0 : 1] = pixel >> 8;
+            }
+        }
+    }
+}
+
+static inline __attribute__((always_inline)) void iyuv2rgb(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out,
+                                                           const h264_yuv2rgb_matrix_t *matrix, uint8_t bpp, bool be)
+{
+    uint8_t *y = in;
+    uint8_t *u = y + (width * height);
+    uint8_t *v = u + (width * height >> 2);
+    /** Line pair by line pair, so the source lines are still in cache when the pixels are written */
+    for (uint32_t i = 0; i < height; i += 2) {
+        iyuv2rgb_line_pair(width, y, u, v, out, matrix, bpp, be);
+        y += width * 2;
+        u += width >> 1;
+        v += width >> 1;
+        out += width * bpp * 2;
+    }
+}
+
+void iyuv2rgb565le(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix)
+{
+    iyuv2rgb(height, width, in, out, matrix, 2, false);
+}
+
+void iyuv2rgb565be(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix)
+{
+    iyuv2rgb(height, width, in, out, matrix, 2, true);
+}
+
+void iyuv2rgb888(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix)
+{
+    iyuv2rgb(height, width, in, out, matrix, 3, false);
+}
+
+static void plane_downscale(uint32_t height, uint32_t width, uint8_t shift, uint8_t *in, uint8_t *out)
+{
+    uint32_t n = 1 << shift;
+    uint32_t out_w = width >> shift;
+    uint32_t out_h = height >> shift;
+    uint32_t round = (n * n) >> 1;
+    for (uint32_t i = 0; i < out_h; i++) {
+        uint8_t *line = in + i * n * width;
+        for (uint32_t j = 0; j < out_w; j++) {
+            uint32_t sum = round;
+            uint8_t *block = line + j * n;
+            for (uint32_t k = 0; k < n; k++) {
+                for (uint32_t l = 0; l < n; l++) {
+                    sum += block[l];
+                }
+                block += width;
+            }
+            *(out++) = sum >> (shift << 1);
+        }
+    }
+}
+
+void iyuv_downscale(uint32_t height, uint32_t width, uint8_t shift, uint8_t *in, uint8_t *out)
+{
+    uint32_t out_w = width >> shift;
+    uint32_t out_h = height >> shift;
+    /** The output chroma plane is `(out_w >> 1)` x `(out_h >> 1)`, the same as scaling the input chroma plane */
+    plane_downscale(height, width, shift, in, out);
+    in += width * height;
+    out += out_w * out_h;
+    plane_downscale(height >> 1, width >> 1, shift, in, out);
+    in += (width * height >> 2);
+    out += (out_w * out_h >> 2);
+    plane_downscale(height >> 1, width >> 1, shift, in, out);
+}
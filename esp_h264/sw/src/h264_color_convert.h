@@ -12,6 +12,23 @@ extern "C" {
 
 typedef void (*convert_color)(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out);
 
+/**
+ * @brief  YUV to RGB matrix in Q16 fixed point
+ *         R = y_k * (Y - y_off) + v_r * (V - 128)
+ *         G = y_k * (Y - y_off) + u_g * (U - 128) + v_g * (V - 128)
+ *         B = y_k * (Y - y_off) + u_b * (U - 128)
+ */
+typedef struct {
+    int32_t y_off;  /*<! Luma offset. 16 for limited range, 0 for full range */
+    int32_t y_k;    /*<! Luma scale */
+    int32_t v_r;    /*<! V to R */
+    int32_t u_g;    /*<! U to G */
+    int32_t v_g;    /*<! V to G */
+    int32_t u_b;    /*<! U to B */
+} h264_yuv2rgb_matrix_t;
+
+typedef void (*convert_rgb)(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix);
+
 #ifdef HAVE_ESP32S3
 
 /**
@@ -37,6 +54,80 @@ void yuyv2iyuv_esp32s3(uint32_t height, uint32_t width, uint8_t *in, uint8_t *ou
  */
 void yuyv2iyuv(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out);
 
+/**
+ * @brief  Convert I420 data to NV12 data
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     NV12 data address
+ */
+void iyuv2nv12(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out);
+
+/**
+ * @brief  Convert I420 data to YUYV data. The chroma of one line is used by two lines.
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     YUYV data address
+ */
+void iyuv2yuyv(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out);
+
+/**
+ * @brief  Convert I420 data to O_UYY_E_VYY data
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     O_UYY_E_VYY data address
+ */
+void iyuv2ouyy_evyy(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out);
+
+/**
+ * @brief  Convert I420 data to RGB565 data in little endian
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     RGB565 data address
+ * @param  matrix  YUV to RGB matrix
+ */
+void iyuv2rgb565le(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix);
+
+/**
+ * @brief  Convert I420 data to RGB565 data in big endian
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     RGB565 data address
+ * @param  matrix  YUV to RGB matrix
+ */
+void iyuv2rgb565be(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix);
+
+/**
+ * @brief  Convert I420 data to RGB888 data
+ *
+ * @param  height  Height of picture
+ * @param  width   Width of picture
+ * @param  in      I420 data address
+ * @param  out     RGB888 data address
+ * @param  matrix  YUV to RGB matrix
+ */
+void iyuv2rgb888(uint32_t height, uint32_t width, uint8_t *in, uint8_t *out, const h264_yuv2rgb_matrix_t *matrix);
+
+/**
+ * @brief  Downscale I420 data by box filter. Every output pixel is the average of `1 << shift` x `1 << shift` input pixels.
+ *
+ * @param  height  Height of input picture
+ * @param  width   Width of input picture
+ * @param  shift   Scale shift. 1 for 1/2, 2 for 1/4 and 3 for 1/8
+ * @param  in      I420 data address
+ * @param  out     Downscaled I420 data address. Its size is `(width >> shift)` x `(height >> shift)`
+ */
+void iyuv_downscale(uint32_t height, uint32_t width, uint8_t shift, uint8_t *in, uint8_t *out);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,138 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_h264_alloc.h"
+#include "esp_h264_mutex.h"
+#include "esp_h264_dec_sw.h"
+#include "h264_frame_pool.h"
+
+typedef struct {
+    esp_h264_pkt_t frame;
+    uint8_t        ref;
+} frame_pool_slot_t;
+
+typedef struct esp_h264_frame_pool {
+    uint8_t           num;
+    esp_h264_mutex_t  mutex;
+    frame_pool_slot_t slot[ESP_H264_DEC_FRAME_POOL_MAX];
+} esp_h264_frame_pool_t;
+
+/* The held slot of `buf`, or NULL */
+static frame_pool_slot_t *frame_pool_find(esp_h264_frame_pool_t *pool, const uint8_t *buf)
+{
+    for (uint8_t i = 0; i < pool->num; i++) {
+        if ((pool->slot[i].frame.buffer == buf) && pool->slot[i].ref) {
+            return &pool->slot[i];
+        }
+    }
+    return NULL;
+}
+
+esp_h264_frame_pool_hd_t esp_h264_frame_pool_new(const esp_h264_pkt_t *frames, uint8_t frame_num)
+{
+    uint32_t actual_size;
+    esp_h264_frame_pool_t *pool = esp_h264_calloc_prefer(1, sizeof(esp_h264_frame_pool_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (pool == NULL) {
+        return NULL;
+    }
+    pool->mutex = xSemaphoreCreateMutex();
+    if (pool->mutex == NULL) {
+        esp_h264_free(pool);
+        return NULL;
+    }
+    pool->num = frame_num;
+    for (uint8_t i = 0; i < frame_num; i++) {
+        pool->slot[i].frame = frames[i];
+    }
+    return pool;
+}
+
+esp_h264_err_t esp_h264_frame_pool_check(esp_h264_frame_pool_hd_t pool_hd, uint32_t len)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_mutex_lock(pool->mutex, ESP_H264_MAX_DELAY);
+    for (uint8_t i = 0; i < pool->num; i++) {
+        if (pool->slot[i].frame.len < len) {
+            continue;
+        }
+        if (pool->slot[i].ref == 0) {
+            ret = ESP_H264_ERR_OK;
+            break;
+        }
+        ret = ESP_H264_ERR_BUSY;
+    }
+    esp_h264_mutex_unlock(pool->mutex);
+    return ret;
+}
+
+uint8_t *esp_h264_frame_pool_acquire(esp_h264_frame_pool_hd_t pool_hd, uint32_t len)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    uint8_t *buf = NULL;
+    esp_h264_mutex_lock(pool->mutex, ESP_H264_MAX_DELAY);
+    for (uint8_t i = 0; i < pool->num; i++) {
+        if ((pool->slot[i].ref == 0) && (pool->slot[i].frame.len >= len)) {
+            pool->slot[i].ref = 1;
+            buf = pool->slot[i].frame.buffer;
+            break;
+        }
+    }
+    esp_h264_mutex_unlock(pool->mutex);
+    return buf;
+}
+
+esp_h264_err_t esp_h264_frame_pool_ref(esp_h264_frame_pool_hd_t pool_hd, const uint8_t *buf)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    esp_h264_err_t ret = ESP_H264_ERR_ARG;
+    esp_h264_mutex_lock(pool->mutex, ESP_H264_MAX_DELAY);
+    frame_pool_slot_t *slot = frame_pool_find(pool, buf);
+    if (slot && (slot->ref < UINT8_MAX)) {
+        slot->ref++;
+        ret = ESP_H264_ERR_OK;
+    }
+    esp_h264_mutex_unlock(pool->mutex);
+    return ret;
+}
+
+esp_h264_err_t esp_h264_frame_pool_release(esp_h264_frame_pool_hd_t pool_hd, const uint8_t *buf)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    esp_h264_err_t ret = ESP_H264_ERR_ARG;
+    esp_h264_mutex_lock(pool->mutex, ESP_H264_MAX_DELAY);
+    frame_pool_slot_t *slot = frame_pool_find(pool, buf);
+    if (slot) {
+        slot->ref--;
+        ret = ESP_H264_ERR_OK;
+    }
+    esp_h264_mutex_unlock(pool->mutex);
+    return ret;
+}
+
+bool esp_h264_frame_pool_is_held(esp_h264_frame_pool_hd_t pool_hd)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    bool held = false;
+    esp_h264_mutex_lock(pool->mutex, ESP_H264_MAX_DELAY);
+    for (uint8_t i = 0; i < pool->num; i++) {
+        held |= (pool->slot[i].ref != 0);
+    }
+    esp_h264_mutex_unlock(pool->mutex);
+    return held;
+}
+
+void esp_h264_frame_pool_del(esp_h264_frame_pool_hd_t pool_hd)
+{
+    esp_h264_frame_pool_t *pool = (esp_h264_frame_pool_t *)pool_hd;
+    if (pool == NULL) {
+        return;
+    }
+    if (pool->mutex) {
+        esp_h264_mutex_delete(pool->mutex);
+    }
+    esp_h264_free(pool);
+}
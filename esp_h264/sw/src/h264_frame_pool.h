@@ -0,0 +1,101 @@
+/*
+ * SPDX-FileCopyrightText: 2024 Espressif Systems (Shanghai) CO LTD
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_h264_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void *esp_h264_frame_pool_hd_t;  /*<! Decoded frame pool handle */
+
+/**
+ * @brief  Create a decoded frame pool with the frame buffers of application
+ *         Every frame has a reference count. The frame is free when the count is 0.
+ *
+ * @param  frames     Frame buffers and their lengths
+ * @param  frame_num  The number of frames
+ *
+ * @return
+ *       - >0    Frame pool handle
+ *       - NULL  Allcated memory failed.
+ */
+esp_h264_frame_pool_hd_t esp_h264_frame_pool_new(const esp_h264_pkt_t *frames, uint8_t frame_num);
+
+/**
+ * @brief  Check whether one free frame is large enough for decoder output
+ *
+ * @param  pool_hd  Frame pool handle
+ * @param  len      The required length in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    One free frame is large enough
+ *       - ESP_H264_ERR_BUSY  The large enough frames are all held by application
+ *       - ESP_H264_ERR_FAIL  No frame is large enough
+ */
+esp_h264_err_t esp_h264_frame_pool_check(esp_h264_frame_pool_hd_t pool_hd, uint32_t len);
+
+/**
+ * @brief  Take one free frame for decoder output. Its reference count is 1.
+ *
+ * @param  pool_hd  Frame pool handle
+ * @param  len      The required length in byte
+ *
+ * @return
+ *       - >0    Frame buffer
+ *       - NULL  No free frame is large enough
+ */
+uint8_t *esp_h264_frame_pool_acquire(esp_h264_frame_pool_hd_t pool_hd, uint32_t len);
+
+/**
+ * @brief  Add one reference to the frame
+ *
+ * @param  pool_hd  Frame pool handle
+ * @param  buf      Frame buffer from `esp_h264_frame_pool_acquire`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  The frame isn't held
+ */
+esp_h264_err_t esp_h264_frame_pool_ref(esp_h264_frame_pool_hd_t pool_hd, const uint8_t *buf);
+
+/**
+ * @brief  Remove one reference from the frame. The frame is free after the last reference is removed.
+ *
+ * @param  pool_hd  Frame pool handle
+ * @param  buf      Frame buffer from `esp_h264_frame_pool_acquire`
+ *
+ * @return
+ *       - ESP_H264_ERR_OK   Succeeded
+ *       - ESP_H264_ERR_ARG  The frame isn't held
+ */
+esp_h264_err_t esp_h264_frame_pool_release(esp_h264_frame_pool_hd_t pool_hd, const uint8_t *buf);
+
+/**
+ * @brief  Check whether any frame is held
+ *
+ * @param  pool_hd  Frame pool handle
+ *
+ * @return
+ *       - true   At least one frame is held
+ *       - false  All frames are free
+ */
+bool esp_h264_frame_pool_is_held(esp_h264_frame_pool_hd_t pool_hd);
+
+/**
+ * @brief  Delete the frame pool. The frame buffers are kept by application.
+ *
+ * @param  pool_hd  Frame pool handle
+ */
+void esp_h264_frame_pool_del(esp_h264_frame_pool_hd_t pool_hd);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,15 +7,33 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "esp_cache.h"
+#include "esp_rom_crc.h"
+#include "esp_private/esp_cache_private.h"
 #include "esp_h264_hw_enc_test.h"
 #include "esp_h264_alloc.h"
 #include "h264_io.h"
 
+#define SCENE_TEST_CUT_INTERVAL (10)
+#define SCENE_TEST_CUT_NUM      (4)
+
 static int write_mvm(esp_h264_enc_mvm_pkt_t *mv_pkt, uint32_t length)
 {
     return 1;
 }
 
+/* The output segments are aligned to the larger cache line of internal RAM and PSRAM */
+static uint32_t hw_enc_test_seg_align(void)
+{
+    size_t align_int = 0;
+    size_t align_ext = 0;
+    esp_cache_get_alignment(ESP_H264_MEM_INTERNAL, &align_int);
+    esp_cache_get_alignment(ESP_H264_MEM_SPIRAM, &align_ext);
+    size_t align = align_int > align_ext ? align_int : align_ext;
+    return align > 8 ? (uint32_t)align : 8;
+}
+
 esp_h264_err_t single_hw_enc_process(esp_h264_enc_cfg_hw_t cfg)
 {
     esp_h264_enc_in_frame_t in_frame = {0};
@@ -1267,3 +1285,1674 @@ _exit_dual_:
     }
     return ret;
 }
+
+static esp_h264_err_t hw_enc_test_scene_cuts(esp_h264_enc_cfg_hw_t cfg, esp_h264_enc_in_frame_t *in_frame, uint8_t *pic[2], esp_h264_enc_scene_cfg_t *scene_cfg,
+                                             uint32_t *out_p_len_max, uint8_t *out_qp_swing)
+{
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd  = NULL;
+    esp_h264_enc_scene_cfg_t scene_cfg_info = {0};
+    esp_h264_stats_t stats = {0};
+    uint32_t cut_cnt = 0;
+    int16_t qp_last = -1;
+
+    *out_p_len_max = 0;
+    *out_qp_swing = 0;
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _scene_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd error. line %d \n", __LINE__);
+        goto _scene_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_scene_change(param_hd, *scene_cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_scene_change failed. line %d \n", __LINE__);
+        goto _scene_exit_;
+    }
+    ret = esp_h264_enc_hw_get_scene_change_cfg_info(param_hd, &scene_cfg_info);
+    if ((ret != ESP_H264_ERR_OK)
+            || (scene_cfg_info.enable != scene_cfg->enable)
+            || (scene_cfg_info.mad_thres != scene_cfg->mad_thres)
+            || (scene_cfg_info.hist_thres != scene_cfg->hist_thres)) {
+        printf("esp_h264_enc_hw_get_scene_change_cfg_info failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _scene_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _scene_exit_;
+    }
+    /** The first frame has no RC history, so its bound is the largest. The cut frame is promoted only when the output buffer holds an IDR-frame. */
+    ret = esp_h264_enc_hw_get_out_buf_size(enc, &out_frame.raw_data.len);
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if ((ret != ESP_H264_ERR_OK) || !out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _scene_exit_;
+    }
+    for (uint32_t i = 0; i < SCENE_TEST_CUT_INTERVAL * SCENE_TEST_CUT_NUM; i++) {
+        memcpy(in_frame->raw_data.buffer, pic[(i / SCENE_TEST_CUT_INTERVAL) & 1], in_frame->raw_data.len);
+        ret = esp_h264_enc_process(enc, in_frame, &out_frame);
+        ret |= esp_h264_enc_get_stats(enc, &stats);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _scene_exit_;
+        }
+        /** The GOP is greater than the number of frames. So the IDR-frames are the first frame and the cuts only. */
+        bool is_cut = (i % SCENE_TEST_CUT_INTERVAL) == 0;
+        bool is_idr = out_frame.frame_type == ESP_H264_FRAME_TYPE_IDR;
+        if ((scene_cfg->enable ? is_cut : (i == 0)) != is_idr) {
+            printf("Frame %d type %d, the cut is %d. line %d \n", (int)i, out_frame.frame_type, is_cut, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _scene_exit_;
+        }
+        cut_cnt += is_idr && i;
+        /** The bits and QP stability of P-frames. The QP swing isn't counted across IDR-frame */
+        int16_t qp = stats.frame_stats[stats.frame_stats_num - 1].qp;
+        if (!is_idr) {
+            *out_p_len_max = (out_frame.length > *out_p_len_max) ? out_frame.length : *out_p_len_max;
+            if (qp_last >= 0) {
+                uint8_t swing = (qp > qp_last) ? (qp - qp_last) : (qp_last - qp);
+                *out_qp_swing = (swing > *out_qp_swing) ? swing : *out_qp_swing;
+            }
+        }
+        qp_last = is_idr ? -1 : qp;
+    }
+    printf("Scene change detection %d: %d cuts in %d frames, P-frame length max %d, QP swing %d \n", scene_cfg->enable, (int)cut_cnt,
+           SCENE_TEST_CUT_INTERVAL * SCENE_TEST_CUT_NUM, (int)*out_p_len_max, (int)*out_qp_swing);
+_scene_exit_:
+    if (enc) {
+        ret |= esp_h264_enc_close(enc);
+        ret |= esp_h264_enc_del(enc);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_scene_change_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_scene_cfg_t scene_cfg = {
+        .enable = true,
+        .mad_thres = 300,
+        .hist_thres = 50,
+    };
+    esp_h264_enc_scene_cfg_t off_cfg = {0};
+    uint8_t *pic[2] = {NULL};
+    uint32_t buf_len = 0;
+    uint32_t p_len_max[2] = {0};
+    uint8_t qp_swing[2] = {0};
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _scene_exit_;
+    }
+    /** Two flat pictures of different luma. The sequence switches between them every `SCENE_TEST_CUT_INTERVAL` frames. */
+    for (uint8_t i = 0; i < 2; i++) {
+        pic[i] = esp_h264_calloc_prefer(1, in_frame.raw_data.len, &buf_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+        if (!pic[i] || (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) <= 0)) {
+            printf("Input picture failed.line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _scene_exit_;
+        }
+        memcpy(pic[i], in_frame.raw_data.buffer, in_frame.raw_data.len);
+    }
+    /** The same cut-heavy sequence without and with scene change detection */
+    ret = hw_enc_test_scene_cuts(cfg, &in_frame, pic, &off_cfg, &p_len_max[0], &qp_swing[0]);
+    ret |= hw_enc_test_scene_cuts(cfg, &in_frame, pic, &scene_cfg, &p_len_max[1], &qp_swing[1]);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _scene_exit_;
+    }
+    /** The cut P-frames are gone. So the P-frames mustn't be larger or swing more in QP */
+    if ((p_len_max[1] > p_len_max[0]) || (qp_swing[1] > qp_swing[0])) {
+        printf("Scene change detection doesn't stabilize the bits and QP. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+    /** Reset the color index of input */
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0);
+_scene_exit_:
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        if (pic[i]) {
+            esp_h264_free(pic[i]);
+        }
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_static_skip_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd  = NULL;
+    /** The MAD check is off, so every frame of the same picture is skipped until `max_skip` */
+    esp_h264_enc_skip_cfg_t skip_cfg = {
+        .enable = true,
+        .diff_thres = 2,
+        .mad_thres = 0,
+        .max_skip = 10,
+    };
+    esp_h264_enc_skip_cfg_t skip_cfg_info = {0};
+    esp_h264_stats_t stats = {0};
+    uint32_t skip_cnt = 0;
+    uint32_t skip_len = 0;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd error. line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_static_skip(param_hd, skip_cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_static_skip failed. line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    ret = esp_h264_enc_hw_get_static_skip_cfg_info(param_hd, &skip_cfg_info);
+    if ((ret != ESP_H264_ERR_OK)
+            || (skip_cfg_info.enable != skip_cfg.enable)
+            || (skip_cfg_info.diff_thres != skip_cfg.diff_thres)
+            || (skip_cfg_info.mad_thres != skip_cfg.mad_thres)
+            || (skip_cfg_info.max_skip != skip_cfg.max_skip)) {
+        printf("esp_h264_enc_hw_get_static_skip_cfg_info failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _skip_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _skip_exit_;
+    }
+    /** The same picture is encoded again and again. So it is a static scene. */
+    if (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) <= 0) {
+        ret = ESP_H264_ERR_FAIL;
+        goto _skip_exit_;
+    }
+    for (uint32_t i = 0; i < cfg.gop; i++) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        ret |= esp_h264_enc_get_stats(enc, &stats);
+        if ((ret != ESP_H264_ERR_OK) || (stats.frame_stats_num == 0)) {
+            printf("process failed. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _skip_exit_;
+        }
+        if ((i == 0) && (out_frame.frame_type != ESP_H264_FRAME_TYPE_IDR)) {
+            printf("The first frame isn't IDR-frame. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _skip_exit_;
+        }
+        /** The skipped frame isn't encoded by hardware, so it has no QP in statistics.
+         *  Every `max_skip` skipped frames are followed by one encoded frame. */
+        bool skipped = stats.frame_stats[stats.frame_stats_num - 1].qp == 0;
+        if (skipped != ((i % (skip_cfg.max_skip + 1)) != 0)) {
+            printf("Frame %d is skipped %d. line %d \n", (int)i, skipped, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _skip_exit_;
+        }
+        if (skipped) {
+            /** The all P_Skip slices are the same size, as `frame_num` has fixed bits */
+            skip_len = skip_len ? skip_len : out_frame.length;
+            if ((out_frame.frame_type != ESP_H264_FRAME_TYPE_P) || (out_frame.length != skip_len) || (out_frame.length >= 32)) {
+                printf("Skipped frame %d type %d length %d. line %d \n", (int)i, out_frame.frame_type, (int)out_frame.length, __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _skip_exit_;
+            }
+            skip_cnt++;
+        }
+        write_enc_cb(&out_frame);
+    }
+    if (skip_cnt != cfg.gop - (cfg.gop + skip_cfg.max_skip) / (skip_cfg.max_skip + 1)) {
+        printf("%d frames are skipped. line %d \n", (int)skip_cnt, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+    /** Reset the color index of input */
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0);
+_skip_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+/* Encode the same picture `frame_num` times. The total length of output is returned. */
+static esp_h264_err_t single_hw_enc_static_bytes(esp_h264_enc_cfg_hw_t cfg, uint32_t frame_num, uint32_t *out_bytes)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    *out_bytes = 0;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _static_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _static_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    ret |= esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _static_exit_;
+    }
+    if (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) <= 0) {
+        ret = ESP_H264_ERR_FAIL;
+        goto _static_exit_;
+    }
+    for (uint32_t i = 0; i < frame_num; i++) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _static_exit_;
+        }
+        *out_bytes += out_frame.length;
+    }
+    /** Reset the color index of input */
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0);
+_static_exit_:
+    if (enc) {
+        ret |= esp_h264_enc_close(enc);
+        ret |= esp_h264_enc_del(enc);
+    }
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_capped_static_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    uint32_t bitrate_bytes = 0;
+    uint32_t capped_bytes = 0;
+    /** Both modes have the same QP range */
+    cfg.rc.mode = ESP_H264_RC_MODE_BITRATE;
+    esp_h264_err_t ret = single_hw_enc_static_bytes(cfg, 60, &bitrate_bytes);
+    cfg.rc.mode = ESP_H264_RC_MODE_CAPPED_QUALITY;
+    ret |= single_hw_enc_static_bytes(cfg, 60, &capped_bytes);
+    if (ret != ESP_H264_ERR_OK) {
+        return ret;
+    }
+    printf("Static scene: %d bytes in bitrate mode, %d bytes in capped quality mode \n", (int)bitrate_bytes, (int)capped_bytes);
+    /** The bitrate mode spends the budget on the static scene. The capped quality mode stays at `qp_min` and doesn't spend more. */
+    if (capped_bytes > bitrate_bytes) {
+        printf("The capped quality mode spends more bits. line %d \n", __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+static esp_h264_err_t hw_enc_test_noise_rate(esp_h264_enc_cfg_hw_t cfg, uint16_t frame_num, uint32_t *out_bitrate, uint8_t *out_qp_min)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_stats_t stats = {0};
+    uint32_t seed = 1;
+    uint64_t bits = 0;
+
+    *out_bitrate = 0;
+    *out_qp_min = ESP_H264_QP_MAX;
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    out_frame.raw_data.len = in_frame.raw_data.len * 2;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer || !out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _noise_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    ret |= esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _noise_exit_;
+    }
+    for (uint16_t i = 0; i < frame_num; i++) {
+        for (uint32_t j = 0; j < in_frame.raw_data.len; j++) {
+            seed = seed * 1103515245 + 12345;
+            in_frame.raw_data.buffer[j] = 0x70 + (seed >> 27);
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _noise_exit_;
+        }
+        /** RC has settled after the first second */
+        if (i + cfg.fps >= frame_num) {
+            bits += out_frame.length * 8;
+        }
+    }
+    *out_bitrate = (uint32_t)bits;
+    ret = esp_h264_enc_get_stats(enc, &stats);
+    /** The QP histogram covers every frame. No bin may lie below `qp_min` */
+    for (uint8_t i = 0; i < (cfg.rc.qp_min >> 2); i++) {
+        if (stats.qp_hist[i]) {
+            *out_qp_min = i << 2;
+            break;
+        }
+    }
+    for (uint8_t i = 0; i < stats.frame_stats_num; i++) {
+        *out_qp_min = (stats.frame_stats[i].qp < *out_qp_min) ? stats.frame_stats[i].qp : *out_qp_min;
+    }
+_noise_exit_:
+    if (enc) {
+        ret |= esp_h264_enc_close(enc);
+        ret |= esp_h264_enc_del(enc);
+    }
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_capped_quality_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    uint32_t free_bitrate = 0;
+    uint32_t capped_bitrate = 0;
+    uint8_t qp_min = 0;
+    uint16_t frame_num = cfg.fps * 3;
+    /** The ceiling is far above the noise, so the QP stays near `qp_min` */
+    cfg.rc.mode = ESP_H264_RC_MODE_CAPPED_QUALITY;
+    cfg.rc.bitrate = 20 * 1000 * 1000;
+    esp_h264_err_t ret = hw_enc_test_noise_rate(cfg, frame_num, &free_bitrate, &qp_min);
+    if ((ret != ESP_H264_ERR_OK) || (qp_min < cfg.rc.qp_min)) {
+        printf("Free capped quality encoding failed. QP %d line %d \n", (int)qp_min, __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    /** Half of the free bitrate must be the ceiling. RC raises QP when the excess bits pass half of the ceiling */
+    cfg.rc.bitrate = free_bitrate >> 1;
+    ret = hw_enc_test_noise_rate(cfg, frame_num, &capped_bitrate, &qp_min);
+    printf("Free bitrate %d, ceiling %d, capped bitrate %d, QP >= %d \n", (int)free_bitrate, (int)cfg.rc.bitrate, (int)capped_bitrate, (int)qp_min);
+    if ((ret != ESP_H264_ERR_OK) || (capped_bitrate > cfg.rc.bitrate + (cfg.rc.bitrate >> 1)) || (qp_min < cfg.rc.qp_min)) {
+        printf("The capped quality mode breaks the ceiling or the QP range. line %d \n", __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t single_hw_enc_qp_map_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd  = NULL;
+    esp_h264_enc_roi_cfg_t roi_cfg = {0};
+    esp_h264_enc_roi_reg_t roi_reg = {0};
+    uint16_t mb_width = (cfg.res.width + 15) >> 4;
+    uint16_t mb_height = (cfg.res.height + 15) >> 4;
+    uint32_t frame_cnt = 0;
+    esp_h264_enc_qp_map_t qp_map = {
+        .frame_qp = 30,
+        .map_len = mb_width * mb_height,
+    };
+    int8_t *map = esp_h264_calloc_prefer(1, qp_map.map_len, &qp_map.map_len, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (!map) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    qp_map.map_len = mb_width * mb_height;
+    /** The top-left quarter is -5 and the bottom-right quarter is 8. The others are 0. */
+    for (uint16_t y = 0; y < mb_height; y++) {
+        for (uint16_t x = 0; x < mb_width; x++) {
+            if ((x < (mb_width >> 1)) && (y < (mb_height >> 1))) {
+                map[y * mb_width + x] = -5;
+            } else if ((x >= (mb_width >> 1)) && (y >= (mb_height >> 1))) {
+                map[y * mb_width + x] = 8;
+            }
+        }
+    }
+    qp_map.delta_qp_map = map;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd error. line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    while (1) {
+        int ret_w = read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        /** The frame QP changes every frame */
+        qp_map.frame_qp = 20 + (frame_cnt % 20);
+        ret = esp_h264_enc_hw_set_qp_map(param_hd, qp_map);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_set_qp_map failed. line %d \n", __LINE__);
+            goto _qp_map_exit_;
+        }
+        ret = esp_h264_enc_hw_get_roi_cfg_info(param_hd, &roi_cfg);
+        if ((ret != ESP_H264_ERR_OK)
+                || (roi_cfg.roi_mode != ESP_H264_ROI_MODE_DELTA_QP)
+                || (roi_cfg.none_roi_delta_qp != 0)) {
+            printf("The none ROI region delta QP is wrong. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _qp_map_exit_;
+        }
+        /** The bottom-right quarter is heavier. So it is the first region. */
+        roi_reg.reg_idx = 0;
+        ret = esp_h264_enc_hw_get_roi_region(param_hd, &roi_reg);
+        if ((ret != ESP_H264_ERR_OK)
+                || (roi_reg.qp != 8)
+                || (roi_reg.x != (mb_width >> 1))
+                || (roi_reg.y != (mb_height >> 1))) {
+            printf("The ROI region 0 is wrong. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _qp_map_exit_;
+        }
+        roi_reg.reg_idx = 1;
+        ret = esp_h264_enc_hw_get_roi_region(param_hd, &roi_reg);
+        if ((ret != ESP_H264_ERR_OK)
+                || (roi_reg.qp != -5)
+                || (roi_reg.len_x != (mb_width >> 1))
+                || (roi_reg.len_y != (mb_height >> 1))) {
+            printf("The ROI region 1 is wrong. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _qp_map_exit_;
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _qp_map_exit_;
+        }
+        frame_cnt++;
+        write_enc_cb(&out_frame);
+    }
+    /** Disable QP map */
+    qp_map.frame_qp = -1;
+    qp_map.delta_qp_map = NULL;
+    ret = esp_h264_enc_hw_set_qp_map(param_hd, qp_map);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_set_qp_map failed. line %d \n", __LINE__);
+        goto _qp_map_exit_;
+    }
+    ret = esp_h264_enc_hw_get_roi_cfg_info(param_hd, &roi_cfg);
+    if ((ret != ESP_H264_ERR_OK) || (roi_cfg.roi_mode != ESP_H264_ROI_MODE_DISABLE)) {
+        printf("The ROI isn't disabled. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_qp_map_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    if (map) {
+        esp_h264_free(map);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_auto_roi_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd  = NULL;
+    esp_h264_enc_auto_roi_cfg_t auto_roi_cfg = {
+        .enable = true,
+        .mv_thres = 2,
+        .min_area = 2,
+        .roi_delta_qp = -4,
+        .none_roi_delta_qp = 2,
+    };
+    esp_h264_enc_auto_roi_cfg_t auto_roi_cfg_info = {0};
+    esp_h264_enc_roi_cfg_t roi_cfg = {0};
+    esp_h264_enc_mv_cfg_t mv_cfg = {0};
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd error. line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_auto_roi(param_hd, auto_roi_cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_auto_roi failed. line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    ret = esp_h264_enc_hw_get_auto_roi_cfg_info(param_hd, &auto_roi_cfg_info);
+    if ((ret != ESP_H264_ERR_OK)
+            || (auto_roi_cfg_info.enable != auto_roi_cfg.enable)
+            || (auto_roi_cfg_info.mv_thres != auto_roi_cfg.mv_thres)
+            || (auto_roi_cfg_info.min_area != auto_roi_cfg.min_area)
+            || (auto_roi_cfg_info.roi_delta_qp != auto_roi_cfg.roi_delta_qp)
+            || (auto_roi_cfg_info.none_roi_delta_qp != auto_roi_cfg.none_roi_delta_qp)) {
+        printf("esp_h264_enc_hw_get_auto_roi_cfg_info failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _auto_roi_exit_;
+    }
+    /** No MV packet is set. So the encoder enables MV output itself. */
+    ret = esp_h264_enc_hw_get_mv_cfg_info(param_hd, &mv_cfg);
+    if ((ret != ESP_H264_ERR_OK) || (mv_cfg.mv_mode == ESP_H264_MVM_MODE_DISABLE)) {
+        printf("The MV output isn't enabled. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _auto_roi_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _auto_roi_exit_;
+    }
+    while (1) {
+        int ret_w = read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _auto_roi_exit_;
+        }
+        ret = esp_h264_enc_hw_get_roi_cfg_info(param_hd, &roi_cfg);
+        if ((ret != ESP_H264_ERR_OK)
+                || (roi_cfg.roi_mode != ESP_H264_ROI_MODE_DELTA_QP)
+                || (roi_cfg.none_roi_delta_qp != auto_roi_cfg.none_roi_delta_qp)) {
+            printf("The ROI configuration is wrong. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _auto_roi_exit_;
+        }
+        write_enc_cb(&out_frame);
+    }
+    /** Disable MV driven ROI. The MV output owned by encoder is disabled too. */
+    auto_roi_cfg.enable = false;
+    ret = esp_h264_enc_hw_cfg_auto_roi(param_hd, auto_roi_cfg);
+    ret |= esp_h264_enc_hw_get_roi_cfg_info(param_hd, &roi_cfg);
+    ret |= esp_h264_enc_hw_get_mv_cfg_info(param_hd, &mv_cfg);
+    if ((ret != ESP_H264_ERR_OK)
+            || (roi_cfg.roi_mode != ESP_H264_ROI_MODE_DISABLE)
+            || (mv_cfg.mv_mode != ESP_H264_MVM_MODE_DISABLE)) {
+        printf("MV driven ROI isn't disabled. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_auto_roi_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_mv_ring_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd  = NULL;
+    esp_h264_enc_mv_cfg_t mv_cfg = {
+        .mv_mode = ESP_H264_MVM_MODE_P16X16,
+        .mv_fmt = ESP_H264_MVM_FMT_ALL,
+    };
+    esp_h264_enc_mvm_pkt_t mv_pkt = {0};
+    uint32_t mv_buf_len = ((cfg.res.width + 15) >> 4) * ((cfg.res.height + 15) >> 4) * sizeof(esp_h264_enc_mv_data_t);
+    uint32_t p_frame_cnt = 0;
+    uint32_t pkt_cnt = 0;
+    bool held = false;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd error. line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_mv(param_hd, mv_cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_mv failed. line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_mv_ring(param_hd, 3);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_mv_ring failed. line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _mv_ring_exit_;
+    }
+    while (1) {
+        int ret_w = read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _mv_ring_exit_;
+        }
+        write_enc_cb(&out_frame);
+        /** Every encoded P-frame has one MV packet. I-frame has no MV. */
+        p_frame_cnt += (out_frame.frame_type == ESP_H264_FRAME_TYPE_P);
+        while (esp_h264_enc_hw_acquire_mv_pkt(param_hd, &mv_pkt) == ESP_H264_ERR_OK) {
+            if (mv_pkt.len > mv_buf_len) {
+                printf("The MV packet length is wrong. line %d \n", __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _mv_ring_exit_;
+            }
+            write_mvm(&mv_pkt, mv_pkt.len / sizeof(esp_h264_enc_mv_data_t));
+            pkt_cnt++;
+            if (pkt_cnt == 1) {
+                /** Hold the first MV packet. */
+                held = true;
+                break;
+            }
+            ret = esp_h264_enc_hw_release_mv_pkt(param_hd, mv_pkt);
+            if (ret != ESP_H264_ERR_OK) {
+                printf("esp_h264_enc_hw_release_mv_pkt failed. line %d \n", __LINE__);
+                goto _mv_ring_exit_;
+            }
+        }
+        if (held) {
+            held = false;
+            /** The ring can't be deleted when the MV packet is held */
+            if (esp_h264_enc_hw_cfg_mv_ring(param_hd, 0) != ESP_H264_ERR_FAIL) {
+                printf("The MV buffer ring is deleted with held MV packet. line %d \n", __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _mv_ring_exit_;
+            }
+            ret = esp_h264_enc_hw_release_mv_pkt(param_hd, mv_pkt);
+            if (ret != ESP_H264_ERR_OK) {
+                printf("esp_h264_enc_hw_release_mv_pkt failed. line %d \n", __LINE__);
+                goto _mv_ring_exit_;
+            }
+        }
+    }
+    if ((pkt_cnt == 0) || (pkt_cnt != p_frame_cnt)) {
+        printf("The MV packets %d aren't equal to P-frames %d. line %d \n", (int)pkt_cnt, (int)p_frame_cnt, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _mv_ring_exit_;
+    }
+    ret = esp_h264_enc_hw_cfg_mv_ring(param_hd, 0);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_mv_ring failed. line %d \n", __LINE__);
+    }
+_mv_ring_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_out_size_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_pkt_t spill = {0};
+    uint32_t out_buf_len = 0;
+    uint32_t out_buf_size = 0;
+    uint32_t spill_len = 0;
+    uint32_t frame_cnt = 0;
+    uint32_t seg_align = hw_enc_test_seg_align();
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    out_buf_len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_buf_len, &out_buf_len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    spill.len = in_frame.raw_data.len;
+    spill.buffer = esp_h264_aligned_calloc(seg_align, 1, spill.len, &spill.len, ESP_H264_MEM_INTERNAL);
+    if (!spill.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    spill.len &= ~(seg_align - 1);
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    while (1) {
+        int ret_w = read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        ret = esp_h264_enc_hw_get_out_buf_size(enc, &out_buf_size);
+        if ((ret != ESP_H264_ERR_OK) || (out_buf_size == 0)) {
+            printf("esp_h264_enc_hw_get_out_buf_size failed. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _out_size_exit_;
+        }
+        /** The output buffer is sized per frame */
+        out_frame.raw_data.len = out_buf_size < out_buf_len ? out_buf_size : out_buf_len;
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _out_size_exit_;
+        }
+        if (out_frame.length > out_buf_size) {
+            printf("The frame %d is larger than the estimate %d. line %d \n", (int)out_frame.length, (int)out_buf_size, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _out_size_exit_;
+        }
+        write_enc_cb(&out_frame);
+        frame_cnt++;
+    }
+    if (frame_cnt == 0) {
+        goto _out_size_exit_;
+    }
+    /** The output buffer is too small for the IDR-frame. The rest of encoded data is in the spill buffer. */
+    ret = esp_h264_enc_hw_set_spill_buf(enc, spill);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_set_spill_buf failed. line %d \n", __LINE__);
+        goto _out_size_exit_;
+    }
+    /** One GOP has one IDR-frame at least */
+    out_frame.raw_data.len = 64;
+    frame_cnt = 0;
+    for (uint8_t i = 0; i < cfg.gop; i++) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _out_size_exit_;
+        }
+        ret = esp_h264_enc_hw_get_spill_len(enc, &spill_len);
+        if ((ret != ESP_H264_ERR_OK)
+                || (spill_len > out_frame.length)
+                || (out_frame.length - spill_len > out_frame.raw_data.len)) {
+            printf("The spill length %d of frame %d is wrong. line %d \n", (int)spill_len, (int)out_frame.length, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _out_size_exit_;
+        }
+        if ((out_frame.frame_type == ESP_H264_FRAME_TYPE_IDR) && spill_len) {
+            frame_cnt++;
+        }
+    }
+    if (frame_cnt == 0) {
+        printf("The IDR-frame isn't in the spill buffer. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _out_size_exit_;
+    }
+    /** Unset the spill buffer */
+    spill_len = 1;
+    esp_h264_pkt_t no_spill = {0};
+    ret = esp_h264_enc_hw_set_spill_buf(enc, no_spill);
+    ret |= esp_h264_enc_hw_get_spill_len(enc, &spill_len);
+    if ((ret != ESP_H264_ERR_OK) || spill_len) {
+        printf("The spill buffer isn't unset. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_out_size_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    if (spill.buffer) {
+        esp_h264_free(spill.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_out_seg_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_pkt_t seg[ESP_H264_OUT_SEG_MAX] = {0};
+    uint32_t seg_len[ESP_H264_OUT_SEG_MAX] = {0};
+    uint8_t *seg_buf = NULL;
+    uint32_t seg_buf_len = 0;
+    uint32_t out_buf_size = 0;
+    uint32_t seg_align = hw_enc_test_seg_align();
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_seg_exit_;
+    }
+    /** The output buffer only holds SPS, PPS, slice header and the start of slice data */
+    out_frame.raw_data.len = 64;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_seg_exit_;
+    }
+    out_frame.raw_data.len = 64;
+    seg_buf_len = in_frame.raw_data.len;
+    seg_buf = esp_h264_aligned_calloc(seg_align, 1, seg_buf_len, &seg_buf_len, ESP_H264_MEM_INTERNAL);
+    if (!seg_buf) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _out_seg_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _out_seg_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _out_seg_exit_;
+    }
+    while (1) {
+        int ret_w = read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        /** The frame is spread over the half of segments at least */
+        ret = esp_h264_enc_hw_get_out_buf_size(enc, &out_buf_size);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_get_out_buf_size failed. line %d \n", __LINE__);
+            goto _out_seg_exit_;
+        }
+        uint32_t len = ((out_buf_size / (ESP_H264_OUT_SEG_MAX >> 1)) + seg_align - 1) & ~(seg_align - 1);
+        if (len * ESP_H264_OUT_SEG_MAX > seg_buf_len) {
+            len = (seg_buf_len / ESP_H264_OUT_SEG_MAX) & ~(seg_align - 1);
+        }
+        for (uint8_t i = 0; i < ESP_H264_OUT_SEG_MAX; i++) {
+            seg[i].buffer = seg_buf + i * len;
+            seg[i].len = len;
+        }
+        ret = esp_h264_enc_hw_set_out_seg(enc, seg, ESP_H264_OUT_SEG_MAX);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_set_out_seg failed. line %d \n", __LINE__);
+            goto _out_seg_exit_;
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _out_seg_exit_;
+        }
+        ret = esp_h264_enc_hw_get_out_seg_len(enc, seg_len, ESP_H264_OUT_SEG_MAX);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_get_out_seg_len failed. line %d \n", __LINE__);
+            goto _out_seg_exit_;
+        }
+        /** The segments are filled in order */
+        uint32_t total = 0;
+        for (uint8_t i = 0; i < ESP_H264_OUT_SEG_MAX; i++) {
+            if ((seg_len[i] > seg[i].len) || (seg_len[i] && i && (seg_len[i - 1] != seg[i - 1].len))) {
+                printf("The length %d of segment %d is wrong. line %d \n", (int)seg_len[i], i, __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _out_seg_exit_;
+            }
+            total += seg_len[i];
+        }
+        if ((total > out_frame.length) || (out_frame.length - total > out_frame.raw_data.len)) {
+            printf("The segments length %d of frame %d is wrong. line %d \n", (int)total, (int)out_frame.length, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _out_seg_exit_;
+        }
+    }
+    /** Unset the output segments */
+    ret = esp_h264_enc_hw_set_out_seg(enc, NULL, 0);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_set_out_seg failed. line %d \n", __LINE__);
+    }
+_out_seg_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    if (seg_buf) {
+        esp_h264_free(seg_buf);
+    }
+    return ret;
+}
+
+static esp_h264_err_t single_hw_enc_pool_process(esp_h264_enc_handle_t enc, esp_h264_enc_cfg_hw_t *cfg, esp_h264_enc_in_frame_t *in_frame, esp_h264_enc_out_frame_t *out_frame)
+{
+    esp_h264_err_t ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        return ret;
+    }
+    bool first = true;
+    while (1) {
+        int ret_w = read_enc_cb_420(in_frame, cfg->res.width, cfg->res.height);
+        if (ret_w <= 0) {
+            break;
+        }
+        ret = esp_h264_enc_process(enc, in_frame, out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            break;
+        }
+        /** The reference frame isn't kept after the pool is used by another encoder */
+        if (first && (out_frame->frame_type != ESP_H264_FRAME_TYPE_IDR)) {
+            printf("The first frame after open isn't IDR-frame. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            break;
+        }
+        first = false;
+        write_enc_cb(out_frame);
+    }
+    ret |= esp_h264_enc_close(enc);
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_pool_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_hw_pool_handle_t pool = NULL;
+    esp_h264_enc_hw_pool_cfg_t pool_cfg = {
+        .res = cfg.res,
+    };
+    esp_h264_enc_hw_pool_info_t pool_info = {0};
+    esp_h264_enc_handle_t enc[2] = {NULL};
+    esp_h264_enc_handle_t enc_busy = NULL;
+    esp_h264_enc_cfg_hw_t cfg_small = cfg;
+    cfg_small.res.width = cfg.res.width - 16;
+    cfg_small.res.height = cfg.res.height - 16;
+    esp_h264_enc_param_hw_handle_t param_hd = NULL;
+    esp_h264_enc_roi_cfg_t roi_cfg = {
+        .roi_mode = ESP_H264_ROI_MODE_DELTA_QP,
+        .none_roi_delta_qp = 2,
+    };
+    esp_h264_enc_roi_cfg_t roi_cfg_info = {0};
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    ret = esp_h264_enc_hw_pool_new(&pool_cfg, &pool);
+    ret |= esp_h264_enc_hw_pool_get_info(pool, &pool_info);
+    if ((ret != ESP_H264_ERR_OK) || !pool_info.ref_size || !pool_info.db_size || !pool_info.db_tmp_size) {
+        printf("esp_h264_enc_hw_pool_new failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    ret = esp_h264_enc_hw_new_with_pool(&cfg, pool, &enc[0]);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_new_with_pool failed. line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    /** The ROI configuration of the first encoder is kept while the second one is used */
+    ret = esp_h264_enc_hw_get_param_hd(enc[0], &param_hd);
+    ret |= esp_h264_enc_hw_cfg_roi(param_hd, roi_cfg);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_cfg_roi failed. line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    ret = esp_h264_enc_hw_new_with_pool(&cfg_small, pool, &enc[1]);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_new_with_pool failed. line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    /** The pool is shared in time. Only one encoder is open. */
+    ret = esp_h264_enc_open(enc[0]);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    if ((esp_h264_enc_open(enc[1]) != ESP_H264_ERR_FAIL)
+            || (esp_h264_enc_hw_new_with_pool(&cfg_small, pool, &enc_busy) != ESP_H264_ERR_FAIL)) {
+        printf("The pool is used by two encoders at the same time. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    ret = esp_h264_enc_close(enc[0]);
+    for (uint8_t i = 0; (i < 4) && (ret == ESP_H264_ERR_OK); i++) {
+        ret = single_hw_enc_pool_process(enc[i & 1], (i & 1) ? &cfg_small : &cfg, &in_frame, &out_frame);
+    }
+    if (ret != ESP_H264_ERR_OK) {
+        goto _pool_exit_;
+    }
+    /** The configuration is in the hardware after open */
+    ret = esp_h264_enc_open(enc[0]);
+    ret |= esp_h264_enc_hw_get_roi_cfg_info(param_hd, &roi_cfg_info);
+    ret |= esp_h264_enc_close(enc[0]);
+    if ((ret != ESP_H264_ERR_OK)
+            || (roi_cfg_info.roi_mode != roi_cfg.roi_mode)
+            || (roi_cfg_info.none_roi_delta_qp != roi_cfg.none_roi_delta_qp)) {
+        printf("The ROI configuration isn't restored. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    /** The pool can't be deleted before its encoders */
+    if (esp_h264_enc_hw_pool_del(pool) != ESP_H264_ERR_FAIL) {
+        printf("The pool is deleted with encoders. line %d \n", __LINE__);
+        pool = NULL;
+        ret = ESP_H264_ERR_FAIL;
+    }
+_pool_exit_:
+    ret |= esp_h264_enc_del(enc[0]);
+    ret |= esp_h264_enc_del(enc[1]);
+    if (pool) {
+        ret |= esp_h264_enc_hw_pool_del(pool);
+    }
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_mem_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_hw_mem_info_t info = {0};
+    int64_t create_us = 0;
+    const uint8_t loop = 10;
+    /** Encoders are rebuilt on resolution change, so the creation time matters */
+    for (uint8_t i = 0; (i < loop) && (ret == ESP_H264_ERR_OK); i++) {
+        int64_t start = esp_timer_get_time();
+        ret = esp_h264_enc_hw_new(&cfg, &enc);
+        create_us += esp_timer_get_time() - start;
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_new failed. line %d \n", __LINE__);
+            break;
+        }
+        ret = esp_h264_enc_hw_get_mem_info(enc, &info);
+        ret |= esp_h264_enc_del(enc);
+    }
+    if (ret != ESP_H264_ERR_OK) {
+        return ret;
+    }
+    printf("Create %dx%d encoder in %d us\n", cfg.res.width, cfg.res.height, (int)(create_us / loop));
+    printf("Memory: handle %d arena %d desc %d ref %d db_tmp %d nal %d db %d total %d\n", (int)info.handle, (int)info.arena, (int)info.desc,
+           (int)info.ref, (int)info.db_tmp, (int)info.nal, (int)info.db, (int)info.total);
+    /** All the regions except de-blocking filter data are in the arena */
+    if (!info.desc || !info.ref || !info.db_tmp || !info.nal || !info.db
+            || (info.desc + info.ref + info.db_tmp + info.nal > info.arena)
+            || (info.total != info.handle + info.arena + info.db)) {
+        printf("The memory information is wrong. line %d \n", __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t single_hw_enc_reconfig_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_enc_param_hw_handle_t param_hd = NULL;
+    esp_h264_resolution_t res = {0};
+    esp_h264_enc_cfg_hw_t cfg_new[2] = {cfg, cfg};
+
+    /** Down to the lower resolution and bitrate, then back to the one at creation */
+    cfg_new[0].res.width = cfg.res.width - 16;
+    cfg_new[0].res.height = cfg.res.height - 16;
+    cfg_new[0].rc.bitrate = cfg.rc.bitrate >> 1;
+    cfg_new[0].rc.qp_min = cfg.rc.qp_min + 5;
+    cfg_new[0].fps = cfg.fps >> 1;
+    cfg_new[0].gop = cfg.gop >> 1;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _reconfig_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _reconfig_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _reconfig_exit_;
+    }
+    ret = esp_h264_enc_hw_get_param_hd(enc, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_hw_get_param_hd failed .line %d \n", __LINE__);
+        goto _reconfig_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _reconfig_exit_;
+    }
+    for (uint8_t n = 0; n < 2; n++) {
+        for (uint8_t i = 0; i < 5; i++) {
+            if (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) <= 0) {
+                read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+            }
+            ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+            if (ret != ESP_H264_ERR_OK) {
+                printf("process failed. line %d \n", __LINE__);
+                goto _reconfig_exit_;
+            }
+            write_enc_cb(&out_frame);
+        }
+        ret = esp_h264_enc_hw_reconfigure(enc, &cfg_new[n]);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_reconfigure failed. line %d \n", __LINE__);
+            goto _reconfig_exit_;
+        }
+        ret = esp_h264_enc_get_resolution(&param_hd->base, &res);
+        if ((ret != ESP_H264_ERR_OK)
+                || (res.width != cfg_new[n].res.width)
+                || (res.height != cfg_new[n].res.height)) {
+            printf("esp_h264_enc_get_resolution failed .line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _reconfig_exit_;
+        }
+        /** The new configuration starts from IDR-frame */
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _reconfig_exit_;
+        }
+        if (out_frame.frame_type != ESP_H264_FRAME_TYPE_IDR) {
+            printf("The first frame after reconfiguration isn't IDR-frame. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _reconfig_exit_;
+        }
+        write_enc_cb(&out_frame);
+    }
+    /** The resolution greater than the one at creation is refused */
+    cfg_new[1].res.width = cfg.res.width + 16;
+    if (esp_h264_enc_hw_reconfigure(enc, &cfg_new[1]) != ESP_H264_ERR_ARG) {
+        printf("esp_h264_enc_hw_reconfigure accepts larger resolution. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+    /** Reset the color index of input */
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0);
+_reconfig_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_stats_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_stats_t stats = {0};
+    uint32_t frame_cnt = 0;
+    uint32_t idr_cnt = 0;
+    uint32_t qp_cnt = 0;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _stats_exit_;
+        }
+        idr_cnt += (out_frame.frame_type == ESP_H264_FRAME_TYPE_IDR);
+        frame_cnt++;
+        write_enc_cb(&out_frame);
+    }
+    ret = esp_h264_enc_get_stats(enc, &stats);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_get_stats failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    for (uint8_t i = 0; i < ESP_H264_STATS_QP_BIN_NUM; i++) {
+        qp_cnt += stats.qp_hist[i];
+    }
+    printf("Frames %d IDR %d latency avg %d max %d us bitrate %d IDR length %d max %d \n", (int)stats.frame_num, (int)stats.idr_num,
+           (int)stats.latency_avg_us, (int)stats.latency_max_us, (int)stats.bitrate, (int)stats.idr_len_last, (int)stats.idr_len_max);
+    if ((stats.frame_num != frame_cnt)
+            || (stats.idr_num != idr_cnt)
+            || (stats.err_num + stats.timeout_num + stats.overflow_num)
+            || (qp_cnt != frame_cnt)
+            || (stats.frame_stats_num != (frame_cnt < ESP_H264_STATS_FRAME_NUM ? frame_cnt : ESP_H264_STATS_FRAME_NUM))
+            || (stats.frame_stats[stats.frame_stats_num - 1].len != out_frame.length)
+            || !stats.latency_avg_us || (stats.latency_max_us < stats.latency_avg_us)
+            || !stats.bitrate || !stats.idr_len_last || (stats.idr_len_max < stats.idr_len_last)) {
+        printf("The statistics are wrong. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_reset_stats(enc);
+    ret |= esp_h264_enc_get_stats(enc, &stats);
+    if ((ret != ESP_H264_ERR_OK) || stats.frame_num || stats.frame_stats_num) {
+        printf("esp_h264_enc_reset_stats failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_stats_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_trace_test(esp_h264_enc_cfg_hw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    char *json = NULL;
+    uint32_t json_len = 0;
+    uint32_t json_size = 0;
+    char dummy = 0;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _trace_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _trace_exit_;
+    }
+    ret = esp_h264_enc_hw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _trace_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _trace_exit_;
+    }
+    while (read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height) > 0) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _trace_exit_;
+        }
+        write_enc_cb(&out_frame);
+    }
+    /** The required length is reported for the small buffer */
+    ret = esp_h264_enc_hw_trace_export(enc, &dummy, 1, &json_len);
+    if (ret == ESP_H264_ERR_UNSUPPORTED) {
+        printf("The trace points aren't compiled. Enable CONFIG_ESP_H264_TRACE to test them\n");
+        ret = ESP_H264_ERR_OK;
+        goto _trace_exit_;
+    }
+    if ((ret != ESP_H264_ERR_MEM) || (json_len == 0)) {
+        printf("esp_h264_enc_hw_trace_export failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _trace_exit_;
+    }
+    json = esp_h264_calloc_prefer(1, json_len + 1, &json_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!json) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _trace_exit_;
+    }
+    ret = esp_h264_enc_hw_trace_export(enc, json, json_size, &json_len);
+    if ((ret != ESP_H264_ERR_OK)
+            || (strncmp(json, "{\"traceEvents\":[", 16) != 0)
+            || !strstr(json, "\"isr_frame_done\"")
+            || !strstr(json, "\"rc_end\"")
+            || !strstr(json, "\"ph\":\"E\"")) {
+        printf("The trace JSON is wrong. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _trace_exit_;
+    }
+    printf("Trace JSON %d bytes\n", (int)json_len);
+_trace_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (json) {
+        esp_h264_free(json);
+    }
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_hw_enc_cache_test(esp_h264_enc_cfg_hw_t cfg, uint16_t frame_num)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_stats_t stats[2] = {0};
+    uint32_t crc[2] = {0};
+    uint32_t align = hw_enc_test_seg_align();
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _cache_exit_;
+    }
+    /** The output buffer is invalidated by the test with `ESP_H264_ENC_HW_BUF_OUT_DEV_READ`. So it is aligned to the cache line. */
+    out_frame.raw_data.len = (in_frame.raw_data.len + align - 1) & ~(align - 1);
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(align, 1, out_frame.raw_data.len, &out_frame.raw_data.len, ESP_H264_MEM_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _cache_exit_;
+    }
+    /** The same picture is encoded by two encoders, with the default cache synchronization and with the ownership flags.
+     *  The input frame is written back by the first pass, so the hardware reads the right data in the second pass.
+     *  Both bitstreams must be the same. */
+    read_enc_cb_420(&in_frame, cfg.res.width, cfg.res.height);
+    for (uint8_t pass = 0; pass < 2; pass++) {
+        uint32_t flags = pass ? (ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN | ESP_H264_ENC_HW_BUF_OUT_DEV_READ) : 0;
+        ret = esp_h264_enc_hw_new(&cfg, &enc);
+        ret |= esp_h264_enc_open(enc);
+        ret |= esp_h264_enc_hw_set_buf_flags(enc, flags);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_enc_hw_set_buf_flags failed. line %d \n", __LINE__);
+            goto _cache_exit_;
+        }
+        for (uint16_t i = 0; i < frame_num; i++) {
+            ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+            if (ret != ESP_H264_ERR_OK) {
+                printf("process failed. line %d \n", __LINE__);
+                goto _cache_exit_;
+            }
+            if (flags & ESP_H264_ENC_HW_BUF_OUT_DEV_READ) {
+                /** The encoder skips the invalidation, so the CPU reads the encoded data after it */
+                esp_cache_msync(out_frame.raw_data.buffer, (out_frame.length + align - 1) & ~(align - 1), ESP_CACHE_MSYNC_FLAG_DIR_M2C);
+            }
+            crc[pass] = esp_rom_crc32_le(crc[pass], out_frame.raw_data.buffer, out_frame.length);
+        }
+        ret = esp_h264_enc_get_stats(enc, &stats[pass]);
+        if ((ret != ESP_H264_ERR_OK) || (stats[pass].frame_num != frame_num)) {
+            printf("esp_h264_enc_get_stats failed. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _cache_exit_;
+        }
+        ret = esp_h264_enc_close(enc);
+        ret |= esp_h264_enc_del(enc);
+        enc = NULL;
+        if (ret != ESP_H264_ERR_OK) {
+            printf("close failed. line %d \n", __LINE__);
+            goto _cache_exit_;
+        }
+    }
+    printf("Average latency %d us with cache synchronization, %d us without it, %d us saved per frame\n",
+           (int)stats[0].latency_avg_us, (int)stats[1].latency_avg_us, (int)stats[0].latency_avg_us - (int)stats[1].latency_avg_us);
+    if (crc[0] != crc[1]) {
+        printf("The bitstream CRC 0x%08x with cache synchronization, 0x%08x without it. line %d \n", (unsigned)crc[0], (unsigned)crc[1], __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_cache_exit_:
+    if (enc) {
+        ret |= esp_h264_enc_close(enc);
+        ret |= esp_h264_enc_del(enc);
+    }
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t hw_enc_motion_test(uint8_t mb_width, uint8_t mb_height)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_motion_handle_t motion = NULL;
+    esp_h264_motion_cfg_t motion_cfg = {
+        .mb_width = mb_width,
+        .mb_height = mb_height,
+        .mv_thres = 2,
+        .heat_rise = 64,
+        .heat_decay = 64,
+        .heat_thres = 100,
+        .on_thres = 1,
+        .off_thres = 1,
+        .on_frames = 2,
+        .off_frames = 2,
+        .min_area = 2,
+    };
+    esp_h264_motion_result_t result = {0};
+    uint32_t mb_cnt = mb_width * mb_height;
+    uint32_t mv_num = 0;
+    uint8_t *zone_mask = NULL;
+    uint32_t actual_size = 0;
+    esp_h264_enc_mv_data_t *mv = esp_h264_calloc_prefer(mb_cnt, sizeof(esp_h264_enc_mv_data_t), &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    zone_mask = esp_h264_calloc_prefer(1, mb_cnt, &actual_size, ESP_H264_MEM_INTERNAL, ESP_H264_MEM_SPIRAM);
+    if (!mv || !zone_mask) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _motion_exit_;
+    }
+    ret = esp_h264_motion_new(&motion_cfg, &motion);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_motion_new failed. line %d \n", __LINE__);
+        goto _motion_exit_;
+    }
+    /** Zone 0 is the whole picture and zone 1 is the left half */
+    for (uint32_t i = 0; i < mb_cnt; i++) {
+        zone_mask[i] = ((i % mb_width) < (mb_width >> 1)) ? 0x03 : 0x01;
+    }
+    ret = esp_h264_motion_set_zone(motion, zone_mask, mb_cnt);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_motion_set_zone failed. line %d \n", __LINE__);
+        goto _motion_exit_;
+    }
+    /** A 4 x 4 macroblocks block moves in the top left corner, and one noisy macroblock in the bottom right corner */
+    for (uint8_t y = 0; y < 4; y++) {
+        for (uint8_t x = 0; x < 4; x++) {
+            mv[mv_num].mb_x = x;
+            mv[mv_num].mb_y = y;
+            mv[mv_num].mv_x = 4;
+            mv[mv_num].mv_y = -4;
+            mv_num++;
+        }
+    }
+    mv[mv_num].mb_x = mb_width - 1;
+    mv[mv_num].mb_y = mb_height - 1;
+    mv[mv_num].mv_x = 1;
+    mv_num++;
+    /** The heat needs 2 frames to be hot, then the motion starts in `on_frames` frames */
+    for (uint8_t i = 0; i < 1 + motion_cfg.on_frames; i++) {
+        ret = esp_h264_motion_process(motion, mv, mv_num, &result);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_motion_process failed. line %d \n", __LINE__);
+            goto _motion_exit_;
+        }
+        printf("frame %d score %d moving %d motion %d box %d\n", i, result.score, result.moving_mb, result.motion, result.box_num);
+    }
+    if (!result.motion || !result.changed || (result.zone_motion != 0x03) || (result.moving_mb != 16)
+            || (result.box_num != 1) || (result.box[0].x != 0) || (result.box[0].y != 0)
+            || (result.box[0].len_x != 4) || (result.box[0].len_y != 4) || (result.heatmap[0] == 0)) {
+        printf("The motion isn't detected. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _motion_exit_;
+    }
+    /** The heat is still hot in the first still frame, then the motion stops in `off_frames` frames */
+    for (uint8_t i = 0; i < 1 + motion_cfg.off_frames; i++) {
+        ret = esp_h264_motion_process(motion, NULL, 0, &result);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_motion_process failed. line %d \n", __LINE__);
+            goto _motion_exit_;
+        }
+    }
+    if (result.motion || !result.changed || result.zone_motion || result.box_num || result.score) {
+        printf("The motion doesn't stop. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_motion_exit_:
+    if (motion) {
+        ret |= esp_h264_motion_del(motion);
+    }
+    if (mv) {
+        esp_h264_free(mv);
+    }
+    if (zone_mask) {
+        esp_h264_free(zone_mask);
+    }
+    return ret;
+}
@@ -10,6 +10,7 @@
 #include "esp_h264_enc_single.h"
 #include "esp_h264_enc_dual_hw.h"
 #include "esp_h264_enc_dual.h"
+#include "esp_h264_enc_motion.h"
 
 /**
  * @brief Single hardware encoding. It is simple test case. And do the follow opertion.
@@ -188,4 +189,266 @@ esp_h264_err_t single_hw_enc_mv_pkt_test(esp_h264_enc_cfg_hw_t cfg);
  *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
  */
 esp_h264_err_t dual_hw_enc_mv_pkt_test(esp_h264_enc_cfg_dual_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for scene change detection test.
+ *        First call `esp_h264_enc_hw_cfg_scene_change` to enable scene change detection.
+ *        The input switches between two flat pictures every 10 frames. The cut frames must be IDR-frames,
+ *        and the other frames must be P-frames.
+ *        The same sequence is encoded without detection too. With detection, the largest P-frame and the QP swing of
+ *        consecutive P-frames mustn't be greater.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_scene_change_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for static scene frame skipping test.
+ *        First call `esp_h264_enc_hw_cfg_static_skip` to enable frame skipping.
+ *        The input is the same picture in one GOP. Every `max_skip` skipped frames must be followed by one encoded frame,
+ *        and the skipped frames must be the all P_Skip frames of the same size.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_static_skip_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for capped quality mode test.
+ *        The same picture is encoded in bitrate mode and in capped quality mode with the same QP range.
+ *        The capped quality mode mustn't output more bytes for the static scene.
+ *
+ * @param  cfg  THe configuration of single hardware encoder. Its `bitrate` should be much more than the static scene needs
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_capped_static_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for capped quality mode test.
+ *        Noise pictures are encoded with a ceiling far above the stream, then with the ceiling at half of that bitrate.
+ *        The bitrate of the last second must stay under 1.5 times of the ceiling, and every QP must be no less than `qp_min`.
+ *
+ * @param  cfg  THe configuration of single hardware encoder. Its `qp_min` should leave room to halve the bitrate
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_capped_quality_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for frame QP and delta QP map test.
+ *        Call `esp_h264_enc_hw_set_qp_map` before each frame. The map has two quarters with different delta QP.
+ *        The quarters must be compressed into the first two ROI regions.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_qp_map_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for motion vector(MV) driven ROI test.
+ *        First call `esp_h264_enc_hw_cfg_auto_roi` to enable it without MV packet.
+ *        The MV output must be enabled by encoder and the ROI must be in delta QP mode.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_auto_roi_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for motion vector(MV) buffer ring test.
+ *        The MV packet is acquired after each P-frame without `esp_h264_enc_hw_set_mv_pkt`. I-frame has no MV packet.
+ *        The ring can't be deleted until all MV packets are released.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_mv_ring_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for output buffer size estimate and spill buffer test.
+ *        The output buffer of every frame is sized by `esp_h264_enc_hw_get_out_buf_size`.
+ *        Then the output buffer is too small and the rest of encoded data is in the spill buffer.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_out_size_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for scatter-gather output test.
+ *        The output buffer only holds the start of frame and the rest is spread over the output segments.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_out_seg_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoding. This case is for working buffer pool test.
+ *        Two encoders of different resolutions share one pool and are opened in turn.
+ *        The configuration of every encoder is kept after the other one is used.
+ *
+ * @param  cfg  THe configuration of single hardware encoder. It is the pool resolution
+ *
+ * @return
+ *       - ESP_H264_ERR_OK           Succeeded
+ *       - ESP_H264_ERR_TIMEOUT      Timeout
+ *       - ESP_H264_ERR_ARG          Invalid arguments passed
+ *       - ESP_H264_ERR_MEM          Insufficient memory
+ *       - ESP_H264_ERR_FAIL         Failed
+ *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
+ */
+esp_h264_err_t single_hw_enc_pool_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoder memory test.
+ *        It benchmarks the encoder creation and checks the memory of every region reported by encoder.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_hw_enc_mem_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoder reconfiguration test.
+ *        The resolution, bitrate, QP range, FPS and GOP are changed without deleting the encoder.
+ *        The first frame after reconfiguration must be IDR-frame.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_hw_enc_reconfig_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoder statistics test.
+ *        The counters, QP histogram and frame records are checked with the encoded frames.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_hw_enc_stats_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoder trace test.
+ *        The trace events are exported as Chrome trace JSON after encoding. It passes if `CONFIG_ESP_H264_TRACE` is disabled.
+ *
+ * @param  cfg  THe configuration of single hardware encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_hw_enc_trace_test(esp_h264_enc_cfg_hw_t cfg);
+
+/**
+ * @brief Single hardware encoder cache synchronization test.
+ *        The same picture is encoded with and without the buffer ownership flags, and the latency saved per frame is printed.
+ *        The CRC of both bitstreams must be the same.
+ *
+ * @param  cfg        THe configuration of single hardware encoder
+ * @param  frame_num  The number of frames in each pass
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_hw_enc_cache_test(esp_h264_enc_cfg_hw_t cfg, uint16_t frame_num);
+
+/**
+ * @brief Motion detection test with synthetic motion vector(MV) data.
+ *        A moving block in zone 1 starts the motion after `on_frames` frames,
+ *        then the still frames stop the motion after the heat decays and `off_frames` frames.
+ *
+ * @param  mb_width   Width of picture in macroblock
+ * @param  mb_height  Height of picture in macroblock
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t hw_enc_motion_test(uint8_t mb_width, uint8_t mb_height);
 #endif //CONFIG_IDF_TARGET_ESP32P4
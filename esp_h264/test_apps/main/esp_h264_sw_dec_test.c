@@ -3,12 +3,16 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include <math.h>
+#include <stdlib.h>
 #include <string.h>
 #include "esp_h264_dec_param.h"
 #include "esp_h264_sw_dec_test.h"
+#include "esp_h264_alloc.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "h264_io.h"
 
 esp_h264_err_t single_sw_dec_process(esp_h264_dec_cfg_sw_t cfg, uint8_t *inbuf, uint32_t inbuf_len, uint8_t *yuv)
@@ -53,3 +57,1386 @@ _single_exit_:
     ret |= esp_h264_dec_del(dec);
     return ret;
 }
+
+/* Encode the test pictures into one Annex-B stream */
+static esp_h264_err_t sw_dec_test_encode(esp_h264_enc_cfg_sw_t enc_cfg, uint8_t **out_stream, uint32_t *out_len, uint16_t *out_frame_num)
+{
+    esp_h264_enc_in_frame_t enc_in = {0};
+    esp_h264_enc_out_frame_t enc_out = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_MEM;
+    esp_h264_enc_handle_t enc = NULL;
+    uint8_t *stream = NULL;
+    uint32_t stream_size = 0;
+    uint32_t stream_len = 0;
+    uint16_t frame_num = 0;
+
+    enc_in.raw_data.len = (enc_cfg.res.width * enc_cfg.res.height + (enc_cfg.res.width * enc_cfg.res.height >> 1));
+    enc_in.raw_data.buffer = esp_h264_aligned_calloc(16, 1, enc_in.raw_data.len, &enc_in.raw_data.len, MALLOC_CAP_INTERNAL);
+    if (!enc_in.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _encode_exit_;
+    }
+    stream = esp_h264_calloc_prefer(1, enc_in.raw_data.len * 2, &stream_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!stream) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _encode_exit_;
+    }
+    ret = esp_h264_enc_sw_new(&enc_cfg, &enc);
+    ret |= esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("encoder open failed. line %d \n", __LINE__);
+        goto _encode_exit_;
+    }
+    while (read_enc_cb_i420(&enc_in, enc_cfg.res.width, enc_cfg.res.height) > 0) {
+        enc_out.raw_data.buffer = stream + stream_len;
+        enc_out.raw_data.len = stream_size - stream_len;
+        ret = esp_h264_enc_process(enc, &enc_in, &enc_out);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("encoder process failed. line %d \n", __LINE__);
+            goto _encode_exit_;
+        }
+        stream_len += enc_out.length;
+        frame_num++;
+    }
+_encode_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (enc_in.raw_data.buffer) {
+        esp_h264_free(enc_in.raw_data.buffer);
+    }
+    if ((ret != ESP_H264_ERR_OK) && stream) {
+        esp_h264_free(stream);
+        stream = NULL;
+    }
+    *out_stream = stream;
+    *out_len = stream_len;
+    *out_frame_num = frame_num;
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_au_parser_test(esp_h264_enc_cfg_sw_t enc_cfg, uint32_t chunk_len)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_in_frame_t au_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_au_t au = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_au_parser_handle_t parser = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_au_parser_cfg_t parser_cfg = {0};
+    uint8_t *stream = NULL;
+    uint32_t stream_len = 0;
+    uint32_t au_pos = 0;
+    uint16_t frame_num = 0;
+    uint16_t au_num = 0;
+    uint16_t pic_num = 0;
+    bool flushed = false;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _au_exit_;
+    }
+
+    /** The stream is received in small chunks. Every access unit is one picture. */
+    parser_cfg.buf_size = stream_len;
+    ret = esp_h264_au_parser_new(&parser_cfg, &parser);
+    ret |= esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("parser or decoder open failed. line %d \n", __LINE__);
+        goto _au_exit_;
+    }
+    for (uint32_t pos = 0; pos <= stream_len; pos += chunk_len) {
+        in_frame.raw_data.buffer = stream + pos;
+        in_frame.raw_data.len = (stream_len - pos < chunk_len) ? stream_len - pos : chunk_len;
+        /** The time stamps of chunk are its offset in stream */
+        in_frame.dts = pos;
+        in_frame.pts = pos;
+        while (1) {
+            if (in_frame.raw_data.len) {
+                ret = esp_h264_au_parser_process(parser, &in_frame, &au);
+                in_frame.raw_data.buffer += in_frame.consume;
+                in_frame.raw_data.len -= in_frame.consume;
+            } else if ((pos + chunk_len > stream_len) && !flushed) {
+                /** The last access unit is output at the end of last chunk */
+                ret = esp_h264_au_parser_flush(parser, &au);
+                flushed = true;
+            } else {
+                break;
+            }
+            if (ret != ESP_H264_ERR_OK) {
+                printf("parser process failed. ret %d line %d \n", ret, __LINE__);
+                goto _au_exit_;
+            }
+            if (au.len == 0) {
+                continue;
+            }
+            if ((au.nal_num == 0) || ((au.nal_type[au.nal_num - 1] != 1) && (au.nal_type[au.nal_num - 1] != 5))) {
+                printf("The access unit has no slice. line %d \n", __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _au_exit_;
+            }
+            /** The access unit is stamped with the chunk that its first byte arrived in */
+            if ((au.dts != au_pos / chunk_len * chunk_len) || (au.pts != au.dts)) {
+                printf("The access unit at %d has DTS %d. line %d \n", (int)au_pos, (int)au.dts, __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _au_exit_;
+            }
+            au_pos += au.len;
+            au_num++;
+            au_frame.raw_data.buffer = au.buffer;
+            au_frame.raw_data.len = au.len;
+            while (au_frame.raw_data.len) {
+                ret = esp_h264_dec_process(dec, &au_frame, &out_frame);
+                if (ret != ESP_H264_ERR_OK) {
+                    printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+                    goto _au_exit_;
+                }
+                au_frame.raw_data.buffer += au_frame.consume;
+                au_frame.raw_data.len -= au_frame.consume;
+                pic_num += out_frame.out_size ? 1 : 0;
+            }
+        }
+    }
+    if ((au_num != frame_num) || (pic_num != frame_num)) {
+        printf("%d frames, %d access units and %d pictures. line %d \n", frame_num, au_num, pic_num, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_au_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    if (parser) {
+        esp_h264_au_parser_del(parser);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Write the NAL units of access unit with 4 bytes length prefix. The SPS and PPS are skipped if `skip_ps` is true. */
+static uint32_t sw_dec_test_to_avcc(esp_h264_au_t *au, bool skip_ps, uint8_t *out)
+{
+    uint32_t out_len = 0;
+    for (uint8_t i = 0; i < au->nal_num; i++) {
+        uint32_t start = au->nal_offset[i];
+        uint32_t end = (i + 1 < au->nal_num) ? au->nal_offset[i + 1] : au->len;
+        while (au->buffer[start] != 1) {
+            start++;
+        }
+        start++;
+        if (skip_ps && ((au->nal_type[i] == 7) || (au->nal_type[i] == 8))) {
+            continue;
+        }
+        uint32_t nal_len = end - start;
+        out[out_len++] = nal_len >> 24;
+        out[out_len++] = nal_len >> 16;
+        out[out_len++] = nal_len >> 8;
+        out[out_len++] = nal_len;
+        memcpy(out + out_len, au->buffer + start, nal_len);
+        out_len += nal_len;
+    }
+    return out_len;
+}
+
+/* Build avcC with the SPS and PPS of access unit */
+static uint32_t sw_dec_test_avcc_record(esp_h264_au_t *au, uint8_t *out)
+{
+    uint32_t out_len = 6;
+    uint8_t num_pos = 5;
+    for (uint8_t type = 7; type <= 8; type++) {
+        out[num_pos] = 0;
+        for (uint8_t i = 0; i < au->nal_num; i++) {
+            if (au->nal_type[i] != type) {
+                continue;
+            }
+            uint32_t start = au->nal_offset[i];
+            uint32_t end = (i + 1 < au->nal_num) ? au->nal_offset[i + 1] : au->len;
+            while (au->buffer[start] != 1) {
+                start++;
+            }
+            start++;
+            if (type == 7) {
+                /** Profile, compatibility and level are from SPS */
+                memcpy(out + 1, au->buffer + start + 1, 3);
+            }
+            out[out_len++] = (end - start) >> 8;
+            out[out_len++] = (end - start);
+            memcpy(out + out_len, au->buffer + start, end - start);
+            out_len += end - start;
+            out[num_pos]++;
+        }
+        num_pos = out_len++;
+    }
+    out_len--;
+    out[0] = 1;
+    out[4] = 0xFF;
+    out[5] |= 0xE0;
+    return out_len;
+}
+
+/* Encode `frame_num` pictures of pseudo random luma into one Annex-B stream.
+ * The CAVLC data of noise has long zero runs, which need emulation prevention bytes. */
+static esp_h264_err_t sw_dec_test_encode_noise(esp_h264_enc_cfg_sw_t enc_cfg, uint16_t frame_num, uint8_t **out_stream, uint32_t *out_len)
+{
+    esp_h264_enc_in_frame_t enc_in = {0};
+    esp_h264_enc_out_frame_t enc_out = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_MEM;
+    esp_h264_enc_handle_t enc = NULL;
+    uint8_t *stream = NULL;
+    uint32_t stream_size = 0;
+    uint32_t stream_len = 0;
+    uint32_t pixels = enc_cfg.res.width * enc_cfg.res.height;
+    uint32_t seed = 1;
+
+    enc_in.raw_data.len = pixels + (pixels >> 1);
+    enc_in.raw_data.buffer = esp_h264_aligned_calloc(16, 1, enc_in.raw_data.len, &enc_in.raw_data.len, MALLOC_CAP_INTERNAL);
+    if (!enc_in.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _noise_exit_;
+    }
+    stream = esp_h264_calloc_prefer(1, enc_in.raw_data.len * 2 * frame_num, &stream_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!stream) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _noise_exit_;
+    }
+    ret = esp_h264_enc_sw_new(&enc_cfg, &enc);
+    ret |= esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("encoder open failed. line %d \n", __LINE__);
+        goto _noise_exit_;
+    }
+    memset(enc_in.raw_data.buffer + pixels, 0x80, pixels >> 1);
+    for (uint16_t i = 0; i < frame_num; i++) {
+        for (uint32_t j = 0; j < pixels; j++) {
+            seed = seed * 1103515245 + 12345;
+            enc_in.raw_data.buffer[j] = seed >> 24;
+        }
+        enc_out.raw_data.buffer = stream + stream_len;
+        enc_out.raw_data.len = stream_size - stream_len;
+        ret = esp_h264_enc_process(enc, &enc_in, &enc_out);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("encoder process failed. line %d \n", __LINE__);
+            goto _noise_exit_;
+        }
+        stream_len += enc_out.length;
+    }
+_noise_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (enc_in.raw_data.buffer) {
+        esp_h264_free(enc_in.raw_data.buffer);
+    }
+    if ((ret != ESP_H264_ERR_OK) && stream) {
+        esp_h264_free(stream);
+        stream = NULL;
+    }
+    *out_stream = stream;
+    *out_len = stream_len;
+    return ret;
+}
+
+/* Decode one input in whole. `out_frame->out_size` is zero if no picture is output. */
+static esp_h264_err_t sw_dec_test_decode_all(esp_h264_dec_handle_t dec, uint8_t *data, uint32_t len, esp_h264_dec_out_frame_t *out_frame)
+{
+    esp_h264_dec_in_frame_t in_frame = {
+        .raw_data.buffer = data,
+        .raw_data.len = len,
+    };
+    esp_h264_dec_out_frame_t pic_frame = {0};
+    while (in_frame.raw_data.len) {
+        esp_h264_err_t ret = esp_h264_dec_process(dec, &in_frame, out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            return ret;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (out_frame->out_size) {
+            pic_frame = *out_frame;
+        }
+    }
+    *out_frame = pic_frame;
+    return ESP_H264_ERR_OK;
+}
+
+esp_h264_err_t single_sw_dec_avcc_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t ref_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_au_t au = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t ref_dec = NULL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_au_parser_handle_t parser = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_au_parser_cfg_t parser_cfg = {0};
+    uint8_t *stream = NULL;
+    uint8_t *sample = NULL;
+    uint8_t *ref = NULL;
+    uint32_t sample_size = 0;
+    uint32_t ref_size = 0;
+    uint32_t stream_len = 0;
+    uint32_t ref_len = (enc_cfg.res.width * enc_cfg.res.height) + (enc_cfg.res.width * enc_cfg.res.height >> 1);
+    uint16_t frame_num = 4;
+    uint16_t pic_num = 0;
+    uint16_t epb_num = 0;
+    uint8_t avcc[128] = {0};
+
+    ret = sw_dec_test_encode_noise(enc_cfg, frame_num, &stream, &stream_len);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _avcc_exit_;
+    }
+    /** The stream must have emulation prevention bytes, which are removed from AVCC NAL units without start code */
+    for (uint32_t i = 2; i < stream_len; i++) {
+        epb_num += (stream[i] == 0x03) && !stream[i - 1] && !stream[i - 2];
+    }
+    if (epb_num == 0) {
+        printf("No emulation prevention byte in %d bytes stream. line %d \n", (int)stream_len, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _avcc_exit_;
+    }
+    /** Every access unit gets at most one byte more for the length prefix of 3 bytes start code */
+    sample = esp_h264_calloc_prefer(1, stream_len * 2, &sample_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    ref = esp_h264_calloc_prefer(1, ref_len, &ref_size, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!sample || !ref) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _avcc_exit_;
+    }
+    parser_cfg.buf_size = stream_len;
+    ret = esp_h264_au_parser_new(&parser_cfg, &parser);
+    ret |= esp_h264_dec_sw_new(&cfg, &ref_dec);
+    ret |= esp_h264_dec_open(ref_dec);
+    ret |= esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("parser or decoder open failed. line %d \n", __LINE__);
+        goto _avcc_exit_;
+    }
+    /** The samples are rewritten from Annex-B stream like MP4 demuxer output.
+     *  Every picture of AVCC samples is the same as the one of Annex-B access unit. */
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    for (uint16_t i = 0; i < frame_num; i++) {
+        ret = esp_h264_au_parser_process(parser, &in_frame, &au);
+        if ((ret == ESP_H264_ERR_OK) && (au.len == 0)) {
+            ret = esp_h264_au_parser_flush(parser, &au);
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if ((ret != ESP_H264_ERR_OK) || (au.len == 0) || (au.len * 2 > sample_size)) {
+            printf("parser process failed. ret %d line %d \n", ret, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _avcc_exit_;
+        }
+        ret = sw_dec_test_decode_all(ref_dec, au.buffer, au.len, &ref_frame);
+        if ((ret != ESP_H264_ERR_OK) || (ref_frame.out_size != ref_len)) {
+            printf("Annex-B access unit %d isn't decoded. line %d \n", i, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _avcc_exit_;
+        }
+        memcpy(ref, ref_frame.outbuf, ref_len);
+        if (i == 0) {
+            ret = esp_h264_dec_sw_set_avcc(dec, avcc, sw_dec_test_avcc_record(&au, avcc));
+            if (ret != ESP_H264_ERR_OK) {
+                printf("esp_h264_dec_sw_set_avcc failed. line %d \n", __LINE__);
+                goto _avcc_exit_;
+            }
+        }
+        ret = sw_dec_test_decode_all(dec, sample, sw_dec_test_to_avcc(&au, i == 0, sample), &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            goto _avcc_exit_;
+        }
+        if ((out_frame.out_size != ref_len) || memcmp(out_frame.outbuf, ref, ref_len)) {
+            printf("The AVCC picture %d is different from Annex-B one. line %d \n", i, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _avcc_exit_;
+        }
+        pic_num++;
+    }
+    printf("%d pictures with %d emulation prevention bytes are the same \n", pic_num, epb_num);
+_avcc_exit_:
+    ret |= esp_h264_dec_close(ref_dec);
+    ret |= esp_h264_dec_del(ref_dec);
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    if (parser) {
+        esp_h264_au_parser_del(parser);
+    }
+    if (ref) {
+        esp_h264_free(ref);
+    }
+    if (sample) {
+        esp_h264_free(sample);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_frame_pool_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_pkt_t frames[2] = {0};
+    esp_h264_stats_t stats = {0};
+    uint8_t *held[2] = {NULL};
+    uint8_t held_num = 0;
+    uint8_t *stream = NULL;
+    uint32_t stream_len = 0;
+    uint16_t frame_num = 0;
+    uint16_t pic_num = 0;
+    uint16_t full_num = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _pool_exit_;
+    }
+    for (uint8_t i = 0; i < 2; i++) {
+        frames[i].len = enc_cfg.res.width * enc_cfg.res.height + (enc_cfg.res.width * enc_cfg.res.height >> 1);
+        frames[i].buffer = esp_h264_calloc_prefer(1, frames[i].len, &frames[i].len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+        if (!frames[i].buffer) {
+            printf("mem allocation failed.line %d \n", __LINE__);
+            ret = ESP_H264_ERR_MEM;
+            goto _pool_exit_;
+        }
+    }
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= esp_h264_dec_sw_set_frame_pool(dec, frames, 2);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("decoder open failed. line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    /** Every picture has two consumers, like display and analytics. The frames are released when the pool is full. */
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if ((ret == ESP_H264_ERR_BUSY) && (held_num == 2)) {
+            ret = esp_h264_dec_sw_frame_release(dec, held[0]);
+            ret |= esp_h264_dec_sw_frame_release(dec, held[0]);
+            held[0] = held[1];
+            held_num--;
+            full_num++;
+            if (ret != ESP_H264_ERR_OK) {
+                printf("esp_h264_dec_sw_frame_release failed. line %d \n", __LINE__);
+                goto _pool_exit_;
+            }
+            continue;
+        }
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            goto _pool_exit_;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (out_frame.out_size == 0) {
+            continue;
+        }
+        if ((out_frame.outbuf != frames[0].buffer) && (out_frame.outbuf != frames[1].buffer)) {
+            printf("The picture isn't in the frame pool. line %d \n", __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _pool_exit_;
+        }
+        ret = esp_h264_dec_sw_frame_ref(dec, out_frame.outbuf);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("esp_h264_dec_sw_frame_ref failed. line %d \n", __LINE__);
+            goto _pool_exit_;
+        }
+        held[held_num++] = out_frame.outbuf;
+        pic_num++;
+    }
+    /** The pool can't be changed with held frames */
+    if (held_num && (esp_h264_dec_sw_set_frame_pool(dec, NULL, 0) != ESP_H264_ERR_FAIL)) {
+        printf("esp_h264_dec_sw_set_frame_pool failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    while (held_num) {
+        held_num--;
+        ret |= esp_h264_dec_sw_frame_release(dec, held[held_num]);
+        ret |= esp_h264_dec_sw_frame_release(dec, held[held_num]);
+    }
+    ret |= esp_h264_dec_sw_set_frame_pool(dec, NULL, 0);
+    /** The full pool isn't one error */
+    ret |= esp_h264_dec_get_stats(dec, &stats);
+    if ((ret != ESP_H264_ERR_OK) || (pic_num != frame_num) || (full_num == 0) || (stats.frame_num != frame_num) || stats.err_num) {
+        printf("%d frames, %d pictures, %d errors and the pool is full %d times. line %d \n", frame_num, pic_num, (int)stats.err_num, full_num, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    /** The frame smaller than one picture is refused before the picture is consumed */
+    frames[0].len = enc_cfg.res.width * enc_cfg.res.height;
+    ret = esp_h264_dec_sw_set_frame_pool(dec, frames, 1);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_dec_sw_set_frame_pool failed. line %d \n", __LINE__);
+        goto _pool_exit_;
+    }
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            break;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+    }
+    if ((ret != ESP_H264_ERR_FAIL) || in_frame.consume || out_frame.out_size) {
+        printf("The small frame isn't refused. ret %d consume %d line %d \n", ret, (int)in_frame.consume, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _pool_exit_;
+    }
+    ret = esp_h264_dec_sw_set_frame_pool(dec, NULL, 0);
+_pool_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    for (uint8_t i = 0; i < 2; i++) {
+        if (frames[i].buffer) {
+            esp_h264_free(frames[i].buffer);
+        }
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Convert the I420 picture to the output format pixel by pixel. It is the reference of the conversion in decoder. */
+static void sw_dec_test_convert(esp_h264_raw_format_t fmt, uint16_t width, uint16_t height, uint8_t *in, uint8_t *out)
+{
+    uint8_t *u = in + width * height;
+    uint8_t *v = u + (width * height >> 2);
+    for (uint16_t y = 0; y < height; y++) {
+        for (uint16_t x = 0; x < width; x++) {
+            uint8_t luma = in[y * width + x];
+            uint32_t c = (y >> 1) * (width >> 1) + (x >> 1);
+            if (fmt == ESP_H264_RAW_FMT_NV12) {
+                out[y * width + x] = luma;
+                out[width * height + (y >> 1) * width + (x & ~1)] = u[c];
+                out[width * height + (y >> 1) * width + (x | 1)] = v[c];
+            } else if (fmt == ESP_H264_RAW_FMT_YUYV) {
+                out[(y * width + x) * 2] = luma;
+                out[(y * width + x) * 2 + 1] = (x & 1) ? v[c] : u[c];
+            } else {
+                /** Even line is `u y y`, odd line is `v y y` */
+                uint8_t *line = out + y * width * 3 / 2;
+                line[(x >> 1) * 3] = (y & 1) ? v[c] : u[c];
+                line[(x >> 1) * 3 + 1 + (x & 1)] = luma;
+            }
+        }
+    }
+}
+
+/* Convert the I420 picture to RGB in float. It is the reference of the fixed point conversion in decoder. */
+static void sw_dec_test_rgb(esp_h264_raw_format_t fmt, esp_h264_dec_color_space_t color_space, uint16_t width, uint16_t height, uint8_t *in, uint8_t *out)
+{
+    bool bt709 = (color_space == ESP_H264_DEC_COLOR_SPACE_BT709_LIMITED) || (color_space == ESP_H264_DEC_COLOR_SPACE_BT709_FULL);
+    bool full = (color_space == ESP_H264_DEC_COLOR_SPACE_BT601_FULL) || (color_space == ESP_H264_DEC_COLOR_SPACE_BT709_FULL);
+    float kr = bt709 ? 0.2126f : 0.299f;
+    float kb = bt709 ? 0.0722f : 0.114f;
+    float kg = 1.0f - kr - kb;
+    float ys = full ? 1.0f : 255.0f / 219.0f;
+    float cs = full ? 1.0f : 255.0f / 224.0f;
+    uint8_t *u = in + width * height;
+    uint8_t *v = u + (width * height >> 2);
+    for (uint32_t i = 0; i < width * height; i++) {
+        uint32_t c = (i / width >> 1) * (width >> 1) + (i % width >> 1);
+        float l = ys * (in[i] - (full ? 0 : 16));
+        float cu = cs * (u[c] - 128);
+        float cv = cs * (v[c] - 128);
+        float rgb[3] = {
+            l + 2 * (1 - kr) * cv,
+            l - 2 * (1 - kb) * kb / kg * cu - 2 * (1 - kr) * kr / kg * cv,
+            l + 2 * (1 - kb) * cu,
+        };
+        for (uint8_t k = 0; k < 3; k++) {
+            rgb[k] = rgb[k] < 0 ? 0 : (rgb[k] > 255 ? 255 : rgb[k]);
+        }
+        if (fmt == ESP_H264_RAW_FMT_RGB888) {
+            for (uint8_t k = 0; k < 3; k++) {
+                out[i * 3 + k] = (uint8_t)rgb[k];
+            }
+        } else {
+            uint16_t pixel = (((uint8_t)rgb[0] & 0xF8) << 8) | (((uint8_t)rgb[1] & 0xFC) << 3) | ((uint8_t)rgb[2] >> 3);
+            out[i * 2] = (fmt == ESP_H264_RAW_FMT_RGB565_LE) ? pixel & 0xFF : pixel >> 8;
+            out[i * 2 + 1] = (fmt == ESP_H264_RAW_FMT_RGB565_LE) ? pixel >> 8 : pixel & 0xFF;
+        }
+    }
+}
+
+/* Compare with reference. The RGB of fixed point may differ from float by one step. */
+static bool sw_dec_test_same(esp_h264_raw_format_t fmt, uint8_t *ref, uint8_t *out, uint32_t len)
+{
+    if (fmt == ESP_H264_RAW_FMT_RGB888) {
+        for (uint32_t i = 0; i < len; i++) {
+            if (abs(ref[i] - out[i]) > 1) {
+                return false;
+            }
+        }
+        return true;
+    }
+    if ((fmt == ESP_H264_RAW_FMT_RGB565_LE) || (fmt == ESP_H264_RAW_FMT_RGB565_BE)) {
+        uint8_t lo = (fmt == ESP_H264_RAW_FMT_RGB565_LE) ? 0 : 1;
+        for (uint32_t i = 0; i < len; i += 2) {
+            uint16_t a = ref[i + lo] | (ref[i + 1 - lo] << 8);
+            uint16_t b = out[i + lo] | (out[i + 1 - lo] << 8);
+            if ((abs((a >> 11) - (b >> 11)) > 1) || (abs(((a >> 5) & 0x3F) - ((b >> 5) & 0x3F)) > 1) || (abs((a & 0x1F) - (b & 0x1F)) > 1)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    return memcmp(ref, out, len) == 0;
+}
+
+esp_h264_err_t single_sw_dec_fmt_test(esp_h264_enc_cfg_sw_t enc_cfg, esp_h264_raw_format_t fmt, esp_h264_dec_color_space_t color_space)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_in_frame_t fmt_in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_dec_out_frame_t fmt_out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_handle_t fmt_dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_dec_cfg_sw_t fmt_cfg = {.pic_type = fmt};
+    esp_h264_stats_t stats = {0};
+    esp_h264_stats_t fmt_stats = {0};
+    uint8_t *stream = NULL;
+    uint8_t *ref = NULL;
+    uint32_t stream_len = 0;
+    uint32_t ref_len = 0;
+    uint32_t convert_us = 0;
+    uint16_t frame_num = 0;
+    uint16_t pic_num = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _fmt_exit_;
+    }
+    ref_len = enc_cfg.res.width * enc_cfg.res.height * 3;
+    ref = esp_h264_calloc_prefer(1, ref_len, &ref_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!ref) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _fmt_exit_;
+    }
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= esp_h264_dec_sw_new(&fmt_cfg, &fmt_dec);
+    ret |= esp_h264_dec_open(fmt_dec);
+    ret |= esp_h264_dec_sw_set_color_space(fmt_dec, color_space);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("decoder open failed. line %d \n", __LINE__);
+        goto _fmt_exit_;
+    }
+    /** Both decoders get the same data. The I420 picture is converted by reference after decoding. */
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        fmt_in_frame = in_frame;
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        ret |= esp_h264_dec_process(fmt_dec, &fmt_in_frame, &fmt_out_frame);
+        if ((ret != ESP_H264_ERR_OK) || (in_frame.consume != fmt_in_frame.consume)) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _fmt_exit_;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (out_frame.out_size == 0) {
+            continue;
+        }
+        int64_t start = esp_timer_get_time();
+        if ((fmt == ESP_H264_RAW_FMT_RGB565_LE) || (fmt == ESP_H264_RAW_FMT_RGB565_BE) || (fmt == ESP_H264_RAW_FMT_RGB888)) {
+            sw_dec_test_rgb(fmt, color_space, enc_cfg.res.width, enc_cfg.res.height, out_frame.outbuf, ref);
+            ref_len = enc_cfg.res.width * enc_cfg.res.height * ((fmt == ESP_H264_RAW_FMT_RGB888) ? 3 : 2);
+        } else {
+            sw_dec_test_convert(fmt, enc_cfg.res.width, enc_cfg.res.height, out_frame.outbuf, ref);
+            ref_len = (fmt == ESP_H264_RAW_FMT_YUYV) ? enc_cfg.res.width * enc_cfg.res.height * 2 : out_frame.out_size;
+        }
+        convert_us += esp_timer_get_time() - start;
+        if ((fmt_out_frame.out_size != ref_len) || !sw_dec_test_same(fmt, ref, fmt_out_frame.outbuf, ref_len)) {
+            printf("The picture %d in format %d is different. line %d \n", pic_num, fmt, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _fmt_exit_;
+        }
+        pic_num++;
+    }
+    ret = esp_h264_dec_get_stats(dec, &stats);
+    ret |= esp_h264_dec_get_stats(fmt_dec, &fmt_stats);
+    if ((ret != ESP_H264_ERR_OK) || (pic_num != frame_num)) {
+        printf("%d frames and %d pictures. line %d \n", frame_num, pic_num, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _fmt_exit_;
+    }
+    printf("Format %d: decode and convert %d us, decode in format %d us per frame \n", fmt,
+           (int)(stats.latency_avg_us + convert_us / pic_num), (int)fmt_stats.latency_avg_us);
+_fmt_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    ret |= esp_h264_dec_close(fmt_dec);
+    ret |= esp_h264_dec_del(fmt_dec);
+    if (ref) {
+        esp_h264_free(ref);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Downscale one plane by averaging every `n` x `n` block. It is the reference of the downscale in decoder. */
+static void sw_dec_test_downscale(uint16_t width, uint16_t height, uint8_t n, uint8_t *in, uint8_t *out)
+{
+    for (uint16_t y = 0; y < height / n; y++) {
+        for (uint16_t x = 0; x < width / n; x++) {
+            uint32_t sum = 0;
+            for (uint8_t i = 0; i < n * n; i++) {
+                sum += in[(y * n + i / n) * width + x * n + i % n];
+            }
+            *(out++) = (sum + n * n / 2) / (n * n);
+        }
+    }
+}
+
+esp_h264_err_t single_sw_dec_scale_test(esp_h264_enc_cfg_sw_t enc_cfg, esp_h264_dec_scale_t scale)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_in_frame_t scale_in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_dec_out_frame_t scale_out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_handle_t scale_dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    uint16_t width = enc_cfg.res.width;
+    uint16_t height = enc_cfg.res.height;
+    uint8_t n = 1 << scale;
+    uint8_t *stream = NULL;
+    uint8_t *ref = NULL;
+    uint32_t stream_len = 0;
+    uint32_t ref_len = (width / n) * (height / n) * 3 / 2;
+    uint16_t frame_num = 0;
+    uint16_t pic_num = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _scale_exit_;
+    }
+    ref = esp_h264_calloc_prefer(1, ref_len, &ref_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!ref) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _scale_exit_;
+    }
+    ref_len = (width / n) * (height / n) * 3 / 2;
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= esp_h264_dec_sw_new(&cfg, &scale_dec);
+    ret |= esp_h264_dec_open(scale_dec);
+    ret |= esp_h264_dec_sw_set_scale(scale_dec, scale);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("decoder open failed. line %d \n", __LINE__);
+        goto _scale_exit_;
+    }
+    /** Both decoders get the same data. The full picture is downscaled by reference after decoding. */
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        scale_in_frame = in_frame;
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        ret |= esp_h264_dec_process(scale_dec, &scale_in_frame, &scale_out_frame);
+        if ((ret != ESP_H264_ERR_OK) || (in_frame.consume != scale_in_frame.consume)) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _scale_exit_;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (out_frame.out_size == 0) {
+            continue;
+        }
+        uint8_t *u = out_frame.outbuf + width * height;
+        uint8_t *ref_u = ref + (width / n) * (height / n);
+        sw_dec_test_downscale(width, height, n, out_frame.outbuf, ref);
+        sw_dec_test_downscale(width / 2, height / 2, n, u, ref_u);
+        sw_dec_test_downscale(width / 2, height / 2, n, u + width * height / 4, ref_u + (width / n) * (height / n) / 4);
+        if ((scale_out_frame.out_size != ref_len) || memcmp(ref, scale_out_frame.outbuf, ref_len)) {
+            printf("The picture %d downscaled by %d is different. line %d \n", pic_num, n, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _scale_exit_;
+        }
+        pic_num++;
+    }
+    if (pic_num != frame_num) {
+        printf("%d frames and %d pictures. line %d \n", frame_num, pic_num, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _scale_exit_;
+    }
+    printf("Downscale 1/%d: picture %d bytes, downscaled %d bytes \n", n, (int)out_frame.out_size, (int)ref_len);
+_scale_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    ret |= esp_h264_dec_close(scale_dec);
+    ret |= esp_h264_dec_del(scale_dec);
+    if (ref) {
+        esp_h264_free(ref);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_probe_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    /** High profile 1920x1080 with crop, VUI video signal, timing, bitstream restriction and emulation prevention bytes */
+    static const uint8_t hd_stream[] = {
+        0x00, 0x00, 0x00, 0x01, 0x67, 0x64, 0x00, 0x28, 0xAC, 0xCA, 0x50, 0x1E, 0x00, 0x89, 0xF9, 0x66, 0xA0, 0x20, 0x20, 0x28,
+        0x00, 0x00, 0x03, 0x00, 0x08, 0x00, 0x00, 0x03, 0x01, 0xE4, 0x78, 0x44, 0x22, 0xCB, 0x00, 0x00, 0x00, 0x01, 0x68, 0xF0,
+    };
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_dec_param_sw_handle_t param_hd = NULL;
+    esp_h264_stream_info_t info = {0};
+    esp_h264_resolution_t res = {0};
+    uint8_t *stream = NULL;
+    uint32_t stream_len = 0;
+    uint16_t frame_num = 0;
+
+    ret = esp_h264_probe(hd_stream, sizeof(hd_stream), &info);
+    if ((ret != ESP_H264_ERR_OK) || (info.profile_idc != 100) || (info.level_idc != 40) || (info.res.width != 1920)
+            || (info.res.height != 1080) || (info.coded_res.height != 1088) || (info.crop_bottom != 8)
+            || !info.timing_info_present || (info.num_units_in_tick != 1) || (info.time_scale != 60) || !info.fixed_frame_rate
+            || (info.matrix_coefficients != 1) || (info.max_dec_frame_buffering != 4) || !info.pps_present || !info.cabac
+            || (info.log2_max_frame_num != 4) || (info.max_num_ref_frames != 4) || info.frame_num_gaps_allowed) {
+        printf("The probe of high profile stream failed. ret %d line %d \n", ret, __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _probe_exit_;
+    }
+    int64_t start = esp_timer_get_time();
+    ret = esp_h264_probe(stream, stream_len, &info);
+    int64_t probe_us = esp_timer_get_time() - start;
+    if ((ret != ESP_H264_ERR_OK) || (info.profile_idc != 66) || info.cabac || !info.pps_present
+            || (info.res.width != enc_cfg.res.width) || (info.res.height != enc_cfg.res.height)) {
+        printf("The probe of software encoded stream failed. ret %d line %d \n", ret, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _probe_exit_;
+    }
+    /** The probed resolution is the same as the one after decoding */
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= esp_h264_dec_sw_get_param_hd(dec, &param_hd);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("decoder open failed. line %d \n", __LINE__);
+        goto _probe_exit_;
+    }
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len && (out_frame.out_size == 0)) {
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            goto _probe_exit_;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+    }
+    ret = esp_h264_dec_get_resolution(param_hd, &res);
+    if ((ret != ESP_H264_ERR_OK) || (res.width != info.res.width) || (res.height != info.res.height)) {
+        printf("Probed %dx%d, decoded %dx%d. line %d \n", info.res.width, info.res.height, res.width, res.height, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _probe_exit_;
+    }
+    printf("Probe %dx%d profile %d level %d in %d us \n", info.res.width, info.res.height, info.profile_idc, info.level_idc, (int)probe_us);
+_probe_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Decode from `pos` of stream to the end. The decoder seeks after `seek_pic` pictures if it isn't 0. */
+static esp_h264_err_t sw_dec_test_skip_decode(esp_h264_dec_handle_t dec, uint8_t *stream, uint32_t stream_len, uint16_t seek_pic,
+                                              uint16_t *out_pic_num, int64_t *out_us)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    int64_t start = esp_timer_get_time();
+    *out_pic_num = 0;
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            return ret;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (out_frame.out_size == 0) {
+            continue;
+        }
+        (*out_pic_num)++;
+        if (*out_pic_num == seek_pic) {
+            ret = esp_h264_dec_sw_seek(dec);
+        }
+    }
+    *out_us = esp_timer_get_time() - start;
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_skip_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    uint8_t *stream = NULL;
+    uint32_t stream_len = 0;
+    uint16_t frame_num = 0;
+    uint16_t idr_num = 0;
+    uint16_t pic_num = 0;
+    int64_t full_us = 0;
+    int64_t skip_us = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _skip_exit_;
+    }
+    /** The first slice of IDR picture has `first_mb_in_slice` 0 */
+    for (uint32_t i = 0; i + 4 < stream_len; i++) {
+        if (!stream[i] && !stream[i + 1] && (stream[i + 2] == 1) && ((stream[i + 3] & 0x1F) == 5) && (stream[i + 4] & 0x80)) {
+            idr_num++;
+        }
+    }
+    /** Decode all, then IDR pictures only and the referenced pictures only */
+    esp_h264_dec_skip_t skips[] = { ESP_H264_DEC_SKIP_NONE, ESP_H264_DEC_SKIP_NON_INTRA, ESP_H264_DEC_SKIP_NON_REF };
+    uint16_t expects[] = { frame_num, idr_num, frame_num };
+    for (uint8_t i = 0; i < sizeof(skips) / sizeof(skips[0]); i++) {
+        ret = esp_h264_dec_sw_new(&cfg, &dec);
+        ret |= esp_h264_dec_open(dec);
+        ret |= esp_h264_dec_sw_set_skip(dec, skips[i]);
+        ret |= sw_dec_test_skip_decode(dec, stream, stream_len, 0, &pic_num, (i == 0) ? &full_us : &skip_us);
+        ret |= esp_h264_dec_close(dec);
+        ret |= esp_h264_dec_del(dec);
+        dec = NULL;
+        if ((ret != ESP_H264_ERR_OK) || (pic_num != expects[i])) {
+            printf("Skip mode %d: %d pictures, expect %d. line %d \n", skips[i], pic_num, expects[i], __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _skip_exit_;
+        }
+        if (skips[i] == ESP_H264_DEC_SKIP_NON_INTRA) {
+            printf("%d frames in %d us, %d IDR frames only in %d us \n", frame_num, (int)full_us, idr_num, (int)skip_us);
+        }
+    }
+    /** Seek after the first picture. The decoding resumes from the next IDR picture. */
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= sw_dec_test_skip_decode(dec, stream, stream_len, 1, &pic_num, &skip_us);
+    if ((ret != ESP_H264_ERR_OK) || (enc_cfg.gop >= frame_num) || (pic_num != 1 + frame_num - enc_cfg.gop)) {
+        printf("Seek: %d pictures, expect %d. line %d \n", pic_num, 1 + frame_num - enc_cfg.gop, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_skip_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Decode the stream. The luma of pictures is saved in `y_buf` if it isn't NULL, or compared with it in PSNR.
+ * The encoder makes one slice per picture, and `slice_pic` is the source picture of every slice in stream. NULL means in order.
+ * The picture is output with its slice, or before the next slice that isn't consumed. */
+static esp_h264_err_t sw_dec_test_conceal_decode(uint8_t *stream, uint32_t stream_len, uint16_t width, uint16_t height, uint16_t pic_max,
+                                                 const uint16_t *slice_pic, uint8_t *y_buf, bool save, uint16_t *out_pic_num,
+                                                 int32_t *out_last_pic, uint32_t *out_damaged_mb, double *out_psnr)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    double psnr_sum = 0;
+    uint16_t slice_num = 0;
+    int32_t pic = -1;
+    *out_pic_num = 0;
+    *out_last_pic = -1;
+    *out_damaged_mb = 0;
+
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    ret |= esp_h264_dec_sw_set_conceal(dec, true);
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while ((ret == ESP_H264_ERR_OK) && in_frame.raw_data.len) {
+        uint8_t *nal = in_frame.raw_data.buffer;
+        uint32_t pos = 0;
+        while ((pos < in_frame.raw_data.len) && !nal[pos]) {
+            pos++;
+        }
+        bool slice = (pos >= 2) && (pos + 1 < in_frame.raw_data.len) && (nal[pos] == 1)
+                     && (((nal[pos + 1] & 0x1F) == 1) || ((nal[pos + 1] & 0x1F) == 5));
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            break;
+        }
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+        if (slice && in_frame.consume) {
+            pic = (slice_pic && (slice_num < pic_max)) ? slice_pic[slice_num] : slice_num;
+            slice_num++;
+        }
+        if ((out_frame.out_size == 0) || (pic < 0) || (pic >= pic_max)) {
+            continue;
+        }
+        uint8_t *y = y_buf + pic * width * height;
+        if (save) {
+            memcpy(y, out_frame.outbuf, width * height);
+        } else {
+            uint64_t sse = 0;
+            for (uint32_t i = 0; i < width * height; i++) {
+                int32_t diff = y[i] - out_frame.outbuf[i];
+                sse += diff * diff;
+            }
+            /** The same picture is 99 dB */
+            psnr_sum += sse ? 10 * log10(255.0 * 255.0 * width * height / sse) : 99;
+        }
+        *out_damaged_mb += out_frame.damaged_mb;
+        *out_last_pic = pic;
+        (*out_pic_num)++;
+    }
+    *out_psnr = *out_pic_num ? psnr_sum / *out_pic_num : 0;
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_conceal_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    uint16_t width = enc_cfg.res.width;
+    uint16_t height = enc_cfg.res.height;
+    uint8_t *stream = NULL;
+    uint8_t *lossy = NULL;
+    uint8_t *y_buf = NULL;
+    uint16_t *slice_pic = NULL;
+    uint32_t stream_len = 0;
+    uint32_t buf_len = 0;
+    uint32_t damaged_mb = 0;
+    uint16_t frame_num = 0;
+    uint16_t pic_num = 0;
+    int32_t last_pic = -1;
+    uint32_t seed = 1;
+    double psnr = 0;
+    uint8_t loss_rates[] = { 0, 10, 30, 50 };
+    const char *modes[] = { "half", "whole" };
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _conceal_exit_;
+    }
+    lossy = esp_h264_calloc_prefer(1, stream_len, &buf_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    y_buf = esp_h264_calloc_prefer(1, frame_num * width * height, &buf_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    slice_pic = esp_h264_calloc_prefer(frame_num, sizeof(uint16_t), &buf_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!lossy || !y_buf || !slice_pic) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _conceal_exit_;
+    }
+    ret = sw_dec_test_conceal_decode(stream, stream_len, width, height, frame_num, NULL, y_buf, true, &pic_num, &last_pic, &damaged_mb, &psnr);
+    if ((ret != ESP_H264_ERR_OK) || (pic_num != frame_num) || damaged_mb) {
+        printf("%d frames, %d pictures and %d damaged macroblocks. line %d \n", frame_num, pic_num, (int)damaged_mb, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _conceal_exit_;
+    }
+    /** The packet loss drops the second half of P slices, or the whole P slices. The zero bytes end the half slice there. */
+    for (uint8_t m = 0; m < sizeof(modes) / sizeof(modes[0]); m++) {
+        for (uint8_t r = 0; r < sizeof(loss_rates) / sizeof(loss_rates[0]); r++) {
+            uint16_t slice_num = 0;
+            uint16_t kept_num = 0;
+            uint16_t lost_num = 0;
+            int32_t first_lost = -1;
+            uint32_t i = 0;
+            while ((i + 3 <= stream_len) && (stream[i] || stream[i + 1] || (stream[i + 2] != 1))) {
+                i++;
+            }
+            uint32_t lossy_len = i;
+            memcpy(lossy, stream, lossy_len);
+            while (i < stream_len) {
+                uint32_t end = i + 3;
+                while ((end + 3 <= stream_len) && (stream[end] || stream[end + 1] || (stream[end + 2] != 1))) {
+                    end++;
+                }
+                end = (end + 3 <= stream_len) ? end : stream_len;
+                uint8_t type = (i + 3 < stream_len) ? (stream[i + 3] & 0x1F) : 0;
+                bool lost = false;
+                if (type == 1) {
+                    seed = seed * 1103515245 + 12345;
+                    lost = ((seed >> 16) % 100 < loss_rates[r]);
+                }
+                if (lost) {
+                    lost_num++;
+                    first_lost = (first_lost < 0) ? slice_num : first_lost;
+                }
+                if (!lost || !m) {
+                    memcpy(lossy + lossy_len, stream + i, end - i);
+                    if (lost) {
+                        uint32_t half = 3 + (end - i - 3) / 2;
+                        memset(lossy + lossy_len + half, 0, end - i - half);
+                    }
+                    lossy_len += end - i;
+                }
+                if ((type == 1) || (type == 5)) {
+                    if ((!lost || !m) && (kept_num < frame_num)) {
+                        slice_pic[kept_num++] = slice_num;
+                    }
+                    slice_num++;
+                }
+                i = end;
+            }
+            ret = sw_dec_test_conceal_decode(lossy, lossy_len, width, height, frame_num, slice_pic, y_buf, false, &pic_num,
+                                             &last_pic, &damaged_mb, &psnr);
+            /** The damage is reported once any picture after the loss is output, and the concealed pictures are close to source */
+            if ((ret != ESP_H264_ERR_OK) || (pic_num == 0) || (!loss_rates[r] && ((pic_num != frame_num) || damaged_mb || (psnr < 99)))
+                    || (lost_num && (last_pic >= first_lost) && !damaged_mb) || (psnr < 10)) {
+                printf("Drop %s slice in %d%%: %d pictures, %d damaged macroblocks and PSNR %.2f dB. line %d \n", modes[m],
+                       loss_rates[r], pic_num, (int)damaged_mb, psnr, __LINE__);
+                ret = ESP_H264_ERR_FAIL;
+                goto _conceal_exit_;
+            }
+            printf("Drop %s slice in %d%%: %d slices lost, %d/%d pictures, %d damaged macroblocks, PSNR %.2f dB \n", modes[m],
+                   loss_rates[r], lost_num, pic_num, frame_num, (int)damaged_mb, psnr);
+        }
+    }
+_conceal_exit_:
+    if (slice_pic) {
+        esp_h264_free(slice_pic);
+    }
+    if (y_buf) {
+        esp_h264_free(y_buf);
+    }
+    if (lossy) {
+        esp_h264_free(lossy);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+/* Decode the stream by the decoders in turn. The pictures are saved in `ref` if `save` is true, or compared with it. */
+static esp_h264_err_t sw_dec_test_task_decode(esp_h264_dec_handle_t *dec, uint8_t dec_num, uint8_t *stream, uint32_t stream_len,
+                                              uint32_t pic_size, uint16_t pic_max, uint8_t *ref, bool save, uint16_t *out_pic_num)
+{
+    esp_h264_dec_in_frame_t in_frame[2] = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_OK;
+    uint16_t pic_num[2] = {0};
+    uint32_t left = 0;
+    for (uint8_t d = 0; d < dec_num; d++) {
+        in_frame[d].raw_data.buffer = stream;
+        in_frame[d].raw_data.len = stream_len;
+        left += stream_len;
+    }
+    while (left) {
+        for (uint8_t d = 0; d < dec_num; d++) {
+            if (in_frame[d].raw_data.len == 0) {
+                continue;
+            }
+            ret = esp_h264_dec_process(dec[d], &in_frame[d], &out_frame);
+            if (ret != ESP_H264_ERR_OK) {
+                printf("decoder %d process failed. ret %d line %d \n", d, ret, __LINE__);
+                return ret;
+            }
+            in_frame[d].raw_data.buffer += in_frame[d].consume;
+            in_frame[d].raw_data.len -= in_frame[d].consume;
+            left -= in_frame[d].consume;
+            if (out_frame.out_size == 0) {
+                continue;
+            }
+            if ((pic_num[d] >= pic_max) || (out_frame.out_size != pic_size)) {
+                printf("decoder %d picture %d size %d. line %d \n", d, pic_num[d], (int)out_frame.out_size, __LINE__);
+                return ESP_H264_ERR_FAIL;
+            }
+            uint8_t *pic = ref + pic_num[d] * pic_size;
+            if (save) {
+                memcpy(pic, out_frame.outbuf, pic_size);
+            } else if (memcmp(pic, out_frame.outbuf, pic_size)) {
+                printf("decoder %d picture %d is different. line %d \n", d, pic_num[d], __LINE__);
+                return ESP_H264_ERR_FAIL;
+            }
+            pic_num[d]++;
+        }
+    }
+    *out_pic_num = pic_num[0];
+    for (uint8_t d = 1; d < dec_num; d++) {
+        *out_pic_num = (pic_num[d] < *out_pic_num) ? pic_num[d] : *out_pic_num;
+    }
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_task_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec[2] = {NULL};
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_dec_task_cfg_t task_cfgs[] = {
+        {.mode = ESP_H264_DEC_TASK_SINGLE},
+        {.mode = ESP_H264_DEC_TASK_DUAL, .core = 1},
+        {.mode = ESP_H264_DEC_TASK_DUAL, .core = 0, .priority = 10},
+    };
+    uint32_t pic_size = enc_cfg.res.width * enc_cfg.res.height + (enc_cfg.res.width * enc_cfg.res.height >> 1);
+    uint8_t *stream = NULL;
+    uint8_t *ref = NULL;
+    uint32_t stream_len = 0;
+    uint32_t buf_len = 0;
+    uint16_t frame_num = 0;
+    uint16_t pic_num = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _task_exit_;
+    }
+    ref = esp_h264_calloc_prefer(1, frame_num * pic_size, &buf_len, ESP_H264_MEM_SPIRAM, ESP_H264_MEM_INTERNAL);
+    if (!ref) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _task_exit_;
+    }
+    /** The pictures are the same in every task mode. The first mode saves the reference pictures. */
+    for (uint8_t i = 0; i < sizeof(task_cfgs) / sizeof(task_cfgs[0]); i++) {
+        ret = esp_h264_dec_sw_new_with_task(&cfg, &task_cfgs[i], &dec[0]);
+        ret |= esp_h264_dec_open(dec[0]);
+        int64_t start = esp_timer_get_time();
+        ret |= sw_dec_test_task_decode(dec, 1, stream, stream_len, pic_size, frame_num, ref, (i == 0), &pic_num);
+        int64_t us = esp_timer_get_time() - start;
+        ret |= esp_h264_dec_close(dec[0]);
+        ret |= esp_h264_dec_del(dec[0]);
+        dec[0] = NULL;
+        if ((ret != ESP_H264_ERR_OK) || (pic_num != frame_num)) {
+            printf("Task mode %d: %d pictures, expect %d. line %d \n", task_cfgs[i].mode, pic_num, frame_num, __LINE__);
+            ret = ESP_H264_ERR_FAIL;
+            goto _task_exit_;
+        }
+        printf("Task mode %d core %d: %d frames in %d us \n", task_cfgs[i].mode, task_cfgs[i].core, frame_num, (int)us);
+    }
+    /** The main stream decoder in dual task and the substream decoder in single task work at the same time */
+    ret = esp_h264_dec_sw_new_with_task(&cfg, &task_cfgs[1], &dec[0]);
+    ret |= esp_h264_dec_open(dec[0]);
+    ret |= esp_h264_dec_sw_new_with_task(&cfg, &task_cfgs[0], &dec[1]);
+    ret |= esp_h264_dec_open(dec[1]);
+    ret |= sw_dec_test_task_decode(dec, 2, stream, stream_len, pic_size, frame_num, ref, false, &pic_num);
+    if ((ret != ESP_H264_ERR_OK) || (pic_num != frame_num)) {
+        printf("Dual and single task decoders: %d pictures, expect %d. line %d \n", pic_num, frame_num, __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_task_exit_:
+    for (uint8_t d = 0; d < 2; d++) {
+        if (dec[d]) {
+            ret |= esp_h264_dec_close(dec[d]);
+            ret |= esp_h264_dec_del(dec[d]);
+        }
+    }
+    if (ref) {
+        esp_h264_free(ref);
+    }
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_sw_dec_stats_test(esp_h264_enc_cfg_sw_t enc_cfg)
+{
+    esp_h264_dec_in_frame_t in_frame = {0};
+    esp_h264_dec_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_dec_handle_t dec = NULL;
+    esp_h264_dec_cfg_sw_t cfg = {.pic_type = ESP_H264_RAW_FMT_I420};
+    esp_h264_stats_t stats = {0};
+    uint8_t *stream = NULL;
+    uint32_t stream_len = 0;
+    uint32_t consumed_len = 0;
+    uint16_t frame_num = 0;
+    uint16_t pic_cnt = 0;
+
+    ret = sw_dec_test_encode(enc_cfg, &stream, &stream_len, &frame_num);
+    if (ret != ESP_H264_ERR_OK) {
+        goto _stats_exit_;
+    }
+    ret = esp_h264_dec_sw_new(&cfg, &dec);
+    ret |= esp_h264_dec_open(dec);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("decoder open failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    in_frame.raw_data.buffer = stream;
+    in_frame.raw_data.len = stream_len;
+    while (in_frame.raw_data.len) {
+        ret = esp_h264_dec_process(dec, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("decoder process failed. ret %d line %d \n", ret, __LINE__);
+            goto _stats_exit_;
+        }
+        pic_cnt += (out_frame.out_size != 0);
+        in_frame.raw_data.buffer += in_frame.consume;
+        in_frame.raw_data.len -= in_frame.consume;
+    }
+    ret = esp_h264_dec_get_stats(dec, &stats);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_dec_get_stats failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    for (uint8_t i = 0; i < stats.frame_stats_num; i++) {
+        consumed_len += stats.frame_stats[i].len;
+    }
+    printf("Pictures %d latency avg %d max %d us bitrate %d \n", (int)stats.frame_num, (int)stats.latency_avg_us,
+           (int)stats.latency_max_us, (int)stats.bitrate);
+    /** Every picture is one record, and the parameter sets are counted into the first picture */
+    if ((pic_cnt != frame_num)
+            || (stats.frame_num != pic_cnt)
+            || (stats.err_num + stats.timeout_num + stats.overflow_num)
+            || (stats.frame_stats_num != (pic_cnt < ESP_H264_STATS_FRAME_NUM ? pic_cnt : ESP_H264_STATS_FRAME_NUM))
+            || ((pic_cnt <= ESP_H264_STATS_FRAME_NUM) && (consumed_len != stream_len))
+            || !stats.latency_avg_us || (stats.latency_max_us < stats.latency_avg_us)
+            || ((pic_cnt > 1) && !stats.bitrate)) {
+        printf("The statistics are wrong. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _stats_exit_;
+    }
+    ret = esp_h264_dec_reset_stats(dec);
+    ret |= esp_h264_dec_get_stats(dec, &stats);
+    if ((ret != ESP_H264_ERR_OK) || stats.frame_num || stats.frame_stats_num) {
+        printf("esp_h264_dec_reset_stats failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_stats_exit_:
+    ret |= esp_h264_dec_close(dec);
+    ret |= esp_h264_dec_del(dec);
+    if (stream) {
+        esp_h264_free(stream);
+    }
+    return ret;
+}
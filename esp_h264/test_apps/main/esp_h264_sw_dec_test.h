@@ -7,6 +7,9 @@
 #pragma once
 
 #include "esp_h264_dec_sw.h"
+#include "esp_h264_enc_single_sw.h"
+#include "esp_h264_au_parser.h"
+#include "esp_h264_probe.h"
 
 /**
  * @brief Single hardware oneencoding. It is simple test case. And do the follow opertion.
@@ -30,3 +33,155 @@
  *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the decoder.
  */
 esp_h264_err_t single_sw_dec_process(esp_h264_dec_cfg_sw_t cfg, uint8_t *inbuf, uint32_t inbuf_len, uint8_t *yuv);
+
+/**
+ * @brief Access unit parser test with software encoder and decoder.
+ *        The encoded stream is parsed in chunks. Every access unit must be one picture after decoding.
+ *
+ * @param  enc_cfg    THe configuration of single software encoder
+ * @param  chunk_len  The chunk length in byte
+ *
+ * @return
+ *       - ESP_H264_ERR_OK        Succeeded
+ *       - ESP_H264_ERR_ARG       Invalid arguments passed
+ *       - ESP_H264_ERR_MEM       Insufficient memory
+ *       - ESP_H264_ERR_OVERFLOW  The access unit is larger than the parser buffer
+ *       - ESP_H264_ERR_FAIL      Failed
+ */
+esp_h264_err_t single_sw_dec_au_parser_test(esp_h264_enc_cfg_sw_t enc_cfg, uint32_t chunk_len);
+
+/**
+ * @brief AVCC input test with software encoder and decoder.
+ *        The stream of noise pictures has emulation prevention bytes. It is rewritten into avcC and length prefixed samples.
+ *        Every sample must be one picture after decoding, and the same as the picture of Annex-B access unit.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_avcc_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Decoded frame pool test with software encoder and decoder.
+ *        Every picture is output in the frame pool and held by two consumers until the pool is full.
+ *        The full pool isn't counted as error, and the frame smaller than one picture is refused before decoding.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_frame_pool_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Output format test with software encoder and decoder.
+ *        The picture decoded in `fmt` is compared with the I420 picture converted after decoding.
+ *        The RGB picture may differ from the float reference by one step.
+ *        The latency of both ways is printed.
+ *
+ * @param  enc_cfg      THe configuration of single software encoder
+ * @param  fmt          The output format of decoder
+ * @param  color_space  The color space of RGB output format
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_fmt_test(esp_h264_enc_cfg_sw_t enc_cfg, esp_h264_raw_format_t fmt, esp_h264_dec_color_space_t color_space);
+
+/**
+ * @brief Downscaled output test with software encoder and decoder.
+ *        The downscaled picture is compared with the full picture downscaled by box filter after decoding.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ * @param  scale    Downscale of output picture
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_scale_test(esp_h264_enc_cfg_sw_t enc_cfg, esp_h264_dec_scale_t scale);
+
+/**
+ * @brief Stream probe test with software encoder and decoder.
+ *        The SPS and PPS of one high profile stream and the software encoded stream are probed without decoder.
+ *        The probed resolution is compared with the one after decoding.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_probe_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Skip mode and seek test with software encoder and decoder.
+ *        The number of pictures is checked in every skip mode and after seek. The time of IDR frames only is printed.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder. Its `gop` must be less than the number of frames
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_skip_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Error concealment test with software encoder and decoder.
+ *        The second half of P slices, and then the whole P slices, are dropped by 0%, 10%, 30% and 50% loss rate.
+ *        The damaged macroblocks are reported after the loss, and the PSNR to the pictures without loss is 10 dB at least.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_conceal_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Task mode test with software encoder and decoder.
+ *        The pictures decoded in single task and dual task on each core are the same, and the time of each mode is printed.
+ *        Then one dual task decoder and one single task decoder decode at the same time.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_task_test(esp_h264_enc_cfg_sw_t enc_cfg);
+
+/**
+ * @brief Software decoder statistics test.
+ *        Every picture is one record. The counters and the consumed length of records are checked with the encoded stream.
+ *
+ * @param  enc_cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_dec_stats_test(esp_h264_enc_cfg_sw_t enc_cfg);
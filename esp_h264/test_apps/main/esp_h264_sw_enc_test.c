@@ -159,3 +159,182 @@ _exit_:
     }
     return ret;
 }
+
+esp_h264_err_t single_sw_enc_stats_test(esp_h264_enc_cfg_sw_t cfg)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_stats_t stats = {0};
+    uint32_t frame_cnt = 0;
+    uint32_t idr_cnt = 0;
+    uint32_t qp_cnt = 0;
+
+    in_frame.raw_data.len = (cfg.res.width * cfg.res.height + (cfg.res.width * cfg.res.height >> 1));
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, MALLOC_CAP_INTERNAL);
+    if (!in_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    out_frame.raw_data.len = in_frame.raw_data.len;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, MALLOC_CAP_INTERNAL);
+    if (!out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_sw_new(&cfg, &enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("new failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("open failed .line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    while (read_enc_cb_i420(&in_frame, cfg.res.width, cfg.res.height) > 0) {
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _stats_exit_;
+        }
+        idr_cnt += (out_frame.frame_type == ESP_H264_FRAME_TYPE_IDR);
+        frame_cnt++;
+        write_enc_cb(&out_frame);
+    }
+    ret = esp_h264_enc_get_stats(enc, &stats);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("esp_h264_enc_get_stats failed. line %d \n", __LINE__);
+        goto _stats_exit_;
+    }
+    for (uint8_t i = 0; i < ESP_H264_STATS_QP_BIN_NUM; i++) {
+        qp_cnt += stats.qp_hist[i];
+    }
+    printf("Frames %d IDR %d latency avg %d max %d us bitrate %d IDR length %d max %d \n", (int)stats.frame_num, (int)stats.idr_num,
+           (int)stats.latency_avg_us, (int)stats.latency_max_us, (int)stats.bitrate, (int)stats.idr_len_last, (int)stats.idr_len_max);
+    if ((stats.frame_num != frame_cnt)
+            || !idr_cnt || (stats.idr_num != idr_cnt)
+            || (stats.err_num + stats.timeout_num + stats.overflow_num)
+            || (qp_cnt != frame_cnt)
+            || (stats.frame_stats_num != (frame_cnt < ESP_H264_STATS_FRAME_NUM ? frame_cnt : ESP_H264_STATS_FRAME_NUM))
+            || (stats.frame_stats[stats.frame_stats_num - 1].len != out_frame.length)
+            || (stats.frame_stats[stats.frame_stats_num - 1].frame_type != out_frame.frame_type)
+            || !stats.latency_avg_us || (stats.latency_max_us < stats.latency_avg_us)
+            || !stats.bitrate || !stats.idr_len_last || (stats.idr_len_max < stats.idr_len_last)) {
+        printf("The statistics are wrong. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+        goto _stats_exit_;
+    }
+    ret = esp_h264_enc_reset_stats(enc);
+    ret |= esp_h264_enc_get_stats(enc, &stats);
+    if ((ret != ESP_H264_ERR_OK) || stats.frame_num || stats.frame_stats_num) {
+        printf("esp_h264_enc_reset_stats failed. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+_stats_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+/* Encode `frame_num` noise pictures. The bits of the last second and the QP range of recent frames are reported. */
+static esp_h264_err_t sw_enc_test_noise_rate(esp_h264_enc_cfg_sw_t cfg, uint16_t frame_num, uint32_t *out_bitrate, uint8_t *out_qp_min,
+                                             uint8_t *out_qp_max)
+{
+    esp_h264_enc_in_frame_t in_frame = {0};
+    esp_h264_enc_out_frame_t out_frame = {0};
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    esp_h264_enc_handle_t enc = NULL;
+    esp_h264_stats_t stats = {0};
+    uint32_t pixels = cfg.res.width * cfg.res.height;
+    uint32_t seed = 1;
+    uint64_t bits = 0;
+
+    *out_bitrate = 0;
+    *out_qp_min = ESP_H264_QP_MAX;
+    *out_qp_max = 0;
+    in_frame.raw_data.len = pixels + (pixels >> 1);
+    in_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, in_frame.raw_data.len, &in_frame.raw_data.len, MALLOC_CAP_INTERNAL);
+    out_frame.raw_data.len = in_frame.raw_data.len * 2;
+    out_frame.raw_data.buffer = esp_h264_aligned_calloc(16, 1, out_frame.raw_data.len, &out_frame.raw_data.len, MALLOC_CAP_INTERNAL);
+    if (!in_frame.raw_data.buffer || !out_frame.raw_data.buffer) {
+        printf("mem allocation failed.line %d \n", __LINE__);
+        ret = ESP_H264_ERR_MEM;
+        goto _noise_exit_;
+    }
+    ret = esp_h264_enc_sw_new(&cfg, &enc);
+    ret |= esp_h264_enc_open(enc);
+    if (ret != ESP_H264_ERR_OK) {
+        printf("encoder open failed. line %d \n", __LINE__);
+        goto _noise_exit_;
+    }
+    memset(in_frame.raw_data.buffer + pixels, 0x80, pixels >> 1);
+    for (uint16_t i = 0; i < frame_num; i++) {
+        for (uint32_t j = 0; j < pixels; j++) {
+            seed = seed * 1103515245 + 12345;
+            in_frame.raw_data.buffer[j] = 0x70 + (seed >> 27);
+        }
+        ret = esp_h264_enc_process(enc, &in_frame, &out_frame);
+        if (ret != ESP_H264_ERR_OK) {
+            printf("process failed. line %d \n", __LINE__);
+            goto _noise_exit_;
+        }
+        /** RC has settled after the first second */
+        if (i + cfg.fps >= frame_num) {
+            bits += out_frame.length * 8;
+        }
+    }
+    *out_bitrate = (uint32_t)bits;
+    ret = esp_h264_enc_get_stats(enc, &stats);
+    for (uint8_t i = 0; i < stats.frame_stats_num; i++) {
+        *out_qp_min = (stats.frame_stats[i].qp < *out_qp_min) ? stats.frame_stats[i].qp : *out_qp_min;
+        *out_qp_max = (stats.frame_stats[i].qp > *out_qp_max) ? stats.frame_stats[i].qp : *out_qp_max;
+    }
+_noise_exit_:
+    ret |= esp_h264_enc_close(enc);
+    ret |= esp_h264_enc_del(enc);
+    if (in_frame.raw_data.buffer) {
+        esp_h264_free(in_frame.raw_data.buffer);
+    }
+    if (out_frame.raw_data.buffer) {
+        esp_h264_free(out_frame.raw_data.buffer);
+    }
+    return ret;
+}
+
+esp_h264_err_t single_sw_enc_capped_test(esp_h264_enc_cfg_sw_t cfg)
+{
+    esp_h264_err_t ret = ESP_H264_ERR_FAIL;
+    uint16_t frame_num = cfg.fps * 2;
+    uint32_t free_bitrate = 0;
+    uint32_t capped_bitrate = 0;
+    uint8_t qp_min = 0;
+    uint8_t qp_max = 0;
+
+    /** The ceiling far above the stream gives the bitrate at the QP floor */
+    cfg.rc.mode = ESP_H264_RC_MODE_CAPPED_QUALITY;
+    cfg.rc.bitrate = 20 * 1000 * 1000;
+    ret = sw_enc_test_noise_rate(cfg, frame_num, &free_bitrate, &qp_min, &qp_max);
+    if ((ret != ESP_H264_ERR_OK) || (qp_min < cfg.rc.qp_min) || (qp_max > cfg.rc.qp_max)) {
+        printf("Free bitrate %d QP %d ~ %d. line %d \n", (int)free_bitrate, qp_min, qp_max, __LINE__);
+        return ESP_H264_ERR_FAIL;
+    }
+    /** The ceiling at half of it must hold with the QP in range */
+    cfg.rc.bitrate = free_bitrate / 2;
+    ret = sw_enc_test_noise_rate(cfg, frame_num, &capped_bitrate, &qp_min, &qp_max);
+    printf("Free bitrate %d, ceiling %d, capped bitrate %d, QP %d ~ %d \n", (int)free_bitrate, (int)cfg.rc.bitrate, (int)capped_bitrate,
+           qp_min, qp_max);
+    if ((ret != ESP_H264_ERR_OK) || (capped_bitrate > cfg.rc.bitrate + cfg.rc.bitrate / 4)
+            || (qp_min < cfg.rc.qp_min) || (qp_max > cfg.rc.qp_max)) {
+        printf("The bitrate ceiling or QP range isn't kept. line %d \n", __LINE__);
+        ret = ESP_H264_ERR_FAIL;
+    }
+    return ret;
+}
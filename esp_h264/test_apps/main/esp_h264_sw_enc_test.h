@@ -30,3 +30,32 @@
  *       - ESP_H264_ERR_UNSUPPORTED  Process feature is not supported by the encoder.
  */
 esp_h264_err_t single_sw_enc_thread_test(esp_h264_enc_cfg_sw_t cfg);
+
+/**
+ * @brief Single software encoder statistics test.
+ *        The counters, QP histogram and frame records are checked with the encoded frames.
+ *
+ * @param  cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_enc_stats_test(esp_h264_enc_cfg_sw_t cfg);
+
+/**
+ * @brief Single software encoder capped quality mode test.
+ *        The noise pictures are encoded with the ceiling far above the stream, and then with the ceiling at half of its bitrate.
+ *        The bitrate of the last second must be under the ceiling with 25% tolerance, and the QP of frames in [qp_min, qp_max].
+ *
+ * @param  cfg  THe configuration of single software encoder
+ *
+ * @return
+ *       - ESP_H264_ERR_OK    Succeeded
+ *       - ESP_H264_ERR_ARG   Invalid arguments passed
+ *       - ESP_H264_ERR_MEM   Insufficient memory
+ *       - ESP_H264_ERR_FAIL  Failed
+ */
+esp_h264_err_t single_sw_enc_capped_test(esp_h264_enc_cfg_sw_t cfg);
@@ -6,6 +6,7 @@
 
 #include <string.h>
 #include <unity.h>
+#include "freertos/FreeRTOS.h"
 #include "esp_h264_hw_enc_test.h"
 #include "esp_h264_sw_enc_test.h"
 #include "esp_h264_sw_dec_test.h"
@@ -66,6 +67,50 @@ TEST_CASE("hw_enc_single_hw_enc_qp_test", "[esp_h264]")
     }
 }
 
+TEST_CASE("hw_enc_single_hw_enc_capped_quality_test", "[esp_h264]")
+{
+    for (int16_t qp = 0; qp <= 51; qp++) {
+        esp_h264_enc_cfg_hw_t cfg = { 0 };
+        cfg.gop = 5;
+        cfg.fps = 30;
+        cfg.res.width = res_width;
+        cfg.res.height = res_height;
+        cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+        cfg.rc.qp_min = qp;
+        cfg.rc.qp_max = 51;
+        cfg.rc.mode = ESP_H264_RC_MODE_CAPPED_QUALITY;
+        cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+        TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_process(cfg));
+    }
+    /** The noise above QP 30 is too weak to halve the bitrate */
+    for (int16_t qp = 0; qp <= 30; qp += 6) {
+        esp_h264_enc_cfg_hw_t cfg = { 0 };
+        cfg.gop = 30;
+        cfg.fps = 30;
+        cfg.res.width = res_width;
+        cfg.res.height = res_height;
+        cfg.rc.qp_min = qp;
+        cfg.rc.qp_max = 51;
+        cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+        TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_capped_quality_test(cfg));
+    }
+}
+
+TEST_CASE("hw_enc_single_hw_enc_capped_static_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    /** One bit per pixel is far more than the static scene needs at QP 30 */
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps;
+    cfg.rc.qp_min = 30;
+    cfg.rc.qp_max = 51;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_capped_static_test(cfg));
+}
+
 TEST_CASE("hw_enc_dual_hw_enc_gop_test", "[esp_h264]")
 {
     for (int16_t gop = 1; gop < 256; gop++) {
@@ -289,6 +334,193 @@ TEST_CASE("hw_enc_set_get_param_dual_hw_enc_mv_pkt_test", "[esp_h264]")
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, dual_hw_enc_mv_pkt_test(cfg));
 }
 
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_scene_change_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 255;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_scene_change_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_static_skip_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_static_skip_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_qp_map_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_qp_map_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_auto_roi_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_auto_roi_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_mv_ring_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_mv_ring_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_out_size_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_out_size_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_out_seg_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_out_seg_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_pool_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_pool_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_mem_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_mem_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_reconfig_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_reconfig_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_stats_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_stats_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_trace_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_trace_test(cfg));
+}
+
+TEST_CASE("hw_enc_set_get_param_single_hw_enc_cache_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_hw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 40;
+    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_hw_enc_cache_test(cfg, 60));
+}
+
+TEST_CASE("hw_enc_motion_test", "[esp_h264]")
+{
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, hw_enc_motion_test((res_width + 15) >> 4, (res_height + 15) >> 4));
+}
+
 /* error test */
 TEST_CASE("hw_enc_error_test", "[esp_h264]")
 {
@@ -501,6 +733,236 @@ TEST_CASE("hw_enc_error_test", "[esp_h264]")
     /* get_mv_data_len: length is NULL  */
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_mv_data_len(param_hd, NULL));
 
+    /* cfg_scene_change: param_hd is NULL  */
+    esp_h264_enc_scene_cfg_t scene_cfg = {
+        .enable = true,
+        .mad_thres = 300,
+        .hist_thres = 50,
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_scene_change(NULL, scene_cfg));
+
+    /* cfg_scene_change: hist_thres is greater than 100  */
+    scene_cfg.hist_thres = 101;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_scene_change(param_hd, scene_cfg));
+
+    /* get_scene_change_cfg_info: param_hd is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_scene_change_cfg_info(NULL, &scene_cfg));
+
+    /* get_scene_change_cfg_info: scene change configure is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_scene_change_cfg_info(param_hd, NULL));
+
+    /* cfg_static_skip: param_hd is NULL  */
+    esp_h264_enc_skip_cfg_t skip_cfg = {
+        .enable = true,
+        .diff_thres = 2,
+        .mad_thres = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_static_skip(NULL, skip_cfg));
+
+    /* get_static_skip_cfg_info: param_hd is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_static_skip_cfg_info(NULL, &skip_cfg));
+
+    /* get_static_skip_cfg_info: frame skipping configure is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_static_skip_cfg_info(param_hd, NULL));
+
+    /* set_qp_map: param_hd is NULL  */
+    int8_t delta_qp_map[4] = { 0 };
+    esp_h264_enc_qp_map_t qp_map = {
+        .frame_qp = 30,
+        .delta_qp_map = delta_qp_map,
+        .map_len = sizeof(delta_qp_map),
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_qp_map(NULL, qp_map));
+
+    /* set_qp_map: the length of map isn't `mb_width * mb_height`  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_qp_map(param_hd, qp_map));
+
+    /* cfg_auto_roi: param_hd is NULL  */
+    esp_h264_enc_auto_roi_cfg_t auto_roi_cfg = {
+        .enable = true,
+        .mv_thres = 2,
+        .min_area = 2,
+        .roi_delta_qp = -4,
+        .none_roi_delta_qp = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_auto_roi(NULL, auto_roi_cfg));
+
+    /* cfg_auto_roi: ROI delta QP is less than -51  */
+    auto_roi_cfg.roi_delta_qp = -52;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_auto_roi(param_hd, auto_roi_cfg));
+
+    /* get_auto_roi_cfg_info: param_hd is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_auto_roi_cfg_info(NULL, &auto_roi_cfg));
+
+    /* get_auto_roi_cfg_info: MV driven ROI configure is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_auto_roi_cfg_info(param_hd, NULL));
+
+    /* set_qp_map: frame QP is greater than 51  */
+    qp_map.frame_qp = 52;
+    qp_map.delta_qp_map = NULL;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_qp_map(param_hd, qp_map));
+
+    /* cfg_mv_ring: param_hd is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_mv_ring(NULL, 2));
+
+    /* cfg_mv_ring: depth is 1  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_mv_ring(param_hd, 1));
+
+    /* cfg_mv_ring: depth is greater than ESP_H264_MV_RING_DEPTH_MAX  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_cfg_mv_ring(param_hd, ESP_H264_MV_RING_DEPTH_MAX + 1));
+
+    /* acquire_mv_pkt: MV packet is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_acquire_mv_pkt(param_hd, NULL));
+
+    /* acquire_mv_pkt: MV buffer ring isn't configured  */
+    esp_h264_enc_mvm_pkt_t ring_pkt = { 0 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_FAIL, esp_h264_enc_hw_acquire_mv_pkt(param_hd, &ring_pkt));
+
+    /* release_mv_pkt: MV packet data is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_release_mv_pkt(param_hd, ring_pkt));
+
+    /* get_out_buf_size: encoder handle is NULL  */
+    uint32_t out_buf_size = 0;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_out_buf_size(NULL, &out_buf_size));
+
+    /* get_out_buf_size: size is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_out_buf_size(enc, NULL));
+
+    /* set_spill_buf: spill buffer isn't cache line aligned  */
+    uint8_t spill_data[16];
+    esp_h264_pkt_t spill = {
+        .buffer = (uint8_t *)(((uint32_t)spill_data + 8) | 1),
+        .len = 4,
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_spill_buf(enc, spill));
+
+    /* set_spill_buf: encoder handle is NULL  */
+    spill.buffer = NULL;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_spill_buf(NULL, spill));
+
+    /* get_spill_len: length is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_spill_len(enc, NULL));
+
+    /* set_out_seg: segments are NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_out_seg(enc, NULL, 1));
+
+    /* set_out_seg: the number of segments is greater than ESP_H264_OUT_SEG_MAX  */
+    esp_h264_pkt_t out_seg[2] = {
+        {.buffer = (uint8_t *)(((uint32_t)spill_data + 7) & ~7), .len = 4},
+        {.buffer = (uint8_t *)(((uint32_t)spill_data + 7) & ~7), .len = 4},
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_out_seg(enc, out_seg, ESP_H264_OUT_SEG_MAX + 1));
+
+    /* set_out_seg: the length of segment isn't cache line aligned  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_out_seg(enc, out_seg, 2));
+
+    /* get_out_seg_len: length is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_out_seg_len(enc, NULL, 1));
+
+    /* get_mem_info: encoder handle is NULL  */
+    esp_h264_enc_hw_mem_info_t mem_info = { 0 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_mem_info(NULL, &mem_info));
+
+    /* get_mem_info: memory information is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_get_mem_info(enc, NULL));
+
+    /* reconfigure: encoder handle is NULL  */
+    esp_h264_enc_cfg_hw_t cfg_new = cfg;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_reconfigure(NULL, &cfg_new));
+
+    /* reconfigure: configure is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_reconfigure(enc, NULL));
+
+    /* reconfigure: resolution is greater than the one at creation  */
+    cfg_new.res.height = res_height + 16;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_reconfigure(enc, &cfg_new));
+
+    /* get_stats: encoder handle is NULL  */
+    esp_h264_stats_t stats = { 0 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_get_stats(NULL, &stats));
+
+    /* get_stats: statistics is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_get_stats(enc, NULL));
+
+    /* reset_stats: encoder handle is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_reset_stats(NULL));
+
+    /* trace_export: encoder handle is NULL  */
+    char trace_buf[16];
+    uint32_t trace_len = 0;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_trace_export(NULL, trace_buf, sizeof(trace_buf), &trace_len));
+
+    /* trace_export: buffer is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_trace_export(enc, NULL, sizeof(trace_buf), &trace_len));
+
+    /* trace_export: length is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_trace_export(enc, trace_buf, sizeof(trace_buf), NULL));
+
+    /* set_buf_flags: encoder handle is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_buf_flags(NULL, ESP_H264_ENC_HW_BUF_IN_DEV_WRITTEN));
+
+    /* set_buf_flags: unknown flag  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_set_buf_flags(enc, 1 << 7));
+
+    /* pool_new: configure is NULL  */
+    esp_h264_enc_hw_pool_handle_t pool = NULL;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_pool_new(NULL, &pool));
+
+    /* pool_new: resolution is less than the minimum  */
+    esp_h264_enc_hw_pool_cfg_t pool_cfg = {
+        .res = {.width = 16, .height = 16},
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_pool_new(&pool_cfg, &pool));
+
+    /* new_with_pool: pool is NULL  */
+    esp_h264_enc_handle_t enc_pool = NULL;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_new_with_pool(&cfg, NULL, &enc_pool));
+
+    /* new_with_pool: resolution is greater than the pool resolution  */
+    pool_cfg.res.width = res_width - 16;
+    pool_cfg.res.height = res_height - 16;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_enc_hw_pool_new(&pool_cfg, &pool));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_new_with_pool(&cfg, pool, &enc_pool));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_pool_get_info(pool, NULL));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_hw_pool_del(NULL));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_enc_hw_pool_del(pool));
+
+    /* motion_new: configure is NULL  */
+    esp_h264_motion_handle_t motion = NULL;
+    esp_h264_motion_cfg_t motion_cfg = {
+        .mb_width = (res_width + 15) >> 4,
+        .mb_height = (res_height + 15) >> 4,
+        .mv_thres = 2,
+        .heat_rise = 64,
+        .heat_decay = 64,
+        .heat_thres = 100,
+        .on_thres = 1,
+        .off_thres = 2,
+        .on_frames = 2,
+        .off_frames = 2,
+    };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_new(NULL, &motion));
+
+    /* motion_new: stop threshold is greater than start threshold  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_new(&motion_cfg, &motion));
+
+    motion_cfg.off_thres = 1;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_motion_new(&motion_cfg, &motion));
+
+    /* motion_set_zone: the length of zone mask isn't `mb_width * mb_height`  */
+    uint8_t zone_mask[2] = { 0 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_set_zone(motion, zone_mask, sizeof(zone_mask)));
+
+    /* motion_process: MV data is NULL  */
+    esp_h264_motion_result_t motion_res = { 0 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_process(motion, NULL, 1, &motion_res));
+
+    /* motion_process: result is NULL  */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_process(motion, NULL, 0, NULL));
+
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_motion_del(NULL));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_motion_del(motion));
+
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_open(NULL));
 
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_enc_open(enc));
@@ -752,11 +1214,29 @@ TEST_CASE("sw_dec_error_test", "[esp_h264]")
     /* dec handle is NULL*/
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new(&cfg, NULL));
 
-    /* pic_type isn't ESP_H264_RAW_FMT_I420*/
-    cfg.pic_type = ESP_H264_RAW_FMT_O_UYY_E_VYY;
-    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new(&cfg, NULL));
+    /* pic_type isn't supported*/
+    cfg.pic_type = (esp_h264_raw_format_t)(ESP_H264_RAW_FMT_RGB888 + 1);
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new(&cfg, &dec));
 
     cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    esp_h264_dec_task_cfg_t task_cfg = { 0 };
+    /* task_cfg is NULL*/
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new_with_task(&cfg, NULL, &dec));
+
+    /* task mode isn't supported*/
+    task_cfg.mode = (esp_h264_dec_task_mode_t)(ESP_H264_DEC_TASK_DUAL + 1);
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new_with_task(&cfg, &task_cfg, &dec));
+
+    /* task core is out of range*/
+    task_cfg.mode = ESP_H264_DEC_TASK_DUAL;
+    task_cfg.core = 2;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new_with_task(&cfg, &task_cfg, &dec));
+
+    /* task priority is out of range*/
+    task_cfg.core = 1;
+    task_cfg.priority = configMAX_PRIORITIES;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_new_with_task(&cfg, &task_cfg, &dec));
+
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_new(&cfg, &dec));
 
     esp_h264_dec_param_handle_t param_hd = NULL;
@@ -769,6 +1249,110 @@ TEST_CASE("sw_dec_error_test", "[esp_h264]")
     /* get_resolution: resolution is NULL */
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_get_resolution(param_hd, NULL));
 
+    /* set_avcc: decoder handle is NULL */
+    uint8_t avcc[8] = {0x01, 0x42, 0xc0, 0x1e, 0xff, 0xe0, 0x00};
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_avcc(NULL, avcc, 7));
+
+    /* set_avcc: avcC is NULL with length */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_avcc(dec, NULL, 7));
+
+    /* set_avcc: configuration version isn't 1 */
+    avcc[0] = 0;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_avcc(dec, avcc, 7));
+    avcc[0] = 1;
+
+    /* set_avcc: NAL length size is 3 */
+    avcc[4] = 0xfe;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_avcc(dec, avcc, 7));
+    avcc[4] = 0xff;
+
+    /* set_avcc: SPS is truncated */
+    avcc[5] = 0xe1;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_avcc(dec, avcc, 8));
+    avcc[5] = 0xe0;
+
+    /* set_avcc: no parameter set */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_avcc(dec, avcc, 7));
+
+    /* set_avcc: back to Annex-B */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_avcc(dec, NULL, 0));
+
+    /* set_frame_pool: decoder handle is NULL */
+    uint8_t pool_buf[64];
+    esp_h264_pkt_t pool_frames[ESP_H264_DEC_FRAME_POOL_MAX + 1] = {{.buffer = pool_buf, .len = sizeof(pool_buf)}};
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_frame_pool(NULL, pool_frames, 1));
+
+    /* set_frame_pool: frames is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_frame_pool(dec, NULL, 1));
+
+    /* set_frame_pool: too many frames */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_frame_pool(dec, pool_frames, ESP_H264_DEC_FRAME_POOL_MAX + 1));
+
+    /* set_frame_pool: frame buffer is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_frame_pool(dec, pool_frames, 2));
+
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_frame_pool(dec, pool_frames, 1));
+
+    /* frame_ref: the frame isn't held */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_frame_ref(dec, pool_buf));
+
+    /* frame_release: the frame isn't held */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_frame_release(dec, pool_buf));
+
+    /* frame_release: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_frame_release(NULL, pool_buf));
+
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_frame_pool(dec, NULL, 0));
+
+    /* frame_ref: the frame pool isn't set */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_frame_ref(dec, pool_buf));
+
+    /* set_color_space: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_color_space(NULL, ESP_H264_DEC_COLOR_SPACE_BT709_FULL));
+
+    /* set_color_space: color space is invalid */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_color_space(dec, (esp_h264_dec_color_space_t)(ESP_H264_DEC_COLOR_SPACE_BT709_FULL + 1)));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_color_space(dec, ESP_H264_DEC_COLOR_SPACE_BT709_FULL));
+
+    /* set_scale: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_scale(NULL, ESP_H264_DEC_SCALE_1_2));
+
+    /* set_scale: scale is invalid */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_scale(dec, (esp_h264_dec_scale_t)(ESP_H264_DEC_SCALE_1_8 + 1)));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_scale(dec, ESP_H264_DEC_SCALE_1_1));
+
+    /* set_skip: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_skip(NULL, ESP_H264_DEC_SKIP_NON_INTRA));
+
+    /* set_skip: skip mode is invalid */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_skip(dec, (esp_h264_dec_skip_t)(ESP_H264_DEC_SKIP_NON_INTRA + 1)));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_skip(dec, ESP_H264_DEC_SKIP_NONE));
+
+    /* seek: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_seek(NULL));
+
+    /* set_conceal: decoder handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_sw_set_conceal(NULL, true));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_sw_set_conceal(dec, false));
+
+    /* probe: data is NULL */
+    esp_h264_stream_info_t info;
+    uint8_t not_sps[] = { 0x00, 0x00, 0x00, 0x01, 0x68, 0xCE, 0x3C, 0x80 };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_probe(NULL, sizeof(not_sps), &info));
+
+    /* probe: info is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_probe(not_sps, sizeof(not_sps), NULL));
+
+    /* probe: no SPS */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_FAIL, esp_h264_probe(not_sps, sizeof(not_sps), &info));
+
+    /* probe_sps: it isn't SPS */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_FAIL, esp_h264_probe_sps(not_sps + 4, sizeof(not_sps) - 4, &info));
+
+    /* probe_sps: SPS is truncated */
+    uint8_t short_sps[] = { 0x67, 0x42, 0xC0, 0x1E };
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_FAIL, esp_h264_probe_sps(short_sps, sizeof(short_sps), &info));
+
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_open(NULL));
 
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_open(dec));
@@ -780,6 +1364,41 @@ TEST_CASE("sw_dec_error_test", "[esp_h264]")
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_dec_del(NULL));
 
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_dec_del(dec));
+
+    /* au_parser_new: configure is NULL */
+    esp_h264_au_parser_cfg_t parser_cfg = {.buf_size = 1024};
+    esp_h264_au_parser_handle_t parser = NULL;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_new(NULL, &parser));
+
+    /* au_parser_new: parser handle is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_new(&parser_cfg, NULL));
+
+    /* au_parser_new: buffer size is 0 */
+    parser_cfg.buf_size = 0;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_new(&parser_cfg, &parser));
+
+    parser_cfg.buf_size = 8;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_au_parser_new(&parser_cfg, &parser));
+
+    /* au_parser_process: input frame is NULL */
+    uint8_t au_data[512] = {0x00, 0x00, 0x00, 0x01, 0x65, 0x88};
+    esp_h264_dec_in_frame_t au_in = {.raw_data.buffer = au_data, .raw_data.len = sizeof(au_data)};
+    esp_h264_au_t au;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_process(parser, NULL, &au));
+
+    /* au_parser_process: access unit is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_process(parser, &au_in, NULL));
+
+    /* au_parser_process: access unit is larger than the buffer. The buffer size is aligned up to cache line */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OVERFLOW, esp_h264_au_parser_process(parser, &au_in, &au));
+    TEST_ASSERT_EQUAL(sizeof(au_data), au_in.consume);
+
+    /* au_parser_flush: access unit is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_flush(parser, NULL));
+
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_au_parser_del(NULL));
+
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, esp_h264_au_parser_del(parser));
 }
 
 /* configure test */
@@ -885,6 +1504,197 @@ TEST_CASE("sw_enc_set_get_param_single_thread_test", "[esp_h264]")
     TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_enc_thread_test(cfg));
 }
 
+TEST_CASE("sw_enc_stats_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_enc_stats_test(cfg));
+}
+
+TEST_CASE("sw_enc_capped_quality_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.qp_min = 20;
+    cfg.rc.qp_max = 51;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_enc_capped_test(cfg));
+}
+
+TEST_CASE("sw_dec_au_parser_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    /* The chunks are smaller than start code, smaller than access unit and larger than access unit */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_au_parser_test(cfg, 3));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_au_parser_test(cfg, 97));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_au_parser_test(cfg, 4096));
+}
+
+TEST_CASE("sw_dec_avcc_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_avcc_test(cfg));
+}
+
+TEST_CASE("sw_dec_frame_pool_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_frame_pool_test(cfg));
+}
+
+TEST_CASE("sw_dec_fmt_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_NV12, ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_YUYV, ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_O_UYY_E_VYY, ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED));
+}
+
+TEST_CASE("sw_dec_rgb_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_RGB565_LE, ESP_H264_DEC_COLOR_SPACE_BT601_LIMITED));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_RGB565_BE, ESP_H264_DEC_COLOR_SPACE_BT709_LIMITED));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_RGB888, ESP_H264_DEC_COLOR_SPACE_BT601_FULL));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_fmt_test(cfg, ESP_H264_RAW_FMT_RGB888, ESP_H264_DEC_COLOR_SPACE_BT709_FULL));
+}
+
+TEST_CASE("sw_dec_scale_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_scale_test(cfg, ESP_H264_DEC_SCALE_1_2));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_scale_test(cfg, ESP_H264_DEC_SCALE_1_4));
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_scale_test(cfg, ESP_H264_DEC_SCALE_1_8));
+}
+
+TEST_CASE("sw_dec_probe_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_probe_test(cfg));
+}
+
+TEST_CASE("sw_dec_skip_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_skip_test(cfg));
+}
+
+TEST_CASE("sw_dec_conceal_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_conceal_test(cfg));
+}
+
+TEST_CASE("sw_dec_task_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 30;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_task_test(cfg));
+}
+
+TEST_CASE("sw_dec_stats_test", "[esp_h264]")
+{
+    esp_h264_enc_cfg_sw_t cfg = { 0 };
+    cfg.gop = 5;
+    cfg.fps = 30;
+    cfg.res.width = res_width;
+    cfg.res.height = res_height;
+    cfg.rc.bitrate = cfg.res.width * cfg.res.height * cfg.fps / 20;
+    cfg.rc.qp_min = 26;
+    cfg.rc.qp_max = 26;
+    cfg.pic_type = ESP_H264_RAW_FMT_I420;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_OK, single_sw_dec_stats_test(cfg));
+}
+
 /* error test */
 TEST_CASE("sw_enc_error_test", "[esp_h264]")
 {
@@ -934,6 +1744,11 @@ TEST_CASE("sw_enc_error_test", "[esp_h264]")
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_sw_new(&cfg, &enc));
     cfg.rc.qp_max = 26;
 
+    /* RC mode is invalid */
+    cfg.rc.mode = ESP_H264_RC_MODE_MAX;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_sw_new(&cfg, &enc));
+    cfg.rc.mode = ESP_H264_RC_MODE_BITRATE;
+
     /* GOP is 0 */
     cfg.gop = 0;
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_sw_new(&cfg, &enc));
@@ -957,6 +1772,13 @@ TEST_CASE("sw_enc_error_test", "[esp_h264]")
     /* get_resolution: resolution is NULL */
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_get_resolution(param_hd, NULL));
 
+    /* get_stats: encoder handle is NULL */
+    esp_h264_stats_t stats;
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_get_stats(NULL, &stats));
+
+    /* get_stats: statistics is NULL */
+    TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_get_stats(enc, NULL));
+
     /* set_fps: param_hd is NULL */
     uint8_t fps;
     TEST_ASSERT_EQUAL(ESP_H264_ERR_ARG, esp_h264_enc_set_fps(NULL, fps));